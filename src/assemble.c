@@ -1,49 +1,36 @@
 /*
- * Contains the main function which reads in the lines of the program. Then,
- * each line is tokenized, parsed and encoded into binary words. The binary
- * words are written to an out file.
+ * Contains the main function which maps in the program and goes through it
+ * a line at a time. Each line is tokenized in place, parsed and encoded into
+ * binary words, in an output buffer which grows with the program. The binary
+ * words are written to an out file. Words loaded by ldr =expression go in
+ * literal pools, each value once, placed within reach of their loads where
+ * nothing runs into them or branched over. With -j, the program is split into
+ * chunks of lines, which are assembled on a number of threads after a first
+ * pass over them, also on the threads, for their labels and literals.
  */
 
+#include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
 #include "utils/arm.h"
 #include "utils/io.h"
 #include "utils/error.h"
+#include "utils/hash.h"
 #include "assemble/symbolmap.h"
-#include "assemble/referencemap.h"
 #include "assemble/tokenizer.h"
 #include "assemble/parser.h"
 #include "assemble/encode.h"
+#include "assemble/linecache.h"
 #include "assemble.h"
 
 /**
- * Allocate memory for the input stored in the program
- *
- * @param lines: number of lines of the input file
- * @param lineLength: length of input file lines
- * @return: pointer to the array containing input, with memory allocated but
- * not initialised
- */
-static char **allocate_input(int lines, int lineLength) {
-  char **in = malloc(lines * sizeof(char *));
-  if (in == NULL) {
-    return NULL;
-  }
-  in[0] = calloc(lines * lineLength, sizeof(char));
-  if (in[0] == NULL) {
-    free(in);
-    return NULL; // failed;
-  }
-
-  for (int i = 1; i < lines; i++) {
-    in[i] = in[0] + i * lineLength + 1;
-  }
-
-  return in;
-}
-
-/**
- * Free program_state memory
+ * Free program_state memory. Everything but the output and the tokens of
+ * the last line is in the program arena, which is freed in one go.
  *
  * @param program_state: desired program_state to remove from memory
  * @return: free will always succeed so returns EC_OK
@@ -51,148 +38,1101 @@ static char **allocate_input(int lines, int lineLength) {
 static int program_delete(assemble_state_t *program) {
   if (program) {
     free(program->out);
-    // free input characters
-    if (program->in) {
-      free(program->in[0]);
-    }
-    free(program->in);
-    // free data structures
-    rmap_delete(program->rmap);
-    smap_delete(program->smap);
-    list_delete(program->additional_words);
-    list_delete(program->tklst);
+    arena_delete(program->lineArena);
+    arena_delete(program->arena);
   }
-  // free rest of program
-  free(program);
 
   return EC_OK;
 }
 
 /**
- * Allocate memory for the program
+ * Allocate memory for the program, in an arena of its own
  *
  * @return: pointer to an uninitialised program
  */
 static assemble_state_t *program_new(void) {
-  assemble_state_t *program;
-  program = calloc(sizeof(assemble_state_t), 1);
+  arena_t *arena = arena_new(PROGRAM_ARENA_BLOCK_SIZE);
+  if (arena == NULL) {
+    return NULL;
+  }
+  assemble_state_t *program = arena_calloc(arena, 1,
+                                           sizeof(assemble_state_t));
   if (program == NULL) {
+    arena_delete(arena);
     return NULL;
   }
+  program->arena = arena;
 
-  program->lines = MAX_LINES;
-
-  program->smap = smap_new(MAX_S_MAP_CAPACITY);
+  program->smap = smap_new(arena, INITIAL_S_MAP_CAPACITY);
   if (program->smap == NULL) {
     program_delete(program);
     return NULL;
   }
-  program->rmap = rmap_new(MAX_R_MAP_CAPACITY);
-  if (program->rmap == NULL) {
-    program_delete(program);
-    return NULL;
-  }
-  program->additional_words = list_new(&free);
-  if (program->additional_words == NULL) {
+
+  program->lineArena = arena_new(ARENA_BLOCK_SIZE);
+  if (program->lineArena == NULL) {
     program_delete(program);
     return NULL;
   }
-  program->in = allocate_input(MAX_LINES, LINE_SIZE);
-  if (program->in == NULL) {
+
+  program->out = malloc(INITIAL_OUT_SIZE);
+  if (program->out == NULL) {
     program_delete(program);
     return NULL;
   }
+  program->outCapacity = INITIAL_OUT_SIZE;
 
-  program->tklst = token_list_new();
-  if (program->tklst == NULL) {
-    program_delete(program);
-    return NULL;
+  return program;
+}
+
+/**
+ * Print how much an arena has been used
+ *
+ * @param out: stream to print to
+ * @param name: what the arena holds
+ * @param arena: pointer to the arena
+ */
+static void print_arena_stats(FILE *out, const char *name,
+                              const arena_t *arena) {
+  fprintf(out, "%s arena: %zu allocations in %zu blocks, %zu bytes in all, "
+               "peak %zu bytes used\n", name, arena->numAllocs,
+          arena->numBlocks, arena->blockBytes, arena->peak);
+}
+
+/**
+ * Make room in the output for a number of bytes after the current address,
+ * doubling its size until they fit
+ *
+ * @param program: pointer to the program state
+ * @param bytes: number of bytes to make room for
+ * @return: integer error code to represent success or failure
+ */
+static int reserve_output(assemble_state_t *program, size_t bytes) {
+  size_t needed = (size_t) program->mPC + bytes;
+  if (needed <= program->outCapacity) {
+    return EC_OK;
+  }
+  size_t capacity = program->outCapacity;
+  while (capacity < needed) {
+    capacity *= 2;
   }
+  byte_t *out = realloc(program->out, capacity);
+  MEM_CHECK(out, EC_NULL_POINTER);
+  program->out = out;
+  program->outCapacity = capacity;
+  return EC_OK;
+}
 
-  program->out = calloc(sizeof(word_t), MAX_LINES * LINE_SIZE);
+/**
+ * Map function reporting a label that branches refer to but is never defined
+ */
+static void report_undefined(const label_t label, const address_t val,
+                             const void *obj) {
+  size_t *cnt = (size_t *) obj;
+  fprintf(stderr, "undefined label: %s\n", label);
+  *cnt += 1;
+}
 
-  if (program->smap == NULL) {
-    program_delete(program);
-    return NULL;
+/**
+ * Point a load from the literal pool at the slot of its word
+ *
+ * @param program: pointer to the program state
+ * @param ref: address of the ldr
+ * @param addr: address of the slot
+ * @return: integer error code to represent success or failure
+ */
+static int point_load(assemble_state_t *program, address_t ref,
+                      address_t addr) {
+  int32_t offset = (int32_t) (addr - ref - 8);
+  word_t word;
+  get_word(program->out, ref, &word);
+  if (offset < 0) {
+    word &= ~LDR_U_BIT;
+    offset = -offset;
   }
+  if (offset > LDR_MAX_OFFSET) {
+    fprintf(stderr, "literal pool out of range of the ldr at 0x%x\n", ref);
+    return EC_UNSUPPORTED_OP;
+  }
+  set_word(program->out, ref, (word & ~LDR_MAX_OFFSET) | offset);
+  return EC_OK;
+}
 
-  return program;
+/**
+ * Give each of the words waiting for a pool a slot in it, one for each
+ * value. Equal values are found through a table of slots indexed by the
+ * hash of the value.
+ *
+ * @param literals: loads of the words, the oldest first
+ * @param numLiterals: number of loads
+ * @param values: set to the value of each slot, with room for numLiterals
+ * @param slotOf: set to the slot of the word of each load
+ * @return: number of slots, or -1 if allocation failed
+ */
+static int pool_slots(const wordref_t *literals, int numLiterals,
+                      word_t *values, int *slotOf) {
+  size_t capacity = 1;
+  while (capacity < (size_t) numLiterals * 2) {
+    capacity <<= 1;
+  }
+  int *table = malloc(capacity * sizeof(int));
+  if (table == NULL) {
+    return -1;
+  }
+  memset(table, 0xFF, capacity * sizeof(int));
+  int numSlots = 0;
+  for (int i = 0; i < numLiterals; i++) {
+    word_t word = literals[i].word;
+    size_t s = fnv1a_64(&word, sizeof(word_t), FNV_OFFSET_BASIS_64)
+               & (capacity - 1);
+    while (table[s] >= 0 && values[table[s]] != word) {
+      s = (s + 1) & (capacity - 1);
+    }
+    if (table[s] < 0) {
+      table[s] = numSlots;
+      values[numSlots++] = word;
+    }
+    slotOf[i] = table[s];
+  }
+  free(table);
+  return numSlots;
 }
 
 /**
- * Write the binary stored in the program struct to a file
+ * Find how many values the words waiting for a pool hold, each once
  *
- * @param path: path to the binary file to write out to
  * @param program: pointer to the program state
+ * @param numWords: set to the number of values
  * @return: integer error code to represent success or failure
  */
-static int write_program(char *path, assemble_state_t *program) {
-  int no_bytes = program->mPC + program->additional_words->len * 4;
-  program->out = realloc(program->out, sizeof(byte_t) * no_bytes);
-  if (program->out == NULL) {
+static int pool_words(const assemble_state_t *program, int *numWords) {
+  int numLiterals = program->numLiterals;
+  word_t *values = malloc(numLiterals * (sizeof(word_t) + sizeof(int)));
+  MEM_CHECK(values, EC_NULL_POINTER);
+  *numWords = pool_slots(program->literals, numLiterals, values,
+                         (int *) (values + numLiterals));
+  free(values);
+  return *numWords < 0 ? EC_NULL_POINTER : EC_OK;
+}
+
+/**
+ * Place the words waiting for a pool at the current address, each value
+ * once, and point their loads at them
+ *
+ * @param program: pointer to the program state
+ * @param branchOver: whether to branch over the pool, which is not after a
+ * branch that always goes
+ * @return: integer error code to represent success or failure
+ */
+static int place_pool(assemble_state_t *program, bool branchOver) {
+  int numLiterals = program->numLiterals;
+  if (numLiterals == 0) {
+    return EC_OK;
+  }
+  int _status = reserve_output(program, (numLiterals + 1) * sizeof(word_t));
+  FAIL_PRED(_status != EC_OK, _status);
+  address_t branch = program->mPC;
+  address_t pool = branchOver ? branch + sizeof(word_t) : branch;
+
+  word_t *values = malloc(numLiterals * (sizeof(word_t) + sizeof(int)));
+  MEM_CHECK(values, EC_NULL_POINTER);
+  int *slotOf = (int *) (values + numLiterals);
+  int numWords = pool_slots(program->literals, numLiterals, values, slotOf);
+  if (numWords < 0) {
+    free(values);
     return EC_NULL_POINTER;
   }
+  for (int i = 0; i < numWords; i++) {
+    set_word(program->out, pool + i * 4, values[i]);
+  }
+  for (int i = 0; i < numLiterals && _status == EC_OK; i++) {
+    _status = point_load(program, program->literals[i].ref,
+                         pool + slotOf[i] * 4);
+  }
+  free(values);
+  FAIL_PRED(_status != EC_OK, _status);
 
-  for (int i = 0; i < program->additional_words->len; i++) {
-    wordref_t *wordref = list_get(program->additional_words, i);
-    word_t offset = (program->mPC + i * 4 - wordref->ref - 8) | 0xFFFFF000;
-    word_t referenced_word;
-    get_word(program->out, wordref->ref, &referenced_word);
-    referenced_word &= offset;
-    set_word(program->out, wordref->ref, referenced_word);
+  program->mPC = pool + numWords * 4;
+  if (branchOver) {
+    set_word(program->out, branch, BRANCH_ALWAYS
+             | (calculate_offset(program->mPC, branch) & OFFSET_MASK));
+  }
+  program->numLiterals = 0;
+  program->numPooled += numWords;
+  return EC_OK;
+}
 
-    set_word(program->out, i * 4 + program->mPC, wordref->word);
+/**
+ * Check whether the pool is to be placed after the word just put at the
+ * end of the output: once its oldest load would not reach it past another
+ * word, or sooner after a branch that always goes, where it is not run
+ *
+ * @param program: pointer to the program state, just after the word
+ * @param word: the word
+ * @param branchOver: set to whether the pool is to be branched over
+ * @return: true iff the pool is to be placed
+ */
+static bool pool_due(const assemble_state_t *program, word_t word,
+                     bool *branchOver) {
+  if (program->numLiterals == 0) {
+    return false;
+  }
+  address_t oldest = program->literals[0].ref;
+  *branchOver = true;
+  if (program->mPC + program->numLiterals * 4 - oldest > LDR_MAX_OFFSET) {
+    return true;
   }
+  *branchOver = false;
+  return (word & BRANCH_ALWAYS_MASK) == BRANCH_ALWAYS
+         && program->mPC - oldest >= POOL_FLUSH_DISTANCE;
+}
 
-  return write_file(path, program->out, no_bytes);
+/**
+ * Get the address just after a pool placed by the first pass of -j
+ *
+ * @param pool: pointer to the pool
+ * @return: address of the word after it
+ */
+static address_t pool_end(const pool_t *pool) {
+  return pool->address + (pool->branchOver + pool->numWords) * sizeof(word_t);
 }
 
 /**
- * Main Assembler Loop
+ * Write the binary stored in the program struct to a file, after the last
+ * literal pool
  *
- * Takes as arguments the .s file to assemble and the path name of the .bin
- * file to write out to.
+ * @param path: path to the binary file to write out to
+ * @param program: pointer to the program state
+ * @return: integer error code to represent success or failure
+ */
+static int write_program(const char *path, assemble_state_t *program) {
+  int _status = place_pool(program, false);
+  if (_status != EC_OK) {
+    return _status;
+  }
+  return write_file(path, program->out, program->mPC);
+}
+
+/**
+ * Tokenize a line of the source into the program state
  *
+ * @param program: pointer to the program state
+ * @param line: pointer to the start of the line, moved on to the next line
+ * @param end: end of the source
+ * @return: integer error code to represent success or failure, EC_SKIP for
+ * a blank line
  */
-int main(int argc, char **argv) {
-  int _status = EC_OK;
-  assert(argc > 2);
+static int tokenize_next(assemble_state_t *program, const char **line,
+                         const char *end) {
+  const char *newline = memchr(*line, '\n', end - *line);
+  const char *lineEnd = newline != NULL ? newline : end;
+  arena_reset(program->lineArena);
+  int _status = tokenize(*line, lineEnd, program->lineArena, &program->tklst);
+  *line = newline != NULL ? newline + 1 : end;
+  return _status;
+}
 
-  assemble_state_t *program = program_new();
+/**
+ * Put a word at the current address of the output and move on past it
+ *
+ * @param program: pointer to the program state
+ * @param word: the word
+ * @return: integer error code to represent success or failure
+ */
+static int emit_word(assemble_state_t *program, word_t word) {
+  int _status = reserve_output(program, sizeof(word_t));
+  FAIL_PRED(_status != EC_OK, _status);
+  set_word(program->out, program->mPC, word);
+  program->mPC += 4;
 
-  if (program == NULL) {
-    return EC_NULL_POINTER; // unable to allocate space for program.
+  // With -j the first pass placed the pools, so only their gaps are left
+  if (program->labelsDefined) {
+    program->numWords++;
+    if (program->nextPool < program->numPools
+        && program->pools[program->nextPool].after == program->numWords) {
+      program->mPC = pool_end(&program->pools[program->nextPool++]);
+    }
+    return EC_OK;
   }
-  program->lines = read_char_file(argv[1], program->in);
+  bool branchOver;
+  if (pool_due(program, word, &branchOver)) {
+    return place_pool(program, branchOver);
+  }
+  return EC_OK;
+}
 
-  // set up variables for assembler
+/**
+ * Note where a token of a line is, in the entry of the line
+ *
+ * @param entry: the entry
+ * @param line: start of the line
+ * @param token: the token, a slice of the line
+ */
+static void note_label(line_entry_t *entry, const char *line,
+                       const token_t *token) {
+  entry->labelStart = token->str - line;
+  entry->labelLen = token->len;
+}
+
+/**
+ * Assemble a line into the output, noting in an entry for the line cache
+ * what it assembled to
+ *
+ * @param program: pointer to the program state
+ * @param line: start of the line
+ * @param lineEnd: end of the line, before its newline
+ * @param entry: entry whose kind, word, value and label are set
+ * @return: integer error code to represent success or failure
+ */
+static int assemble_line(assemble_state_t *program, const char *line,
+                         const char *lineEnd, line_entry_t *entry) {
   instruction_t instr;
   word_t word;
+  arena_reset(program->lineArena);
+  int _status = tokenize(line, lineEnd, program->lineArena, &program->tklst);
+  entry->kind = LINE_BLANK;
+  if (_status == EC_SKIP) {
+    return EC_OK;
+  }
+  FAIL_PRED(_status != EC_OK, _status);
 
-  //convert each line to binary
-  for (int i = 0; i < program->lines; i++) {
-    _status = tokenize(program->in[i], &program->tklst);
-    if (_status == EC_SKIP) {
-      _status = EC_OK;
-      continue;
+  // Parsing may replace the tokens, and adds a literal for ldr =expression
+  token_list_t *tklst = program->tklst;
+  int numLiterals = program->numLiterals;
+  _status = parse(program, &instr);
+  if (_status == EC_SKIP) {
+    entry->kind = LINE_LABEL;
+    note_label(entry, line, token_list_get(tklst, 0));
+    return EC_OK;
+  }
+  FAIL_PRED(_status != EC_OK, _status);
+
+  _status = encode(&instr, &word);
+  FAIL_PRED(_status != EC_OK, _status);
+
+  entry->kind = LINE_WORD;
+  entry->word = word;
+  if (instr.type == BRN) {
+    entry->word = word & ~OFFSET_MASK;
+    if (token_list_get_type(tklst, 1) == T_STR) {
+      entry->kind = LINE_BRANCH;
+      note_label(entry, line, token_list_get(tklst, 1));
+    } else {
+      entry->kind = LINE_BRANCH_TO;
+      entry->value = token_list_get_value(tklst, 1);
+    }
+  } else if (program->numLiterals > numLiterals) {
+    entry->kind = LINE_LITERAL;
+    entry->value = program->literals[numLiterals].word;
+  }
+  return emit_word(program, word);
+}
+
+/**
+ * Assemble a line from its entry in the line cache, filling in the offset
+ * of a branch and the literal of a load for where the line is now
+ *
+ * @param program: pointer to the program state
+ * @param line: start of the line
+ * @param entry: entry of the line
+ * @return: integer error code to represent success or failure
+ */
+static int replay_line(assemble_state_t *program, const char *line,
+                       const line_entry_t *entry) {
+  int _status = EC_OK;
+  word_t offset;
+  switch (entry->kind) {
+    case LINE_BLANK:
+      return EC_OK;
+    case LINE_LABEL:
+      return define_label(program, line + entry->labelStart,
+                          entry->labelLen);
+    case LINE_BRANCH:
+      _status = label_offset(program, line + entry->labelStart,
+                             entry->labelLen, &offset);
+      FAIL_PRED(_status != EC_OK, _status);
+      return emit_word(program, entry->word | (offset & OFFSET_MASK));
+    case LINE_BRANCH_TO:
+      offset = calculate_offset(entry->value, program->mPC);
+      return emit_word(program, entry->word | (offset & OFFSET_MASK));
+    case LINE_LITERAL:
+      _status = add_literal(program, entry->value, program->mPC);
+      FAIL_PRED(_status != EC_OK, _status);
+      return emit_word(program, entry->word);
+    default:
+      return emit_word(program, entry->word);
+  }
+}
+
+/**
+ * Assemble a line from the line cache if it has been seen before, and
+ * otherwise assemble it and add it to the cache
+ *
+ * @param program: pointer to the program state, with a line cache
+ * @param line: start of the line
+ * @param lineEnd: end of the line, before its newline
+ * @return: integer error code to represent success or failure
+ */
+static int assemble_cached_line(assemble_state_t *program, const char *line,
+                                const char *lineEnd) {
+  line_entry_t entry = {.len = lineEnd - line};
+  if (lineEnd - line > UINT16_MAX) {
+    // Too long for the positions of its label to be noted
+    return assemble_line(program, line, lineEnd, &entry);
+  }
+  entry.hash = linecache_hash(line, entry.len);
+  const line_entry_t *cached = linecache_find(program->cache, entry.hash,
+                                              entry.len);
+  if (cached != NULL) {
+    return replay_line(program, line, cached);
+  }
+  int _status = assemble_line(program, line, lineEnd, &entry);
+  FAIL_PRED(_status != EC_OK, _status);
+  return linecache_put(program->cache, &entry);
+}
+
+/**
+ * Assemble the lines between two points of the source into the output, from
+ * the current address of the program on
+ *
+ * @param program: pointer to the program state
+ * @param line: start of the first line
+ * @param end: end of the last line
+ * @return: integer error code to represent success or failure
+ */
+static int assemble_lines(assemble_state_t *program, const char *line,
+                          const char *end) {
+  int _status = EC_OK;
+  line_entry_t entry;
+
+  while (line < end) {
+    const char *newline = memchr(line, '\n', end - line);
+    const char *lineEnd = newline != NULL ? newline : end;
+    if (program->cache != NULL) {
+      _status = assemble_cached_line(program, line, lineEnd);
+    } else {
+      _status = assemble_line(program, line, lineEnd, &entry);
+    }
+    FAIL_PRED(_status != EC_OK, _status);
+    line = newline != NULL ? newline + 1 : end;
+  }
+  return EC_OK;
+}
+
+/**
+ * Note a line of a chunk that is a word, doubling the room for them in the
+ * arena of the chunk as needed
+ *
+ * @param chunk: pointer to the chunk
+ * @param tklst: tokens of the line
+ * @return: integer error code to represent success or failure
+ */
+static int add_scan_word(chunk_t *chunk, token_list_t *tklst) {
+  if (chunk->numWords == chunk->wordCapacity) {
+    size_t capacity = chunk->wordCapacity > 0
+                      ? chunk->wordCapacity * 2 : INITIAL_SCAN_WORDS;
+    scan_word_t *words = arena_alloc(chunk->state->arena,
+                                     capacity * sizeof(scan_word_t));
+    MEM_CHECK(words, EC_NULL_POINTER);
+    if (chunk->numWords > 0) {
+      memcpy(words, chunk->words, chunk->numWords * sizeof(scan_word_t));
     }
-    CHECK_STATUS(_status, program_delete(program));
+    chunk->words = words;
+    chunk->wordCapacity = capacity;
+  }
+  scan_word_t *word = &chunk->words[chunk->numWords++];
+  word->value = 0;
+  word->kind = scan_line(tklst, &word->value);
+  return EC_OK;
+}
 
-    _status = parse(program, &instr);
+/**
+ * First pass of -j over a chunk, noting its words and the word index of
+ * each of its labels. Every line that is not blank or a label is a word.
+ *
+ * @param chunk: pointer to the chunk
+ * @return: integer error code to represent success or failure
+ */
+static int scan_chunk(chunk_t *chunk) {
+  int _status = EC_OK;
+  assemble_state_t *state = chunk->state;
+  for (const char *line = chunk->start; line < chunk->end;) {
+    _status = tokenize_next(state, &line, chunk->end);
     if (_status == EC_SKIP) {
-      _status = EC_OK;
       continue;
     }
-    CHECK_STATUS(_status, program_delete(program));
+    FAIL_PRED(_status != EC_OK, _status);
+
+    if (is_label(state->tklst)) {
+      token_t *label = token_list_get(state->tklst, 0);
+      _status = smap_put(chunk->labels, label->str, label->len,
+                         chunk->numWords);
+    } else {
+      _status = add_scan_word(chunk, state->tklst);
+    }
+    FAIL_PRED(_status != EC_OK, _status);
+  }
+  return EC_OK;
+}
 
-    _status = encode(&instr, &word);
-    CHECK_STATUS(_status, program_delete(program));
+/**
+ * Second pass of -j over a chunk, assembling it into its part of the output
+ *
+ * @param chunk: pointer to the chunk, with its address set
+ * @return: integer error code to represent success or failure
+ */
+static int assemble_chunk(chunk_t *chunk) {
+  chunk->state->mPC = chunk->address;
+  chunk->state->numWords = chunk->firstWord;
+  chunk->state->nextPool = chunk->firstPool;
+  return assemble_lines(chunk->state, chunk->start, chunk->end);
+}
 
-    set_word(program->out, program->mPC, word);
-    program->mPC += 4;
+/**
+ * Thread of -j, running the function of the queue on chunks from it until
+ * none are left
+ *
+ * @param arg: pointer to the chunk queue
+ * @return: NULL
+ */
+static void *run_chunks(void *arg) {
+  chunk_queue_t *queue = arg;
+  int i;
+  while ((i = __atomic_fetch_add(&queue->next, 1, __ATOMIC_SEQ_CST))
+         < queue->numChunks) {
+    queue->chunks[i].status = queue->func(&queue->chunks[i]);
+  }
+  return NULL;
+}
+
+/**
+ * Run a function on every chunk, on a number of threads including this one
+ *
+ * @param chunks: the chunks
+ * @param numChunks: number of chunks
+ * @param func: function to run on each chunk
+ * @param numThreads: number of threads to run it on
+ * @return: status of the first chunk in order that failed, or EC_OK
+ */
+static int run_on_threads(chunk_t *chunks, int numChunks, chunk_func_t func,
+                          int numThreads) {
+  chunk_queue_t queue = {.chunks = chunks, .numChunks = numChunks,
+                         .next = 0, .func = func};
+  pthread_t threads[MAX_THREADS];
+  int numStarted = 0;
+  while (numStarted < numThreads - 1
+         && pthread_create(&threads[numStarted], NULL, run_chunks,
+                           &queue) == 0) {
+    numStarted++;
+  }
+  run_chunks(&queue);
+  for (int i = 0; i < numStarted; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  for (int i = 0; i < numChunks; i++) {
+    if (chunks[i].status != EC_OK) {
+      return chunks[i].status;
+    }
+  }
+  return EC_OK;
+}
+
+/**
+ * Note a pool placed by the first pass of -j at the current address, taking
+ * the words waiting for it, doubling the room for pools as needed
+ *
+ * @param program: pointer to the program state
+ * @param after: words of the program before the pool
+ * @param branchOver: whether the pool is branched over
+ * @return: integer error code to represent success or failure
+ */
+static int add_pool(assemble_state_t *program, size_t after,
+                    bool branchOver) {
+  if (program->numPools == program->poolCapacity) {
+    int capacity = program->poolCapacity > 0
+                   ? program->poolCapacity * 2 : INITIAL_POOLS;
+    pool_t *pools = arena_alloc(program->arena, capacity * sizeof(pool_t));
+    MEM_CHECK(pools, EC_NULL_POINTER);
+    if (program->numPools > 0) {
+      memcpy(pools, program->pools, program->numPools * sizeof(pool_t));
+    }
+    program->pools = pools;
+    program->poolCapacity = capacity;
+  }
+  pool_t *pool = &program->pools[program->numPools];
+  int _status = pool_words(program, &pool->numWords);
+  FAIL_PRED(_status != EC_OK, _status);
+  pool->after = after;
+  pool->address = program->mPC;
+  pool->branchOver = branchOver;
+  pool->numLiterals = program->numLiterals;
+  program->numPools++;
+  program->mPC = pool_end(pool);
+  program->numLiterals = 0;
+  return EC_OK;
+}
+
+/**
+ * Place the literal pools of -j where assembling on one thread would, from
+ * what the first pass noted of each word, and so find the address of every
+ * chunk
+ *
+ * @param program: pointer to the program state, given its pools
+ * @param chunks: the chunks, given their addresses and first words
+ * @param numChunks: number of chunks
+ * @return: integer error code to represent success or failure
+ */
+static int place_pools_ahead(assemble_state_t *program, chunk_t *chunks,
+                             int numChunks) {
+  int _status = EC_OK;
+  size_t numWords = 0;
+  for (int i = 0; i < numChunks; i++) {
+    chunk_t *chunk = &chunks[i];
+    chunk->address = program->mPC;
+    chunk->firstWord = numWords;
+    chunk->firstPool = program->numPools;
+    for (size_t j = 0; j < chunk->numWords; j++) {
+      const scan_word_t *word = &chunk->words[j];
+      if (word->kind == SCAN_LITERAL) {
+        _status = add_literal(program, word->value, program->mPC);
+        FAIL_PRED(_status != EC_OK, _status);
+      }
+      program->mPC += sizeof(word_t);
+      numWords++;
+      bool branchOver;
+      word_t kind = word->kind == SCAN_BRANCH_ALWAYS ? BRANCH_ALWAYS : 0;
+      if (pool_due(program, kind, &branchOver)) {
+        _status = add_pool(program, numWords, branchOver);
+        FAIL_PRED(_status != EC_OK, _status);
+      }
+    }
+  }
+  // The second pass adds the literals again, with the loads of the chunks
+  program->numLiterals = 0;
+  return EC_OK;
+}
+
+/**
+ * Find the address of a word of the program, after the pools the first
+ * pass of -j placed before it
+ *
+ * @param program: pointer to the program state, with its pools
+ * @param index: words of the program before the word
+ * @return: address of the word
+ */
+static address_t word_address(const assemble_state_t *program,
+                              size_t index) {
+  // The last pool before the word, by bisection
+  int low = 0;
+  int high = program->numPools;
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (program->pools[mid].after <= index) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low == 0) {
+    return index * sizeof(word_t);
+  }
+  const pool_t *pool = &program->pools[low - 1];
+  return pool_end(pool) + (index - pool->after) * sizeof(word_t);
+}
+
+/**
+ * Place the pools of -j at the addresses the first pass gave them, each
+ * taking the oldest loads the second pass left waiting, and leave the rest
+ * for the pool after the program
+ *
+ * @param program: pointer to the program state, with the loads of every
+ * chunk
+ * @return: integer error code to represent success or failure
+ */
+static int place_pools(assemble_state_t *program) {
+  int _status = EC_OK;
+  address_t end = program->mPC;
+  int numLiterals = program->numLiterals;
+  for (int i = 0; i < program->numPools; i++) {
+    const pool_t *pool = &program->pools[i];
+    assert(pool->numLiterals <= numLiterals);
+    program->mPC = pool->address;
+    program->numLiterals = pool->numLiterals;
+    _status = place_pool(program, pool->branchOver);
+    FAIL_PRED(_status != EC_OK, _status);
+    program->literals += pool->numLiterals;
+    numLiterals -= pool->numLiterals;
+  }
+  program->mPC = end;
+  program->numLiterals = numLiterals;
+  program->literalCapacity = numLiterals;
+  return EC_OK;
+}
+
+/**
+ * Map function adding a label of a chunk to the map of the program
+ */
+static void merge_label(const label_t label, const address_t val,
+                        const void *obj) {
+  label_merge_t *merge = (label_merge_t *) obj;
+  int _status = smap_put(merge->smap, label, strlen(label),
+                         word_address(merge->program,
+                                      merge->firstWord + val));
+  if (merge->status == EC_OK) {
+    merge->status = _status;
+  }
+}
+
+/**
+ * Map function adding a label a chunk branched to but could not find to
+ * the map of the program, to be reported from there
+ */
+static void merge_undefined(const label_t label, const address_t val,
+                            const void *obj) {
+  label_merge_t *merge = (label_merge_t *) obj;
+  if (smap_intern(merge->smap, label, strlen(label)) == NULL) {
+    merge->status = EC_NULL_POINTER;
+  }
+}
+
+/**
+ * Allocate the state a chunk is assembled in, which shares the labels of
+ * the program
+ *
+ * @param program: pointer to the program state
+ * @param chunk: the chunk, given its map of labels in the new state
+ * @return: pointer to the state of the chunk, or NULL if allocation failed
+ */
+static assemble_state_t *chunk_state_new(assemble_state_t *program,
+                                         chunk_t *chunk) {
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  if (arena == NULL) {
+    return NULL;
+  }
+  assemble_state_t *state = arena_calloc(arena, 1, sizeof(assemble_state_t));
+  if (state == NULL) {
+    arena_delete(arena);
+    return NULL;
+  }
+  state->arena = arena;
+  state->smap = program->smap;
+  state->labelsDefined = true;
+  state->undefined = smap_new(arena, INITIAL_S_MAP_CAPACITY);
+  chunk->labels = smap_new(arena, INITIAL_S_MAP_CAPACITY);
+  state->lineArena = arena_new(ARENA_BLOCK_SIZE);
+  if (state->undefined == NULL || chunk->labels == NULL
+      || state->lineArena == NULL) {
+    program_delete(state);
+    return NULL;
+  }
+  return state;
+}
+
+/**
+ * Free the states of the chunks, which share the output of the program
+ *
+ * @param chunks: the chunks
+ * @param numChunks: number of chunks
+ */
+static void chunks_delete(chunk_t *chunks, int numChunks) {
+  for (int i = 0; i < numChunks; i++) {
+    if (chunks[i].state != NULL) {
+      chunks[i].state->out = NULL;
+      program_delete(chunks[i].state);
+    }
+  }
+  free(chunks);
+}
+
+/**
+ * Split the source into chunks of about the same size, at line ends
+ *
+ * @param src: the source
+ * @param size: number of bytes in the source
+ * @param chunks: the chunks to set the lines of
+ * @param numChunks: number of chunks
+ */
+static void split_chunks(const char *src, size_t size, chunk_t *chunks,
+                         int numChunks) {
+  const char *end = src + size;
+  const char *start = src;
+  for (int i = 0; i < numChunks; i++) {
+    const char *split = src + size * (i + 1) / numChunks;
+    if (split < start) {
+      split = start;
+    }
+    const char *newline = split < end ? memchr(split, '\n', end - split)
+                                      : NULL;
+    chunks[i].start = start;
+    chunks[i].end = newline != NULL && i < numChunks - 1 ? newline + 1 : end;
+    start = chunks[i].end;
+  }
+}
+
+/**
+ * Assemble the source on a number of threads. A first pass over the chunks
+ * notes the words and labels of each, from which the pools are placed as
+ * on one thread, and then the address of every chunk and label is known,
+ * so no chunk depends on any other: each is assembled into its own part of
+ * the output, leaving gaps for the pools, with a state of its own for its
+ * tokens and literals. The literals are then put in the pools in the order
+ * of the chunks.
+ *
+ * @param program: pointer to the program state
+ * @param src: the source
+ * @param size: number of bytes in the source
+ * @param numThreads: number of threads to assemble on
+ * @return: integer error code to represent success or failure
+ */
+static int assemble_parallel(assemble_state_t *program, const char *src,
+                             size_t size, int numThreads) {
+  int _status = EC_OK;
+  int numChunks = numThreads * CHUNKS_PER_THREAD;
+  chunk_t *chunks = calloc(numChunks, sizeof(chunk_t));
+  MEM_CHECK(chunks, EC_NULL_POINTER);
+  split_chunks(src, size, chunks, numChunks);
+  for (int i = 0; i < numChunks; i++) {
+    chunks[i].state = chunk_state_new(program, &chunks[i]);
+    MEM_CHECK_C(chunks[i].state, EC_NULL_POINTER,
+                chunks_delete(chunks, numChunks));
+  }
+
+  _status = run_on_threads(chunks, numChunks, &scan_chunk, numThreads);
+  CHECK_STATUS(_status, chunks_delete(chunks, numChunks));
+  size_t numLabels = 0;
+  for (int i = 0; i < numChunks; i++) {
+    numLabels += chunks[i].labels->count;
+  }
+  _status = smap_reserve(program->smap, numLabels);
+  CHECK_STATUS(_status, chunks_delete(chunks, numChunks));
+  _status = place_pools_ahead(program, chunks, numChunks);
+  CHECK_STATUS(_status, chunks_delete(chunks, numChunks));
+  label_merge_t merge = {.smap = program->smap, .program = program,
+                         .status = EC_OK};
+  for (int i = 0; i < numChunks; i++) {
+    merge.firstWord = chunks[i].firstWord;
+    smap_enum(chunks[i].labels, &merge_label, &merge);
+  }
+  CHECK_STATUS(merge.status, chunks_delete(chunks, numChunks));
+
+  // Every chunk writes to its own part of an output big enough for all
+  _status = reserve_output(program, 0);
+  CHECK_STATUS(_status, chunks_delete(chunks, numChunks));
+  for (int i = 0; i < numChunks; i++) {
+    chunks[i].state->out = program->out;
+    chunks[i].state->outCapacity = program->outCapacity;
+    chunks[i].state->pools = program->pools;
+    chunks[i].state->numPools = program->numPools;
+  }
+  _status = run_on_threads(chunks, numChunks, &assemble_chunk, numThreads);
+  CHECK_STATUS(_status, chunks_delete(chunks, numChunks));
+
+  int numLiterals = 0;
+  for (int i = 0; i < numChunks; i++) {
+    smap_enum_undefined(chunks[i].state->undefined, &merge_undefined, &merge);
+    numLiterals += chunks[i].state->numLiterals;
+  }
+  CHECK_STATUS(merge.status, chunks_delete(chunks, numChunks));
+  program->literals = arena_alloc(program->arena,
+                                  numLiterals * sizeof(wordref_t));
+  MEM_CHECK_C(program->literals, EC_NULL_POINTER,
+              chunks_delete(chunks, numChunks));
+  for (int i = 0; i < numChunks; i++) {
+    assemble_state_t *state = chunks[i].state;
+    if (state->numLiterals > 0) {
+      memcpy(&program->literals[program->numLiterals], state->literals,
+             state->numLiterals * sizeof(wordref_t));
+      program->numLiterals += state->numLiterals;
+    }
+  }
+  program->literalCapacity = numLiterals;
+  chunks_delete(chunks, numChunks);
+  return place_pools(program);
+}
+
+/**
+ * Assemble a source file into a binary file
+ *
+ * @param srcPath: path of the source
+ * @param outPath: path of the binary to write
+ * @param numThreads: number of threads to assemble on, or 0 to assemble on
+ * this one
+ * @param cache: cache of lines assembled before, or NULL
+ * @param stats: whether to print how much was allocated to stderr
+ * @return: integer error code to represent success or failure
+ */
+static int assemble_file(const char *srcPath, const char *outPath,
+                         int numThreads, line_cache_t *cache, bool stats) {
+  int _status = EC_OK;
+  assemble_state_t *program = program_new();
+
+  if (program == NULL) {
+    return EC_NULL_POINTER; // unable to allocate space for program.
+  }
+  program->cache = cache;
+  if (cache != NULL) {
+    cache->hits = 0;
+    cache->misses = 0;
+  }
+  const char *src;
+  size_t size;
+  _status = map_file(srcPath, &src, &size);
+  CHECK_STATUS(_status, program_delete(program));
+
+  //convert each line to binary
+  if (numThreads > 0) {
+    _status = assemble_parallel(program, src, size, numThreads);
+  } else {
+    _status = assemble_lines(program, src, src + size);
+  }
+  unmap_file(src, size);
+  CHECK_STATUS(_status, program_delete(program));
+
+  // Report every undefined label, rather than stopping at the first
+  size_t numUndefined = 0;
+  smap_enum_undefined(program->smap, &report_undefined, &numUndefined);
+  if (numUndefined > 0) {
+    program_delete(program);
+    return EC_INVALID_PARAM;
+  }
+  _status = write_program(outPath, program);
+  if (stats) {
+    fprintf(stderr, "Labels: %d, literals: %d\n",
+            smap_get_count(program->smap), program->numPooled);
+    if (cache != NULL) {
+      fprintf(stderr, "Lines: %zu from the cache, %zu assembled\n",
+              cache->hits, cache->misses);
+    }
+    print_arena_stats(stderr, "Program", program->arena);
+    print_arena_stats(stderr, "Line", program->lineArena);
   }
-  _status = write_program(argv[2], program);
   program_delete(program);
 
   return _status;
 }
+
+/**
+ * Keep only the lines of the source just assembled in the line cache, and
+ * write it to its side file if it has one
+ *
+ * @param cache: the line cache
+ * @param path: path of the side file, or NULL
+ * @return: integer error code to represent success or failure
+ */
+static int update_cache(line_cache_t *cache, const char *path) {
+  int _status = linecache_prune(cache);
+  if (_status != EC_OK || path == NULL) {
+    return _status;
+  }
+  return linecache_save(cache, path);
+}
+
+/**
+ * Get the time a file was last modified
+ *
+ * @param path: path of the file
+ * @param mtime: where to store the time, left as it is if the file is gone
+ */
+static void get_mtime(const char *path, struct timespec *mtime) {
+  struct stat st;
+  if (stat(path, &st) == 0) {
+    *mtime = st.st_mtim;
+  }
+}
+
+/**
+ * Wait until a file has been modified, looking every WATCH_INTERVAL_MS
+ *
+ * @param path: path of the file
+ * @param mtime: time it was last modified, updated when it changes
+ */
+static void wait_for_change(const char *path, struct timespec *mtime) {
+  const struct timespec interval = {
+      .tv_sec = 0, .tv_nsec = WATCH_INTERVAL_MS * 1000000L};
+  struct timespec last = *mtime;
+  while (last.tv_sec == mtime->tv_sec && last.tv_nsec == mtime->tv_nsec) {
+    nanosleep(&interval, NULL);
+    get_mtime(path, mtime);
+  }
+}
+
+/**
+ * Main Assembler Loop
+ *
+ * Takes as arguments the .s file to assemble and the path name of the .bin
+ * file to write out to, optionally with --stats to print how much memory
+ * the assembler allocated to stderr at the end. With -j and a number of
+ * threads, the lines are assembled on that many threads after a first pass
+ * over them for the labels. With --cache and a side file, lines assembled
+ * by the last run are taken from the file, and with --watch the source is
+ * assembled again each time it changes, until the assembler is killed.
+ *
+ */
+int main(int argc, char **argv) {
+  int _status = EC_OK;
+  const char *paths[2];
+  int numPaths = 0;
+  bool stats = false;
+  bool watch = false;
+  const char *cachePath = NULL;
+  int numThreads = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--stats") == 0) {
+      stats = true;
+    } else if (strcmp(argv[i], "--watch") == 0) {
+      watch = true;
+    } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+      cachePath = argv[++i];
+    } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      numThreads = atoi(argv[++i]);
+      if (numThreads < 1 || numThreads > MAX_THREADS) {
+        fprintf(stderr, "-j takes a number of threads from 1 to %d\n",
+                MAX_THREADS);
+        return EC_INVALID_PARAM;
+      }
+    } else if (numPaths < 2) {
+      paths[numPaths++] = argv[i];
+    }
+  }
+  assert(numPaths == 2);
+
+  line_cache_t *cache = NULL;
+  if (cachePath != NULL || watch) {
+    if (numThreads > 0) {
+      fprintf(stderr, "-j cannot be used with --cache or --watch\n");
+      return EC_INVALID_PARAM;
+    }
+    cache = linecache_new();
+    MEM_CHECK(cache, EC_NULL_POINTER);
+    // A missing or invalid side file leaves every line to be assembled
+    if (cachePath != NULL) {
+      linecache_load(cache, cachePath);
+    }
+  }
+
+  struct timespec mtime = {0, 0};
+  get_mtime(paths[0], &mtime);
+  _status = assemble_file(paths[0], paths[1], numThreads, cache, stats);
+  if (_status == EC_OK && cache != NULL) {
+    _status = update_cache(cache, cachePath);
+  }
+
+  while (watch) {
+    wait_for_change(paths[0], &mtime);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    _status = assemble_file(paths[0], paths[1], 0, cache, stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (_status == EC_OK) {
+      fprintf(stderr, "%s: %.1f ms, %zu of %zu lines from the cache\n",
+              paths[1], (end.tv_sec - start.tv_sec) * 1e3
+                        + (end.tv_nsec - start.tv_nsec) / 1e6,
+              cache->hits, cache->hits + cache->misses);
+      _status = update_cache(cache, cachePath);
+    }
+  }
+  linecache_delete(cache);
+
+  return _status;
+}
@@ -1,28 +1,88 @@
 #ifndef ASSEMBLE_H
 #define ASSEMBLE_H
 
+#include <stdbool.h>
 #include "utils/arm.h"
 #include "assemble/symbolmap.h"
-#include "assemble/referencemap.h"
-#include "utils/list.h"
+#include "assemble/tokenizer.h"
+#include "assemble/linecache.h"
+#include "utils/arena.h"
 
-#define LINE_SIZE 512
-#define MAX_LINES 100
+// Starting size of the output, which doubles as needed
+#define INITIAL_OUT_SIZE 4096
+// Size of the blocks of the arena holding the assembler state
+#define PROGRAM_ARENA_BLOCK_SIZE 65536
+// Starting number of literals, which doubles as needed
+#define INITIAL_LITERALS 64
+// With -j, the source is split into this many chunks per thread, so that
+// threads finishing early take more
+#define CHUNKS_PER_THREAD 4
+// Starting number of words noted by the first pass over a chunk, and of
+// pools it places, which double as needed
+#define INITIAL_SCAN_WORDS 256
+#define INITIAL_POOLS 16
+#define MAX_THREADS 256
+// An ldr from the literal pool reaches up to LDR_MAX_OFFSET bytes on from
+// its address + 8, or back with the U bit clear
+#define LDR_MAX_OFFSET 0xFFF
+#define LDR_U_BIT (1 << 23)
+// Top byte of a branch that always goes, after which nothing runs on
+#define BRANCH_ALWAYS 0xEA000000
+#define BRANCH_ALWAYS_MASK 0xFF000000
+// After a branch that always goes, the pool is placed once its oldest load
+// is this many bytes back, rather than waiting to be branched over
+#define POOL_FLUSH_DISTANCE 2048
+// How often --watch looks at the source for changes
+#define WATCH_INTERVAL_MS 10
 
 typedef struct {
   word_t word;
   address_t ref;
 } wordref_t;
 
+// What the first pass of -j notes of a line that is a word, which is all
+// the placement of the literal pools depends on
+typedef enum {
+  SCAN_WORD,
+  SCAN_LITERAL,              // loads value from the literal pool
+  SCAN_BRANCH_ALWAYS         // a branch that always goes
+} scan_kind_t;
+
+typedef struct {
+  word_t value;
+  scan_kind_t kind;
+} scan_word_t;
+
+// A literal pool placed by the first pass of -j, which the second leaves a
+// gap for
+typedef struct {
+  size_t after;              // words of the program before the pool
+  address_t address;         // of the branch over it, or of its first word
+  bool branchOver;
+  int numLiterals;           // loads it takes, the oldest waiting first
+  int numWords;              // values it holds, each once
+} pool_t;
+
 typedef struct {
   byte_t *out;
+  size_t outCapacity;
   symbol_map_t *smap;
-  reference_map_t *rmap;
-  list_t *additional_words;
-  list_t *tklst;
-  char **in;
-  int lines;
+  wordref_t *literals;       // loads of words waiting for the next pool
+  int numLiterals;
+  int literalCapacity;
+  int numPooled;             // words placed in pools, each value once a pool
+  token_list_t *tklst;
+  arena_t *arena;            // holds the state, freed at the end
+  arena_t *lineArena;        // holds the tokens of a line, reset for each
   word_t mPC;
+  bool labelsDefined;        // by a first pass, so label lines are skipped
+  symbol_map_t *undefined;   // labels branched to that the map does not have
+  line_cache_t *cache;       // lines assembled before, or NULL
+  pool_t *pools;             // placed by the first pass of -j, or NULL
+  int numPools;
+  int poolCapacity;
+  int nextPool;              // first pool not yet passed
+  size_t numWords;           // words put in the output, without the pools
 } assemble_state_t;
 
 typedef struct {
@@ -31,4 +91,37 @@ typedef struct {
   address_t addr;
 } prog_collection_t;
 
+// Lines of the source assembled on their own by -j, into their own state
+// and the part of the shared output from the address of their first line
+typedef struct {
+  const char *start;
+  const char *end;
+  address_t address;
+  scan_word_t *words;        // the lines that are words, in order
+  size_t numWords;
+  size_t wordCapacity;
+  size_t firstWord;          // words of the program before the chunk
+  int firstPool;             // pools of the program before the chunk
+  symbol_map_t *labels;      // defined by the lines, as their word index
+  assemble_state_t *state;
+  int status;
+} chunk_t;
+
+typedef int (*chunk_func_t)(chunk_t *chunk);
+
+typedef struct {
+  chunk_t *chunks;
+  int numChunks;
+  int next;                  // chunk for the next thread to take
+  chunk_func_t func;         // run on each chunk
+} chunk_queue_t;
+
+// Labels of a chunk being added to the map of the program
+typedef struct {
+  symbol_map_t *smap;
+  const assemble_state_t *program;
+  size_t firstWord;          // of the chunk
+  int status;
+} label_merge_t;
+
 #endif
@@ -0,0 +1,283 @@
+/*
+ * Contains the line cache, an open addressing table probed linearly from
+ * the hash of the text of a line, which doubles once more than
+ * LINECACHE_MAX_LOAD percent of its slots are in use. An entry is looked up
+ * by the hash and length of a line, as the text itself is not kept.
+ *
+ * The side file holds a header and then the entries, with a checksum of
+ * them in the header. It is written under a temporary name and renamed into
+ * place, so a reader sees either the old file or the new one, and one that
+ * fails validation is ignored, leaving every line to be assembled again.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include "linecache.h"
+#include "../utils/hash.h"
+#include "../utils/error.h"
+
+/**
+ * Hash the text of a line
+ *
+ * @param line: characters of the line, without its newline
+ * @param len: number of characters in the line
+ * @return: 64 bit FNV-1a hash of the line, never 0
+ */
+uint64_t linecache_hash(const char *line, size_t len) {
+  uint64_t hash = fnv1a_64(line, len, FNV_OFFSET_BASIS_64);
+  return hash != 0 ? hash : 1;
+}
+
+/**
+ * Find the slot of a line, or the empty slot it would go in
+ *
+ * @param entries: the slots of the cache
+ * @param capacity: number of slots, a power of two
+ * @param hash: hash of the line
+ * @param len: number of characters in the line
+ * @return: pointer to the slot
+ */
+static line_entry_t *find_slot(line_entry_t *entries, size_t capacity,
+                               uint64_t hash, size_t len) {
+  size_t mask = capacity - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    line_entry_t *entry = &entries[i];
+    if (entry->hash == 0 || (entry->hash == hash && entry->len == len)) {
+      return entry;
+    }
+  }
+}
+
+/**
+ * Move the entries of the cache into a new table, keeping only those that
+ * have been used if asked to
+ *
+ * @param cache: pointer to the cache
+ * @param capacity: number of slots of the new table, a power of two
+ * @param usedOnly: whether to drop the entries not used
+ * @return: error code (see error.h)
+ */
+static int rehash(line_cache_t *cache, size_t capacity, bool usedOnly) {
+  line_entry_t *entries = calloc(capacity, sizeof(line_entry_t));
+  MEM_CHECK(entries, EC_NULL_POINTER);
+  size_t count = 0;
+  for (size_t i = 0; i < cache->capacity; i++) {
+    line_entry_t *entry = &cache->entries[i];
+    if (entry->hash != 0 && (entry->used || !usedOnly)) {
+      *find_slot(entries, capacity, entry->hash, entry->len) = *entry;
+      count++;
+    }
+  }
+  free(cache->entries);
+  cache->entries = entries;
+  cache->capacity = capacity;
+  cache->count = count;
+  return EC_OK;
+}
+
+/**
+ * Allocate an empty line cache
+ *
+ * @return: pointer to the cache, or NULL if allocation failed
+ */
+line_cache_t *linecache_new(void) {
+  line_cache_t *cache = calloc(1, sizeof(line_cache_t));
+  if (cache == NULL) {
+    return NULL;
+  }
+  cache->entries = calloc(INITIAL_LINECACHE_CAPACITY, sizeof(line_entry_t));
+  if (cache->entries == NULL) {
+    free(cache);
+    return NULL;
+  }
+  cache->capacity = INITIAL_LINECACHE_CAPACITY;
+  return cache;
+}
+
+/**
+ * Free a line cache
+ *
+ * @param cache: pointer to the cache, may be NULL
+ */
+void linecache_delete(line_cache_t *cache) {
+  if (cache != NULL) {
+    free(cache->entries);
+    free(cache);
+  }
+}
+
+/**
+ * Find the entry of a line, marking it as used
+ *
+ * @param cache: pointer to the cache
+ * @param hash: hash of the line, from linecache_hash
+ * @param len: number of characters in the line
+ * @return: pointer to the entry, valid until the next line is added, or
+ * NULL if the line is not in the cache
+ */
+const line_entry_t *linecache_find(line_cache_t *cache, uint64_t hash,
+                                   size_t len) {
+  line_entry_t *entry = find_slot(cache->entries, cache->capacity, hash, len);
+  if (entry->hash == 0) {
+    cache->misses++;
+    return NULL;
+  }
+  entry->used = true;
+  cache->hits++;
+  return entry;
+}
+
+/**
+ * Add the entry of a line, or replace the one it has, marked as used
+ *
+ * @param cache: pointer to the cache
+ * @param entry: the entry, with the hash and length of its line
+ * @return: error code (see error.h)
+ */
+int linecache_put(line_cache_t *cache, const line_entry_t *entry) {
+  if (cache == NULL || entry == NULL || entry->hash == 0) {
+    return EC_INVALID_PARAM;
+  }
+  line_entry_t *slot = find_slot(cache->entries, cache->capacity,
+                                 entry->hash, entry->len);
+  if (slot->hash == 0) {
+    if ((cache->count + 1) * 100 > cache->capacity * LINECACHE_MAX_LOAD) {
+      int _status = rehash(cache, cache->capacity << 1, false);
+      if (_status != EC_OK) {
+        return _status;
+      }
+      slot = find_slot(cache->entries, cache->capacity, entry->hash,
+                       entry->len);
+    }
+    cache->count++;
+  }
+  *slot = *entry;
+  slot->used = true;
+  return EC_OK;
+}
+
+/**
+ * Drop the entries of lines not used since the last prune, so the cache
+ * holds those of the source last assembled, and start counting again
+ *
+ * @param cache: pointer to the cache
+ * @return: error code (see error.h)
+ */
+int linecache_prune(line_cache_t *cache) {
+  size_t used = 0;
+  for (size_t i = 0; i < cache->capacity; i++) {
+    used += cache->entries[i].hash != 0 && cache->entries[i].used;
+  }
+  size_t capacity = INITIAL_LINECACHE_CAPACITY;
+  while (used * 100 > capacity * LINECACHE_MAX_LOAD) {
+    capacity <<= 1;
+  }
+  int _status = rehash(cache, capacity, true);
+  if (_status != EC_OK) {
+    return _status;
+  }
+  for (size_t i = 0; i < cache->capacity; i++) {
+    cache->entries[i].used = false;
+  }
+  cache->hits = 0;
+  cache->misses = 0;
+  return EC_OK;
+}
+
+/**
+ * Add the entries of a side file to the cache, as not used yet
+ *
+ * @param cache: pointer to the cache
+ * @param path: path of the side file
+ * @return: error code (see error.h), EC_INVALID_PARAM for a file that
+ * fails validation, from which nothing is added
+ */
+int linecache_load(line_cache_t *cache, const char *path) {
+  FILE *fp = fopen(path, "rb");
+  FAIL_SYS(fp == NULL);
+  linecache_header_t header;
+  if (fread(&header, sizeof(header), 1, fp) != 1
+      || header.magic != LINECACHE_MAGIC
+      || header.entrySize != sizeof(line_entry_t)
+      || header.version != LINECACHE_VERSION) {
+    fclose(fp);
+    return EC_INVALID_PARAM;
+  }
+  line_entry_t *entries = malloc((size_t) header.numEntries
+                                 * sizeof(line_entry_t) + 1);
+  MEM_CHECK_C(entries, EC_NULL_POINTER, fclose(fp));
+  bool valid = fread(entries, sizeof(line_entry_t), header.numEntries, fp)
+               == header.numEntries
+               && fgetc(fp) == EOF
+               && fnv1a_64(entries, header.numEntries * sizeof(line_entry_t),
+                           FNV_OFFSET_BASIS_64) == header.checksum;
+  fclose(fp);
+
+  int _status = valid ? EC_OK : EC_INVALID_PARAM;
+  for (uint32_t i = 0; valid && i < header.numEntries; i++) {
+    if (entries[i].hash == 0) {
+      continue;
+    }
+    if ((_status = linecache_put(cache, &entries[i])) != EC_OK) {
+      break;
+    }
+  }
+  for (size_t i = 0; i < cache->capacity; i++) {
+    cache->entries[i].used = false;
+  }
+  free(entries);
+  return _status;
+}
+
+/**
+ * Write the entries of the cache to a side file
+ *
+ * @param cache: pointer to the cache
+ * @param path: path of the side file, replaced as a whole
+ * @return: error code (see error.h)
+ */
+int linecache_save(const line_cache_t *cache, const char *path) {
+  line_entry_t *entries = malloc(cache->count * sizeof(line_entry_t) + 1);
+  MEM_CHECK(entries, EC_NULL_POINTER);
+  uint32_t numEntries = 0;
+  for (size_t i = 0; i < cache->capacity; i++) {
+    if (cache->entries[i].hash != 0) {
+      entries[numEntries] = cache->entries[i];
+      entries[numEntries].used = false;
+      numEntries++;
+    }
+  }
+  linecache_header_t header = {
+      .magic = LINECACHE_MAGIC, .entrySize = sizeof(line_entry_t),
+      .version = LINECACHE_VERSION, .numEntries = numEntries,
+      .checksum = fnv1a_64(entries, numEntries * sizeof(line_entry_t),
+                           FNV_OFFSET_BASIS_64)};
+
+  char tmp[PATH_MAX];
+  if (snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int) getpid())
+      >= (int) sizeof(tmp)) {
+    free(entries);
+    return EC_INVALID_PARAM;
+  }
+  FILE *fp = fopen(tmp, "wb");
+  if (fp == NULL) {
+    int err = errno;
+    free(entries);
+    return EC_FROM_SYS_ERROR(err);
+  }
+  fwrite(&header, sizeof(header), 1, fp);
+  fwrite(entries, sizeof(line_entry_t), numEntries, fp);
+  free(entries);
+
+  bool failed = ferror(fp);
+  failed |= fclose(fp) != 0;
+  if (failed || rename(tmp, path) != 0) {
+    int err = errno;
+    unlink(tmp);
+    return EC_FROM_SYS_ERROR(err);
+  }
+  return EC_OK;
+}
@@ -0,0 +1,75 @@
+/*
+ *  Cache of what each line of a source assembled to, kept in a side file
+ *  between runs, so that a line seen before is not tokenized, parsed or
+ *  encoded again.
+ */
+
+#ifndef LINECACHE_H
+#define LINECACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../utils/arm.h"
+
+#define LINECACHE_MAGIC 0x4341534c // "LSAC"
+#define LINECACHE_VERSION 1
+// Starting number of slots, a power of two, which doubles as lines are added
+#define INITIAL_LINECACHE_CAPACITY 1024
+// Percentage of slots in use past which the table grows
+#define LINECACHE_MAX_LOAD 70
+
+// What a line assembles to. None of them depends on where the line is, so
+// an entry holds for the same text at any address: the offset of a branch
+// and the literal of a load are filled in each time the line is assembled.
+typedef enum {
+  LINE_BLANK,     // nothing
+  LINE_LABEL,     // defines the label at labelStart
+  LINE_WORD,      // word
+  LINE_BRANCH,    // word, branching to the label at labelStart
+  LINE_BRANCH_TO, // word, branching to the address in value
+  LINE_LITERAL    // word, loading value from the literal pool
+} line_kind_t;
+
+typedef struct {
+  uint64_t hash;       // of the text of the line, 0 for an empty slot
+  uint32_t len;        // of the text of the line
+  word_t word;         // with no offset for a branch
+  word_t value;
+  uint16_t labelStart; // position of the label in the line
+  uint16_t labelLen;
+  uint8_t kind;
+  uint8_t used;        // by the lines assembled since linecache_prune
+  uint8_t pad[6];      // so the entry has no padding of its own
+} line_entry_t;
+
+typedef struct {
+  size_t capacity;     // number of slots, a power of two
+  size_t count;        // slots in use
+  line_entry_t *entries;
+  size_t hits;         // lines found since linecache_prune
+  size_t misses;
+} line_cache_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t entrySize;  // sizeof(line_entry_t) of the writer
+  uint32_t version;
+  uint32_t numEntries;
+  uint64_t checksum;   // of the entries that follow
+} linecache_header_t;
+
+uint64_t linecache_hash(const char *line, size_t len);
+
+line_cache_t *linecache_new(void);
+void linecache_delete(line_cache_t *cache);
+
+const line_entry_t *linecache_find(line_cache_t *cache, uint64_t hash,
+                                   size_t len);
+int linecache_put(line_cache_t *cache, const line_entry_t *entry);
+int linecache_prune(line_cache_t *cache);
+
+int linecache_load(line_cache_t *cache, const char *path);
+int linecache_save(const line_cache_t *cache, const char *path);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * Contains the table of mnemonics, built from the list of bases crossed with
+ * the condition suffixes, and the lookup of a mnemonic in it.
+ */
+
+#include <string.h>
+#include "mnemonic.h"
+
+// Every base with every condition suffix, the first being none
+#define SUFFIXES(X, name, b0, b1, b2, kind, opcode, shift, flag) \
+  X(name, b0, b1, b2, 0, 0, kind, opcode, shift, flag, AL) \
+  X(name ## eq, b0, b1, b2, 'e', 'q', kind, opcode, shift, flag, EQ) \
+  X(name ## ne, b0, b1, b2, 'n', 'e', kind, opcode, shift, flag, NE) \
+  X(name ## ge, b0, b1, b2, 'g', 'e', kind, opcode, shift, flag, GE) \
+  X(name ## lt, b0, b1, b2, 'l', 't', kind, opcode, shift, flag, LT) \
+  X(name ## gt, b0, b1, b2, 'g', 't', kind, opcode, shift, flag, GT) \
+  X(name ## le, b0, b1, b2, 'l', 'e', kind, opcode, shift, flag, LE) \
+  X(name ## al, b0, b1, b2, 'a', 'l', kind, opcode, shift, flag, AL)
+
+#define MNEMONICS(X) \
+  SUFFIXES(X, add, 'a', 'd', 'd', MNEMONIC_DP, ADD, LSL, 0) \
+  SUFFIXES(X, sub, 's', 'u', 'b', MNEMONIC_DP, SUB, LSL, 0) \
+  SUFFIXES(X, rsb, 'r', 's', 'b', MNEMONIC_DP, RSB, LSL, 0) \
+  SUFFIXES(X, and, 'a', 'n', 'd', MNEMONIC_DP, AND, LSL, 0) \
+  SUFFIXES(X, eor, 'e', 'o', 'r', MNEMONIC_DP, EOR, LSL, 0) \
+  SUFFIXES(X, orr, 'o', 'r', 'r', MNEMONIC_DP, ORR, LSL, 0) \
+  SUFFIXES(X, mov, 'm', 'o', 'v', MNEMONIC_DP, MOV, LSL, 0) \
+  SUFFIXES(X, tst, 't', 's', 't', MNEMONIC_DP, TST, LSL, 0) \
+  SUFFIXES(X, teq, 't', 'e', 'q', MNEMONIC_DP, TEQ, LSL, 0) \
+  SUFFIXES(X, cmp, 'c', 'm', 'p', MNEMONIC_DP, CMP, LSL, 0) \
+  SUFFIXES(X, mul, 'm', 'u', 'l', MNEMONIC_MUL, AND, LSL, 0) \
+  SUFFIXES(X, mla, 'm', 'l', 'a', MNEMONIC_MUL, AND, LSL, 1) \
+  SUFFIXES(X, ldr, 'l', 'd', 'r', MNEMONIC_SDT, AND, LSL, 1) \
+  SUFFIXES(X, str, 's', 't', 'r', MNEMONIC_SDT, AND, LSL, 0) \
+  SUFFIXES(X, lsl, 'l', 's', 'l', MNEMONIC_SHIFT, MOV, LSL, 0) \
+  SUFFIXES(X, lsr, 'l', 's', 'r', MNEMONIC_SHIFT, MOV, LSR, 0) \
+  SUFFIXES(X, asr, 'a', 's', 'r', MNEMONIC_SHIFT, MOV, ASR, 0) \
+  SUFFIXES(X, ror, 'r', 'o', 'r', MNEMONIC_SHIFT, MOV, ROR, 0) \
+  SUFFIXES(X, b, 'b', 0, 0, MNEMONIC_BRN, AND, LSL, 0)
+
+#define MNEMONIC_ENTRY(name, b0, b1, b2, s0, s1, kind, opcode, shift, flag, \
+                       cond) \
+  [MNEMONIC_SLOT(b0, b1, b2, s0, s1)] = \
+      {#name, sizeof(#name) - 1, kind, opcode, shift, flag, cond},
+
+// Two mnemonics in one slot would leave one out, which test_mnemonic checks
+static const mnemonic_t mnemonics[MNEMONIC_SLOTS] = {
+    MNEMONICS(MNEMONIC_ENTRY)
+};
+
+/**
+ * Find a mnemonic, with one probe of the table. The only base starting
+ * with b is b itself, so the suffix starts after the first character of a
+ * mnemonic starting with b, and after the third of any other.
+ *
+ * @param str: start of the mnemonic, which need not be NULL terminated
+ * @param len: number of characters in it
+ * @return: pointer to the mnemonic, or NULL if there is none by that name
+ */
+const mnemonic_t *mnemonic_lookup(const char *str, int len) {
+  const byte_t *c = (const byte_t *) str;
+  int baseLen = len > 0 && c[0] == 'b' ? 1 : 3;
+  int suffixLen = len - baseLen;
+  if (suffixLen != 0 && suffixLen != 2) {
+    return NULL;
+  }
+  byte_t b1 = baseLen == 3 ? c[1] : 0;
+  byte_t b2 = baseLen == 3 ? c[2] : 0;
+  byte_t s0 = suffixLen != 0 ? c[baseLen] : 0;
+  byte_t s1 = suffixLen != 0 ? c[baseLen + 1] : 0;
+
+  const mnemonic_t *mnemonic = &mnemonics[MNEMONIC_SLOT(c[0], b1, b2, s0, s1)];
+  if (mnemonic->len != len || memcmp(mnemonic->name, str, len) != 0) {
+    return NULL;
+  }
+  return mnemonic;
+}
@@ -0,0 +1,50 @@
+/*
+ *  Mnemonics of the assembler, each a base such as add or b followed by an
+ *  optional condition suffix. They are found with a perfect hash: a base and
+ *  a suffix each hash to a different value, so together they pick out one
+ *  slot of a table that is filled in as it is compiled.
+ */
+
+#ifndef MNEMONIC_H
+#define MNEMONIC_H
+
+#include "../utils/arm.h"
+
+#define MNEMONIC_BASES 32
+#define MNEMONIC_CONDS 8
+#define MNEMONIC_SLOTS (MNEMONIC_BASES * MNEMONIC_CONDS)
+
+// Perfect over the bases in mnemonic.c, each given as three characters,
+// padded with 0
+#define MNEMONIC_BASE_HASH(c0, c1, c2) \
+  ((((c0) * 10 + (c1) * 2 + (c2) * 35) >> 1) & (MNEMONIC_BASES - 1))
+
+// Minimal and perfect over the condition suffixes, with none as 0, 0
+#define MNEMONIC_COND_HASH(c0, c1) \
+  ((((c0) * 47 + (c1) * 57) >> 2) & (MNEMONIC_CONDS - 1))
+
+#define MNEMONIC_SLOT(b0, b1, b2, s0, s1) \
+  (MNEMONIC_BASE_HASH(b0, b1, b2) * MNEMONIC_CONDS + MNEMONIC_COND_HASH(s0, s1))
+
+typedef enum {
+  MNEMONIC_NONE,    // an empty slot
+  MNEMONIC_DP,
+  MNEMONIC_MUL,
+  MNEMONIC_SDT,
+  MNEMONIC_BRN,
+  MNEMONIC_SHIFT    // such as lsl, a mov of a register shifted by itself
+} mnemonic_kind_t;
+
+typedef struct {
+  const char *name;
+  byte_t len;
+  mnemonic_kind_t kind;
+  opcode_t opcode;      // of a DP instruction
+  shift_type_t shift;   // of a shift
+  flag_t flag;          // A of a MUL, L of an SDT instruction
+  condition_t cond;
+} mnemonic_t;
+
+const mnemonic_t *mnemonic_lookup(const char *str, int len);
+
+#endif
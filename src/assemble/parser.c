@@ -10,97 +10,63 @@
 #include "../assemble.h"
 #include "parser.h"
 #include "tokenizer.h"
+#include "mnemonic.h"
 #include "../utils/io.h"
 #include "../utils/error.h"
 #include "../utils/bitops.h"
 #include "../utils/instructions.h"
 
-const suffix_to_num brn_suffixes[NUM_BRN_SUFFIXES] = {
-    {"eq", 0x0},
-    {"ne", 0x1},
-    {"ge", 0xA},
-    {"lt", 0xB},
-    {"gt", 0xC},
-    {"le", 0xD},
-    {"al", 0xE},
-    {"", 0xE}
+// Handlers of the kinds of mnemonic
+static const parse_func_t parsers[] = {
+    [MNEMONIC_DP] = &parse_dp,
+    [MNEMONIC_MUL] = &parse_mul,
+    [MNEMONIC_SDT] = &parse_sdt,
+    [MNEMONIC_BRN] = &parse_brn,
+    [MNEMONIC_SHIFT] = &parse_shift
 };
 
-const suffix_to_num shifts[NUM_SHIFT_SUFFIXES] = {
-    {"asr", ASR},
-    {"lsl", LSL},
-    {"lsr", LSR},
-    {"ror", ROR}
-};
-
-const opcode_to_parser oplist[NUM_NON_BRANCH_OPS] = {
-    {"add", ADD, &parse_dp},
-    {"sub", SUB, &parse_dp},
-    {"rsb", RSB, &parse_dp},
-    {"and", AND, &parse_dp},
-    {"eor", EOR, &parse_dp},
-    {"orr", ORR, &parse_dp},
-    {"mov", MOV, &parse_dp},
-    {"tst", TST, &parse_dp},
-    {"teq", TEQ, &parse_dp},
-    {"cmp", CMP, &parse_dp},
-
-    {"mul", MOV, &parse_mul},   // Dummy value for opcode_t
-    {"mla", MOV, &parse_mul},   // ...
-
-    {"ldr", MOV, &parse_sdt},   // ...
-    {"str", MOV, &parse_sdt},   // ...
-
-    {"lsl", MOV, &parse_lsl},   // ...
-    {"andeq", MOV, &parse_halt} // ...
-};
-
-
 //// UTILITY FUNCTIONS ////
 
-bool is_label(list_t *tklst) {
+bool is_label(token_list_t *tklst) {
   return token_list_get_type(tklst, tklst->len - 1) == T_LABEL;
 }
 
-char *remove_first_char(char *string) {
-  return (string + 1);
+reg_address_t parse_register(token_list_t *tklst, reg_address_t reg) {
+  return token_list_get_value(tklst, reg);
 }
 
-reg_address_t parse_register(list_t *tklst, reg_address_t reg) {
-  return atoi(remove_first_char(token_list_get_str(tklst, reg)));
+word_t parse_expression(token_list_t *tklst, int idx) {
+  return (word_t) token_list_get_value(tklst, idx);
 }
 
-bool compare_op(char *str, char *opcode) {
-  return strcmp(str, opcode) == 0;
-}
-
-int str_to_enum(char *opcode) {
-  opcode_t op_enum;
-  int isSet = 0;
-  for (int i = 0; i < NUM_NON_BRANCH_OPS; i++) {
-    if (compare_op(opcode, oplist[i].op)) {
-      op_enum = oplist[i].op_enum;
-      isSet = 1;
+/**
+ * Add a word to be placed after the program, doubling the room for them in
+ * the program arena as needed
+ *
+ * @param prog: pointer to the program state
+ * @param word: the word
+ * @param ref: address of the instruction loading it
+ * @return: integer error code based on success of function
+ */
+int add_literal(assemble_state_t *prog, word_t word, address_t ref) {
+  if (prog->numLiterals == prog->literalCapacity) {
+    int capacity = prog->literalCapacity > 0
+                   ? prog->literalCapacity * 2 : INITIAL_LITERALS;
+    wordref_t *literals = arena_alloc(prog->arena,
+                                      capacity * sizeof(wordref_t));
+    if (literals == NULL) {
+      return EC_NULL_POINTER;
     }
+    if (prog->numLiterals > 0) {
+      memcpy(literals, prog->literals, prog->numLiterals * sizeof(wordref_t));
+    }
+    prog->literals = literals;
+    prog->literalCapacity = capacity;
   }
-  if (!isSet) return -1;
-  return op_enum;
-}
-
-word_t parse_expression(list_t *tklst, int idx) {
-  char *str_expr = remove_first_char(token_list_get_str(tklst, idx));
-  return (word_t) strtol(str_expr, NULL, 0);
-}
-
-// Create word-reference pair data structure
-wordref_t *wordref_new(word_t word, address_t ref) {
-  wordref_t *self = malloc(sizeof(wordref_t));
-  if (self == NULL) {
-    return NULL;
-  }
-  self->word = word;
-  self->ref = ref;
-  return self;
+  prog->literals[prog->numLiterals].word = word;
+  prog->literals[prog->numLiterals].ref = ref;
+  prog->numLiterals++;
+  return EC_OK;
 }
 
 //// OPERAND/OFFSET INSTRUCTIONS ////
@@ -142,7 +108,7 @@ int make_rotation(op_rotate_immediate_t *op_rot_imm, word_t value) {
  * @param start: starting index of offset/operand
  * @return: integer error code based on success of function
  */
-int parse_shifted_reg(list_t *tklst, operand_t *op, int start) {
+int parse_shifted_reg(token_list_t *tklst, operand_t *op, int start) {
   int operand_size = tklst->len - start;
 
   // Case 1: <Operand2> := <register>
@@ -165,12 +131,10 @@ int parse_shifted_reg(list_t *tklst, operand_t *op, int start) {
   //Case 2: <register>, <shiftname> <register>
   //      | <register>, <shiftname> <#expression>
   if (operand_size >= 4) {
-    char *shiftname = token_list_get_str(tklst, start + 2);
-    for (int i = 0; i < NUM_SHIFT_SUFFIXES; i++) {
-      if (strcmp(shifts[i].suffix, shiftname) == 0) {
-        op->reg.type = shifts[i].num;
-      }
+    if (token_list_get_type(tklst, start + 2) != T_SHIFT) {
+      return EC_UNSUPPORTED_OP;
     }
+    op->reg.type = token_list_get_value(tklst, start + 2);
     op->reg.rm = parse_register(tklst, start);
 
     // Case 2a: <Operand2> := <register>, <shiftname> <register>
@@ -201,20 +165,13 @@ int parse_shifted_reg(list_t *tklst, operand_t *op, int start) {
  * @param start: starting index of offset/operand
  * @return: integer error code based on success of function
  */
-int parse_operand(list_t *tklst, instruction_t *instr, int start) {
+int parse_operand(token_list_t *tklst, instruction_t *instr, int start) {
   operand_t *op = &instr->i.dp.operand2;
 
   // Case 1: <Operand2> := #expression,
   if (instr->i.dp.I) {
-    char *operand2 = token_list_get_str(tklst, start);
-    // Strip leading hash sign
-    char *strVal = remove_first_char(operand2);
-
-    // Determine the base (hex or decimal) and convert to int
-    uint8_t
-        base = (uint8_t)((strncmp("0x", strVal, 2) == 0) ? HEX_BASE : DEC_BASE);
-
-    uint64_t raw_val = (uint64_t) strtoul(strVal, NULL, base);
+    // The expression is parsed as a hex or decimal number by the tokenizer
+    uint64_t raw_val = (uint64_t) token_list_get_value(tklst, start);
     // Num cannot be represented if it is larger than 32 bits
     uint64_t big_mask = UINT64_MAX - UINT32_MAX;
     if ((raw_val & big_mask) != 0) {
@@ -248,50 +205,58 @@ int parse_operand(list_t *tklst, instruction_t *instr, int start) {
  * Case 6: [Rn],{+/-}Rm{,<shift>
  *
  * @param prog: pointer to the program state
+ * @param mnemonic: the mnemonic of the instruction
  * @param inst: pointer to the Instruction to store information in
  * @param start: starting index of offset/operand
  */
-int parse_offset(assemble_state_t *prog, instruction_t *instr, int start) {
+int parse_offset(assemble_state_t *prog, const mnemonic_t *mnemonic,
+                 instruction_t *instr, int start) {
 
-  int value = 0;
+  word_t value = 0;
   // Case 1: =expr -> Re-execute with mov or ldr
   if (prog->tklst->len == NUM_TOKS_EQ_EXPR) {
     value = parse_expression(prog->tklst, 3);
 
     if (value <= MAX_HEX) {
-      char *immVal = token_list_get_str(prog->tklst, 3);
-      immVal[0] = '#';
-      list_t *mod_tklst = token_list_new();
-      token_list_add_pair(mod_tklst, T_OPCODE, "mov");
+      token_t immVal = *token_list_get(prog->tklst, 3);
+      immVal.type = T_HASH_EXPR;
+      token_list_t *mod_tklst = token_list_new(prog->tklst->arena);
+      if (mod_tklst == NULL) {
+        return EC_NULL_POINTER;
+      }
+      token_list_add_slice(mod_tklst, T_OPCODE, "mov", 3, 0);
       token_list_add(mod_tklst, token_list_get(prog->tklst, 1));
       token_list_add(mod_tklst, token_list_get(prog->tklst, 2));
-      token_list_add_pair(mod_tklst, T_HASH_EXPR, immVal);
+      token_list_add(mod_tklst, &immVal);
 
-      token_list_delete(prog->tklst);
       prog->tklst = mod_tklst;
 
-      return parse_dp(prog, instr);
+      mnemonic_t mov = *mnemonic;
+      mov.kind = MNEMONIC_DP;
+      mov.opcode = MOV;
+      return parse_dp(prog, &mov, instr);
     } else {
-      wordref_t *addon = wordref_new(value, prog->mPC);
-      if (addon == NULL) {
-        return EC_NULL_POINTER;
+      int _status = add_literal(prog, value, prog->mPC);
+      if (_status != EC_OK) {
+        return _status;
       }
-      list_add(prog->additional_words, addon);
 
-      list_t *mod_tklst = token_list_new();
-      token_list_add_pair(mod_tklst, T_OPCODE, "ldr");
+      token_list_t *mod_tklst = token_list_new(prog->tklst->arena);
+      if (mod_tklst == NULL) {
+        return EC_NULL_POINTER;
+      }
+      token_list_add_slice(mod_tklst, T_OPCODE, "ldr", 3, 0);
       token_list_add(mod_tklst, token_list_get(prog->tklst, 1));
       token_list_add(mod_tklst, token_list_get(prog->tklst, 2));
-      token_list_add_pair(mod_tklst, T_L_BRACKET, "[");
-      token_list_add_pair(mod_tklst, T_REGISTER, "r15");
-      token_list_add_pair(mod_tklst, T_COMMA, ",");
-      token_list_add_pair(mod_tklst, T_HASH_EXPR, "#0xFFF");
-      token_list_add_pair(mod_tklst, T_R_BRACKET, "]");
+      token_list_add_slice(mod_tklst, T_L_BRACKET, "[", 1, 0);
+      token_list_add_slice(mod_tklst, T_REGISTER, "r15", 3, REG_N_PC);
+      token_list_add_slice(mod_tklst, T_COMMA, ",", 1, 0);
+      token_list_add_slice(mod_tklst, T_HASH_EXPR, "#0xFFF", 6, 0xFFF);
+      token_list_add_slice(mod_tklst, T_R_BRACKET, "]", 1, 0);
 
-      token_list_delete(prog->tklst);
       prog->tklst = mod_tklst;
 
-      return parse_sdt(prog, instr);
+      return parse_sdt(prog, mnemonic, instr);
     }
   }
   // Case 2: [Rn]
@@ -365,31 +330,28 @@ int parse_offset(assemble_state_t *prog, instruction_t *instr, int start) {
  * Parse a DP instruction
  *
  * @param prog: pointer to the program state
+ * @param mnemonic: the mnemonic of the instruction
  * @param inst: pointer to the Instruction to store information in
  * @return: integer error code based on success of function
  */
-int parse_dp(assemble_state_t *prog, instruction_t *instr) {
-
-  // Get opcode enum
-  char *opcode = token_list_get_str(prog->tklst, 0);
-  opcode_t op_enum = (opcode_t) str_to_enum(opcode);
+int parse_dp(assemble_state_t *prog, const mnemonic_t *mnemonic,
+             instruction_t *instr) {
+  opcode_t op_enum = mnemonic->opcode;
 
   // Set whether the CPSR flags should be set
-  bool S = compare_op(opcode, "tst") || compare_op(opcode, "teq")
-      || compare_op(opcode, "cmp");
+  bool S = op_enum == TST || op_enum == TEQ || op_enum == CMP;
 
   // Set position of rn and position of operand2
-  int rn_pos = S || compare_op(opcode, "mov") ? 1 : 3;
+  int rn_pos = S || op_enum == MOV ? 1 : 3;
 
   // Set all instruction fields
   instr->type = DP;
-  instr->cond = AL_COND_CODE; //0b1110
+  instr->cond = mnemonic->cond;
   instr->i.dp.padding = 0x00;
   instr->i.dp.I = token_list_get_type(prog->tklst, rn_pos + 2) == T_HASH_EXPR;
   instr->i.dp.opcode = op_enum;
   instr->i.dp.S = S;
-  instr->i.dp.rn =
-      compare_op(opcode, "mov") ? 0 : parse_register(prog->tklst, rn_pos);
+  instr->i.dp.rn = op_enum == MOV ? 0 : parse_register(prog->tklst, rn_pos);
   instr->i.dp.rd = S ? 0 : parse_register(prog->tklst, RD_POS);
 
   return parse_operand(prog->tklst, instr, rn_pos + 2);
@@ -399,11 +361,13 @@ int parse_dp(assemble_state_t *prog, instruction_t *instr) {
  * Parse a MUL instruction
  *
  * @param prog: pointer to the program state
+ * @param mnemonic: the mnemonic of the instruction
  * @param inst: pointer to the Instruction to store information in
  * @return: integer error code based on success of function
  */
-int parse_mul(assemble_state_t *prog, instruction_t *inst) {
-  flag_t A = (flag_t) strcmp(token_list_get_str(prog->tklst, 0), "mul");
+int parse_mul(assemble_state_t *prog, const mnemonic_t *mnemonic,
+              instruction_t *inst) {
+  flag_t A = mnemonic->flag;
 
   reg_address_t rd = parse_register(prog->tklst, RD_POS);
   reg_address_t rm = parse_register(prog->tklst, RM_POS);
@@ -411,7 +375,7 @@ int parse_mul(assemble_state_t *prog, instruction_t *inst) {
   reg_address_t rn = A ? parse_register(prog->tklst, RN_POS) : 0;
 
   inst->type = MUL;
-  inst->cond = AL_COND_CODE;
+  inst->cond = mnemonic->cond;
   inst->i.mul.pad0 = 0x0;
   inst->i.mul.A = A;
   inst->i.mul.S = 0x0;
@@ -428,23 +392,20 @@ int parse_mul(assemble_state_t *prog, instruction_t *inst) {
  * Parse an SDT instruction
  *
  * @param prog: pointer to the program state
+ * @param mnemonic: the mnemonic of the instruction
  * @param inst: pointer to the Instruction to store information in
  * @return: integer error code based on success of function
  */
-int parse_sdt(assemble_state_t *prog, instruction_t *instr) {
-  char *opcode = token_list_get_str(prog->tklst, 0);
-  flag_t L = compare_op(opcode, "ldr");
-  if (!L && !compare_op(opcode, "str")) {
-    perror("Opcode not recognised\n");
-  }
+int parse_sdt(assemble_state_t *prog, const mnemonic_t *mnemonic,
+              instruction_t *instr) {
   instr->type = SDT;
-  instr->cond = AL_COND_CODE; //0b1110
-  instr->i.sdt.L = L;
+  instr->cond = mnemonic->cond;
+  instr->i.sdt.L = mnemonic->flag;
   instr->i.sdt.pad1 = 0x1;
   instr->i.sdt.pad0 = 0x0;
   instr->i.sdt.rd = parse_register(prog->tklst, RD_POS);
 
-  return parse_offset(prog, instr, 3);
+  return parse_offset(prog, mnemonic, instr, 3);
 }
 
 /**
@@ -473,6 +434,46 @@ word_t calculate_offset(int32_t address, word_t PC) {
   return shifted_offset.value;
 }
 
+/**
+ * Find the offset of a branch at the current address to a label, or, for a
+ * label not defined yet, join the chain of branches waiting for it
+ *
+ * @param prog: pointer to the program state
+ * @param label: characters of the label, not necessarily NUL terminated
+ * @param len: number of characters in the label
+ * @param offset: where to store the offset, or link, of the branch
+ * @return: integer error code based on success of function
+ */
+int label_offset(assemble_state_t *prog, const char *label, size_t len,
+                 word_t *offset) {
+  if (prog->labelsDefined) {
+    // The map is complete and shared with other threads, so a label it
+    // does not have is only noted, to be reported at the end
+    const symbol_t *symbol = smap_find(prog->smap, label, len);
+    if (symbol == NULL && smap_intern(prog->undefined, label, len) == NULL) {
+      return EC_NULL_POINTER;
+    }
+    *offset = symbol != NULL ? calculate_offset(symbol->address, prog->mPC)
+                             : 0;
+    return EC_OK;
+  }
+
+  symbol_t *symbol = smap_intern(prog->smap, label, len);
+  if (symbol == NULL) {
+    return EC_NULL_POINTER;
+  }
+  if (symbol->defined) {
+    *offset = calculate_offset(symbol->address, prog->mPC);
+  } else {
+    if (FIXUP_LINK(prog->mPC) > OFFSET_MASK) {
+      return EC_UNSUPPORTED_OP;
+    }
+    *offset = symbol->address;
+    symbol->address = FIXUP_LINK(prog->mPC);
+  }
+  return EC_OK;
+}
+
 /**
  * Parse a BRN instruction
  *
@@ -488,33 +489,23 @@ word_t calculate_offset(int32_t address, word_t PC) {
  * in the Offset field.
  *
  * @param prog: pointer to the program state
+ * @param mnemonic: the mnemonic of the instruction
  * @param inst: pointer to the Instruction to store information in
  * @return: integer error code based on success of function
  */
-int parse_brn(assemble_state_t *prog, instruction_t *inst) {
-  // Parse for condition
-  char *suffix = remove_first_char(token_list_get_str(prog->tklst, 0));
-  for (int i = 0; i < NUM_BRN_SUFFIXES; i++) {
-    if (strcmp(brn_suffixes[i].suffix, suffix) == 0) {
-      inst->cond = brn_suffixes[i].num;
-    }
-  }
+int parse_brn(assemble_state_t *prog, const mnemonic_t *mnemonic,
+              instruction_t *inst) {
+  inst->cond = mnemonic->cond;
 
   word_t offset;
-  if (token_list_get_type(prog->tklst, 1) == T_STR) {
-    // Check if label is already in map, if so get address
-    char *label = token_list_get_str(prog->tklst, 1);
-    if (smap_exists(prog->smap, label)) {
-      address_t addr = 0;
-      smap_get_address(prog->smap, label, &addr);
-      offset = calculate_offset(addr, prog->mPC);
-    } else {
-      rmap_put(prog->rmap, label, prog->mPC);
-      offset = 0xFFFFFF; // dummy value
-    }
+  if (token_list_get_type(prog->tklst, 1) != T_STR) {
+    offset = calculate_offset(parse_expression(prog->tklst, 1), prog->mPC);
   } else {
-    offset =
-        calculate_offset(atoi(token_list_get_str(prog->tklst, 0)), prog->mPC);
+    token_t *label = token_list_get(prog->tklst, 1);
+    int _status = label_offset(prog, label->str, label->len, &offset);
+    if (_status != EC_OK) {
+      return _status;
+    }
   }
 
   inst->type = BRN;
@@ -527,81 +518,86 @@ int parse_brn(assemble_state_t *prog, instruction_t *inst) {
 //// SPECIAL INSTRUCTIONS ////
 
 /**
- * Parse a logical shift left instruction
+ * Parse a shift instruction, such as lsl
  *
  * @param prog: pointer to the program state
+ * @param mnemonic: the mnemonic of the instruction
  * @param inst: pointer to the Instruction to store information in
  * @return: integer error code based on success of function
  */
-int parse_lsl(assemble_state_t *prog, instruction_t *inst) {
+int parse_shift(assemble_state_t *prog, const mnemonic_t *mnemonic,
+                instruction_t *inst) {
   //lsl Rn, <expr> === mov Rn, Rn, lsl <expr>
+  if (prog->tklst->len != NUM_TOKS_SHIFT) {
+    return EC_UNSUPPORTED_OP;
+  }
 
-  // Create new instruction in memory, to be parsed by sdt
-  list_t *mod_tklst = token_list_new();
-  token_list_add_pair(mod_tklst, T_OPCODE, "mov");
+  // Create new instruction in memory, to be parsed by dp
+  token_list_t *mod_tklst = token_list_new(prog->tklst->arena);
+  if (mod_tklst == NULL) {
+    return EC_NULL_POINTER;
+  }
+  token_list_add_slice(mod_tklst, T_OPCODE, "mov", 3, 0);
   token_list_add(mod_tklst, token_list_get(prog->tklst, 1));
   token_list_add(mod_tklst, token_list_get(prog->tklst, 2));
   token_list_add(mod_tklst, token_list_get(prog->tklst, 1));
   token_list_add(mod_tklst, token_list_get(prog->tklst, 2));
-  token_list_add_pair(mod_tklst, T_SHIFT, "lsl");
+  token_list_add_slice(mod_tklst, T_SHIFT, mnemonic->name, 3,
+                       mnemonic->shift);
   token_list_add(mod_tklst, token_list_get(prog->tklst, 3));
 
-  token_list_delete(prog->tklst);
   prog->tklst = mod_tklst;
 
-
-  return parse_dp(prog, inst);
+  mnemonic_t mov = *mnemonic;
+  mov.kind = MNEMONIC_DP;
+  mov.opcode = MOV;
+  return parse_dp(prog, &mov, inst);
 }
 
+//// LABEL INSTRUCTIONS ////
+
 /**
- * Parse the HAL instruction
+ * Define a label at the current address, patching the branches that
+ * referred to it before
  *
  * @param prog: pointer to the program state
- * @param inst: pointer to the Instruction to store information in
+ * @param label: characters of the label, not necessarily NUL terminated
+ * @param len: number of characters in the label
  * @return: integer error code based on success of function
  */
-int parse_halt(assemble_state_t *prog, instruction_t *inst) {
-  inst->type = HAL;
-  inst->cond = 0;
-  inst->i.hal.pad0 = 0;
+int define_label(assemble_state_t *prog, const char *label, size_t len) {
+  symbol_t *symbol = smap_intern(prog->smap, label, len);
+  if (symbol == NULL) {
+    return EC_NULL_POINTER;
+  }
+  if (symbol->defined) {
+    return EC_IS_LABEL;
+  }
+  word_t link = symbol->address;
+  symbol->address = prog->mPC;
+  symbol->defined = true;
+
+  while (link != FIXUP_END) {
+    address_t addr = FIXUP_ADDRESS(link);
+    word_t curr;
+    get_word(prog->out, addr, &curr);
+    link = curr & OFFSET_MASK;
+    curr = (curr & ~OFFSET_MASK)
+        | (calculate_offset(prog->mPC, addr) & OFFSET_MASK);
+    set_word(prog->out, addr, curr);
+  }
   return EC_OK;
 }
 
-//// LABEL INSTRUCTIONS ////
-
 /**
- * Parse a line containing a branch with a label
+ * Parse a line containing a label, defining it at the current address
  *
  * @param prog: pointer to the program state
  * @return: integer error code based on success of function
  */
 int parse_label(assemble_state_t *prog) {
-  int _status = EC_OK;
-  char *label = token_list_get_str(prog->tklst, 0);
-  if (smap_exists(prog->smap, label)) {
-    return EC_IS_LABEL;
-  }
-  smap_put(prog->smap, label, prog->mPC);
-  if (rmap_exists(prog->rmap, label)) {
-    int num_references = rmap_get_references(prog->rmap, label, NULL, 0);
-    size_t size_ref = num_references * sizeof(address_t);
-    address_t *addrs = malloc(size_ref);
-    if (addrs == NULL) {
-      perror("parse_label(): malloc failed");
-      return EC_NULL_POINTER;
-    }
-    if ((_status = rmap_get_references(prog->rmap, label, addrs, size_ref))) {
-      return _status;
-    }
-    for (int i = 0; i < num_references; i++) {
-      word_t offset = calculate_offset(prog->mPC, addrs[i]) | 0xFF000000;
-      word_t curr;
-      get_word(prog->out, addrs[i], &curr);
-      curr &= offset;
-      set_word(prog->out, addrs[i], curr);
-    }
-  }
-  return _status;
+  token_t *token = token_list_get(prog->tklst, 0);
+  return define_label(prog, token->str, token->len);
 }
 
 /**
@@ -616,29 +612,47 @@ int parse_label(assemble_state_t *prog) {
 int parse(assemble_state_t *prog, instruction_t *inst) {
   // If the assembly line is a label
   if (is_label(prog->tklst)) {
-    parse_label(prog);
-    return EC_SKIP;
+    if (prog->labelsDefined) {
+      return EC_SKIP;
+    }
+    int _status = parse_label(prog);
+    return _status == EC_OK ? EC_SKIP : _status;
   }
 
-  // Get the pointer to the first token - this will be the opcode
-  char *opcode = token_list_get_str(prog->tklst, 0);
-
-  // Parse a branch instruction and its condition
-  if (!strncmp(opcode, "b", 1)) {
-    return parse_brn(prog, inst);
+  // Find the mnemonic of the first token, with its condition
+  token_t *opcode = token_list_get(prog->tklst, 0);
+  const mnemonic_t *mnemonic = mnemonic_lookup(opcode->str, opcode->len);
+  if (mnemonic != NULL) {
+    return parsers[mnemonic->kind](prog, mnemonic, inst);
   }
 
-  if (!strcmp("lsl", opcode)) {
-    return parse_lsl(prog, inst);
-  }
+  // Throw an error here, unsupported opcode
+  return EC_UNSUPPORTED_OP;
+}
 
-  // Calculate function pointer to parse an instruction from the opcode
-  for (int i = 0; i < NUM_NON_BRANCH_OPS; i++) {
-    if (strcmp(oplist[i].op, opcode) == 0) {
-      return oplist[i].parse_func(prog, inst);
+/**
+ * Find what the placement of the literal pools needs to know of a line of
+ * tokens that is not a label, without parsing it: whether it loads a word
+ * from the pool, as parse_offset makes it, or is a branch that always goes
+ *
+ * @param tklst: tokens of the line
+ * @param value: set to the word loaded, for SCAN_LITERAL
+ * @return: kind of the line, SCAN_WORD for any other
+ */
+scan_kind_t scan_line(token_list_t *tklst, word_t *value) {
+  token_t *opcode = token_list_get(tklst, 0);
+  const mnemonic_t *mnemonic = mnemonic_lookup(opcode->str, opcode->len);
+  if (mnemonic == NULL) {
+    return SCAN_WORD;
+  }
+  if (mnemonic->kind == MNEMONIC_BRN && mnemonic->cond == AL) {
+    return SCAN_BRANCH_ALWAYS;
+  }
+  if (mnemonic->kind == MNEMONIC_SDT && tklst->len == NUM_TOKS_EQ_EXPR) {
+    *value = parse_expression(tklst, 3);
+    if (*value > MAX_HEX) {
+      return SCAN_LITERAL;
     }
   }
-
-  // Throw an error here, unsupported opcode
-  return EC_UNSUPPORTED_OP;
+  return SCAN_WORD;
 }
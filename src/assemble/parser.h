@@ -2,28 +2,15 @@
 #define PARSER_H
 
 #include "tokenizer.h"
+#include "mnemonic.h"
 #include "../assemble.h"
 #include "../utils/instructions.h"
 
-typedef struct {
-  char *suffix;
-  byte_t num;
-} suffix_to_num;
-
-typedef struct {
-  char *op;
-  opcode_t op_enum;
-  int (*parse_func)(assemble_state_t *, instruction_t *);
-} opcode_to_parser;
-
-#define NUM_NON_BRANCH_OPS 16
-#define NUM_BRN_SUFFIXES 8
-#define NUM_SHIFT_SUFFIXES 4
+typedef int (*parse_func_t)(assemble_state_t *, const mnemonic_t *,
+                            instruction_t *);
 
 // Definitions used in aux functions
 #define MAX_ROT_VAL 16
-#define HEX_BASE 16
-#define DEC_BASE 10
 #define MSB_24_START 31
 #define MSB_24_END 8
 
@@ -42,15 +29,34 @@ typedef struct {
 #define NUM_TOKS_PRE_IND_ADDR 6
 #define NUM_TOKS_HASH_EXPR 8
 
-// Definitions used in parse
-#define AL_COND_CODE 0xE
+// Definitions used in parse_shift
+#define NUM_TOKS_SHIFT 4
 
-int parse(assemble_state_t *prog, instruction_t *inst);
+// Definitions used in label_offset and define_label. Until its label is
+// defined, the offset of a branch holds a link to the previous branch to the
+// same label, one more than its word index, or FIXUP_END for the first.
+#define OFFSET_MASK 0xFFFFFF
+#define FIXUP_END 0
+#define FIXUP_LINK(addr) (((addr) >> 2) + 1)
+#define FIXUP_ADDRESS(link) (((link) - 1) << 2)
 
-int parse_dp(assemble_state_t *prog, instruction_t *inst);
-int parse_mul(assemble_state_t *prog, instruction_t *inst);
-int parse_sdt(assemble_state_t *prog, instruction_t *inst);
-int parse_brn(assemble_state_t *prog, instruction_t *inst);
-int parse_lsl(assemble_state_t *prog, instruction_t *inst);
-int parse_halt(assemble_state_t *prog, instruction_t *inst);
+int parse(assemble_state_t *prog, instruction_t *inst);
+bool is_label(token_list_t *tklst);
+int add_literal(assemble_state_t *prog, word_t word, address_t ref);
+int label_offset(assemble_state_t *prog, const char *label, size_t len,
+                 word_t *offset);
+int define_label(assemble_state_t *prog, const char *label, size_t len);
+word_t calculate_offset(int32_t address, word_t PC);
+scan_kind_t scan_line(token_list_t *tklst, word_t *value);
+
+int parse_dp(assemble_state_t *prog, const mnemonic_t *mnemonic,
+             instruction_t *inst);
+int parse_mul(assemble_state_t *prog, const mnemonic_t *mnemonic,
+              instruction_t *inst);
+int parse_sdt(assemble_state_t *prog, const mnemonic_t *mnemonic,
+              instruction_t *inst);
+int parse_brn(assemble_state_t *prog, const mnemonic_t *mnemonic,
+              instruction_t *inst);
+int parse_shift(assemble_state_t *prog, const mnemonic_t *mnemonic,
+                instruction_t *inst);
 #endif
@@ -1,99 +1,191 @@
 /*
  * Contains functions for a symbol map, which associates labels
  * with memory addresses, used when parsing a branch instruction.
+ *
+ * The map is an open addressing table probed linearly, which doubles once
+ * more than S_MAP_MAX_LOAD percent of its slots are in use. The map lives in
+ * an arena given to it, and each label is copied once into the arena, with
+ * its length and hash kept beside it, so growing rehashes nothing and
+ * lookups take slices of the source without allocating. A label referred
+ * to before it is defined gets an entry straight away, marked as not
+ * defined yet.
  */
 
 #include "symbolmap.h"
 #include "../utils/error.h"
+#include "../utils/hash.h"
+
+/**
+ * Hash a label
+ *
+ * @param label: characters of the label, not necessarily NUL terminated
+ * @param len: number of characters in the label
+ * @return: 64 bit FNV-1a hash of the label
+ */
+uint64_t smap_hash(const char *label, size_t len) {
+  return fnv1a_64(label, len, FNV_OFFSET_BASIS_64);
+}
 
-// Based on djb2 by Dan Bernstein
-unsigned long smap_hash(const label_t label) {
-  unsigned long smap_hash = 5381;
-  for (size_t i = 0; i < strlen(label); i++) {
-    smap_hash = ((smap_hash << 5) + smap_hash) + label[i];
+/**
+ * Find the slot a label is in, or the empty slot it would go in
+ *
+ * @param symbols: the slots of the map
+ * @param capacity: number of slots, a power of two
+ * @param label: characters of the label
+ * @param len: number of characters in the label
+ * @param hash: hash of the label
+ * @return: pointer to the slot
+ */
+static symbol_t *find_slot(symbol_t *symbols, size_t capacity,
+                           const char *label, size_t len, uint64_t hash) {
+  size_t mask = capacity - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    symbol_t *symbol = &symbols[i];
+    if (symbol->label == NULL
+        || (symbol->hash == hash && symbol->len == len
+            && memcmp(symbol->label, label, len) == 0)) {
+      return symbol;
+    }
   }
-  return smap_hash;
 }
 
 /**
- * Get a symbol entry in the map from a particular bucket
+ * Double the number of slots, moving every symbol by its cached hash. The
+ * old slots are left in the arena, taking at most as much as the new ones.
  *
- * @param label: string representation of the label
- * @param bucket: pointer to bucket structure containing symbols in bucket
- * @return: corresponding symbol for that label in that bucket.
+ * @param map: pointer to the map
+ * @return: error code (see error.h)
  */
-static symbol_t *get_symbol(sbucket_t *bucket, const label_t label) {
-  size_t n = bucket->count;
-  if (n == 0) {
-    return NULL;
+static int grow(symbol_map_t *map) {
+  size_t capacity = map->capacity << 1;
+  symbol_t *symbols = arena_calloc(map->arena, capacity, sizeof(symbol_t));
+  if (symbols == NULL) {
+    return EC_NULL_POINTER;
   }
-  symbol_t *symbol = bucket->symbols;
-  for (size_t i = 0; i < n; i++) {
+  for (size_t i = 0; i < map->capacity; i++) {
+    symbol_t *symbol = &map->symbols[i];
     if (symbol->label != NULL) {
-      if (strcmp(symbol->label, label) == 0) {
-        return symbol;
-      }
+      *find_slot(symbols, capacity, symbol->label, symbol->len,
+                 symbol->hash) = *symbol;
     }
-    symbol++;
   }
-  return NULL;
+  map->symbols = symbols;
+  map->capacity = capacity;
+  return EC_OK;
 }
 
 /**
- * Allocate memory for symbol map and set capacity
+ * Allocate a symbol map in an arena, where it stays until the arena is
+ * deleted
  *
- * @param capacity: max capacity of the map
+ * @param arena: pointer to the arena
+ * @param capacity: number of slots to start with, rounded up to a power of two
  * @return: pointer to the new smap
  */
-symbol_map_t *smap_new(size_t capacity) {
-  symbol_map_t *map;
-  map = calloc(1, sizeof(symbol_map_t));
+symbol_map_t *smap_new(arena_t *arena, size_t capacity) {
+  symbol_map_t *map = arena_calloc(arena, 1, sizeof(symbol_map_t));
   if (map == NULL) {
     return NULL;
   }
-  map->count = capacity;
-  map->buckets = calloc(map->count, sizeof(sbucket_t));
-  if (map->buckets == NULL) {
-    free(map);
+  map->arena = arena;
+  map->capacity = 1;
+  while (map->capacity < capacity) {
+    map->capacity <<= 1;
+  }
+  map->symbols = arena_calloc(arena, map->capacity, sizeof(symbol_t));
+  if (map->symbols == NULL) {
     return NULL;
   }
   return map;
 }
 
 /**
- * Free up the memory allocated for the map
+ * Make room for a number of labels, so that adding them will not grow the
+ * map again
  *
- * @param map: Pointer to the map
+ * @param map: pointer to the the symbol map object
+ * @param count: number of labels to be added
  * @return: error code (see error.h)
  */
-int smap_delete(symbol_map_t *map) {
+int smap_reserve(symbol_map_t *map, size_t count) {
   if (map == NULL) {
-    return EC_NULL_POINTER;
+    return EC_INVALID_PARAM;
   }
-  sbucket_t *bucket = map->buckets;
-  for (size_t i = 0; i < map->count; i++) {
-    symbol_t *symbol = bucket->symbols;
-    for (size_t j = 0; j < bucket->count; j++) {
-      free(symbol->label);
-      symbol++;
+  int _status = EC_OK;
+  while ((map->count + count) * 100 > map->capacity * S_MAP_MAX_LOAD) {
+    if ((_status = grow(map)) != EC_OK) {
+      return _status;
     }
-    free(bucket->symbols);
-    bucket++;
   }
-  free(map->buckets);
-  free(map);
   return EC_OK;
 }
 
+/**
+ * Get the entry for a label, adding one that is not defined yet if the
+ * label is not in the map
+ *
+ * @param map: pointer to the the symbol map object
+ * @param label: characters of the label, not necessarily NUL terminated
+ * @param len: number of characters in the label
+ * @return: pointer to the entry, valid until the next label is added, or
+ * NULL if it could not be added. The map is not changed for a label already
+ * in it, so threads may look up labels at once.
+ */
+symbol_t *smap_intern(symbol_map_t *map, const char *label, size_t len) {
+  if (map == NULL || label == NULL) {
+    return NULL;
+  }
+  uint64_t hash = smap_hash(label, len);
+  symbol_t *symbol = find_slot(map->symbols, map->capacity, label, len, hash);
+  if (symbol->label != NULL) {
+    return symbol;
+  }
+  if ((map->count + 1) * 100 > map->capacity * S_MAP_MAX_LOAD) {
+    if (grow(map) != EC_OK) {
+      return NULL;
+    }
+    symbol = find_slot(map->symbols, map->capacity, label, len, hash);
+  }
+  symbol->label = arena_strndup(map->arena, label, len);
+  if (symbol->label == NULL) {
+    return NULL;
+  }
+  symbol->len = len;
+  symbol->hash = hash;
+  symbol->address = 0;
+  symbol->defined = false;
+  map->count++;
+  return symbol;
+}
+
+/**
+ * Find the entry for a defined label
+ *
+ * @param map: pointer to the the symbol map object
+ * @param label: characters of the label, not necessarily NUL terminated
+ * @param len: number of characters in the label
+ * @return: pointer to the entry, or NULL if the label is not defined
+ */
+const symbol_t *smap_find(const symbol_map_t *map, const char *label,
+                          size_t len) {
+  if (map == NULL || label == NULL) {
+    return NULL;
+  }
+  symbol_t *symbol = find_slot(map->symbols, map->capacity, label, len,
+                               smap_hash(label, len));
+  return symbol->label != NULL && symbol->defined ? symbol : NULL;
+}
+
 /**
  * Get an address and store it in the given pointer
  *
  * @param map: pointer to the the symbol map object
- * @param label: label object to compare against
+ * @param label: characters of the label, not necessarily NUL terminated
+ * @param len: number of characters in the label
  * @param out: preallocated space for the address to be placed
  * @return: error code (see error.h)
  */
-int smap_get_address(const symbol_map_t *map, const label_t label,
+int smap_get_address(const symbol_map_t *map, const char *label, size_t len,
                      address_t *out) {
   if (map == NULL) {
     return EC_INVALID_PARAM;
@@ -104,9 +196,7 @@ int smap_get_address(const symbol_map_t *map, const label_t label,
   if (out == NULL) {
     return EC_INVALID_PARAM;
   }
-  size_t ind = smap_hash(label) % map->count;
-  sbucket_t *bucket = &(map->buckets[ind]);
-  symbol_t *symbol = get_symbol(bucket, label);
+  const symbol_t *symbol = smap_find(map, label, len);
   if (symbol == NULL) {
     return EC_NULL_POINTER;
   }
@@ -118,34 +208,25 @@ int smap_get_address(const symbol_map_t *map, const label_t label,
  * Check if a label exists in the given map or not
  *
  * @param map: pointer to the the symbol map object
- * @param label: label object to compare against
+ * @param label: characters of the label, not necessarily NUL terminated
+ * @param len: number of characters in the label
  * @return: 1 iff label exists in map
  */
-int smap_exists(const symbol_map_t *map, const label_t label) {
-  if (map == NULL) {
-    return 0;
-  }
-  if (label == NULL) {
-    return 0;
-  }
-  size_t ind = smap_hash(label) % map->count;
-  sbucket_t *bucket = &(map->buckets[ind]);
-  symbol_t *symbol = get_symbol(bucket, label);
-  if (symbol == NULL) {
-    return 0;
-  }
-  return 1;
+int smap_exists(const symbol_map_t *map, const char *label, size_t len) {
+  return smap_find(map, label, len) != NULL;
 }
 
 /**
- * Put a label-address pair as an entry into the map
+ * Put a label-address pair as an entry into the map, interning the label
  *
  * @param map: pointer to the the symbol map object
- * @param label: label to place in the map
+ * @param label: characters of the label, not necessarily NUL terminated
+ * @param len: number of characters in the label
  * @param address: address to enter into the map
- * @return: error code (see error.h)
+ * @return: error code (see error.h), EC_IS_LABEL if the label is already
+ * defined, which is left as it was
  */
-int smap_put(const symbol_map_t *map, const label_t label,
+int smap_put(symbol_map_t *map, const char *label, size_t len,
              const address_t address) {
   if (map == NULL) {
     return EC_INVALID_PARAM;
@@ -153,73 +234,70 @@ int smap_put(const symbol_map_t *map, const label_t label,
   if (label == NULL) {
     return EC_INVALID_PARAM;
   }
-  int label_len = strlen(label) + 1;
-  size_t ind = smap_hash(label) % map->count;
-  sbucket_t *bucket = &(map->buckets[ind]);
-
-  symbol_t *symbol;
-  if ((symbol = get_symbol(bucket, label)) != NULL) {
-    symbol->address = address;
-    return EC_NULL_POINTER;
-  }
-  label_t new_label = malloc(label_len);
-  if (new_label == NULL) {
+  symbol_t *symbol = smap_intern(map, label, len);
+  if (symbol == NULL) {
     return EC_NULL_POINTER;
   }
-  address_t new_address = address;
-  if (bucket->count == 0) {
-    bucket->symbols = malloc(sizeof(symbol_t));
-    if (bucket->symbols == NULL) {
-      free(new_label);
-      return EC_NULL_POINTER;
-    }
-    bucket->count = 1;
-  } else {
-    bucket->count += 1;
-    symbol_t *tmp_symbols =
-        realloc(bucket->symbols, bucket->count * sizeof(symbol_t));
-    if (tmp_symbols == NULL) {
-      free(new_label);
-      bucket->count -= 1;
-      return EC_NULL_POINTER;
-    }
-    bucket->symbols = tmp_symbols;
+  if (symbol->defined) {
+    return EC_IS_LABEL;
   }
-  symbol = &(bucket->symbols[bucket->count - 1]);
-  symbol->label = new_label;
-  memcpy(symbol->label, label, label_len);
-  symbol->address = new_address;
+  symbol->address = address;
+  symbol->defined = true;
   return EC_OK;
 }
 
 /**
- * Enumerate through each label-address pair and apply the map function
- * to the entry with the object for return/side-effects.
+ * Apply a map function to each entry that is, or is not, defined
  *
  * @param map: Pointer to the the symbol map object
  * @param func: void function that takes a label, address and object params
  * @param obj: The object to pass around to each func. Can be null.
+ * @param defined: whether to enumerate the defined entries or the others
  * @return: error code (see error.h)
  */
-int smap_enum(symbol_map_t *map, map_func_t func, const void *obj) {
+static int enum_symbols(symbol_map_t *map, map_func_t func, const void *obj,
+                        bool defined) {
   if (map == NULL) {
     return EC_INVALID_PARAM;
   }
   if (func == NULL) {
     return EC_INVALID_PARAM;
   }
-  sbucket_t *bucket = map->buckets;
-  for (size_t i = 0; i < map->count; i++) {
-    symbol_t *symbol = bucket->symbols;
-    for (size_t j = 0; j < bucket->count; j++) {
+  for (size_t i = 0; i < map->capacity; i++) {
+    symbol_t *symbol = &map->symbols[i];
+    if (symbol->label != NULL && symbol->defined == defined) {
       func(symbol->label, symbol->address, obj);
-      symbol++;
     }
-    bucket++;
   }
   return EC_OK;
 }
 
+/**
+ * Enumerate through each label-address pair and apply the map function
+ * to the entry with the object for return/side-effects.
+ *
+ * @param map: Pointer to the the symbol map object
+ * @param func: void function that takes a label, address and object params
+ * @param obj: The object to pass around to each func. Can be null.
+ * @return: error code (see error.h)
+ */
+int smap_enum(symbol_map_t *map, map_func_t func, const void *obj) {
+  return enum_symbols(map, func, obj, true);
+}
+
+/**
+ * Enumerate through each label that has been referred to but not defined,
+ * passing the head of its chain of references as the address
+ *
+ * @param map: Pointer to the the symbol map object
+ * @param func: void function that takes a label, address and object params
+ * @param obj: The object to pass around to each func. Can be null.
+ * @return: error code (see error.h)
+ */
+int smap_enum_undefined(symbol_map_t *map, map_func_t func, const void *obj) {
+  return enum_symbols(map, func, obj, false);
+}
+
 /**
  * Simple map function that takes a pointer to a size_t object and increments it
  */
@@ -230,7 +308,8 @@ void smap_count_func(const label_t label, const address_t val,
 }
 
 /**
- * Apply the smap_count_func to each entry to get a total count of entries
+ * Apply the smap_count_func to each entry to get a total count of the
+ * defined labels
  *
  * @param map: pointer to the the symbol map object
  * @return: integer for the total count of the map objects
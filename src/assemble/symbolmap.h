@@ -1,44 +1,56 @@
 #ifndef SYMBOL_MAP_H
 #define SYMBOL_MAP_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "../utils/arm.h"
+#include "../utils/arena.h"
 
-#define MAX_S_MAP_CAPACITY 20
+// Starting number of slots, a power of two, which doubles as labels are added
+#define INITIAL_S_MAP_CAPACITY 64
+// Percentage of slots in use past which the table grows
+#define S_MAP_MAX_LOAD 70
 
 typedef char *label_t;
 typedef void (*map_func_t)(const label_t label, const address_t val,
                            const void *obj);
 
+// A label that has been referred to but not defined yet has as its address
+// the head of the chain of branches waiting for it (see parser.c)
 typedef struct {
-  label_t label;
+  label_t label;              // interned in the map, NULL for an empty slot
+  size_t len;
+  uint64_t hash;
   address_t address;
+  bool defined;
 } symbol_t;
 
 typedef struct {
-  size_t count;
+  size_t capacity;            // number of slots, a power of two
+  size_t count;               // slots in use
   symbol_t *symbols;
-} sbucket_t;
-
-typedef struct {
-  size_t count;
-  sbucket_t *buckets;
+  arena_t *arena;             // holds the map and its interned labels
 } symbol_map_t;
 
-unsigned long smap_hash(const label_t label);
+uint64_t smap_hash(const char *label, size_t len);
 
-symbol_map_t *smap_new(size_t capacity);
-int smap_delete(symbol_map_t *map);
+symbol_map_t *smap_new(arena_t *arena, size_t capacity);
 
-int smap_get_address(const symbol_map_t *map, const label_t label,
+int smap_reserve(symbol_map_t *map, size_t count);
+symbol_t *smap_intern(symbol_map_t *map, const char *label, size_t len);
+const symbol_t *smap_find(const symbol_map_t *map, const char *label,
+                          size_t len);
+int smap_get_address(const symbol_map_t *map, const char *label, size_t len,
                      address_t *out);
-int smap_exists(const symbol_map_t *map, const label_t label);
-int smap_put(const symbol_map_t *map, const label_t label,
+int smap_exists(const symbol_map_t *map, const char *label, size_t len);
+int smap_put(symbol_map_t *map, const char *label, size_t len,
              const address_t address);
 
 int smap_get_count(symbol_map_t *map);
 
 int smap_enum(symbol_map_t *map, map_func_t func, const void *obj);
+int smap_enum_undefined(symbol_map_t *map, map_func_t func, const void *obj);
 
 #endif
@@ -1,6 +1,7 @@
 /*
  * Contains function tokenize which takes in a program line and stores an array
- * of substrings (tokens) such as ["mov', "r2" ,",", "\#1"] for parsing.
+ * of tokens such as ["mov', "r2" ,",", "\#1"] for parsing. Each token is a
+ * slice of the line, found in a single pass over it.
  */
 
 #include <stdio.h>
@@ -9,217 +10,282 @@
 #include <assert.h>
 #include "../utils/arm.h"//EC
 #include "tokenizer.h"
+#include "mnemonic.h"
 #include "../utils/error.h"
 
+// Character classes of the lexer
+#define CLASS_WORD 0    // part of a word
+#define CLASS_SPACE 1   // between tokens
+#define CLASS_PUNCT 2   // a token of its own
+#define CLASS_SIGN 3    // a token of its own at the start of one, else a word
+
+#define SHIFT_NAME_LEN 3
+
+static const byte_t charClass[256] = {
+    [' '] = CLASS_SPACE,
+    ['\t'] = CLASS_SPACE,
+    ['\r'] = CLASS_SPACE,
+    ['\n'] = CLASS_SPACE,
+    [','] = CLASS_PUNCT,
+    ['['] = CLASS_PUNCT,
+    [']'] = CLASS_PUNCT,
+    [':'] = CLASS_PUNCT,
+    ['+'] = CLASS_SIGN,
+    ['-'] = CLASS_SIGN
+};
+
 /**
- * Determine token type by first character for all types except opcode
+ * Determine the type of a token of one character
  *
- * @param src: source string
- * @return: integer associated with token type enum value
+ * @param c: the character, of class CLASS_PUNCT or CLASS_SIGN
+ * @return: type of the token
  */
-int token_type(char *src) {
-  switch (src[0]) {
-    case '+':
-      return T_PLUS;
-    case '-':
-      return T_MINUS;
+static token_type_t punct_type(char c) {
+  switch (c) {
     case ',':
       return T_COMMA;
     case '[':
       return T_L_BRACKET;
     case ']':
       return T_R_BRACKET;
-    case '=':
-      return T_EQ_EXPR;
-    case '#':
-      return T_HASH_EXPR;
     case ':':
       return T_LABEL;
-    case 'r':
-      return T_REGISTER;
-  }
-
-  if (!strcmp(src, "asr") || !strcmp(src, "lsl")
-      || !strcmp(src, "lsr") || !strcmp(src, "ror")) {
-    return T_SHIFT;
+    case '+':
+      return T_PLUS;
+    default:
+      return T_MINUS;
   }
-  return T_STR;
 }
 
-
 /**
- * Skip separator characters and build a list of strings which are tokens
- * (for use in tokenize)
+ * Parse a decimal or 0x prefixed hexadecimal number, with an optional sign,
+ * stopping at the first character that is not a digit
  *
- * @param src: source string. Assumes NULL terminated string
- * @param sep: char separator
- * @param ouput: location in memory to store the separated sublists
- * @return: number of tokens found
+ * @param str: start of the number
+ * @param len: number of characters it may take up
+ * @return: value of the number
  */
-int str_separate(char *src, char *tokens, char sep, char ***output) {
-  assert(src != NULL && output != NULL);
-
-  int len = strlen(src);
-  if (len == 0) {
-    return 0;
+static int64_t lex_number(const char *str, int len) {
+  int i = 0;
+  bool negative = false;
+  if (i < len && (str[i] == '-' || str[i] == '+')) {
+    negative = str[i] == '-';
+    i++;
   }
-  // Loops through src to count number of tokens needed
-  int splits = 0;
-  int noSpaces = 0;
-  for (int i = 0; i < len; i++) {
-    if (strchr(tokens, src[i])) {
-      splits++;
-      if ((i + 1 < len) && src[i + 1] != sep
-          && !strchr(tokens, src[i + 1])) { //
-        splits++;
+  uint64_t value = 0;
+  if (i + 1 < len && str[i] == '0'
+      && (str[i + 1] == 'x' || str[i + 1] == 'X')) {
+    for (i += 2; i < len; i++) {
+      char c = str[i];
+      if (c >= '0' && c <= '9') {
+        value = value * 16 + (c - '0');
+      } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+        value = value * 16 + ((c | 0x20) - 'a' + 10);
+      } else {
+        break;
       }
     }
-    if (src[i] == sep) {
-      noSpaces++;
-      if ((i + 1 < len) && src[i + 1] != sep && !strchr(tokens, src[i + 1])) {
-        splits++;
-      }
+  } else {
+    for (; i < len && str[i] >= '0' && str[i] <= '9'; i++) {
+      value = value * 10 + (str[i] - '0');
     }
   }
-  int n = splits + 1;
-  *output = malloc(n * sizeof(char *)); // Allocated memory for 2D array outer
-  if (*output == NULL) {
-    return -EC_NULL_POINTER;
-  }
-  char **currentpart = *output;
-  int mem_size = len + n - noSpaces;
-  char *mem = calloc(mem_size, sizeof(char)); // Allocate memory for inner array
-  if (mem == NULL) {
-    return -EC_NULL_POINTER;
-  }
+  return negative ? -(int64_t) value : (int64_t) value;
+}
 
-  // Loop through source and place in correct position in mem
-  int j = 0;
-  for (int i = 0; i < len; i++) {
-    if (src[i] == sep) { //Sep
-      if (src[i - 1] != sep) {
-        j++;
+/**
+ * Determine the type of a word that is not an opcode from its characters,
+ * and parse its value
+ *
+ * @param token: the token, with its slice set
+ */
+static void lex_word(token_t *token) {
+  const char *str = token->str;
+  int len = token->len;
+  token->value = 0;
+  switch (str[0]) {
+    case '#':
+      token->type = T_HASH_EXPR;
+      token->value = lex_number(str + 1, len - 1);
+      return;
+    case '=':
+      token->type = T_EQ_EXPR;
+      token->value = lex_number(str + 1, len - 1);
+      return;
+    case 'r':
+      if ((len == 2 && str[1] >= '0' && str[1] <= '9')
+          || (len == 3 && str[1] == '1' && str[2] >= '0' && str[2] <= '5')) {
+        token->type = T_REGISTER;
+        token->value = lex_number(str + 1, len - 1);
+        return;
       }
-      continue;
-    }
-    mem[j] = src[i];
-    j++;
-    if (strchr(tokens, src[i]) && src[i + 1] != sep) { //Token
-      j++;
-    } else if (strchr(tokens, src[i + 1])) {
-      j++;
-    }
   }
 
-  // Allocated outer pointers to correct position in memory
-  *currentpart = mem;
-
-  for (int j = 0; j < mem_size - 1; j++) {
-    if (mem[j] == '\0') {
-      currentpart++;
-      *currentpart = &mem[j + 1];
-    }
+  // A shift name is the mnemonic of the shift, without a condition
+  const mnemonic_t *mnemonic = mnemonic_lookup(str, len);
+  if (mnemonic != NULL && mnemonic->kind == MNEMONIC_SHIFT
+      && mnemonic->cond == AL && len == SHIFT_NAME_LEN) {
+    token->type = T_SHIFT;
+    token->value = mnemonic->shift;
+    return;
   }
-  return n;
+  token->type = T_STR;
 }
 
-//// Create and Remove Tokens in Memory ////
+//// Token List Utility Functions ////
 
-token_t *token_new(token_type_t type, char *str) {
-  token_t *tkn = malloc(sizeof(token_t));
-  if (tkn == NULL) {
+/**
+ * Create an empty list of tokens in an arena, which holds it until reset
+ *
+ * @param arena: arena to allocate the list and its array from
+ * @return: pointer to the list, or NULL if allocation failed
+ */
+token_list_t *token_list_new(arena_t *arena) {
+  token_list_t *self = arena_alloc(arena, sizeof(token_list_t));
+  if (self == NULL) {
     return NULL;
   }
-  tkn->type = type;
-  tkn->str = strdup(str);
-  return tkn;
-}
-
-void token_free(void *obj) {
-  token_t *tkn = (token_t *) obj;
-  if (tkn) {
-    free(tkn->str);
+  self->tokens = arena_alloc(arena, INITIAL_TOKENS * sizeof(token_t));
+  if (self->tokens == NULL) {
+    return NULL;
   }
-  free(tkn);
+  self->len = 0;
+  self->capacity = INITIAL_TOKENS;
+  self->arena = arena;
+  return self;
 }
 
-//// Token List Utility Functions ////
-
-list_t *token_list_new(void) {
-  return list_new(&token_free);
-}
-
-void token_list_delete(list_t *self) {
-  list_delete(self);
+/**
+ * Add a copy of a token to the end of a list. The string is not copied,
+ * and must live as long as the arena of the list.
+ *
+ * @param self: pointer to the list
+ * @param token: the token
+ * @return: integer error code based on success of function
+ */
+int token_list_add(token_list_t *self, const token_t *token) {
+  if (self->len == self->capacity) {
+    token_t *tokens = arena_alloc(self->arena,
+                                  2 * self->capacity * sizeof(token_t));
+    if (tokens == NULL) {
+      return EC_NULL_POINTER;
+    }
+    memcpy(tokens, self->tokens, self->len * sizeof(token_t));
+    self->tokens = tokens;
+    self->capacity *= 2;
+  }
+  self->tokens[self->len++] = *token;
+  return EC_OK;
 }
 
-int token_list_add(list_t *self, token_t *token) {
-  return token_list_add_pair(self, token->type, token->str);
+int token_list_add_slice(token_list_t *self, token_type_t type,
+                         const char *str, int len, int64_t value) {
+  token_t token = {.type = type, .str = str, .len = len, .value = value};
+  return token_list_add(self, &token);
 }
 
-int token_list_add_pair(list_t *self, token_type_t type, char *str) {
-  return list_add(self, token_new(type, str));
+token_t *token_list_get(token_list_t *self, int idx) {
+  assert(idx >= 0 && idx < self->len);
+  return &self->tokens[idx];
 }
 
-token_t *token_list_get(list_t *self, int idx) {
-  return (token_t *) list_get(self, idx);
+token_type_t token_list_get_type(token_list_t *self, int idx) {
+  return token_list_get(self, idx)->type;
 }
 
-token_type_t token_list_get_type(list_t *self, int idx) {
-  return token_list_get(self, idx)->type;
+int64_t token_list_get_value(token_list_t *self, int idx) {
+  return token_list_get(self, idx)->value;
 }
 
-char *token_list_get_str(list_t *self, int idx) {
-  return token_list_get(self, idx)->str;
+/**
+ * Copy the string of a token into the arena of the list
+ *
+ * @param self: pointer to the list
+ * @param idx: index of the token
+ * @return: the NULL terminated copy, or NULL if allocation failed
+ */
+char *token_list_dup_str(token_list_t *self, int idx) {
+  token_t *token = token_list_get(self, idx);
+  return arena_strndup(self->arena, token->str, token->len);
 }
 
-int token_list_remove(list_t *self, int idx) {
-  return list_remove(self, idx);
+/**
+ * Compare the string of a token with a NULL terminated string
+ *
+ * @param token: the token
+ * @param str: the string
+ * @return: true iff they are the same
+ */
+bool token_equals(const token_t *token, const char *str) {
+  return strncmp(token->str, str, token->len) == 0 && str[token->len] == '\0';
 }
 
-void token_list_print(list_t *tklst) {
+void token_list_print(token_list_t *tklst) {
   printf("Tokens (%u)\n", tklst->len);
   for (int i = 0; i < tklst->len; i++) {
-    printf("%u(T:%u): %s\n",
-           i,
-           token_list_get_type(tklst, i),
-           token_list_get_str(tklst, i));
+    token_t *token = token_list_get(tklst, i);
+    printf("%u(T:%u): %.*s\n", i, token->type, token->len, token->str);
   }
 }
 
 /**
- * Use str_separate to build a list of tokens in the current line
+ * Build a list of the tokens in a line, in one pass over it. The tokens
+ * point into the line, and they and the list are allocated from the arena,
+ * so there is nothing to free, and they last until the arena is reset.
  *
- * @param line: current line of assembly
- * @param tkns: empty list of tokens
+ * @param line: start of the line of assembly, which is not NULL terminated
+ * @param end: end of the line
+ * @param arena: arena to allocate the tokens from
+ * @param tkns: set to the list of tokens
  * @return: integer error code based on success of function
  */
-int tokenize(char *line, list_t **tkns) {
+int tokenize(const char *line, const char *end, arena_t *arena,
+             token_list_t **tkns) {
   assert(tkns != NULL);
 
-  char **token_strs = NULL;
-
-  line[strcspn(line, "\r\n")] = 0; //Ends new line
+  token_list_t *self = NULL;
+  const char *c = line;
+  while (c < end) {
+    byte_t class = charClass[(byte_t) *c];
+    if (class == CLASS_SPACE) {
+      c++;
+      continue;
+    }
+    if (self == NULL) {
+      self = token_list_new(arena);
+      if (self == NULL) {
+        return EC_NULL_POINTER;
+      }
+    }
 
-  int n = str_separate(line, "[],:", ' ', &token_strs);
-  if (n == 0) {
-    return EC_SKIP;
-  }
-  if (*tkns != NULL) {
-    token_list_delete(*tkns);
-  }
-  *tkns = token_list_new();
-  if (*tkns == NULL) {
-    return EC_NULL_POINTER;
+    token_t token = {.str = c};
+    if (class == CLASS_PUNCT || class == CLASS_SIGN) {
+      token.type = punct_type(*c);
+      token.len = 1;
+      token.value = 0;
+      c++;
+    } else {
+      do {
+        c++;
+      } while (c < end && (charClass[(byte_t) *c] == CLASS_WORD
+                           || charClass[(byte_t) *c] == CLASS_SIGN));
+      token.len = c - token.str;
+      if (self->len == 0) {
+        token.type = T_OPCODE;
+        token.value = 0;
+      } else {
+        lex_word(&token);
+      }
+    }
+    int _status = token_list_add(self, &token);
+    if (_status != EC_OK) {
+      return _status;
+    }
   }
 
-  token_list_add_pair(*tkns, T_OPCODE, token_strs[0]);
-
-  for (int i = 1; i < n; i++) {
-    token_list_add_pair(*tkns, token_type(token_strs[i]), token_strs[i]);
+  if (self == NULL) {
+    return EC_SKIP;
   }
-  free(token_strs[0]);
-  free(token_strs);
-
+  *tkns = self;
   return EC_OK;
 }
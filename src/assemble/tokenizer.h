@@ -1,7 +1,11 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
-#include "../utils/list.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "../utils/arena.h"
+
+#define INITIAL_TOKENS 16
 
 typedef enum {
   T_OPCODE,
@@ -18,25 +22,38 @@ typedef enum {
   T_STR,
 } token_type_t;
 
+// A token is a slice of the source, which is not NULL terminated. Registers,
+// expressions and shifts are parsed as they are read, into value.
 typedef struct {
   token_type_t type;
-  char *str;
+  const char *str;
+  int len;
+  int64_t value;    // register number, expression value or shift_type_t
 } token_t;
 
-int str_separate(char *src, char *tokens, char sep, char ***output);
+// Tokens of a line, in an array allocated from the arena of the line
+typedef struct {
+  token_t *tokens;
+  int len;
+  int capacity;
+  arena_t *arena;
+} token_list_t;
 
 // List Construction
-list_t *token_list_new(void);
-void token_list_delete(list_t *self);
-
-void token_list_print(list_t *tklst);
-int token_list_add(list_t *self, token_t *token);
-int token_list_add_pair(list_t *self, token_type_t type, char *str);
-token_t *token_list_get(list_t *self, int idx);
-token_type_t token_list_get_type(list_t *self, int idx);
-char *token_list_get_str(list_t *self, int idx);
-int token_list_remove(list_t *self, int idx);
-
-int tokenize(char *line, list_t **tkns);
+token_list_t *token_list_new(arena_t *arena);
+
+void token_list_print(token_list_t *tklst);
+int token_list_add(token_list_t *self, const token_t *token);
+int token_list_add_slice(token_list_t *self, token_type_t type,
+                         const char *str, int len, int64_t value);
+token_t *token_list_get(token_list_t *self, int idx);
+token_type_t token_list_get_type(token_list_t *self, int idx);
+int64_t token_list_get_value(token_list_t *self, int idx);
+char *token_list_dup_str(token_list_t *self, int idx);
+
+bool token_equals(const token_t *token, const char *str);
+
+int tokenize(const char *line, const char *end, arena_t *arena,
+             token_list_t **tkns);
 
 #endif
@@ -3,73 +3,308 @@
  * executing them until the halt instruction or end of memory is reached.
  */
 
+#include <string.h>
+#include <unistd.h>
 #include "emulate.h"
 
 /**
- * Allocate space on the heap for the emulator state
+ * Run from the instruction in the pipeline until the halt, then execute it
  *
- * @return: heap-allocated emulate_state_t struct
+ * @param state: pointer to the machine state, with its pipeline filled
+ * @return: integer error code of the first instruction to fail, or of the halt
  */
-static emulate_state_t *emulate_state_new() {
-  emulate_state_t *state = calloc(1, sizeof(emulate_state_t));
-  MEM_CHECK(state, NULL);
-  state->pipeline.decoded = calloc(1, sizeof(instruction_t));
-  MEM_CHECK(state->pipeline.decoded, NULL);
-  state->pipeline.fetched = calloc(1, sizeof(word_t));
-  MEM_CHECK(state->pipeline.fetched, NULL);
+static int run(emulate_state_t *state) {
+  int _status = execute_program(state);
+  // Output of the guest comes before its final state
+  uart_flush(state->uart);
+  FAIL_PRED(_status != EC_OK, _status);
+  return execute(state);
+}
+
+/**
+ * Load a binary into a new machine state
+ *
+ * @param binary: path of the binary file
+ * @param cacheDir: directory to cache decoded binaries in, or NULL
+ * @param trace: whether hot loops run as traces
+ * @param state: set to the new machine state
+ * @return: integer error code based on success of the function
+ */
+static int load(const char *binary, const char *cacheDir, bool trace,
+                emulate_state_t **state) {
+  *state = emulate_state_new();
+  MEM_CHECK(*state, EC_NULL_POINTER);
+  (*state)->traces.enabled = trace;
 
-  return state;
+  int _status = read_file(binary, (*state)->memory, MEM_SIZE);
+  CHECK_STATUS(_status, emulate_state_free(*state); *state = NULL);
+
+  if (cacheDir != NULL) {
+    // The cache only saves work, so carry on without it
+    _status = diskcache_load(*state, cacheDir);
+    if (_status != EC_OK) {
+      ec_strerror(stderr, _status, __FILE__, __LINE__, __func__);
+    }
+  }
+  return EC_OK;
 }
 
 /**
- * Free space on heap of an emulate_state_t
+ * Run binaries of the same program, differing in their data, as lanes in
+ * lockstep, LOCKSTEP_WIDTH at a time. The final state of each is printed
+ * after its path, and so are the messages of its guest, which are held
+ * back while the lanes run together.
  *
- * @param state: pointer to the emulate_state_t to free
+ * @param binaries: paths of the binary files
+ * @param numBinaries: number of binary files
+ * @param cacheDir: directory to cache decoded binaries in, or NULL
+ * @param trace: whether lanes that leave lockstep run hot loops as traces
+ * @param stats: whether to print counters for each lane to stderr
+ * @return: integer error code of the first lane to fail
  */
-static void emulate_state_free(emulate_state_t *state) {
-  if (state) {
-    free(state->pipeline.decoded);
-    free(state->pipeline.fetched);
+static int run_lockstep(char **binaries, int numBinaries,
+                        const char *cacheDir, bool trace, bool stats) {
+  int result = EC_OK;
+  for (int start = 0; start < numBinaries; start += LOCKSTEP_WIDTH) {
+    emulate_state_t *lanes[LOCKSTEP_WIDTH] = {NULL};
+    char *outputs[LOCKSTEP_WIDTH] = {NULL};
+    size_t outputSizes[LOCKSTEP_WIDTH] = {0};
+    int numLanes = numBinaries - start < LOCKSTEP_WIDTH
+                   ? numBinaries - start : LOCKSTEP_WIDTH;
+    int _status = EC_OK;
+    for (int i = 0; i < numLanes && _status == EC_OK; i++) {
+      _status = load(binaries[start + i], cacheDir, trace, &lanes[i]);
+      if (_status == EC_OK) {
+        // Held back until the header of the lane is printed
+        lanes[i]->out = open_memstream(&outputs[i], &outputSizes[i]);
+        if (lanes[i]->out == NULL) {
+          lanes[i]->out = stdout;
+          _status = EC_NULL_POINTER;
+        }
+      }
+    }
+    if (_status == EC_OK) {
+      _status = lockstep_run(lanes, numLanes);
+    }
+
+    for (int i = 0; i < numLanes && _status == EC_OK; i++) {
+      printf("%s:\n", binaries[start + i]);
+      fclose(lanes[i]->out);
+      lanes[i]->out = stdout;
+      fwrite(outputs[i], 1, outputSizes[i], stdout);
+      int laneStatus = run(lanes[i]);
+      if (stats) {
+        print_stats(lanes[i], stderr);
+      }
+      if (result == EC_OK) {
+        result = laneStatus;
+      }
+    }
+    for (int i = 0; i < numLanes; i++) {
+      if (lanes[i] != NULL && lanes[i]->out != stdout) {
+        fclose(lanes[i]->out);
+      }
+      free(outputs[i]);
+      emulate_state_free(lanes[i]);
+    }
+    CHECK_STATUS(_status, );
   }
-  free(state);
+  return result;
+}
+
+/**
+ * Run a binary on several cores sharing its memory. The registers of each
+ * core are printed, then the memory.
+ *
+ * @param binary: path of the binary file
+ * @param numCores: number of cores, at most MAX_CORES
+ * @param stats: whether to print counters for each core to stderr
+ * @return: integer error code of the first core to fail
+ */
+static int run_cores(const char *binary, int numCores, bool stats) {
+  emulate_state_t *cores[MAX_CORES] = {NULL};
+  int _status = load(binary, NULL, false, &cores[0]);
+  CHECK_STATUS(_status, );
+  for (int i = 1; i < numCores && _status == EC_OK; i++) {
+    cores[i] = emulate_state_new();
+    if (cores[i] == NULL) {
+      _status = EC_NULL_POINTER;
+    }
+  }
+  if (_status == EC_OK) {
+    _status = smp_run(cores, numCores);
+  }
+
+  if (_status == EC_OK) {
+    for (int i = 0; i < numCores; i++) {
+      printf("Core %d:\n", i);
+      print_registers(cores[i]);
+      if (stats) {
+        print_stats(cores[i], stderr);
+      }
+    }
+    printf("Non-zero memory:\n");
+    print_mem(cores[0]);
+  }
+  for (int i = 0; i < numCores; i++) {
+    emulate_state_free(cores[i]);
+  }
+  return _status;
 }
 
 /**
  * Main Emulator Loop
  *
- * Takes as argument the name of the binary file to emulate
+ * Takes as argument the name of the binary file to emulate, optionally
+ * preceded by --cache and the directory to cache decoded binaries in, and by
+ * --stats to print counters to stderr at the end, and by --no-trace to
+ * interpret hot loops rather than run them as traces. With --lockstep, every
+ * binary given is run, in lockstep with the others while they agree. With
+ * --cores and a number, the binary is run on that many cores at once. With
+ * --fork-server, the binary is loaded once and run in a child for each
+ * request on the fork server descriptors. With --serve and the path of a
+ * socket, no binary is given and jobs sent to the socket are run by
+ * --workers processes, one per CPU by default. A single binary runs with the
+ * system timer in timer.h, counting modelled cycles, or instructions with
+ * --timer instructions. With --vcd and a path, its GPIO pins are modelled as
+ * in gpio.h and their levels written to that VCD file. Its UART, in uart.h,
+ * writes to stdout, or the file given with --uart-out, and reads the file
+ * given with --uart-in.
  */
 int main(int argc, char **argv) {
   int _status = EC_OK;
-  if (argc <= 1) {
-    fprintf(stderr, "%s <path_to_binary_file>", argv[0]);
+  char **binaries = calloc(argc, sizeof(char *));
+  MEM_CHECK(binaries, EC_NULL_POINTER);
+  int numBinaries = 0;
+  const char *cacheDir = NULL;
+  bool stats = false;
+  bool trace = true;
+  bool lockstep = false;
+  int numCores = 1;
+  bool forkServer = false;
+  const char *socketPath = NULL;
+  int numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  const char *timerClock = NULL;
+  const char *vcdPath = NULL;
+  const char *uartOut = NULL;
+  const char *uartIn = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+      cacheDir = argv[++i];
+    } else if (strcmp(argv[i], "--stats") == 0) {
+      stats = true;
+    } else if (strcmp(argv[i], "--no-trace") == 0) {
+      trace = false;
+    } else if (strcmp(argv[i], "--lockstep") == 0) {
+      lockstep = true;
+    } else if (strcmp(argv[i], "--cores") == 0 && i + 1 < argc) {
+      numCores = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--fork-server") == 0) {
+      forkServer = true;
+    } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+      socketPath = argv[++i];
+    } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+      numWorkers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--timer") == 0 && i + 1 < argc) {
+      timerClock = argv[++i];
+    } else if (strcmp(argv[i], "--vcd") == 0 && i + 1 < argc) {
+      vcdPath = argv[++i];
+    } else if (strcmp(argv[i], "--uart-out") == 0 && i + 1 < argc) {
+      uartOut = argv[++i];
+    } else if (strcmp(argv[i], "--uart-in") == 0 && i + 1 < argc) {
+      uartIn = argv[++i];
+    } else {
+      binaries[numBinaries++] = argv[i];
+    }
+  }
+  bool serve = socketPath != NULL;
+  bool timerInstrs = timerClock != NULL
+      && strcmp(timerClock, "instructions") == 0;
+  if ((numBinaries == 0) != serve || (numBinaries > 1 && !lockstep)
+      || numCores < 1 || numCores > MAX_CORES
+      || (numCores > 1 && lockstep)
+      || (forkServer && (lockstep || numCores > 1))
+      || (serve && (lockstep || numCores > 1 || forkServer))
+      || ((vcdPath != NULL || uartOut != NULL || uartIn != NULL)
+          && (lockstep || numCores > 1 || serve))
+      || (timerClock != NULL && (lockstep || numCores > 1 || serve
+                                 || (!timerInstrs
+                                     && strcmp(timerClock, "cycles") != 0)))) {
+    fprintf(stderr, "%s [--cache <dir>] [--stats] [--no-trace] "
+                    "[--fork-server] [--timer <instructions|cycles>] "
+                    "[--vcd <file>] [--uart-out <file>] [--uart-in <file>] "
+                    "<path_to_binary_file>\n"
+                    "%s --lockstep [--cache <dir>] [--stats] [--no-trace] "
+                    "<path_to_binary_file>...\n"
+                    "%s --cores <n> [--stats] <path_to_binary_file>\n"
+                    "%s --serve <path_to_socket> [--workers <n>]\n",
+            argv[0], argv[0], argv[0], argv[0]);
+    free(binaries);
     return EC_INVALID_PARAM;
   }
+  if (serve) {
+    free(binaries);
+    emulate_state_t *state = emulate_state_new();
+    MEM_CHECK(state, EC_NULL_POINTER);
+    _status = server_run(state, socketPath, numWorkers);
+    emulate_state_free(state);
+    return _status;
+  }
+  if (lockstep) {
+    _status = run_lockstep(binaries, numBinaries, cacheDir, trace, stats);
+    free(binaries);
+    return _status;
+  }
+  if (numCores > 1) {
+    _status = run_cores(binaries[0], numCores, stats);
+    free(binaries);
+    return _status;
+  }
 
-  emulate_state_t *state = emulate_state_new();
-  MEM_CHECK_C(state, EC_NULL_POINTER, emulate_state_free(state));
+  const char *binary = binaries[0];
+  free(binaries);
+  emulate_state_t *state = NULL;
+  _status = load(binary, cacheDir, trace, &state);
+  CHECK_STATUS(_status, );
+  state->timer = timer_new(timerInstrs);
+  MEM_CHECK_C(state->timer, EC_NULL_POINTER, emulate_state_free(state));
 
-  _status = read_file(argv[1], state->memory, MEM_SIZE);
+  if (forkServer) {
+    bool child;
+    _status = forkserver_start(state, binary, &child);
+    if (!child) {
+      CHECK_STATUS(_status, emulate_state_free(state));
+      emulate_state_free(state);
+      return EC_OK;
+    }
+    CHECK_STATUS(_status, emulate_state_free(state));
+  }
+  // After forking, so that each run writes its own capture
+  if (vcdPath != NULL) {
+    _status = gpio_new(vcdPath, &state->gpio);
+    CHECK_STATUS(_status, emulate_state_free(state));
+  }
+  _status = uart_new(uartOut, uartIn, &state->uart);
   CHECK_STATUS(_status, emulate_state_free(state));
 
   //Setup Pipeline
-  set_pc(state, 0x8);
-  _status = get_mem_word(state, 0, state->pipeline.fetched);
+  _status = pipeline_refill(state, 0x0);
   CHECK_STATUS(_status, emulate_state_free(state));
 
-  _status = decode_word(state->pipeline.decoded, *state->pipeline.fetched);
-  get_mem_word(state, 0x4, state->pipeline.fetched);
-
-  while (state->pipeline.decoded->type != HAL) {
-    _status = execute(state);
-    if (!_status) {
-      _status = decode_word(state->pipeline.decoded, *state->pipeline.fetched);
-      get_mem_word(state, get_pc(state), state->pipeline.fetched);
-    }
-    increment_pc(state);
+  _status = run(state);
+  if (stats) {
+    print_stats(state, stderr);
+  }
+  int closed = gpio_free(state->gpio, state->steps);
+  state->gpio = NULL;
+  if (_status == EC_OK) {
+    _status = closed;
+  }
+  closed = uart_free(state->uart);
+  state->uart = NULL;
+  if (_status == EC_OK) {
+    _status = closed;
   }
-
-  _status = execute(state);
   emulate_state_free(state);
   return _status;
 }
@@ -9,9 +9,28 @@
 #include "utils/instructions.h"
 #include "utils/error.h"
 
+// Guest memory is split into pages for self-modifying code detection
+#define CODE_PAGE_SHIFT 8
+#define CODE_PAGE_SIZE (1 << CODE_PAGE_SHIFT)
+#define NUM_CODE_PAGES (MEM_SIZE >> CODE_PAGE_SHIFT)
+#define MEM_WORDS (MEM_SIZE >> 2)
+
+// Part of the key of files in the cache directory, change when their
+// contents would change
+#define EMULATOR_VERSION "1.2"
+
 //Forward Definitions
 typedef struct pipeline pipeline_t;
 typedef struct registers registers_t;
+typedef struct decode_cache decode_cache_t;
+typedef struct emulate_stats emulate_stats_t;
+typedef struct perf_counters perf_counters_t;
+typedef struct trace_cache trace_cache_t;
+typedef struct smp smp_t;
+typedef struct sched_task sched_task_t;
+typedef struct systimer systimer_t;
+typedef struct gpio gpio_t;
+typedef struct uart uart_t;
 typedef struct emulate_state emulate_state_t;
 
 #include "utils/io.h"
@@ -19,10 +38,26 @@ typedef struct emulate_state emulate_state_t;
 
 #include "emulate/execute.h"
 #include "emulate/decode.h"
+#include "emulate/predecode.h"
+#include "emulate/diskcache.h"
+#include "emulate/trace.h"
+#include "emulate/lockstep.h"
+#include "emulate/smp.h"
+#include "emulate/forkserver.h"
+#include "emulate/server.h"
+#include "emulate/sched.h"
+#include "emulate/wheel.h"
+#include "emulate/timer.h"
+#include "emulate/gpio.h"
+#include "emulate/uart.h"
+#include "emulate/mmio.h"
 
 struct pipeline {
   word_t *fetched;
+  word_t fetched_addr;
   instruction_t *decoded;
+  word_t decoded_addr;
+  word_t decoded_word;
 };
 
 struct registers {
@@ -31,9 +66,67 @@ struct registers {
   word_t cpsr;
 };
 
+// Decoded instructions, one per word of guest memory
+struct decode_cache {
+  instruction_t entries[MEM_WORDS];
+  byte_t valid[MEM_WORDS / 8];
+  uint32_t invalidations;
+  uint32_t generations[NUM_CODE_PAGES]; // invalidations of each page
+
+  // Table of the binary as loaded, mapped from the cache directory
+  const instruction_t *warm;
+  word_t warmWords;
+  byte_t warmPages[NUM_CODE_PAGES / 8]; // pages not written since loading
+  void *map;
+  size_t mapSize;
+};
+
+// Counters reported by --stats
+struct emulate_stats {
+  uint64_t fusions[NUM_FUSIONS];
+  uint64_t tracesRecorded;
+  uint64_t traceAborts;
+  uint64_t tracesRetired;
+  uint64_t traceEntries;
+  uint64_t traceIterations;
+  uint64_t irOpsLowered;
+  uint64_t irOpsOptimised;
+  uint64_t lockstepSteps;
+  uint64_t idleIterations;
+};
+
+// Values the guest performance counters were last reset at, see mmio.h
+struct perf_counters {
+  uint64_t steps;
+  uint64_t cycles;
+  uint64_t nanos;
+  word_t high; // high word of the last counter read
+};
+
 struct emulate_state {
   registers_t registers;
-  byte_t memory[MEM_SIZE];
+  byte_t *memory;                        // ram, or that of the first core
+  byte_t ram[MEM_SIZE];
+  byte_t code_pages[NUM_CODE_PAGES / 8]; // pages with decoded instructions
   pipeline_t pipeline;
+  decode_cache_t dcache;
+  emulate_stats_t stats;
+  trace_cache_t traces;
+  smp_t *smp;                            // shared by the cores, or NULL
+  int core;
+  uint64_t budget;                       // instructions allowed, 0 for any
+  uint64_t steps;                        // instructions run
+  uint64_t cycles;                       // cycles modelled, see execute.h
+  perf_counters_t perf;
+  sched_task_t *task;                    // running under a scheduler, or NULL
+  systimer_t *timer;                     // mapped, or NULL
+  gpio_t *gpio;                          // modelled pins, or NULL
+  uart_t *uart;                          // mapped, or NULL
+  uint64_t effects;                      // stores, and loads that may differ
+  FILE *out;                             // where guest messages are printed
 };
+
+emulate_state_t *emulate_state_new(void);
+void emulate_state_free(emulate_state_t *state);
+
 #endif
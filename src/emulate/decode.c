@@ -3,9 +3,37 @@
  *  instructions. Since there are many aspects to an instruction,
  *  we have broken them down into different structs and we start the decoding
  *  process at the lowest level and work up.
+ *
+ *  The instruction class is found with a single lookup in a 4096 entry table
+ *  indexed by bits [27:20] and [7:4] of the word, the classic ARM decoding
+ *  scheme. The table is built by the preprocessor, so there is no start-up
+ *  cost, and every index that is not an encoding we support maps to UND.
  */
 
 #include "decode.h"
+#include "../utils/register.h"
+
+/**
+ *  Get the nibble ending at a given bit position (inlined field extraction)
+ *
+ *  @param word: instruction word to extract from
+ *  @param pos: most significant bit of the nibble
+ *  @return: the 4 bits downwards from pos, right aligned
+ */
+static inline byte_t field_nibble(word_t word, byte_t pos) {
+  return (word >> (pos - 3)) & 0xF;
+}
+
+/**
+ *  Get a single bit of an instruction as a flag (inlined field extraction)
+ *
+ *  @param word: instruction word to extract from
+ *  @param pos: position of the bit
+ *  @return: flag that is true iff the bit at pos is set
+ */
+static inline flag_t field_flag(word_t word, byte_t pos) {
+  return (word >> pos) & 0x1;
+}
 
 /**
  *  Set the value of the operand when I is 0
@@ -16,23 +44,23 @@
  */
 int decode_shifted_reg(operand_t *op, word_t word) {
 
-  op->reg.type = get_bits(word, OP_SHIFT_TYPE_START, OP_SHIFT_TYPE_END);
-  op->reg.shiftBy = get_flag(word, OP_SHIFTBY_FLAG);
+  op->reg.type = (word >> OP_SHIFT_TYPE_END) & 0x3;
+  op->reg.shiftBy = field_flag(word, OP_SHIFTBY_FLAG);
 
   // Shift by register
   if (op->reg.shiftBy) {
     op->reg.shift.shiftreg = (op_shift_register_t) {
-        .rs = get_nibble(word, OP_START),
+        .rs = field_nibble(word, OP_START),
         .zeroPad = 0x0
     };
 
     // Shift by constant
   } else {
     op->reg.shift.constant = (op_shift_const_t) {
-        .integer = get_bits(word, OP_START, OP_IMM_START)
+        .integer = (word >> OP_IMM_START) & 0x1F
     };
   }
-  op->reg.rm = get_nibble(word, REG_M_START);
+  op->reg.rm = field_nibble(word, REG_M_START);
   return EC_OK;
 }
 
@@ -46,8 +74,8 @@ int decode_shifted_reg(operand_t *op, word_t word) {
 int decode_operand(flag_t I, word_t word, operand_t *op) {
   // Immediate
   if (I) {
-    op->imm = (op_immediate_t) {.rotated.rotate = get_nibble(word, OP_START),
-        .rotated.value = get_byte(word, OP_IMM_START)};
+    op->imm = (op_immediate_t) {.rotated.rotate = field_nibble(word, OP_START),
+        .rotated.value = word & 0xFF};
   }
     // Register
   else {
@@ -70,7 +98,7 @@ int decode_offset(flag_t I, word_t word, operand_t *op) {
   }
     // Immediate
   else {
-    op->imm.fixed = get_bits(word, OP_START, 0);
+    op->imm.fixed = word & 0xFFF;
   }
   return EC_OK;
 }
@@ -85,12 +113,13 @@ int decode_offset(flag_t I, word_t word, operand_t *op) {
 int decode_dp(instruction_t *instr, word_t word) {
   assert(instr != NULL);
 
+  instr->type = DP;
   instr->i.dp.padding = 0x0;
-  instr->i.dp.I = get_flag(word, I_FLAG);
-  instr->i.dp.opcode = get_nibble(word, OPCODE_START);
-  instr->i.dp.S = get_flag(word, S_FLAG);
-  instr->i.dp.rn = get_nibble(word, DP_RN_START);
-  instr->i.dp.rd = get_nibble(word, DP_RD_START);
+  instr->i.dp.I = field_flag(word, I_FLAG);
+  instr->i.dp.opcode = field_nibble(word, OPCODE_START);
+  instr->i.dp.S = field_flag(word, S_FLAG);
+  instr->i.dp.rn = field_nibble(word, DP_RN_START);
+  instr->i.dp.rd = field_nibble(word, DP_RD_START);
   return decode_operand(instr->i.dp.I, word, &instr->i.dp.operand2);
 
 }
@@ -105,14 +134,15 @@ int decode_dp(instruction_t *instr, word_t word) {
 int decode_mul(instruction_t *instr, word_t word) {
   assert(instr != NULL);
 
+  instr->type = MUL;
   instr->i.mul.pad0 = 0x0;
-  instr->i.mul.A = get_flag(word, A_FLAG);
-  instr->i.mul.S = get_flag(word, S_FLAG);
-  instr->i.mul.rd = get_nibble(word, MUL_RD_START);
-  instr->i.mul.rn = get_nibble(word, MUL_RN_START);
-  instr->i.mul.rs = get_nibble(word, REG_S_START);
+  instr->i.mul.A = field_flag(word, A_FLAG);
+  instr->i.mul.S = field_flag(word, S_FLAG);
+  instr->i.mul.rd = field_nibble(word, MUL_RD_START);
+  instr->i.mul.rn = field_nibble(word, MUL_RN_START);
+  instr->i.mul.rs = field_nibble(word, REG_S_START);
   instr->i.mul.pad9 = 0x9;
-  instr->i.mul.rm = get_nibble(word, REG_M_START);
+  instr->i.mul.rm = field_nibble(word, REG_M_START);
 
   return EC_OK;
 }
@@ -127,14 +157,15 @@ int decode_mul(instruction_t *instr, word_t word) {
 int decode_sdt(instruction_t *instr, word_t word) {
   assert(instr != NULL);
 
+  instr->type = SDT;
   instr->i.sdt.pad1 = 0x1;
-  instr->i.sdt.I = get_flag(word, I_FLAG);
-  instr->i.sdt.P = get_flag(word, P_FLAG);
-  instr->i.sdt.U = get_flag(word, U_FLAG);
+  instr->i.sdt.I = field_flag(word, I_FLAG);
+  instr->i.sdt.P = field_flag(word, P_FLAG);
+  instr->i.sdt.U = field_flag(word, U_FLAG);
   instr->i.sdt.pad0 = 0x0;
-  instr->i.sdt.L = get_flag(word, L_FLAG);
-  instr->i.sdt.rn = get_nibble(word, SDT_RN_START);
-  instr->i.sdt.rd = get_nibble(word, SDT_RD_START);
+  instr->i.sdt.L = field_flag(word, L_FLAG);
+  instr->i.sdt.rn = field_nibble(word, SDT_RN_START);
+  instr->i.sdt.rd = field_nibble(word, SDT_RD_START);
   return decode_offset(instr->i.sdt.I, word, &instr->i.sdt.offset);
 
 }
@@ -149,8 +180,9 @@ int decode_sdt(instruction_t *instr, word_t word) {
 int decode_brn(instruction_t *instr, word_t word) {
   assert(instr != NULL);
 
+  instr->type = BRN;
   instr->i.brn.padA = 0xA;
-  instr->i.brn.offset = get_bits(word, 23, 0);
+  instr->i.brn.offset = word & 0xFFFFFF;
   return EC_OK;
 }
 
@@ -168,70 +200,119 @@ int decode_halt(instruction_t *instr, word_t word) {
     return EC_INVALID_PARAM;
   }
 
+  instr->type = HAL;
   instr->i.hal.pad0 = word;
   return EC_OK;
 }
 
 /**
- *  Decode Instruction Type
+ *  Reject an encoding that the emulator does not support. The instruction is
+ *  still marked so that a pipeline which decodes ahead can carry it, and the
+ *  error is only raised if it is actually executed.
  *
  *  @param instr: pointer to the instruction
  *  @param word: instruction word to decode
- *  @return: integer error code based on success of function
+ *  @return: EC_UNSUPPORTED_OP
  */
-int decode_instruction_type(instruction_t *instr, word_t word) {
+int decode_undefined(instruction_t *instr, word_t word) {
   assert(instr != NULL);
-  int _status = EC_OK;
 
-  instruction_type_t instruction_type;
+  instr->type = UND;
+  instr->i.hal.pad0 = word;
+  return EC_UNSUPPORTED_OP;
+}
 
-  if (word == 0x0) {
-    instruction_type = HAL;
-    _status = decode_halt(instr, word);
-  } else {
-    word_t selectionBits = get_bits(word, INSTR_TYPE_START, INSTR_TYPE_END);
-    word_t pad9;
-    switch (selectionBits) {
-      case 0x0:
-        pad9 = get_bits(word, MUL_TYPE_START, MUL_TYPE_END);
-        if (!(pad9 ^ 0x9)) {
-          instruction_type = MUL;
-          _status = decode_mul(instr, word);
-        } else {
-          instruction_type = DP;
-          _status = decode_dp(instr, word);
-        }
-        break;
-      case 0x1:
-        instruction_type = DP;
-        _status = decode_dp(instr, word);
-        break;
-      case 0x2:
-      case 0x3:
-        instruction_type = SDT;
-        _status = decode_sdt(instr, word);
-        break;
-      case 0x5:
-        instruction_type = BRN;
-        _status = decode_brn(instr, word);
-        break;
-      default:
-        return EC_UNSUPPORTED_OP;
-    }
-  }
+//// DECODE TABLE ////
 
-  instr->type = instruction_type;
-  return _status;
-}
+/*
+ * Classification of a table index i = bits [27:20] : bits [7:4].
+ * These are integer constant expressions so the table below is generated
+ * entirely at compile time.
+ */
+#define DT_HI(i) ((i) >> 4)
+#define DT_LO(i) ((i) & 0xF)
+
+#define DT_DP_OPCODE(i) ((DT_HI(i) >> 1) & 0xF)
+#define DT_DP_SUPPORTED(i) ((DP_SUPPORTED_OPCODES >> DT_DP_OPCODE(i)) & 0x1)
+#define DT_DP_TEST(i) ((DP_TEST_OPCODES >> DT_DP_OPCODE(i)) & 0x1)
+
+// bits 27-22 = 000000, bits 7-4 = 1001
+#define DT_IS_MUL(i) ((DT_HI(i) & 0xFC) == 0x0 && DT_LO(i) == 0x9)
+// bits 27-26 = 00, not in the multiply/extra load-store space, an opcode we
+// execute, and S set for the test opcodes (S clear encodes MRS/MSR etc.)
+#define DT_IS_DP(i) ((DT_HI(i) >> 6) == 0x0 \
+    && ((DT_HI(i) & 0x20) || (DT_LO(i) & 0x9) != 0x9) \
+    && DT_DP_SUPPORTED(i) && (!DT_DP_TEST(i) || (DT_HI(i) & 0x1)))
+// bits 27-26 = 01, byte (22) and write-back (21) bits clear, and not a
+// register offset (I) with bit 4 set, which is the media space, as an
+// offset is never shifted by a register
+#define DT_IS_SDT(i) ((DT_HI(i) >> 6) == 0x1 && (DT_HI(i) & 0x6) == 0x0 \
+    && !((DT_HI(i) & 0x20) && (DT_LO(i) & 0x1)))
+// bits 27-24 = 1010, link bit clear
+#define DT_IS_BRN(i) ((DT_HI(i) >> 4) == 0xA)
+
+#define DT_CLASS(i) (DT_IS_MUL(i) ? DECODE_MUL \
+    : DT_IS_DP(i) ? DECODE_DP \
+    : DT_IS_SDT(i) ? DECODE_SDT \
+    : DT_IS_BRN(i) ? DECODE_BRN \
+    : DECODE_UND)
+
+#define DT_1(i) DT_CLASS(i),
+#define DT_4(i) DT_1(i) DT_1((i) + 1) DT_1((i) + 2) DT_1((i) + 3)
+#define DT_16(i) DT_4(i) DT_4((i) + 4) DT_4((i) + 8) DT_4((i) + 12)
+#define DT_64(i) DT_16(i) DT_16((i) + 16) DT_16((i) + 32) DT_16((i) + 48)
+#define DT_256(i) DT_64(i) DT_64((i) + 64) DT_64((i) + 128) DT_64((i) + 192)
+#define DT_1024(i) DT_256(i) DT_256((i) + 256) DT_256((i) + 512) \
+    DT_256((i) + 768)
+#define DT_4096(i) DT_1024(i) DT_1024((i) + 1024) DT_1024((i) + 2048) \
+    DT_1024((i) + 3072)
+
+static const byte_t decode_table[DECODE_TABLE_SIZE] = {DT_4096(0)};
+
+static int (*const decoders[NUM_DECODE_CLASSES])(instruction_t *, word_t) = {
+    [DECODE_UND] = &decode_undefined,
+    [DECODE_DP] = &decode_dp,
+    [DECODE_MUL] = &decode_mul,
+    [DECODE_SDT] = &decode_sdt,
+    [DECODE_BRN] = &decode_brn
+};
 
 /**
  *  Decode Word (entry point to file)
  *
  *  @param instr: instruction to load with the data in the word
  *  @param word: binary instruction to decode
- *  @return: integer error code based on success of function
+ *  @return: integer error code based on success of function,
+ *  EC_UNSUPPORTED_OP if the word is not an encoding we support
  */
 int decode_word(instruction_t *instr, word_t word) {
-  instr->cond = get_nibble(word, COND_START);
-  return decode_instruction_type(instr, word);
+  assert(instr != NULL);
+
+  instr->cond = field_nibble(word, COND_START);
+  instr->fusion = FUSE_NONE;
+  if (word == 0x0) {
+    return decode_halt(instr, word);
+  }
+  return decoders[decode_table[DECODE_INDEX(word)]](instr, word);
+}
+
+/**
+ *  Check whether an instruction writes the PC other than as a branch
+ *
+ *  @param instr: decoded instruction
+ *  @return: true iff executing the instruction may change the PC
+ */
+bool writes_pc(const instruction_t *instr) {
+  switch (instr->type) {
+    case DP:
+      return instr->i.dp.rd == REG_N_PC && instr->i.dp.opcode != TST
+          && instr->i.dp.opcode != TEQ && instr->i.dp.opcode != CMP;
+    case MUL:
+      return instr->i.mul.rd == REG_N_PC;
+    case SDT:
+      return (instr->i.sdt.L && instr->i.sdt.rd == REG_N_PC)
+          || (!instr->i.sdt.P && instr->i.sdt.rn == REG_N_PC);
+    default:
+      return false;
+  }
 }
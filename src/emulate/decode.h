@@ -15,9 +15,6 @@
 // GENERAL INSTRUCTION DEFINITIONS
 #define COND_START 31
 
-#define INSTR_TYPE_START 27
-#define INSTR_TYPE_END 25
-
 #define A_FLAG 21
 #define S_FLAG 20
 
@@ -42,9 +39,6 @@
 
 #define REG_S_START 11
 
-#define MUL_TYPE_START 7
-#define MUL_TYPE_END 4
-
 #define REG_M_START 3
 
 #define OP_START 11
@@ -59,6 +53,28 @@
 
 #define SDT_RD_START 15
 
+
+// DECODE TABLE DEFINITIONS
+#define DECODE_TABLE_SIZE 4096
+
+// Index from bits [27:20] and [7:4] of the instruction
+#define DECODE_INDEX(word) ((((word) >> 16) & 0xFF0) | (((word) >> 4) & 0xF))
+
+#define DP_SUPPORTED_OPCODES ((1 << AND) | (1 << EOR) | (1 << SUB) \
+    | (1 << RSB) | (1 << ADD) | (1 << TST) | (1 << TEQ) | (1 << CMP) \
+    | (1 << ORR) | (1 << MOV))
+#define DP_TEST_OPCODES ((1 << TST) | (1 << TEQ) | (1 << CMP))
+
+typedef enum {
+  DECODE_UND,
+  DECODE_DP,
+  DECODE_MUL,
+  DECODE_SDT,
+  DECODE_BRN,
+  NUM_DECODE_CLASSES
+} decode_class_t;
+
 int decode_word(instruction_t *instr, word_t word);
+bool writes_pc(const instruction_t *instr);
 
 #endif
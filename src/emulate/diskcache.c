@@ -0,0 +1,290 @@
+/*
+ *  On-disk cache of decoded binaries. The file for a binary is named after
+ *  a hash of the emulator version and the binary, and holds a header, a
+ *  table of sections, then the data of each section with its checksum.
+ *  Files are written under a temporary name and renamed into place, so
+ *  readers see either no file or a whole one. A file that fails validation
+ *  (an emulator built differently, a truncated or corrupted write) is
+ *  rebuilt.
+ *
+ *  A valid file is mapped read-only and its table serves predecode() for
+ *  the pages of the binary that have not been written to since loading.
+ */
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "diskcache.h"
+#include "decode.h"
+#include "../utils/io.h"
+#include "../utils/hash.h"
+#include "../utils/error.h"
+
+/**
+ *  Find the number of words in the loaded binary, up to its last non-zero
+ *  byte
+ *
+ *  @param state: pointer to the machine state with the binary loaded
+ *  @return: number of words of the binary
+ */
+static word_t image_words(emulate_state_t *state) {
+  word_t size = MEM_SIZE;
+  while (size > 0 && state->memory[size - 1] == 0) {
+    size--;
+  }
+  return (size + 3) >> 2;
+}
+
+/**
+ *  Compute the key of a binary in the cache
+ *
+ *  @param state: pointer to the machine state with the binary loaded
+ *  @param words: number of words of the binary
+ *  @return: hash of the emulator version and the binary
+ */
+static uint64_t image_key(emulate_state_t *state, word_t words) {
+  uint64_t hash = fnv1a_64(EMULATOR_VERSION, strlen(EMULATOR_VERSION),
+                           FNV_OFFSET_BASIS_64);
+  return fnv1a_64(state->memory, words << 2, hash);
+}
+
+/**
+ *  Find a section of a mapped file whose header has been validated
+ *
+ *  @param map: start of the mapped file
+ *  @param type: type of the section to find
+ *  @return: pointer to the section's entry, NULL if there is none
+ */
+static const diskcache_section_t *find_section(const byte_t *map,
+                                               uint32_t type) {
+  const diskcache_header_t *header = (const diskcache_header_t *) map;
+  const diskcache_section_t *sections =
+      (const diskcache_section_t *) (map + sizeof(diskcache_header_t));
+  for (uint32_t i = 0; i < header->numSections; i++) {
+    if (sections[i].type == type) {
+      return &sections[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ *  Check that a mapped file is intact and belongs to the loaded binary
+ *
+ *  @param map: start of the mapped file
+ *  @param size: size of the mapped file
+ *  @param key: key of the loaded binary
+ *  @param words: number of words of the loaded binary
+ *  @return: true iff every section can be used
+ */
+static bool cache_valid(const byte_t *map, size_t size, uint64_t key,
+                        word_t words) {
+  if (size < sizeof(diskcache_header_t)) {
+    return false;
+  }
+  const diskcache_header_t *header = (const diskcache_header_t *) map;
+  if (header->magic != DISKCACHE_MAGIC
+      || header->entrySize != sizeof(instruction_t)
+      || header->key != key
+      || header->imageWords != words
+      || strncmp(header->version, EMULATOR_VERSION,
+                 DISKCACHE_VERSION_SIZE) != 0) {
+    return false;
+  }
+
+  size_t tableEnd = sizeof(diskcache_header_t)
+      + (size_t) header->numSections * sizeof(diskcache_section_t);
+  if (header->numSections > size / sizeof(diskcache_section_t)
+      || tableEnd > size) {
+    return false;
+  }
+  const diskcache_section_t *sections =
+      (const diskcache_section_t *) (map + sizeof(diskcache_header_t));
+  for (uint32_t i = 0; i < header->numSections; i++) {
+    if ((size_t) sections[i].offset + sections[i].size > size
+        || fnv1a_64(map + sections[i].offset, sections[i].size,
+                    FNV_OFFSET_BASIS_64) != sections[i].checksum) {
+      return false;
+    }
+  }
+
+  const diskcache_section_t *decode =
+      find_section(map, DISKCACHE_SECTION_DECODE);
+  return decode != NULL
+      && decode->size == words * sizeof(instruction_t)
+      && decode->offset % sizeof(word_t) == 0;
+}
+
+/**
+ *  Map a cache file read-only
+ *
+ *  @param path: path of the file
+ *  @param map: set to the start of the mapping
+ *  @param size: set to the size of the mapping
+ *  @return: integer error code based on success of the function
+ */
+static int cache_map(const char *path, void **map, size_t *size) {
+  int fd = open(path, O_RDONLY);
+  FAIL_SYS(fd < 0);
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return EC_INVALID_PARAM;
+  }
+  *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  FAIL_SYS(*map == MAP_FAILED);
+  *size = st.st_size;
+  return EC_OK;
+}
+
+/**
+ *  Decode the loaded binary and write it to its cache file
+ *
+ *  @param state: pointer to the machine state with the binary loaded
+ *  @param path: path of the cache file
+ *  @param key: key of the binary
+ *  @param words: number of words of the binary
+ *  @return: integer error code based on success of the function
+ */
+static int cache_write(emulate_state_t *state, const char *path,
+                       uint64_t key, word_t words) {
+  instruction_t *table = calloc(words ? words : 1, sizeof(instruction_t));
+  MEM_CHECK(table, EC_NULL_POINTER);
+  for (word_t i = 0; i < words; i++) {
+    word_t word;
+    get_word(state->memory, i << 2, &word);
+    decode_word(&table[i], word);
+  }
+  // Tag pairs as predecode() does, never across a page
+  for (word_t i = 0; i + 1 < words; i++) {
+    if (((i + 1) << 2) & (CODE_PAGE_SIZE - 1)) {
+      table[i].fusion = fusion_kind(&table[i], &table[i + 1]);
+    }
+  }
+
+  diskcache_header_t header = {
+      .magic = DISKCACHE_MAGIC,
+      .entrySize = sizeof(instruction_t),
+      .key = key,
+      .imageWords = words,
+      .numSections = 1
+  };
+  strncpy(header.version, EMULATOR_VERSION, DISKCACHE_VERSION_SIZE - 1);
+  diskcache_section_t section = {
+      .type = DISKCACHE_SECTION_DECODE,
+      .offset = sizeof(header) + sizeof(section),
+      .size = words * sizeof(instruction_t),
+      .checksum = fnv1a_64(table, words * sizeof(instruction_t),
+                           FNV_OFFSET_BASIS_64)
+  };
+
+  char tmp[PATH_MAX];
+  if (snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int) getpid())
+      >= (int) sizeof(tmp)) {
+    free(table);
+    return EC_INVALID_PARAM;
+  }
+  FILE *fp = fopen(tmp, "wb");
+  if (fp == NULL) {
+    free(table);
+    return EC_FROM_SYS_ERROR(errno);
+  }
+  fwrite(&header, sizeof(header), 1, fp);
+  fwrite(&section, sizeof(section), 1, fp);
+  fwrite(table, sizeof(instruction_t), words, fp);
+  free(table);
+
+  bool failed = ferror(fp);
+  failed |= fclose(fp) != 0;
+  if (failed || rename(tmp, path) != 0) {
+    int err = errno;
+    unlink(tmp);
+    return EC_FROM_SYS_ERROR(err);
+  }
+  return EC_OK;
+}
+
+/**
+ *  Use a validated mapping as the warm decode table
+ *
+ *  @param state: pointer to the machine state
+ *  @param map: start of the mapped file
+ *  @param size: size of the mapped file
+ *  @param words: number of words of the loaded binary
+ */
+static void cache_install(emulate_state_t *state, void *map, size_t size,
+                          word_t words) {
+  const diskcache_section_t *decode =
+      find_section(map, DISKCACHE_SECTION_DECODE);
+  decode_cache_t *dcache = &state->dcache;
+  dcache->map = map;
+  dcache->mapSize = size;
+  dcache->warm = (const instruction_t *) ((byte_t *) map + decode->offset);
+  dcache->warmWords = words;
+
+  // Marked as code so that the first store into a page retires it
+  for (word_t addr = 0; addr < words << 2; addr += CODE_PAGE_SIZE) {
+    word_t page = addr >> CODE_PAGE_SHIFT;
+    dcache->warmPages[page >> 3] |= 1 << (page & 0x7);
+    mark_code_page(state, addr);
+  }
+}
+
+/**
+ *  Map the decoded table of the loaded binary from a cache directory,
+ *  creating or rebuilding its file first if needed
+ *
+ *  @param state: pointer to the machine state with the binary loaded
+ *  @param dir: path of the cache directory
+ *  @return: integer error code based on success of the function
+ */
+int diskcache_load(emulate_state_t *state, const char *dir) {
+  assert(state != NULL && dir != NULL);
+  word_t words = image_words(state);
+  uint64_t key = image_key(state, words);
+
+  char path[PATH_MAX];
+  FAIL_PRED(snprintf(path, sizeof(path), "%s/%016" PRIx64 "%s", dir, key,
+                     DISKCACHE_SUFFIX) >= (int) sizeof(path),
+            EC_INVALID_PARAM);
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    void *map;
+    size_t size;
+    if (cache_map(path, &map, &size) == EC_OK) {
+      if (cache_valid(map, size, key, words)) {
+        cache_install(state, map, size, words);
+        return EC_OK;
+      }
+      munmap(map, size);
+    }
+    if (attempt == 0) {
+      int _status = cache_write(state, path, key, words);
+      if (_status != EC_OK) {
+        return _status;
+      }
+    }
+  }
+  return EC_INVALID_PARAM;
+}
+
+/**
+ *  Unmap the warm decode table, if there is one
+ *
+ *  @param state: pointer to the machine state
+ */
+void diskcache_release(emulate_state_t *state) {
+  decode_cache_t *dcache = &state->dcache;
+  if (dcache->map != NULL) {
+    munmap(dcache->map, dcache->mapSize);
+  }
+  dcache->map = NULL;
+  dcache->warm = NULL;
+  dcache->warmWords = 0;
+}
@@ -0,0 +1,41 @@
+/*
+ *  Cache directory holding the decoded instructions of binaries, so that
+ *  later runs of the same binary map them instead of decoding.
+ */
+
+#ifndef DISKCACHE_H
+#define DISKCACHE_H
+
+#include <stdint.h>
+#include "../utils/arm.h"
+#include "../emulate.h"
+
+#define DISKCACHE_MAGIC 0x43444d45 // "EMDC"
+#define DISKCACHE_SUFFIX ".dcache"
+#define DISKCACHE_VERSION_SIZE 16
+
+typedef enum {
+  DISKCACHE_SECTION_DECODE = 1 // instruction_t for every word of the image
+} diskcache_section_type_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t entrySize; // sizeof(instruction_t) of the writer
+  uint64_t key;
+  char version[DISKCACHE_VERSION_SIZE];
+  uint32_t imageWords;
+  uint32_t numSections;
+} diskcache_header_t;
+
+typedef struct {
+  uint32_t type;
+  uint32_t offset; // from the start of the file
+  uint32_t size;
+  uint32_t pad;
+  uint64_t checksum;
+} diskcache_section_t;
+
+int diskcache_load(emulate_state_t *state, const char *dir);
+void diskcache_release(emulate_state_t *state);
+
+#endif
@@ -14,7 +14,17 @@
  *  @return: 1 when condition is met, 0 if not
  */
 int condition(emulate_state_t *state, byte_t cond) {
-  byte_t flags = get_flags(state);
+  return condition_flags(get_flags(state), cond);
+}
+
+/**
+ *  Check if a condition is met by a given value of the flags
+ *
+ *  @param flags: byte with the 4 least significant bits set to the flags
+ *  @param cond: condition extracted from the instruction
+ *  @return: non-zero when condition is met, 0 if not
+ */
+int condition_flags(byte_t flags, byte_t cond) {
   switch (cond) {
     case EQ:
       return flags & Z;
@@ -56,18 +66,32 @@ int evaluate_shifted_reg(emulate_state_t *state, operand_t op,
   else {
     shiftAmount = op.reg.shift.constant.integer;
   }
-  switch (op.reg.type) {
+  return barrel_shift(op.reg.type, rm, shiftAmount, result);
+}
+
+/**
+ *  Shift a value through the barrel shifter
+ *
+ *  @param type: shift type, one of LSL, LSR, ASR and ROR
+ *  @param value: value to shift
+ *  @param amount: amount to shift by
+ *  @param result: pointer to the shifted value and its carry
+ *  @return: integer error code based on success of the function
+ */
+int barrel_shift(byte_t type, word_t value, byte_t amount,
+                 shift_result_t *result) {
+  switch (type) {
     case LSL:
-      *result = l_shift_left_c(rm, shiftAmount);
+      *result = l_shift_left_c(value, amount);
       break;
     case LSR:
-      *result = l_shift_right_c(rm, shiftAmount);
+      *result = l_shift_right_c(value, amount);
       break;
     case ASR:
-      *result = a_shift_right_c(rm, shiftAmount);
+      *result = a_shift_right_c(value, amount);
       break;
     case ROR:
-      *result = rotate_right_c(rm, shiftAmount);
+      *result = rotate_right_c(value, amount);
       break;
     default:
       return EC_UNSUPPORTED_OP;
@@ -127,7 +151,76 @@ int execute(emulate_state_t *state) {
   if (decoded->type == HAL) {
     return execute_halt(state);
   }
+  if (decoded->fusion != FUSE_NONE) {
+    return execute_fused(state);
+  }
+  return execute_single(state, decoded);
+}
 
+/**
+ *  Get the cycles the cycle counter models an instruction as taking, not
+ *  counting the refill after a taken branch
+ *
+ *  @param instr: the instruction, whether or not its condition holds
+ *  @return: the cycles it takes
+ */
+word_t cycle_cost(const instruction_t *instr) {
+  switch (instr->type) {
+    case MUL:
+      return CYCLES_MUL;
+    case SDT:
+      return instr->i.sdt.L ? CYCLES_LOAD : 1;
+    default:
+      return 1;
+  }
+}
+
+/**
+ *  Run from the instruction in the pipeline up to the halt, without
+ *  executing it
+ *
+ *  @param state: pointer to the program_state state, with its pipeline filled
+ *  @return: integer error code of the first instruction to fail
+ */
+int execute_program(emulate_state_t *state) {
+  int _status = EC_OK;
+  while (state->pipeline.decoded->type != HAL) {
+    if (state->budget != 0 && state->steps >= state->budget) {
+      return EC_BUDGET;
+    }
+    word_t cycles = cycle_cost(state->pipeline.decoded);
+    if (state->traces.recording) {
+      _status = trace_record(state);
+    } else {
+      _status = execute(state);
+    }
+    // The instruction runs again once the task is resumed
+    if (_status == EC_BLOCKED) {
+      return _status;
+    }
+    state->steps++;
+    state->cycles += _status == EC_SKIP ? cycles + CYCLES_BRANCH_TAKEN : cycles;
+    if (_status != EC_SKIP) {
+      CHECK_STATUS(_status, );
+      pipeline_decode(state);
+      pipeline_fetch(state, get_pc(state));
+    }
+    increment_pc(state);
+    if (_status == EC_SKIP && state->traces.enabled) {
+      trace_branch_taken(state);
+    }
+  }
+  return EC_OK;
+}
+
+/**
+ *  Execute one instruction that is not a halt
+ *
+ *  @param state: pointer to the program_state state
+ *  @param decoded: the instruction to execute
+ *  @return: integer error code returned by a particular execute function
+ */
+int execute_single(emulate_state_t *state, instruction_t *decoded) {
   if (condition(state, decoded->cond)) {
     switch (decoded->type) {
       case DP:
@@ -138,6 +231,10 @@ int execute(emulate_state_t *state) {
         return execute_sdt(state, decoded->i.sdt);
       case BRN:
         return execute_brn(state, decoded->i.brn);
+      case UND:
+        fprintf(stderr, "Undefined instruction at 0x%08x\n",
+                get_pc(state) - 8);
+        return EC_UNSUPPORTED_OP;
       default:
         fprintf(stderr, "Invalid type%x\n", decoded->type);
         return EC_UNSUPPORTED_OP;
@@ -146,6 +243,62 @@ int execute(emulate_state_t *state) {
   return EC_OK;
 }
 
+/**
+ *  Execute a fused pair: the decoded instruction and the one fetched behind
+ *  it, stepping the pipeline between them as the main loop would. The first
+ *  of a pair never stores, so the fetched word cannot change under it and
+ *  is checked up front. If it does not complete the pair, or the budget
+ *  leaves room for one instruction only, only the first is executed.
+ *
+ *  @param state: pointer to the program_state state
+ *  @return: integer error code of the second instruction, as execute()
+ */
+int execute_fused(emulate_state_t *state) {
+  pipeline_t *pipeline = &state->pipeline;
+  instruction_t first = *pipeline->decoded;
+  instruction_t second;
+  // The pair retires two instructions, which the budget may not allow
+  if (pipeline_peek(state, &second) != EC_OK
+      || !fusion_matches(first.fusion, &second)
+      || (state->budget != 0 && state->steps + 1 >= state->budget)) {
+    return execute_single(state, pipeline->decoded);
+  }
+
+  // The first half is unconditional and never branches
+  int _status = first.type == SDT ? execute_sdt(state, first.i.sdt)
+                                  : execute_dp(state, first.i.dp);
+  if (_status != EC_OK) {
+    return _status;
+  }
+  state->steps++;
+  state->cycles += cycle_cost(&second);
+  *pipeline->decoded = second;
+  pipeline->decoded_addr = pipeline->fetched_addr;
+  pipeline->decoded_word = *pipeline->fetched;
+  pipeline_fetch(state, get_pc(state));
+  increment_pc(state);
+  state->stats.fusions[first.fusion]++;
+
+  switch (first.fusion) {
+    case FUSE_SUBS_BNE:
+      // The flags were all just set by the subs
+      if (get_flags(state) & Z) {
+        return EC_OK;
+      }
+      return execute_brn(state, second.i.brn);
+    case FUSE_CMP_BRN:
+      if (!condition(state, second.cond)) {
+        return EC_OK;
+      }
+      return execute_brn(state, second.i.brn);
+    default:
+      if (!condition(state, second.cond)) {
+        return EC_OK;
+      }
+      return execute_dp(state, second.i.dp);
+  }
+}
+
 /**
  *  Execute Data Processing instruction
  *
@@ -155,10 +308,34 @@ int execute(emulate_state_t *state) {
  */
 int execute_dp(emulate_state_t *state, dp_instruction_t instr) {
   shift_result_t barrel = evaluate_operand(state, instr.I, instr.operand2);
+  word_t rn = get_register(state, instr.rn);
+  byte_t flags;
+  word_t result = alu(instr.opcode, rn, barrel, &flags);
+
+  if (instr.S) {
+    set_flags(state, flags);
+  }
+
+  if (instr.opcode != TST && instr.opcode != TEQ && instr.opcode != CMP) {
+    set_register(state, instr.rd, result);
+  }
+  return EC_OK;
+}
+
+/**
+ *  Compute the result of a data processing operation and the flags it
+ *  would set
+ *
+ *  @param opcode: operation to perform
+ *  @param rn: value of the first operand
+ *  @param barrel: value of the second operand and the shifter carry
+ *  @param flags: set to the flags of the result
+ *  @return: result of the operation
+ */
+word_t alu(byte_t opcode, word_t rn, shift_result_t barrel, byte_t *flags) {
   word_t op2 = barrel.value;
   word_t result = 0;
-  word_t rn = get_register(state, instr.rn);
-  switch (instr.opcode) {
+  switch (opcode) {
     case AND:
     case TST:
       result = rn & op2;
@@ -185,35 +362,27 @@ int execute_dp(emulate_state_t *state, dp_instruction_t instr) {
       break;
   }
 
-
-  if (instr.S) {
-    byte_t flags = 0x0;
-    switch (instr.opcode) {
-      case AND:
-      case TST:
-      case EOR:
-      case TEQ:
-      case ORR:
-      case MOV:
-        flags |= C * barrel.carry;
-        break;
-      case SUB:
-      case RSB:
-      case CMP:
-      case ADD:
-        flags |= C * ((is_negative(rn) == is_negative(op2))
-            != is_negative(result));
-        break;
-    }
-    flags |= (N * is_negative(result));
-    flags |= (Z * (result == 0));
-    set_flags(state, flags);
-  }
-
-  if (instr.opcode != TST && instr.opcode != TEQ && instr.opcode != CMP) {
-    set_register(state, instr.rd, result);
+  *flags = 0x0;
+  switch (opcode) {
+    case AND:
+    case TST:
+    case EOR:
+    case TEQ:
+    case ORR:
+    case MOV:
+      *flags |= C * barrel.carry;
+      break;
+    case SUB:
+    case RSB:
+    case CMP:
+    case ADD:
+      *flags |= C * ((is_negative(rn) == is_negative(op2))
+          != is_negative(result));
+      break;
   }
-  return EC_OK;
+  *flags |= (N * is_negative(result));
+  *flags |= (Z * (result == 0));
+  return result;
 }
 
 /**
@@ -272,7 +441,6 @@ int execute_mul(emulate_state_t *state, mul_instruction_t instr) {
  *  @return: integer error code based on success of the function
  */
 int execute_brn(emulate_state_t *state, brn_instruction_t instr) {
-  int _status = EC_OK;
   word_t pc = get_pc(state);
 
   //Shift offset left by 2 bits
@@ -285,12 +453,18 @@ int execute_brn(emulate_state_t *state, brn_instruction_t instr) {
   // 8 bytes ahead of the instruction being executed.
   set_pc(state, pc + (int32_t) shiftedOffset);
 
-  // Fetch new word at PC
-  get_mem_word(state, get_pc(state), state->pipeline.fetched);
-  _status = decode_word(state->pipeline.decoded, *state->pipeline.fetched);
+  // Backward branches close loops, which the trace tier may take over
+  if (get_pc(state) <= pc - 8) {
+    trace_count_branch(state, get_pc(state));
+  }
+
+  // Fetch new word at PC. A word we cannot decode is only an error if it is
+  // executed, which execute() reports.
+  pipeline_fetch(state, get_pc(state));
+  pipeline_decode(state);
   increment_pc(state);
-  get_mem_word(state, get_pc(state), state->pipeline.fetched);
-  return _status == EC_OK ? EC_SKIP : _status;
+  pipeline_fetch(state, get_pc(state));
+  return EC_SKIP;
 }
 
 /**
@@ -316,7 +490,11 @@ int execute_sdt(emulate_state_t *state, sdt_instruction_t instr) {
     }
     if (instr.L) {
       //Load from memory at address rn into reg rd.
-      if (!get_mem_word(state, rn, &data)) {
+      int _status = get_mem_word(state, rn, &data);
+      if (_status == EC_BLOCKED) {
+        return _status;
+      }
+      if (_status == EC_OK) {
         set_register(state, instr.rd, data);
       }
     } else {
@@ -328,7 +506,12 @@ int execute_sdt(emulate_state_t *state, sdt_instruction_t instr) {
     //Post-indexing
     if (instr.L) {
       //Load from memory at address rn into reg rd.
-      if (!get_mem_word(state, rn, &data)) {
+      int _status = get_mem_word(state, rn, &data);
+      // Nothing is written, so the load can run again
+      if (_status == EC_BLOCKED) {
+        return _status;
+      }
+      if (_status == EC_OK) {
         set_register(state, instr.rd, data);
       }
 
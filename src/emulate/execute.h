@@ -10,11 +10,26 @@
 #include "../utils/arm.h"
 #include "../emulate.h"
 #include "decode.h"
+#include "predecode.h"
 
 #define OFFSET_BITMASK 0xFF000000
 
+// Cycle counter model: one cycle per instruction, except multiplies and
+// loads, and a pipeline refill after every taken branch
+#define CYCLES_MUL 2
+#define CYCLES_LOAD 2
+#define CYCLES_BRANCH_TAKEN 2
+
 int condition(emulate_state_t *state, byte_t cond);
+int condition_flags(byte_t flags, byte_t cond);
+int barrel_shift(byte_t type, word_t value, byte_t amount,
+                 shift_result_t *result);
+word_t alu(byte_t opcode, word_t rn, shift_result_t barrel, byte_t *flags);
+word_t cycle_cost(const instruction_t *instr);
 int execute(emulate_state_t *state);
+int execute_program(emulate_state_t *state);
+int execute_single(emulate_state_t *state, instruction_t *decoded);
+int execute_fused(emulate_state_t *state);
 int execute_dp(emulate_state_t *state, dp_instruction_t instr);
 int execute_mul(emulate_state_t *state, mul_instruction_t instr);
 int execute_brn(emulate_state_t *state, brn_instruction_t instr);
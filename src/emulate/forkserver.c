@@ -0,0 +1,124 @@
+/*
+ *  The server decodes the loaded binary into the decode cache, so that
+ *  children share the decoded pages copy-on-write, then speaks the AFL fork
+ *  server protocol:
+ *  - it writes 4 bytes to FORKSERVER_STATUS_FD once it is ready
+ *  - for every 4 bytes read from FORKSERVER_CONTROL_FD it forks a child,
+ *    writes the child's pid, waits for it and writes its wait status
+ *  - it stops when the control descriptor is closed
+ *
+ *  Each child reads the binary again, since the controlling process may
+ *  have rewritten it, and drops the decodes of the pages that changed. It
+ *  then runs as the emulator would have, printing to the server's output.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "forkserver.h"
+#include "predecode.h"
+#include "../utils/io.h"
+#include "../utils/error.h"
+
+/**
+ *  Decode every word of the loaded binary, up to its last non-zero byte,
+ *  into the decode cache
+ *
+ *  @param state: pointer to the machine state with the binary loaded
+ */
+static void forkserver_warm(emulate_state_t *state) {
+  word_t size = MEM_SIZE;
+  while (size > 0 && state->memory[size - 1] == 0) {
+    size--;
+  }
+  for (word_t addr = 0; addr < size; addr += 4) {
+    word_t word;
+    instruction_t instr;
+    get_word(state->memory, addr, &word);
+    predecode(state, addr, word, &instr);
+  }
+}
+
+/**
+ *  Load the binary again, as it may have changed since the server loaded
+ *  it. Pages that differ are copied in and their decodes dropped.
+ *
+ *  @param state: pointer to the machine state with the old binary loaded
+ *  @param binary: path of the binary file
+ *  @param image: buffer of MEM_SIZE bytes to read the binary into
+ *  @return: integer error code returned by read_file
+ */
+int forkserver_reload(emulate_state_t *state, const char *binary,
+                      byte_t *image) {
+  memset(image, 0, MEM_SIZE);
+  int _status = read_file(binary, image, MEM_SIZE);
+  CHECK_STATUS(_status, );
+
+  predecode_reload(state, image);
+  return EC_OK;
+}
+
+/**
+ *  Write a word to the status descriptor
+ *
+ *  @param value: word to write
+ *  @return: integer error code based on success of the function
+ */
+static int forkserver_report(uint32_t value) {
+  FAIL_SYS(write(FORKSERVER_STATUS_FD, &value, sizeof(value))
+               != sizeof(value));
+  return EC_OK;
+}
+
+/**
+ *  Serve runs of the loaded binary until the controlling process stops
+ *  asking. Returns in each child, with the binary reloaded and ready to
+ *  run, and in the server once it is done.
+ *
+ *  @param state: pointer to the machine state with the binary loaded
+ *  @param binary: path of the binary file
+ *  @param child: set to true in the children, false in the server
+ *  @return: integer error code based on success of the function
+ */
+int forkserver_start(emulate_state_t *state, const char *binary,
+                     bool *child) {
+  *child = false;
+  byte_t *image = malloc(MEM_SIZE);
+  MEM_CHECK(image, EC_NULL_POINTER);
+  forkserver_warm(state);
+
+  int _status = forkserver_report(0);
+  uint32_t request;
+  while (_status == EC_OK
+         && read(FORKSERVER_CONTROL_FD, &request, sizeof(request))
+             == sizeof(request)) {
+    // Nothing buffered may be written twice
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+      _status = EC_FROM_SYS_ERROR(errno);
+      break;
+    }
+    if (pid == 0) {
+      close(FORKSERVER_CONTROL_FD);
+      close(FORKSERVER_STATUS_FD);
+      *child = true;
+      _status = forkserver_reload(state, binary, image);
+      free(image);
+      return _status;
+    }
+
+    int status;
+    _status = forkserver_report((uint32_t) pid);
+    if (waitpid(pid, &status, 0) < 0) {
+      _status = EC_FROM_SYS_ERROR(errno);
+    } else if (_status == EC_OK) {
+      _status = forkserver_report((uint32_t) status);
+    }
+  }
+  free(image);
+  return _status;
+}
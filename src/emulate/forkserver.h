@@ -0,0 +1,21 @@
+/*
+ *  Fork server: the emulator is set up once, then forks a child for every
+ *  run a controlling process asks for.
+ */
+
+#ifndef FORKSERVER_H
+#define FORKSERVER_H
+
+#include <stdbool.h>
+#include "../utils/arm.h"
+#include "../emulate.h"
+
+// The descriptors AFL uses, so that it can drive the server
+#define FORKSERVER_CONTROL_FD 198
+#define FORKSERVER_STATUS_FD 199
+
+int forkserver_start(emulate_state_t *state, const char *binary, bool *child);
+int forkserver_reload(emulate_state_t *state, const char *binary,
+                      byte_t *image);
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ *  A level change is written as the time, when it differs from that of the
+ *  last change, then a line for each pin that changed. Each pin is named by
+ *  one printable character from GPIO_VCD_ID.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "../emulate.h"
+#include "gpio.h"
+
+#define GPIO_VCD_ID '!'
+// Room for a time and a change of every pin
+#define GPIO_VCD_CHANGE (24 + 3 * GPIO_PINS)
+#define GPIO_MASK ((UINT64_C(1) << GPIO_PINS) - 1)
+
+/**
+ *  Write out the buffered changes
+ *
+ *  @param gpio: pointer to the pins, capturing to a file
+ */
+static void gpio_flush(gpio_t *gpio) {
+  fwrite(gpio->buffer, 1, gpio->used, gpio->vcd);
+  gpio->used = 0;
+}
+
+/**
+ *  Buffer the level of every pin in the given set
+ *
+ *  @param gpio: pointer to the pins, capturing to a file
+ *  @param pins: bits of the pins
+ */
+static void gpio_dump(gpio_t *gpio, uint64_t pins) {
+  for (int pin = 0; pin < GPIO_PINS; pin++) {
+    if (pins & (UINT64_C(1) << pin)) {
+      gpio->buffer[gpio->used++] = '0' + ((gpio->levels >> pin) & 1);
+      gpio->buffer[gpio->used++] = GPIO_VCD_ID + pin;
+      gpio->buffer[gpio->used++] = '\n';
+    }
+  }
+}
+
+/**
+ *  Allocate the pins, all inputs, and start a capture of their levels
+ *
+ *  @param vcdPath: path of the VCD file to write, or NULL not to capture
+ *  @param gpio: set to the pins, to be freed with gpio_free
+ *  @return: integer error code based on success of the function
+ */
+int gpio_new(const char *vcdPath, gpio_t **gpio) {
+  *gpio = calloc(1, sizeof(gpio_t));
+  MEM_CHECK(*gpio, EC_NULL_POINTER);
+  if (vcdPath == NULL) {
+    return EC_OK;
+  }
+  (*gpio)->vcd = fopen(vcdPath, "w");
+  if ((*gpio)->vcd == NULL) {
+    int _status = EC_FROM_SYS_ERROR(errno);
+    free(*gpio);
+    *gpio = NULL;
+    return _status;
+  }
+
+  FILE *vcd = (*gpio)->vcd;
+  fprintf(vcd, "$comment Timed in guest instructions retired $end\n"
+               "$timescale 1 ns $end\n"
+               "$scope module gpio $end\n");
+  for (int pin = 0; pin < GPIO_PINS; pin++) {
+    fprintf(vcd, "$var wire 1 %c pin%d $end\n", GPIO_VCD_ID + pin, pin);
+  }
+  fprintf(vcd, "$upscope $end\n"
+               "$enddefinitions $end\n"
+               "#0\n"
+               "$dumpvars\n");
+  gpio_dump(*gpio, GPIO_MASK);
+  gpio_flush(*gpio);
+  fprintf(vcd, "$end\n");
+  return EC_OK;
+}
+
+/**
+ *  Drive the pins selected as outputs, and capture the levels that change
+ *
+ *  @param state: non-null pointer to the machine state, with pins
+ */
+static void gpio_update(emulate_state_t *state) {
+  gpio_t *gpio = state->gpio;
+  uint64_t levels = gpio->latch & gpio->outputs;
+  uint64_t changed = levels ^ gpio->levels;
+  gpio->levels = levels;
+  if (changed == 0 || gpio->vcd == NULL) {
+    return;
+  }
+
+  if (gpio->used + GPIO_VCD_CHANGE > GPIO_VCD_BUFFER) {
+    gpio_flush(gpio);
+  }
+  if (state->steps != gpio->time) {
+    gpio->time = state->steps;
+    gpio->used += sprintf(gpio->buffer + gpio->used, "#%" PRIu64 "\n",
+                          gpio->time);
+  }
+  gpio_dump(gpio, changed);
+}
+
+/**
+ *  Read a register of the pins
+ *
+ *  @param state: non-null pointer to the machine state, with pins
+ *  @param addr: address of the register
+ *  @return: value read
+ */
+word_t gpio_load(emulate_state_t *state, word_t addr) {
+  gpio_t *gpio = state->gpio;
+  if (addr < GPIO_FSEL0 + 4 * GPIO_FSEL_WORDS) {
+    return gpio->fsel[(addr - GPIO_FSEL0) >> 2];
+  }
+  switch (addr) {
+    case GPIO_LEV0:
+      return (word_t) gpio->levels;
+    case GPIO_LEV1:
+      return (word_t) (gpio->levels >> 32);
+  }
+  return 0;
+}
+
+/**
+ *  Write a register of the pins. The levels ignore writes.
+ *
+ *  @param state: non-null pointer to the machine state, with pins
+ *  @param addr: address of the register
+ *  @param word: value written
+ */
+void gpio_store(emulate_state_t *state, word_t addr, word_t word) {
+  gpio_t *gpio = state->gpio;
+  if (addr < GPIO_FSEL0 + 4 * GPIO_FSEL_WORDS) {
+    int n = (addr - GPIO_FSEL0) >> 2;
+    gpio->fsel[n] = word;
+    for (int i = 0; i < 10 && 10 * n + i < GPIO_PINS; i++) {
+      uint64_t pin = UINT64_C(1) << (10 * n + i);
+      if (((word >> (3 * i)) & 0x7) == GPIO_FUNC_OUTPUT) {
+        gpio->outputs |= pin;
+      } else {
+        gpio->outputs &= ~pin;
+      }
+    }
+  } else if (addr == GPIO_SET0 || addr == GPIO_SET1) {
+    gpio->latch |= ((uint64_t) word << (addr == GPIO_SET1 ? 32 : 0))
+        & GPIO_MASK;
+  } else if (addr == GPIO_CLR0 || addr == GPIO_CLR1) {
+    gpio->latch &= ~((uint64_t) word << (addr == GPIO_CLR1 ? 32 : 0));
+  } else {
+    return;
+  }
+  gpio_update(state);
+}
+
+/**
+ *  Finish the capture of the levels, if any, and free the pins
+ *
+ *  @param gpio: pointer to the pins, or NULL
+ *  @param end: time the capture ends at
+ *  @return: integer error code based on success of writing the capture
+ */
+int gpio_free(gpio_t *gpio, uint64_t end) {
+  int _status = EC_OK;
+  if (gpio != NULL && gpio->vcd != NULL) {
+    gpio_flush(gpio);
+    if (end > gpio->time) {
+      fprintf(gpio->vcd, "#%" PRIu64 "\n", end);
+    }
+    if (ferror(gpio->vcd)) {
+      _status = EC_FROM_SYS_ERROR(EIO);
+    }
+    if (fclose(gpio->vcd) != 0 && _status == EC_OK) {
+      _status = EC_FROM_SYS_ERROR(errno);
+    }
+  }
+  free(gpio);
+  return _status;
+}
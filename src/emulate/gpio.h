@@ -0,0 +1,57 @@
+/*
+ *  Model of the GPIO pins, laid out as those of the BCM2835. It replaces
+ *  the messages printed for GPIO accesses when a run captures the pin
+ *  levels to a VCD file, timed in instructions retired.
+ *
+ *  Registers of the pins, mapped beyond guest memory:
+ *  - GPIO_FSEL0 + 4 * n selects the functions of pins 10 * n to 10 * n + 9,
+ *    three bits each. A pin is driven only when selected as an output.
+ *  - GPIO_SET0 and GPIO_SET1 set the output of pins 0-31 and 32-53 for each
+ *    bit written as 1, and GPIO_CLR0 and GPIO_CLR1 clear it
+ *  - GPIO_LEV0 and GPIO_LEV1 read as the levels of the pins, which are low
+ *    unless driven
+ */
+
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "../utils/arm.h"
+#include "../emulate.h"
+
+#define GPIO_PINS 54
+#define GPIO_FSEL_WORDS 6
+#define GPIO_FUNC_OUTPUT 0x1
+#define GPIO_VCD_BUFFER 65536
+
+#define GPIO_BASE 0x20200000
+#define GPIO_FSEL0 GPIO_BASE
+#define GPIO_SET0 (GPIO_BASE + 0x1C)
+#define GPIO_SET1 (GPIO_BASE + 0x20)
+#define GPIO_CLR0 (GPIO_BASE + 0x28)
+#define GPIO_CLR1 (GPIO_BASE + 0x2C)
+#define GPIO_LEV0 (GPIO_BASE + 0x34)
+#define GPIO_LEV1 (GPIO_BASE + 0x38)
+#define GPIO_END (GPIO_BASE + 0x3C)
+
+// Pins as bits of a 64 bit word
+struct gpio {
+  word_t fsel[GPIO_FSEL_WORDS];
+  uint64_t outputs;              // pins selected as outputs
+  uint64_t latch;                // outputs set and not cleared since
+  uint64_t levels;
+
+  // Level changes are written to the VCD file a buffer at a time
+  FILE *vcd;                     // or NULL
+  uint64_t time;                 // of the last change written
+  size_t used;
+  char buffer[GPIO_VCD_BUFFER];
+};
+
+int gpio_new(const char *vcdPath, gpio_t **gpio);
+word_t gpio_load(emulate_state_t *state, word_t addr);
+void gpio_store(emulate_state_t *state, word_t addr, word_t word);
+int gpio_free(gpio_t *gpio, uint64_t end);
+
+#endif
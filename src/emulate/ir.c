@@ -0,0 +1,716 @@
+/*
+ *  Lowering, optimisation and execution of traces. Each instruction of a
+ *  recorded loop iteration becomes one or more operations reading guest
+ *  registers or constants: the PC reads as the address of its instruction
+ *  plus 8 and SP and LR read as get_register returns them, so neither needs
+ *  the machine state. The operations are then optimised over the straight
+ *  line body of the loop:
+ *
+ *   - constants and register copies are propagated into later operations,
+ *     and shifts of constants or by a constant zero are folded away
+ *   - flags that are set again before anything reads them are not set
+ *   - registers that are written again before anything reads them are not
+ *     written, and operations left with no effect are removed
+ *
+ *  A guard or a store into a code page leaves the trace, with every guest
+ *  register and the CPSR as they would be after the same instructions on
+ *  the interpreter. Everything is therefore live there, and at the end of
+ *  the body, which continues into the next iteration.
+ */
+
+#include <string.h>
+// The machine state embeds the trace cache, so it is defined first
+#include "../emulate.h"
+#include "ir.h"
+#include "execute.h"
+#include "../utils/io.h"
+#include "../utils/register.h"
+#include "../utils/error.h"
+
+#define IR_GUEST_REGS ((1u << NUM_GENERAL_REGISTERS) - 1)
+
+/**
+ *  Make a source reading a constant
+ *
+ *  @param value: the constant
+ *  @return: the source
+ */
+static ir_src_t ir_const(word_t value) {
+  ir_src_t src = {IR_CONST, value};
+  return src;
+}
+
+/**
+ *  Make a source reading a guest register
+ *
+ *  @param reg: register read by the instruction
+ *  @param addr: address of the instruction
+ *  @return: the source, a constant for registers other than r0-r12
+ */
+static ir_src_t ir_reg(reg_address_t reg, word_t addr) {
+  if (reg < NUM_GENERAL_REGISTERS) {
+    ir_src_t src = {reg, 0};
+    return src;
+  }
+  if (reg == REG_N_PC) {
+    return ir_const(addr + 8);
+  }
+  // What get_register returns for registers we do not model
+  return ir_const(EC_INVALID_PARAM);
+}
+
+/**
+ *  Find the IR register a guest register is written to
+ *
+ *  @param reg: register written by the instruction, other than the PC
+ *  @return: the IR register, IR_NONE if the write is ignored
+ */
+static byte_t ir_dst(reg_address_t reg) {
+  return reg < NUM_GENERAL_REGISTERS ? reg : IR_NONE;
+}
+
+/**
+ *  Append an operation to a trace
+ *
+ *  @param trace: trace being lowered
+ *  @param kind: kind of the operation
+ *  @param entry: instruction the operation comes from
+ *  @return: the operation, which reads and writes nothing yet
+ */
+static ir_op_t *ir_emit(ir_trace_t *trace, ir_kind_t kind,
+                        const trace_entry_t *entry) {
+  assert(trace->numOps < IR_MAX_OPS);
+  ir_op_t *op = &trace->ops[trace->numOps++];
+  memset(op, 0, sizeof(ir_op_t));
+  op->kind = kind;
+  op->cond = entry->instr.cond;
+  op->dst = IR_NONE;
+  op->shift = IR_NO_SHIFT;
+  op->a = op->b = op->s = op->d = ir_const(0);
+  op->addr = entry->addr;
+  return op;
+}
+
+/**
+ *  Set the second operand of an operation to a shifted register
+ *
+ *  @param op: operation to set
+ *  @param operand: shifted register operand or offset
+ *  @param addr: address of the instruction
+ */
+static void ir_shifted_reg(ir_op_t *op, operand_t operand, word_t addr) {
+  op->b = ir_reg(operand.reg.rm, addr);
+  op->shift = operand.reg.type;
+  if (operand.reg.shiftBy) {
+    op->s = ir_reg(operand.reg.shift.shiftreg.rs, addr);
+  } else {
+    op->s = ir_const(operand.reg.shift.constant.integer);
+  }
+}
+
+/**
+ *  Set the second operand of a transfer to its offset
+ *
+ *  @param op: operation to set
+ *  @param instr: the transfer instruction
+ *  @param addr: address of the instruction
+ */
+static void ir_offset(ir_op_t *op, sdt_instruction_t instr, word_t addr) {
+  if (instr.I) {
+    ir_shifted_reg(op, instr.offset, addr);
+  } else {
+    op->b = ir_const(instr.offset.imm.fixed);
+  }
+}
+
+/**
+ *  Lower a data processing instruction
+ *
+ *  @param trace: trace being lowered
+ *  @param entry: the recorded instruction
+ */
+static void lower_dp(ir_trace_t *trace, const trace_entry_t *entry) {
+  dp_instruction_t instr = entry->instr.i.dp;
+  ir_op_t *op = ir_emit(trace, IR_ALU, entry);
+  op->opcode = instr.opcode;
+  op->setFlags = instr.S;
+  op->a = ir_reg(instr.rn, entry->addr);
+  if (instr.I) {
+    shift_result_t imm = rotate_right_c(
+        left_pad_zeros(instr.operand2.imm.rotated.value),
+        instr.operand2.imm.rotated.rotate * 2);
+    op->b = ir_const(imm.value);
+    op->carry = imm.carry;
+  } else {
+    ir_shifted_reg(op, instr.operand2, entry->addr);
+  }
+  if (instr.opcode != TST && instr.opcode != TEQ && instr.opcode != CMP) {
+    op->dst = ir_dst(instr.rd);
+  }
+}
+
+/**
+ *  Lower a multiply instruction
+ *
+ *  @param trace: trace being lowered
+ *  @param entry: the recorded instruction
+ */
+static void lower_mul(ir_trace_t *trace, const trace_entry_t *entry) {
+  mul_instruction_t instr = entry->instr.i.mul;
+  ir_op_t *op = ir_emit(trace, IR_MUL, entry);
+  op->setFlags = instr.S;
+  op->a = ir_reg(instr.rm, entry->addr);
+  op->b = ir_reg(instr.rs, entry->addr);
+  if (instr.A) {
+    op->s = ir_reg(instr.rn, entry->addr);
+  }
+  op->dst = ir_dst(instr.rd);
+}
+
+/**
+ *  Lower a single data transfer. Post-indexing is a transfer from the base
+ *  followed by the write back of the base; a load that overwrites a
+ *  register the offset or base is read from first copies them to
+ *  temporaries, since execute_sdt reads them before loading.
+ *
+ *  @param trace: trace being lowered
+ *  @param entry: the recorded instruction
+ */
+static void lower_sdt(ir_trace_t *trace, const trace_entry_t *entry) {
+  sdt_instruction_t instr = entry->instr.i.sdt;
+  word_t addr = entry->addr;
+  ir_kind_t kind = instr.L ? IR_LOAD : IR_STORE;
+
+  if (instr.P) {
+    ir_op_t *op = ir_emit(trace, kind, entry);
+    op->a = ir_reg(instr.rn, addr);
+    op->up = instr.U;
+    ir_offset(op, instr, addr);
+    if (instr.L) {
+      op->dst = ir_dst(instr.rd);
+    } else {
+      op->d = ir_reg(instr.rd, addr);
+    }
+    return;
+  }
+
+  ir_op_t base = {0};
+  base.shift = IR_NO_SHIFT;
+  base.b = base.s = ir_const(0);
+  base.a = ir_reg(instr.rn, addr);
+  ir_offset(&base, instr, addr);
+
+  byte_t rd = ir_dst(instr.rd);
+  bool clobbers = instr.L && rd != IR_NONE
+      && (base.a.reg == rd || base.b.reg == rd || base.s.reg == rd);
+  if (clobbers) {
+    ir_op_t *copy = ir_emit(trace, IR_ALU, entry);
+    copy->opcode = MOV;
+    copy->b = base.a;
+    copy->dst = IR_TEMP;
+    base.a.reg = IR_TEMP;
+
+    copy = ir_emit(trace, IR_ALU, entry);
+    copy->opcode = MOV;
+    copy->b = base.b;
+    copy->shift = base.shift;
+    copy->s = base.s;
+    copy->dst = IR_TEMP + 1;
+    base.b.reg = IR_TEMP + 1;
+    base.shift = IR_NO_SHIFT;
+    base.s = ir_const(0);
+  }
+
+  ir_op_t *op = ir_emit(trace, kind, entry);
+  op->a = base.a;
+  op->up = true;
+  if (instr.L) {
+    op->dst = rd;
+  } else {
+    op->d = ir_reg(instr.rd, addr);
+  }
+
+  op = ir_emit(trace, IR_ALU, entry);
+  op->opcode = instr.U ? ADD : SUB;
+  op->a = base.a;
+  op->b = base.b;
+  op->shift = base.shift;
+  op->s = base.s;
+  op->dst = ir_dst(instr.rn);
+}
+
+/**
+ *  Lower a branch. The trace follows the recorded direction, so only a
+ *  conditional branch needs a guard, which leaves to the other direction.
+ *
+ *  @param trace: trace being lowered
+ *  @param entry: the recorded instruction
+ */
+static void lower_brn(ir_trace_t *trace, const trace_entry_t *entry) {
+  if (entry->instr.cond == AL) {
+    return;
+  }
+  word_t offset = l_shift_left(entry->instr.i.brn.offset, 0x2);
+  offset |= (offset >> 23) ? OFFSET_BITMASK : 0x0;
+
+  ir_op_t *op = ir_emit(trace, IR_GUARD, entry);
+  op->up = entry->taken;
+  op->target = entry->taken ? entry->addr + 4
+                            : entry->addr + 8 + (int32_t) offset;
+}
+
+/**
+ *  Lower a recorded loop iteration
+ *
+ *  @param entries: instructions in the order they executed, starting at the
+ *  head of the loop
+ *  @param numEntries: number of instructions, at most TRACE_MAX_INSTRS
+ *  @return: heap-allocated trace, NULL if an instruction cannot be lowered
+ */
+ir_trace_t *ir_lower(const trace_entry_t *entries, int numEntries) {
+  assert(entries != NULL && numEntries > 0
+             && numEntries <= TRACE_MAX_INSTRS);
+  ir_trace_t *trace = calloc(1, sizeof(ir_trace_t));
+  MEM_CHECK(trace, NULL);
+  trace->head = entries[0].addr;
+  trace->headWord = entries[0].word;
+  trace->numInstrs = numEntries;
+
+  for (int i = 0; i < numEntries; i++) {
+    const trace_entry_t *entry = &entries[i];
+    int firstOp = trace->numOps;
+    if (writes_pc(&entry->instr)) {
+      free(trace);
+      return NULL;
+    }
+    switch (entry->instr.type) {
+      case DP:
+        lower_dp(trace, entry);
+        break;
+      case MUL:
+        lower_mul(trace, entry);
+        break;
+      case SDT:
+        lower_sdt(trace, entry);
+        break;
+      case BRN:
+        lower_brn(trace, entry);
+        break;
+      default:
+        free(trace);
+        return NULL;
+    }
+    for (int op = firstOp; op < trace->numOps; op++) {
+      trace->ops[op].instrs = i;
+      trace->ops[op].cycles = trace->cycles;
+    }
+    trace->cycles += cycle_cost(&entry->instr);
+    if (entry->taken) {
+      trace->cycles += CYCLES_BRANCH_TAKEN;
+    }
+  }
+  return trace;
+}
+
+/**
+ *  Replace a register source by what is known of the register
+ *
+ *  @param src: source to rewrite
+ *  @param known: which registers hold a known constant
+ *  @param values: the constants
+ *  @param copies: register each register is a copy of, or IR_NONE
+ */
+static void forward_src(ir_src_t *src, const bool *known,
+                        const word_t *values, const byte_t *copies) {
+  if (src->reg == IR_CONST) {
+    return;
+  }
+  if (known[src->reg]) {
+    *src = ir_const(values[src->reg]);
+  } else if (copies[src->reg] != IR_NONE) {
+    src->reg = copies[src->reg];
+  }
+}
+
+/**
+ *  Fold the shift of an operation's second operand, if its amount is known
+ *  and either the operand is known too or the shift does nothing
+ *
+ *  @param op: operation to fold
+ */
+static void fold_shift(ir_op_t *op) {
+  if (op->shift == IR_NO_SHIFT || op->s.reg != IR_CONST) {
+    return;
+  }
+  byte_t amount = get_byte(op->s.value, 7);
+  if (op->b.reg == IR_CONST) {
+    shift_result_t result;
+    barrel_shift(op->shift, op->b.value, amount, &result);
+    op->b.value = result.value;
+    op->carry = result.carry;
+    op->shift = IR_NO_SHIFT;
+  } else if (op->shift == LSL && amount == 0) {
+    op->carry = 0;
+    op->shift = IR_NO_SHIFT;
+  }
+}
+
+/**
+ *  Propagate constants and copies forward through the body, folding
+ *  operations whose operands are all known into constant moves
+ *
+ *  @param trace: trace to optimise
+ */
+static void fold_constants(ir_trace_t *trace) {
+  bool known[IR_NUM_REGS] = {false};
+  word_t values[IR_NUM_REGS] = {0};
+  byte_t copies[IR_NUM_REGS];
+  memset(copies, IR_NONE, sizeof(copies));
+
+  for (int i = 0; i < trace->numOps; i++) {
+    ir_op_t *op = &trace->ops[i];
+    forward_src(&op->a, known, values, copies);
+    forward_src(&op->b, known, values, copies);
+    forward_src(&op->s, known, values, copies);
+    forward_src(&op->d, known, values, copies);
+    fold_shift(op);
+
+    // A move only reads its second operand
+    bool constant = op->shift == IR_NO_SHIFT && op->b.reg == IR_CONST
+        && (op->a.reg == IR_CONST || op->opcode == MOV);
+    word_t value = 0;
+    if (op->kind == IR_ALU && constant) {
+      byte_t flags;
+      shift_result_t operand = {op->b.value, op->carry};
+      value = alu(op->opcode, op->a.value, operand, &flags);
+    } else if (op->kind == IR_MUL && op->a.reg == IR_CONST
+               && op->b.reg == IR_CONST && op->s.reg == IR_CONST) {
+      value = op->a.value * op->b.value + op->s.value;
+      constant = true;
+    } else {
+      constant = false;
+    }
+    if (constant && !op->setFlags) {
+      op->kind = IR_ALU;
+      op->opcode = MOV;
+      op->a = ir_const(0);
+      op->b = ir_const(value);
+      op->s = ir_const(0);
+      op->carry = 0;
+    }
+
+    if (op->dst == IR_NONE) {
+      continue;
+    }
+    byte_t dst = op->dst;
+    known[dst] = false;
+    copies[dst] = IR_NONE;
+    for (int reg = 0; reg < IR_NUM_REGS; reg++) {
+      if (copies[reg] == dst) {
+        copies[reg] = IR_NONE;
+      }
+    }
+    // Conditional operations and loads may leave the register as it was
+    if (op->cond != AL || op->kind == IR_LOAD) {
+      continue;
+    }
+    if (constant) {
+      known[dst] = true;
+      values[dst] = value;
+    } else if (op->kind == IR_ALU && op->opcode == MOV
+               && op->shift == IR_NO_SHIFT && op->b.reg != dst) {
+      copies[dst] = op->b.reg;
+    }
+  }
+}
+
+/**
+ *  Stop setting flags that are set again before anything reads them
+ *
+ *  @param trace: trace to optimise
+ */
+static void eliminate_dead_flags(ir_trace_t *trace) {
+  // The flags carry into the next iteration
+  bool live = true;
+  for (int i = trace->numOps - 1; i >= 0; i--) {
+    ir_op_t *op = &trace->ops[i];
+    // Each may leave the trace, as a load does when the task blocks on it
+    if (op->kind == IR_GUARD || op->kind == IR_STORE
+        || op->kind == IR_LOAD) {
+      live = true;
+      continue;
+    }
+    if (op->setFlags) {
+      if (!live) {
+        op->setFlags = false;
+      } else if (op->kind == IR_ALU && op->cond == AL) {
+        live = false;
+      }
+    }
+    // A multiply adds to the flags it finds
+    if (op->cond != AL || (op->kind == IR_MUL && op->setFlags)) {
+      live = true;
+    }
+  }
+}
+
+/**
+ *  Mark the registers an operation reads as live
+ *
+ *  @param op: the operation
+ *  @param live: bitmap of live IR registers
+ */
+static void use_srcs(const ir_op_t *op, uint32_t *live) {
+  const ir_src_t *srcs[] = {&op->a, &op->b, &op->s, &op->d};
+  for (size_t i = 0; i < sizeof(srcs) / sizeof(srcs[0]); i++) {
+    if (srcs[i]->reg != IR_CONST) {
+      *live |= 1u << srcs[i]->reg;
+    }
+  }
+}
+
+/**
+ *  Drop writes to registers that are written again before anything reads
+ *  them, and the operations that are then left with no effect
+ *
+ *  @param trace: trace to optimise
+ */
+static void eliminate_dead_stores(ir_trace_t *trace) {
+  // Guest registers carry into the next iteration, temporaries do not
+  uint32_t live = IR_GUEST_REGS;
+  for (int i = trace->numOps - 1; i >= 0; i--) {
+    ir_op_t *op = &trace->ops[i];
+    if (op->kind == IR_GUARD || op->kind == IR_STORE
+        || op->kind == IR_LOAD) {
+      live |= IR_GUEST_REGS;
+    }
+    if (op->dst != IR_NONE && !((live >> op->dst) & 0x1)) {
+      op->dst = IR_NONE;
+    }
+    if (op->dst == IR_NONE && !op->setFlags
+        && (op->kind == IR_ALU || op->kind == IR_MUL)) {
+      op->removed = true;
+      continue;
+    }
+    if (op->dst != IR_NONE && op->cond == AL && op->kind != IR_LOAD) {
+      live &= ~(1u << op->dst);
+    }
+    use_srcs(op, &live);
+  }
+}
+
+/**
+ *  Optimise a lowered trace in place
+ *
+ *  @param trace: trace to optimise
+ */
+void ir_optimise(ir_trace_t *trace) {
+  assert(trace != NULL);
+  fold_constants(trace);
+  eliminate_dead_flags(trace);
+  eliminate_dead_stores(trace);
+
+  int numOps = 0;
+  for (int i = 0; i < trace->numOps; i++) {
+    if (!trace->ops[i].removed) {
+      trace->ops[numOps++] = trace->ops[i];
+    }
+  }
+  trace->numOps = numOps;
+}
+
+/**
+ *  Read a source
+ *
+ *  @param src: source to read
+ *  @param regs: IR registers
+ *  @return: value of the source
+ */
+static inline word_t ir_value(const ir_src_t *src, const word_t *regs) {
+  return src->reg == IR_CONST ? src->value : regs[src->reg];
+}
+
+/**
+ *  Evaluate the second operand of an operation
+ *
+ *  @param op: the operation
+ *  @param regs: IR registers
+ *  @return: value of the operand and the shifter carry
+ */
+static inline shift_result_t ir_operand(const ir_op_t *op,
+                                        const word_t *regs) {
+  shift_result_t result = {ir_value(&op->b, regs), op->carry};
+  if (op->shift != IR_NO_SHIFT) {
+    barrel_shift(op->shift, result.value,
+                 get_byte(ir_value(&op->s, regs), 7), &result);
+  }
+  return result;
+}
+
+/**
+ *  Count the iterations of a wait that can be skipped rather than run: an
+ *  iteration that left the registers, flags and memory as they were, and
+ *  read nothing that may differ, runs the same way again until the next
+ *  timer event. Those ending before that event are skipped.
+ *
+ *  @param state: pointer to the machine state, with a timer
+ *  @param trace: trace just run
+ *  @param steps: instructions run by the end of the iteration
+ *  @param cycles: cycles taken by the end of the iteration
+ *  @return: number of iterations to skip
+ */
+static uint64_t ir_idle_iterations(const emulate_state_t *state,
+                                   const ir_trace_t *trace, uint64_t steps,
+                                   uint64_t cycles) {
+  const systimer_t *timer = state->timer;
+  uint64_t now = timer->instrs ? steps : cycles;
+  uint64_t period = timer->instrs ? trace->numInstrs : trace->cycles;
+  if (timer->wheel.next <= now) {
+    return 0;
+  }
+  uint64_t skipped = (timer->wheel.next - now) / period;
+  // Stop short of the budget, so the iteration using it up is run
+  if (state->budget != 0) {
+    uint64_t left = state->budget > steps
+                    ? (state->budget - steps - 1) / trace->numInstrs : 0;
+    if (left < skipped) {
+      skipped = left;
+    }
+  }
+  return skipped;
+}
+
+/**
+ *  Run a trace until it leaves. The registers are kept in a local register
+ *  file for the whole run and written back on leaving. The guest time is
+ *  brought up to that of each memory access, for the devices, and waits on
+ *  the timer are skipped.
+ *
+ *  @param state: pointer to the machine state, at the head of the trace
+ *  @param trace: trace to run
+ *  @return: address of the guest instruction to continue from
+ */
+word_t ir_run(emulate_state_t *state, const ir_trace_t *trace) {
+  word_t regs[IR_NUM_REGS] = {0};
+  memcpy(regs, state->registers.r, sizeof(state->registers.r));
+  byte_t flags = get_flags(state);
+  const ir_op_t *end = trace->ops + trace->numOps;
+  word_t exit;
+  // Guest time at the head of the iteration
+  uint64_t steps = state->steps;
+  uint64_t cycles = state->cycles;
+  // State at the head of the iteration, while a timer event is pending
+  word_t waitRegs[NUM_GENERAL_REGISTERS];
+  byte_t waitFlags = 0;
+  uint64_t waitEffects = 0;
+
+  for (;;) {
+    bool waiting = state->timer != NULL
+        && state->timer->wheel.next != WHEEL_NEVER;
+    if (waiting) {
+      memcpy(waitRegs, regs, sizeof(waitRegs));
+      waitFlags = flags;
+      waitEffects = state->effects;
+    }
+    for (const ir_op_t *op = trace->ops; op < end; op++) {
+      if (op->kind == IR_GUARD) {
+        if ((condition_flags(flags, op->cond) != 0) != op->up) {
+          // The branch goes the other way to when it was recorded
+          state->steps = steps + op->instrs + 1;
+          state->cycles = cycles + op->cycles + 1
+              + (op->up ? 0 : CYCLES_BRANCH_TAKEN);
+          exit = op->target;
+          goto leave;
+        }
+        continue;
+      }
+      if (op->cond != AL && !condition_flags(flags, op->cond)) {
+        continue;
+      }
+
+      switch (op->kind) {
+        case IR_ALU: {
+          byte_t result;
+          word_t value = alu(op->opcode, ir_value(&op->a, regs),
+                             ir_operand(op, regs), &result);
+          if (op->setFlags) {
+            flags = result;
+          }
+          if (op->dst != IR_NONE) {
+            regs[op->dst] = value;
+          }
+          break;
+        }
+        case IR_MUL: {
+          word_t value = ir_value(&op->a, regs) * ir_value(&op->b, regs)
+              + ir_value(&op->s, regs);
+          if (op->setFlags) {
+            flags |= N * is_negative(value);
+            flags |= Z * (value == 0);
+          }
+          if (op->dst != IR_NONE) {
+            regs[op->dst] = value;
+          }
+          break;
+        }
+        case IR_LOAD: {
+          word_t offset = ir_operand(op, regs).value;
+          word_t base = ir_value(&op->a, regs);
+          word_t data;
+          state->steps = steps + op->instrs;
+          state->cycles = cycles + op->cycles;
+          int loaded = get_mem_word(state, op->up ? base + offset
+                                                  : base - offset, &data);
+          // The interpreter runs the load again once the task is resumed
+          if (loaded == EC_BLOCKED) {
+            exit = op->addr;
+            goto leave;
+          }
+          if (loaded == EC_OK && op->dst != IR_NONE) {
+            regs[op->dst] = data;
+          }
+          break;
+        }
+        case IR_STORE: {
+          word_t offset = ir_operand(op, regs).value;
+          word_t base = ir_value(&op->a, regs);
+          word_t addr = op->up ? base + offset : base - offset;
+          state->steps = steps + op->instrs;
+          state->cycles = cycles + op->cycles;
+          // The interpreter does the store, and notices the code change
+          if (is_code_page(state, addr)
+              || ((addr & 0x3) && is_code_page(state, addr + 3))) {
+            exit = op->addr;
+            goto leave;
+          }
+          set_mem_word(state, addr, ir_value(&op->d, regs));
+          break;
+        }
+        default:
+          break;
+      }
+    }
+    state->stats.traceIterations++;
+    steps += trace->numInstrs;
+    cycles += trace->cycles;
+    if (waiting && flags == waitFlags && state->effects == waitEffects
+        && memcmp(regs, waitRegs, sizeof(waitRegs)) == 0) {
+      uint64_t skipped = ir_idle_iterations(state, trace, steps, cycles);
+      state->stats.idleIterations += skipped;
+      steps += skipped * trace->numInstrs;
+      cycles += skipped * trace->cycles;
+    }
+    state->steps = steps;
+    state->cycles = cycles;
+    // Leave at the head, where the interpreter notices the budget is used up
+    if (state->budget != 0 && state->steps >= state->budget) {
+      exit = trace->head;
+      goto leave;
+    }
+  }
+
+leave:
+  memcpy(state->registers.r, regs, sizeof(state->registers.r));
+  set_flags(state, flags);
+  return exit;
+}
@@ -0,0 +1,85 @@
+/*
+ *  Intermediate representation of the traces recorded by the trace tier.
+ *  A trace is one iteration of a guest loop along the path it took when
+ *  recorded, lowered to operations on the guest registers. Conditional
+ *  branches become guards that leave the trace when the path differs.
+ */
+
+#ifndef IR_H
+#define IR_H
+
+#include <stdbool.h>
+#include "../utils/arm.h"
+#include "../utils/instructions.h"
+#include "../emulate.h"
+
+#define TRACE_MAX_INSTRS 64
+// An instruction lowers to at most this many operations
+#define IR_OPS_PER_INSTR 4
+#define IR_MAX_OPS (TRACE_MAX_INSTRS * IR_OPS_PER_INSTR)
+#define IR_MAX_PAGES 4
+
+// Registers of the IR: the general registers, then temporaries
+#define IR_NUM_TEMPS 2
+#define IR_TEMP NUM_GENERAL_REGISTERS
+#define IR_NUM_REGS (NUM_GENERAL_REGISTERS + IR_NUM_TEMPS)
+
+#define IR_CONST 0xFF    // source reads the constant in its value
+#define IR_NONE 0xFF     // operation writes no register
+#define IR_NO_SHIFT 0xFF // second operand is used as is
+
+typedef enum {
+  IR_ALU,   // dst = a <opcode> shift(b, s)
+  IR_MUL,   // dst = a * b + s
+  IR_LOAD,  // dst = memory[a +/- shift(b, s)]
+  IR_STORE, // memory[a +/- shift(b, s)] = d
+  IR_GUARD  // leave to target unless cond is as recorded
+} ir_kind_t;
+
+typedef struct {
+  byte_t reg;   // register read, or IR_CONST
+  word_t value; // value when reg is IR_CONST
+} ir_src_t;
+
+typedef struct {
+  byte_t kind;
+  byte_t cond;      // condition the operation executes under
+  byte_t dst;       // register written, or IR_NONE
+  byte_t opcode;    // data processing opcode of an IR_ALU
+  byte_t shift;     // shift type applied to b, or IR_NO_SHIFT
+  flag_t carry;     // shifter carry when b is not shifted
+  flag_t setFlags;
+  flag_t up;        // transfers add the offset, guards expect cond to hold
+  bool removed;     // dropped by an optimisation pass
+  ir_src_t a, b, s, d;
+  word_t addr;      // address of the guest instruction
+  word_t target;    // address a guard leaves to
+  word_t instrs;    // guest instructions before this one in the trace
+  word_t cycles;    // cycles those take
+} ir_op_t;
+
+// An instruction as it executed while recording
+typedef struct {
+  word_t addr;
+  word_t word;
+  instruction_t instr;
+  bool taken; // for a branch, whether it was taken
+} trace_entry_t;
+
+typedef struct {
+  word_t head;      // address the trace starts and loops back to
+  word_t headWord;
+  int numInstrs;
+  word_t cycles;    // of an iteration
+  int numPages;     // code pages the trace was recorded from
+  word_t pages[IR_MAX_PAGES];
+  uint32_t generations[IR_MAX_PAGES];
+  int numOps;
+  ir_op_t ops[IR_MAX_OPS];
+} ir_trace_t;
+
+ir_trace_t *ir_lower(const trace_entry_t *entries, int numEntries);
+void ir_optimise(ir_trace_t *trace);
+word_t ir_run(emulate_state_t *state, const ir_trace_t *trace);
+
+#endif
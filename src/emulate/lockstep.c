@@ -0,0 +1,436 @@
+/*
+ *  Guests of the same binary are run as lanes of one group. Each
+ *  instruction is fetched and decoded once for the group and applied to
+ *  every lane whose condition holds, with the registers of the lanes held
+ *  side by side. Memory stays with each lane.
+ *
+ *  A lane leaves the group, and carries on alone from the same point, when
+ *  it goes its own way: a branch it disagrees with the group on, code that
+ *  differs from the group's, or a store into a word the group has fetched.
+ *  Instructions the group does not cover (halts, PC writes, undefined
+ *  words) take every lane out, so that each runs them as it would alone.
+ */
+
+#include <string.h>
+#include "../emulate.h"
+#include "lockstep.h"
+#include "execute.h"
+#include "predecode.h"
+#include "decode.h"
+#include "../utils/bitops.h"
+#include "../utils/io.h"
+#include "../utils/register.h"
+
+#define FLAGS_SHIFT (sizeof(word_t) * 8 - NUM_FLAGS)
+#define LANE(lane) ((lane_mask_t) 1 << (lane))
+#define FOR_LANES(group, mask, lane) \
+  for (int lane = 0; lane < (group)->numLanes; lane++) \
+    if ((mask) & LANE(lane))
+
+/**
+ *  Count the lanes in a mask
+ *
+ *  @param group: the lanes
+ *  @param mask: lanes to count
+ *  @return: number of lanes in the mask
+ */
+static int lane_count(lockstep_t *group, lane_mask_t mask) {
+  int count = 0;
+  FOR_LANES(group, mask, lane) {
+    count++;
+  }
+  return count;
+}
+
+/**
+ *  Get the value of a register in one lane, as get_register would
+ *
+ *  @param group: the lanes
+ *  @param reg: register's address
+ *  @param lane: lane to read
+ *  @return: word stored at that register
+ */
+static word_t lane_register(lockstep_t *group, reg_address_t reg, int lane) {
+  if (reg < NUM_GENERAL_REGISTERS) {
+    return group->r[reg][lane];
+  }
+  if (reg == REG_N_PC) {
+    return group->pc + 8;
+  }
+  return EC_INVALID_PARAM;
+}
+
+/**
+ *  Set the value of a register in one lane, as set_register would. The
+ *  group never runs instructions that write the PC.
+ *
+ *  @param group: the lanes
+ *  @param reg: register's address
+ *  @param lane: lane to write
+ *  @param value: value to write
+ */
+static void set_lane_register(lockstep_t *group, reg_address_t reg, int lane,
+                              word_t value) {
+  if (reg < NUM_GENERAL_REGISTERS) {
+    group->r[reg][lane] = value;
+  }
+}
+
+/**
+ *  Take lanes out of the group, leaving each ready to run alone from an
+ *  address
+ *
+ *  @param group: the lanes
+ *  @param mask: lanes to take out
+ *  @param addr: address of the next instruction for those lanes
+ */
+static void lockstep_detach(lockstep_t *group, lane_mask_t mask,
+                            word_t addr) {
+  FOR_LANES(group, mask & group->active, lane) {
+    emulate_state_t *state = group->lanes[lane];
+    for (int reg = 0; reg < NUM_GENERAL_REGISTERS; reg++) {
+      state->registers.r[reg] = group->r[reg][lane];
+    }
+    state->registers.cpsr = group->cpsr[lane];
+    pipeline_refill(state, addr);
+  }
+  group->active &= ~mask;
+}
+
+/**
+ *  Check whether the group has fetched a word
+ *
+ *  @param group: the lanes
+ *  @param idx: index of the word in memory
+ *  @return: true iff the word has been fetched in lockstep
+ */
+static bool lockstep_fetched(lockstep_t *group, word_t idx) {
+  return idx < MEM_WORDS && ((group->fetched[idx >> 3] >> (idx & 0x7)) & 0x1);
+}
+
+/**
+ *  Fetch a word for the group. The first time a word is fetched, lanes that
+ *  hold a different word there leave the group before the current
+ *  instruction.
+ *
+ *  @param group: the lanes
+ *  @param addr: aligned address in memory to fetch
+ */
+static void lockstep_fetch(lockstep_t *group, word_t addr) {
+  word_t idx = addr >> 2;
+  if (lockstep_fetched(group, idx)) {
+    return;
+  }
+
+  word_t word = 0;
+  int first = -1;
+  lane_mask_t differ = 0;
+  FOR_LANES(group, group->active, lane) {
+    word_t laneWord;
+    get_word(group->lanes[lane]->memory, addr, &laneWord);
+    if (first < 0) {
+      first = lane;
+      word = laneWord;
+    } else if (laneWord != word) {
+      differ |= LANE(lane);
+    }
+  }
+  lockstep_detach(group, differ, group->pc);
+
+  decode_word(&group->decoded[idx], word);
+  group->fetched[idx >> 3] |= 1 << (idx & 0x7);
+}
+
+/**
+ *  Check whether a store would write into a word the group has fetched
+ *
+ *  @param group: the lanes
+ *  @param addr: address stored to
+ *  @return: true iff the store overlaps a fetched word
+ */
+static bool lockstep_stores_to_code(lockstep_t *group, word_t addr) {
+  if (addr >= MEM_SIZE) {
+    return false;
+  }
+  return lockstep_fetched(group, addr >> 2)
+      || lockstep_fetched(group, (addr + 3) >> 2);
+}
+
+/**
+ *  Find the lanes whose flags meet a condition
+ *
+ *  @param group: the lanes
+ *  @param cond: condition extracted from the instruction
+ *  @return: mask of the active lanes meeting it
+ */
+static lane_mask_t lockstep_condition(lockstep_t *group, byte_t cond) {
+  if (cond == AL) {
+    return group->active;
+  }
+  lane_mask_t mask = 0;
+  FOR_LANES(group, group->active, lane) {
+    if (condition_flags(group->cpsr[lane] >> FLAGS_SHIFT, cond)) {
+      mask |= LANE(lane);
+    }
+  }
+  return mask;
+}
+
+/**
+ *  Evaluate a shifted register operand in one lane, as evaluate_shifted_reg
+ *  would
+ *
+ *  @param group: the lanes
+ *  @param op: operand to evaluate
+ *  @param lane: lane to evaluate it in
+ *  @return: the shifted value and its carry
+ */
+static shift_result_t lane_shifted_reg(lockstep_t *group, operand_t op,
+                                       int lane) {
+  word_t rm = lane_register(group, op.reg.rm, lane);
+  byte_t shiftAmount = op.reg.shift.constant.integer;
+  if (op.reg.shiftBy) {
+    shiftAmount = get_byte(lane_register(group, op.reg.shift.shiftreg.rs,
+                                         lane), 7);
+  }
+  shift_result_t result;
+  barrel_shift(op.reg.type, rm, shiftAmount, &result);
+  return result;
+}
+
+/**
+ *  Execute a Data Processing instruction in the lanes of a mask
+ *
+ *  @param group: the lanes
+ *  @param instr: DP instruction to execute
+ *  @param mask: lanes whose condition holds
+ */
+static void lockstep_dp(lockstep_t *group, dp_instruction_t instr,
+                        lane_mask_t mask) {
+  bool writes = instr.opcode != TST && instr.opcode != TEQ
+      && instr.opcode != CMP;
+  shift_result_t barrel = {0};
+  if (instr.I) {
+    barrel = rotate_right_c(left_pad_zeros(instr.operand2.imm.rotated.value),
+                            instr.operand2.imm.rotated.rotate * 2);
+  }
+
+  FOR_LANES(group, mask, lane) {
+    if (!instr.I) {
+      barrel = lane_shifted_reg(group, instr.operand2, lane);
+    }
+    byte_t flags;
+    word_t result = alu(instr.opcode, lane_register(group, instr.rn, lane),
+                        barrel, &flags);
+    if (instr.S) {
+      group->cpsr[lane] = (word_t) flags << FLAGS_SHIFT;
+    }
+    if (writes) {
+      set_lane_register(group, instr.rd, lane, result);
+    }
+  }
+}
+
+/**
+ *  Execute a Multiply instruction in the lanes of a mask
+ *
+ *  @param group: the lanes
+ *  @param instr: MUL instruction to execute
+ *  @param mask: lanes whose condition holds
+ */
+static void lockstep_mul(lockstep_t *group, mul_instruction_t instr,
+                         lane_mask_t mask) {
+  FOR_LANES(group, mask, lane) {
+    word_t result = lane_register(group, instr.rm, lane)
+        * lane_register(group, instr.rs, lane);
+    if (instr.A) {
+      result += lane_register(group, instr.rn, lane);
+    }
+    // As execute_mul, the N and Z flags are added to those already set
+    if (instr.S) {
+      word_t flags = (N * is_negative(result)) | (Z * (result == 0));
+      group->cpsr[lane] |= flags << FLAGS_SHIFT;
+    }
+    set_lane_register(group, instr.rd, lane, result);
+  }
+}
+
+/**
+ *  Execute a Single Data Transfer instruction in the lanes of a mask. Lanes
+ *  that would store into a fetched word leave the group before it.
+ *
+ *  @param group: the lanes
+ *  @param instr: SDT instruction to execute
+ *  @param mask: lanes whose condition holds
+ */
+static void lockstep_sdt(lockstep_t *group, sdt_instruction_t instr,
+                         lane_mask_t mask) {
+  word_t addrs[LOCKSTEP_WIDTH];
+  word_t bases[LOCKSTEP_WIDTH];
+  lane_mask_t leave = 0;
+  FOR_LANES(group, mask, lane) {
+    word_t offset = instr.offset.imm.fixed;
+    if (instr.I) {
+      offset = lane_shifted_reg(group, instr.offset, lane).value;
+    }
+    word_t rn = lane_register(group, instr.rn, lane);
+    word_t moved = instr.U ? rn + offset : rn - offset;
+    addrs[lane] = instr.P ? moved : rn;
+    bases[lane] = moved;
+    if (!instr.L && lockstep_stores_to_code(group, addrs[lane])) {
+      leave |= LANE(lane);
+    }
+  }
+  lockstep_detach(group, leave, group->pc);
+  mask &= group->active;
+
+  FOR_LANES(group, mask, lane) {
+    emulate_state_t *state = group->lanes[lane];
+    if (instr.L) {
+      word_t data;
+      if (!get_mem_word(state, addrs[lane], &data)) {
+        set_lane_register(group, instr.rd, lane, data);
+      }
+    } else {
+      set_mem_word(state, addrs[lane],
+                   lane_register(group, instr.rd, lane));
+    }
+    if (!instr.P) {
+      set_lane_register(group, instr.rn, lane, bases[lane]);
+    }
+  }
+}
+
+/**
+ *  Execute a branch in the lanes of a mask. If the lanes disagree, the
+ *  larger side stays in the group.
+ *
+ *  @param group: the lanes
+ *  @param instr: BRN instruction to execute
+ *  @param mask: lanes whose condition holds
+ */
+static void lockstep_brn(lockstep_t *group, brn_instruction_t instr,
+                         lane_mask_t mask) {
+  word_t offset = l_shift_left(instr.offset, 0x2);
+  offset |= (offset >> 23) ? OFFSET_BITMASK : 0x0;
+  word_t target = group->pc + 8 + (int32_t) offset;
+  word_t next = group->pc + 4;
+
+  lane_mask_t notTaken = group->active & ~mask;
+  if (lane_count(group, mask) >= lane_count(group, notTaken)) {
+    lockstep_detach(group, notTaken, next);
+    group->pc = target;
+  } else {
+    lockstep_detach(group, mask, target);
+    group->pc = next;
+  }
+}
+
+/**
+ *  Count an instruction run by lanes in their steps and cycles, as
+ *  execute_program would for each alone
+ *
+ *  @param group: the lanes
+ *  @param ran: lanes that ran the instruction
+ *  @param taken: lanes among them that took it as a branch
+ *  @param cycles: cycles of the instruction, without a taken branch
+ */
+static void lockstep_retire(lockstep_t *group, lane_mask_t ran,
+                            lane_mask_t taken, word_t cycles) {
+  FOR_LANES(group, ran, lane) {
+    emulate_state_t *state = group->lanes[lane];
+    state->stats.lockstepSteps++;
+    state->steps++;
+    state->cycles += (taken & LANE(lane)) ? cycles + CYCLES_BRANCH_TAKEN
+                                          : cycles;
+  }
+}
+
+/**
+ *  Execute one instruction in every lane of the group, or take the lanes
+ *  out of the group if it cannot
+ *
+ *  @param group: the lanes
+ */
+static void lockstep_step(lockstep_t *group) {
+  word_t addr = group->pc;
+  if ((addr & 0x3) || addr + 8 > MEM_SIZE) {
+    lockstep_detach(group, group->active, addr);
+    return;
+  }
+  lockstep_fetch(group, addr);
+  lockstep_fetch(group, addr + 4);
+  if (!group->active) {
+    return;
+  }
+
+  // The group leaves the halt, and what it does not cover, to the lanes
+  instruction_t *instr = &group->decoded[addr >> 2];
+  if (instr->type == HAL || instr->type == UND || writes_pc(instr)) {
+    lockstep_detach(group, group->active, addr);
+    return;
+  }
+  switch (instr->cond) {
+    case EQ:
+    case NE:
+    case GE:
+    case LT:
+    case GT:
+    case LE:
+    case AL:
+      break;
+    default:
+      lockstep_detach(group, group->active, addr);
+      return;
+  }
+
+  lane_mask_t mask = lockstep_condition(group, instr->cond);
+  lane_mask_t ran = group->active;
+  switch (instr->type) {
+    case DP:
+      lockstep_dp(group, instr->i.dp, mask);
+      break;
+    case MUL:
+      lockstep_mul(group, instr->i.mul, mask);
+      break;
+    case SDT:
+      // Lanes that left the group before a store run it alone
+      lockstep_sdt(group, instr->i.sdt, mask);
+      ran &= group->active;
+      break;
+    case BRN:
+      // Lanes that left the group at a branch have still run it
+      lockstep_brn(group, instr->i.brn, mask);
+      lockstep_retire(group, ran, mask, cycle_cost(instr));
+      return;
+    default:
+      break;
+  }
+  lockstep_retire(group, ran, 0, cycle_cost(instr));
+  group->pc = addr + 4;
+}
+
+/**
+ *  Run guests together from the start of memory for as long as they agree.
+ *  Each is left ready to run alone from where it left the group, which is
+ *  the halt if it got there in lockstep.
+ *
+ *  @param lanes: machine states with their binaries loaded and their
+ *  registers cleared
+ *  @param numLanes: number of guests, at most LOCKSTEP_WIDTH
+ *  @return: integer error code based on success of the function
+ */
+int lockstep_run(emulate_state_t **lanes, int numLanes) {
+  FAIL_PRED(numLanes < 1 || numLanes > LOCKSTEP_WIDTH, EC_INVALID_PARAM);
+  lockstep_t *group = calloc(1, sizeof(lockstep_t));
+  MEM_CHECK(group, EC_NULL_POINTER);
+
+  group->numLanes = numLanes;
+  memcpy(group->lanes, lanes, numLanes * sizeof(emulate_state_t *));
+  group->active = (lane_mask_t) ((1ull << numLanes) - 1);
+  while (group->active) {
+    lockstep_step(group);
+  }
+  free(group);
+  return EC_OK;
+}
@@ -0,0 +1,34 @@
+/*
+ *  Lockstep tier: runs several guests of the same binary, differing only in
+ *  their data, one instruction at a time across all of them.
+ */
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <stdint.h>
+#include "../utils/arm.h"
+#include "../utils/instructions.h"
+#include "../emulate.h"
+
+// Guests run together in one group
+#define LOCKSTEP_WIDTH 16
+
+typedef uint32_t lane_mask_t;
+
+typedef struct {
+  int numLanes;
+  emulate_state_t *lanes[LOCKSTEP_WIDTH];
+  lane_mask_t active;               // lanes still in lockstep
+  word_t pc;                        // address of the next instruction
+  word_t r[NUM_GENERAL_REGISTERS][LOCKSTEP_WIDTH];
+  word_t cpsr[LOCKSTEP_WIDTH];
+
+  // Words fetched in lockstep, which every active lane holds the same
+  byte_t fetched[MEM_WORDS / 8];
+  instruction_t decoded[MEM_WORDS];
+} lockstep_t;
+
+int lockstep_run(emulate_state_t **lanes, int numLanes);
+
+#endif
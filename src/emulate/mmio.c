@@ -0,0 +1,358 @@
+/*
+ *  Dispatches the word accesses of the guest to the device whose registers
+ *  they hit, before falling through to guest memory, where aligned words
+ *  shared between cores are accessed atomically and stores into code
+ *  invalidate the instructions decoded from it.
+ */
+
+#include <time.h>
+#include "../emulate.h"
+#include "mmio.h"
+
+/**
+ * Determine whether an address is a performance counter register
+ *
+ * @param addr: address to check
+ * @return: true iff the address is a register in mmio.h
+ */
+static bool is_perf_addr(word_t addr) {
+  return addr >= PERF_CONTROL && addr <= PERF_HIGH && !(addr & 0x3);
+}
+
+/**
+ * Get the host time
+ *
+ * @return: nanoseconds since an arbitrary point
+ */
+static uint64_t host_nanos(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/**
+ * Read a performance counter register
+ *
+ * @param state: non-null pointer to the machine state
+ * @param addr: address of the register
+ * @return: value read
+ */
+static word_t perf_load(emulate_state_t *state, word_t addr) {
+  perf_counters_t *perf = &state->perf;
+  uint64_t value;
+  switch (addr) {
+    case PERF_INSTRS:
+      value = state->steps - perf->steps;
+      break;
+    case PERF_CYCLES:
+      value = state->cycles - perf->cycles;
+      break;
+    case PERF_NANOS:
+      value = host_nanos() - perf->nanos;
+      break;
+    case PERF_HIGH:
+      return perf->high;
+    default:
+      return 0;
+  }
+  perf->high = (word_t) (value >> 32);
+  return (word_t) value;
+}
+
+/**
+ * Write a performance counter register. Only the control word takes
+ * writes.
+ *
+ * @param state: non-null pointer to the machine state
+ * @param addr: address of the register
+ * @param word: value written
+ */
+static void perf_store(emulate_state_t *state, word_t addr, word_t word) {
+  if (addr == PERF_CONTROL && (word & PERF_RESET)) {
+    state->perf.steps = state->steps;
+    state->perf.cycles = state->cycles;
+    state->perf.nanos = host_nanos();
+  }
+}
+
+/**
+ * Check whether an address is a register of the cores, which are only
+ * mapped when there are several
+ *
+ * @param state: non-null pointer to the machine state
+ * @param addr: address accessed
+ * @return: true iff the address is a register in smp.h
+ */
+static bool is_smp_addr(emulate_state_t *state, word_t addr) {
+  return state->smp != NULL && addr >= SMP_BASE && addr < SMP_END
+      && !(addr & 0x3);
+}
+
+/**
+ * Read a register of the cores
+ *
+ * @param state: non-null pointer to the machine state of the reading core
+ * @param addr: address of the register
+ * @return: value read
+ */
+static word_t smp_load(emulate_state_t *state, word_t addr) {
+  smp_t *smp = state->smp;
+  switch (addr) {
+    case SMP_CORE_ID:
+      return state->core;
+    case SMP_NUM_CORES:
+      return smp->numCores;
+    case SMP_LOCK:
+      return __atomic_exchange_n(&smp->lock, 1, __ATOMIC_SEQ_CST);
+  }
+  if (addr < SMP_MAILBOX) {
+    return 0;
+  }
+  return __atomic_exchange_n(&smp->mailboxes[(addr - SMP_MAILBOX) >> 2], 0,
+                             __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Write a register of the cores. The read only ones ignore writes.
+ *
+ * @param state: non-null pointer to the machine state of the writing core
+ * @param addr: address of the register
+ * @param word: value written
+ */
+static void smp_store(emulate_state_t *state, word_t addr, word_t word) {
+  smp_t *smp = state->smp;
+  if (addr == SMP_LOCK) {
+    __atomic_store_n(&smp->lock, word, __ATOMIC_SEQ_CST);
+  } else if (addr >= SMP_MAILBOX) {
+    __atomic_store_n(&smp->mailboxes[(addr - SMP_MAILBOX) >> 2], word,
+                     __ATOMIC_SEQ_CST);
+  }
+}
+
+/**
+ * Check whether an address is a register of the task the machine runs as,
+ * which are only mapped under a scheduler
+ *
+ * @param state: non-null pointer to the machine state
+ * @param addr: address accessed
+ * @return: true iff the address is a register in sched.h
+ */
+static bool is_sched_addr(emulate_state_t *state, word_t addr) {
+  return state->task != NULL && addr >= SCHED_BASE && addr < SCHED_END
+      && !(addr & 0x3);
+}
+
+/**
+ * Read a register of the task
+ *
+ * @param state: non-null pointer to the machine state of the task
+ * @param addr: address of the register
+ * @param dest: non-null pointer to destination of loaded word
+ * @return: EC_BLOCKED if the task has to wait for input, EC_OK otherwise
+ */
+static int sched_load(emulate_state_t *state, word_t addr, word_t *dest) {
+  sched_task_t *task = state->task;
+  *dest = 0;
+  if (addr != SCHED_INPUT) {
+    return EC_OK;
+  }
+  int _status = EC_BLOCKED;
+  pthread_mutex_lock(&task->lock);
+  if (task->inputLen > 0) {
+    *dest = task->input[task->inputHead];
+    task->inputHead = (task->inputHead + 1) % SCHED_INPUT_WORDS;
+    task->inputLen--;
+    _status = EC_OK;
+  }
+  pthread_mutex_unlock(&task->lock);
+  return _status;
+}
+
+/**
+ * Write a register of the task. The input ignores writes.
+ *
+ * @param state: non-null pointer to the machine state of the task
+ * @param addr: address of the register
+ * @param word: value written
+ */
+static void sched_store(emulate_state_t *state, word_t addr, word_t word) {
+  sched_task_t *task = state->task;
+  if (addr == SCHED_OUTPUT && task->output != NULL) {
+    task->output(task, word);
+  }
+}
+
+/**
+ * Check whether a word access goes to memory shared between cores, where
+ * aligned words are accessed atomically
+ *
+ * @param state: non-null pointer to the machine state
+ * @param byteAddr: address accessed
+ * @return: true iff the access is atomic
+ */
+static bool is_shared_word(emulate_state_t *state, word_t byteAddr) {
+  return state->smp != NULL && byteAddr < MEM_SIZE && !(byteAddr & 0x3);
+}
+
+/**
+ * Check whether an address is a register of the system timer, which is only
+ * mapped when the machine has one
+ *
+ * @param state: non-null pointer to the machine state
+ * @param addr: address accessed
+ * @return: true iff the address is a register in timer.h
+ */
+static bool is_timer_addr(emulate_state_t *state, word_t addr) {
+  return state->timer != NULL && addr >= TIMER_BASE && addr < TIMER_END
+      && !(addr & 0x3);
+}
+
+/**
+ * Check whether an address is a register of the modelled GPIO pins, which
+ * replace the GPIO messages when the machine has them
+ *
+ * @param state: non-null pointer to the machine state
+ * @param addr: address accessed
+ * @return: true iff the address is a register in gpio.h
+ */
+static bool is_gpio_pin_addr(emulate_state_t *state, word_t addr) {
+  return state->gpio != NULL && addr >= GPIO_BASE && addr < GPIO_END
+      && !(addr & 0x3);
+}
+
+/**
+ * Check whether an address is a register of the UART, which is only mapped
+ * when the machine has one
+ *
+ * @param state: non-null pointer to the machine state
+ * @param addr: address accessed
+ * @return: true iff the address is a register in uart.h
+ */
+static bool is_uart_addr(emulate_state_t *state, word_t addr) {
+  return state->uart != NULL && (addr == UART_DR || addr == UART_FR);
+}
+
+/**
+ *  Read a 32 bit word from the emulator memory
+ *
+ *  @param state: non-null pointer to the machine state
+ *  @param byteAddr: byte address to read from
+ *  @param dest: non-null pointer to destination of loaded word
+ *  @return: int error code indicating success or failure
+ */
+int get_mem_word(emulate_state_t *state, word_t byteAddr, word_t *dest) {
+  assert(state != NULL);
+  if (is_timer_addr(state, byteAddr)) {
+    *dest = timer_load(state, byteAddr);
+    return EC_OK;
+  }
+  // Only guest stores change the pins, so reads are not effects
+  if (is_gpio_pin_addr(state, byteAddr)) {
+    *dest = gpio_load(state, byteAddr);
+    return EC_OK;
+  }
+  if (is_uart_addr(state, byteAddr)) {
+    *dest = uart_load(state, byteAddr);
+    return EC_OK;
+  }
+  if (is_smp_addr(state, byteAddr)) {
+    state->effects++;
+    *dest = smp_load(state, byteAddr);
+    return EC_OK;
+  }
+  if (is_sched_addr(state, byteAddr)) {
+    state->effects++;
+    return sched_load(state, byteAddr, dest);
+  }
+  if (is_perf_addr(byteAddr)) {
+    state->effects++;
+    *dest = perf_load(state, byteAddr);
+    return EC_OK;
+  }
+  if (check_address_invalid(byteAddr)) {
+    return EC_INVALID_PARAM;
+  }
+
+  // GPIO extension
+  if (is_gpio_addr(byteAddr)) {
+    state->effects++;
+    print_gpio_access(state->out, byteAddr);
+    *dest = byteAddr;
+    return EC_OK;
+  }
+  if (is_shared_word(state, byteAddr)) {
+    word_t word = __atomic_load_n((word_t *) &state->memory[byteAddr],
+                                  __ATOMIC_ACQUIRE);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap32(word);
+#endif
+    *dest = word;
+    return EC_OK;
+  }
+  get_word(state->memory, byteAddr, dest);
+  return EC_OK;
+}
+
+/**
+ * Write a word at a specified byte address in memory. A store into a page
+ * holding decoded instructions invalidates them, so the only cost on the
+ * store path is a test of the code page bitmap.
+ *
+ *  @param state: non-null pointer to the machine state
+ *  @param byteAddr: byte address to be written into
+ *  @param word: word to write into memory
+ *  @return: return 0 iff success
+ */
+int set_mem_word(emulate_state_t *state, word_t byteAddr, word_t word) {
+  assert(state != NULL);
+  state->effects++;
+  if (is_timer_addr(state, byteAddr)) {
+    timer_store(state, byteAddr, word);
+    return EC_OK;
+  }
+  if (is_gpio_pin_addr(state, byteAddr)) {
+    gpio_store(state, byteAddr, word);
+    return EC_OK;
+  }
+  if (is_uart_addr(state, byteAddr)) {
+    uart_store(state, byteAddr, word);
+    return EC_OK;
+  }
+  if (is_smp_addr(state, byteAddr)) {
+    smp_store(state, byteAddr, word);
+    return EC_OK;
+  }
+  if (is_sched_addr(state, byteAddr)) {
+    sched_store(state, byteAddr, word);
+    return EC_OK;
+  }
+  if (is_perf_addr(byteAddr)) {
+    perf_store(state, byteAddr, word);
+    return EC_OK;
+  }
+  if (check_address_invalid(byteAddr)) { return EC_INVALID_PARAM; }
+  // GPIO extension
+  if (is_gpio_addr(byteAddr)) {
+    print_gpio_access(state->out, byteAddr);
+    return EC_OK;
+  }
+  // Cores do not cache decoded instructions, so there is nothing to drop
+  if (is_shared_word(state, byteAddr)) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap32(word);
+#endif
+    __atomic_store_n((word_t *) &state->memory[byteAddr], word,
+                     __ATOMIC_RELEASE);
+    return EC_OK;
+  }
+  int _status = set_word(state->memory, byteAddr, word);
+
+  if (is_code_page(state, byteAddr)) {
+    invalidate_code_page(state, byteAddr);
+  }
+  // An unaligned word may straddle into the next page
+  if ((byteAddr & 0x3) && is_code_page(state, byteAddr + 3)) {
+    invalidate_code_page(state, byteAddr + 3);
+  }
+  return _status;
+}
@@ -0,0 +1,27 @@
+/*
+ *  Word accesses of the guest, which go either to memory or to the
+ *  registers of a device mapped beyond it. A device is only mapped when the
+ *  machine has it, so an address of one that is absent falls through to
+ *  the checks of guest memory.
+ */
+
+#ifndef MMIO_H
+#define MMIO_H
+
+#include "../utils/arm.h"
+#include "../emulate.h"
+
+// Performance counters, each counting from its last reset. A read of the
+// low word of a counter latches its high word, read at PERF_HIGH. Writing
+// PERF_RESET to PERF_CONTROL resets them all.
+#define PERF_CONTROL 0x20202000
+#define PERF_INSTRS 0x20202004 // instructions retired
+#define PERF_CYCLES 0x20202008 // cycles as modelled in execute.h
+#define PERF_NANOS 0x2020200C  // host nanoseconds
+#define PERF_HIGH 0x20202010
+#define PERF_RESET 0x1
+
+int get_mem_word(emulate_state_t *state, word_t byteAddr, word_t *dest);
+int set_mem_word(emulate_state_t *state, word_t byteAddr, word_t word);
+
+#endif
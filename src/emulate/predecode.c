@@ -0,0 +1,290 @@
+/*
+ *  Decoded instructions are kept in a cache with one entry per word of guest
+ *  memory. Filling an entry marks its page as code, and a store into a code
+ *  page drops the entries of that page (see set_mem_word), so the cache is
+ *  always consistent with memory. With a cache directory, words not yet in
+ *  the cache come from the table of the binary mapped by diskcache_load.
+ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <string.h>
+#include "predecode.h"
+#include "decode.h"
+#include "../utils/io.h"
+#include "../utils/error.h"
+#include "../utils/register.h"
+
+/**
+ * Get the index of the code page containing an address
+ *
+ * @param byteAddr: address in guest memory
+ * @return: index of the page in the code page bitmap
+ */
+static word_t code_page(word_t byteAddr) {
+  return (byteAddr >> CODE_PAGE_SHIFT) & (NUM_CODE_PAGES - 1);
+}
+
+/**
+ * Check whether a page contains instructions that have been decoded
+ *
+ * @param state: non-null pointer to the machine state
+ * @param byteAddr: any address within the page
+ * @return: true iff the page is marked as code
+ */
+bool is_code_page(emulate_state_t *state, word_t byteAddr) {
+  word_t page = code_page(byteAddr);
+  return (state->code_pages[page >> 3] >> (page & 0x7)) & 0x1;
+}
+
+/**
+ * Mark a page as containing decoded instructions
+ *
+ * @param state: non-null pointer to the machine state
+ * @param byteAddr: any address within the page
+ */
+void mark_code_page(emulate_state_t *state, word_t byteAddr) {
+  word_t page = code_page(byteAddr);
+  state->code_pages[page >> 3] |= 1 << (page & 0x7);
+}
+
+/**
+ * Drop every cached decode for a page and unmark it, after guest code
+ * wrote into it
+ *
+ * @param state: non-null pointer to the machine state
+ * @param byteAddr: any address within the page
+ */
+void invalidate_code_page(emulate_state_t *state, word_t byteAddr) {
+  word_t page = code_page(byteAddr);
+  state->code_pages[page >> 3] &= ~(1 << (page & 0x7));
+  state->dcache.warmPages[page >> 3] &= ~(1 << (page & 0x7));
+
+  word_t firstWord = (page << CODE_PAGE_SHIFT) >> 2;
+  memset(&state->dcache.valid[firstWord >> 3], 0, (CODE_PAGE_SIZE >> 2) >> 3);
+  state->dcache.invalidations++;
+  state->dcache.generations[page]++;
+}
+
+/**
+ *  Find the fused handler for a pair of adjacent instructions
+ *
+ *  @param first: instruction at the lower address
+ *  @param second: instruction in the word after it
+ *  @return: the fusion that executes both, FUSE_NONE if there is none
+ */
+fusion_t fusion_kind(const instruction_t *first, const instruction_t *second) {
+  if (first->cond != AL) {
+    return FUSE_NONE;
+  }
+  if (first->type == DP && second->type == BRN) {
+    dp_instruction_t dp = first->i.dp;
+    if (dp.opcode == SUB && dp.S && dp.rd != REG_N_PC && second->cond == NE) {
+      return FUSE_SUBS_BNE;
+    }
+    if (dp.opcode == CMP) {
+      return FUSE_CMP_BRN;
+    }
+  }
+  if (first->type == SDT && second->type == DP) {
+    sdt_instruction_t sdt = first->i.sdt;
+    dp_instruction_t dp = second->i.dp;
+    if (sdt.L && sdt.P && sdt.rd != REG_N_PC && dp.opcode == ADD
+        && dp.rd != REG_N_PC
+        && (dp.rn == sdt.rd || (!dp.I && dp.operand2.reg.rm == sdt.rd))) {
+      return FUSE_LDR_ADD;
+    }
+  }
+  return FUSE_NONE;
+}
+
+/**
+ *  Check that an instruction can be the second half of a fusion
+ *
+ *  @param fusion: fusion tagged on the first half
+ *  @param second: instruction that would execute next
+ *  @return: true iff the fused handler can execute it
+ */
+bool fusion_matches(fusion_t fusion, const instruction_t *second) {
+  switch (fusion) {
+    case FUSE_CMP_BRN:
+      return second->type == BRN;
+    case FUSE_SUBS_BNE:
+      return second->type == BRN && second->cond == NE;
+    case FUSE_LDR_ADD:
+      return second->type == DP && second->i.dp.opcode == ADD
+          && second->i.dp.rd != REG_N_PC;
+    default:
+      return false;
+  }
+}
+
+/**
+ *  Decode the word at a given address, going through the decode cache
+ *
+ *  @param state: pointer to the machine state
+ *  @param byteAddr: address the word was fetched from
+ *  @param word: word fetched from byteAddr
+ *  @param instr: instruction to load with the decoded word
+ *  @return: integer error code returned by decode_word
+ */
+int predecode(emulate_state_t *state, word_t byteAddr, word_t word,
+              instruction_t *instr) {
+  assert(state != NULL && instr != NULL);
+
+  // Only aligned words in RAM are cached, and only with a single core, as
+  // other cores may write code at any time
+  if (byteAddr >= MEM_SIZE || (byteAddr & 0x3) || state->smp != NULL) {
+    return decode_word(instr, word);
+  }
+
+  decode_cache_t *dcache = &state->dcache;
+  word_t idx = byteAddr >> 2;
+  if ((dcache->valid[idx >> 3] >> (idx & 0x7)) & 0x1) {
+    *instr = dcache->entries[idx];
+    return instr->type == UND ? EC_UNSUPPORTED_OP : EC_OK;
+  }
+
+  // Then the table mapped from the cache directory, while the page holds
+  // what was loaded
+  word_t page = byteAddr >> CODE_PAGE_SHIFT;
+  if (idx < dcache->warmWords
+      && ((dcache->warmPages[page >> 3] >> (page & 0x7)) & 0x1)) {
+    *instr = dcache->warm[idx];
+    return instr->type == UND ? EC_UNSUPPORTED_OP : EC_OK;
+  }
+
+  int _status = decode_word(instr, word);
+  if (_status == EC_OK && ((byteAddr + 4) & (CODE_PAGE_SIZE - 1))) {
+    instruction_t next;
+    word_t nextWord;
+    get_word(state->memory, byteAddr + 4, &nextWord);
+    if (decode_word(&next, nextWord) == EC_OK) {
+      instr->fusion = fusion_kind(instr, &next);
+    }
+  }
+
+  // A word held in the pipeline may predate a store to its address, so it is
+  // only cached if it still matches memory
+  word_t current;
+  get_word(state->memory, byteAddr, &current);
+  if (current == word) {
+    dcache->entries[idx] = *instr;
+    dcache->valid[idx >> 3] |= 1 << (idx & 0x7);
+    mark_code_page(state, byteAddr);
+  }
+  return _status;
+}
+
+/**
+ *  Fetch the word at an address into the pipeline
+ *
+ *  @param state: pointer to the machine state
+ *  @param byteAddr: address to fetch from
+ *  @return: integer error code returned by get_mem_word
+ */
+int pipeline_fetch(emulate_state_t *state, word_t byteAddr) {
+  state->pipeline.fetched_addr = byteAddr;
+  return get_mem_word(state, byteAddr, state->pipeline.fetched);
+}
+
+/**
+ *  Decode the fetched word of the pipeline without moving it along
+ *
+ *  @param state: pointer to the machine state
+ *  @param instr: instruction to load with the decoded word
+ *  @return: integer error code returned by predecode
+ */
+int pipeline_peek(emulate_state_t *state, instruction_t *instr) {
+  return predecode(state, state->pipeline.fetched_addr,
+                   *state->pipeline.fetched, instr);
+}
+
+/**
+ *  Decode the fetched word of the pipeline into its decoded instruction
+ *
+ *  @param state: pointer to the machine state
+ *  @return: integer error code returned by predecode
+ */
+int pipeline_decode(emulate_state_t *state) {
+  state->pipeline.decoded_addr = state->pipeline.fetched_addr;
+  state->pipeline.decoded_word = *state->pipeline.fetched;
+  return predecode(state, state->pipeline.fetched_addr,
+                   *state->pipeline.fetched, state->pipeline.decoded);
+}
+
+/**
+ *  Refill the pipeline from an address, leaving it as a branch there would:
+ *  the word at the address decoded, the next one fetched and the PC 8 bytes
+ *  ahead
+ *
+ *  @param state: pointer to the machine state
+ *  @param byteAddr: address of the next instruction to execute
+ *  @return: integer error code returned by pipeline_fetch
+ */
+int pipeline_refill(emulate_state_t *state, word_t byteAddr) {
+  set_pc(state, byteAddr);
+  int _status = pipeline_fetch(state, byteAddr);
+  pipeline_decode(state);
+  increment_pc(state);
+  pipeline_fetch(state, get_pc(state));
+  increment_pc(state);
+  return _status;
+}
+
+/**
+ *  Copy a binary over memory, page by page. Only pages that differ are
+ *  copied, and the decodes of those dropped, so the decodes of a binary
+ *  loaded again stay valid.
+ *
+ *  @param state: pointer to the machine state
+ *  @param image: MEM_SIZE bytes of the binary, zero after its end
+ */
+void predecode_reload(emulate_state_t *state, const byte_t *image) {
+  for (word_t addr = 0; addr < MEM_SIZE; addr += CODE_PAGE_SIZE) {
+    if (memcmp(&state->memory[addr], &image[addr], CODE_PAGE_SIZE) != 0) {
+      memcpy(&state->memory[addr], &image[addr], CODE_PAGE_SIZE);
+      if (is_code_page(state, addr)) {
+        invalidate_code_page(state, addr);
+      }
+    }
+  }
+}
+
+/**
+ *  Print the counters collected while emulating
+ *
+ *  @param state: pointer to the state of the emulator
+ *  @param out: stream to print to
+ */
+void print_stats(emulate_state_t *state, FILE *out) {
+  assert(state != NULL);
+  const char *fusionNames[NUM_FUSIONS] = {
+      [FUSE_CMP_BRN] = "cmp+b",
+      [FUSE_LDR_ADD] = "ldr+add",
+      [FUSE_SUBS_BNE] = "subs+bne"
+  };
+
+  fprintf(out, "Decode cache invalidations: %u\n",
+          state->dcache.invalidations);
+  for (int i = FUSE_NONE + 1; i < NUM_FUSIONS; i++) {
+    fprintf(out, "Fused %-8s: %" PRIu64 "\n", fusionNames[i],
+            state->stats.fusions[i]);
+  }
+
+  emulate_stats_t *stats = &state->stats;
+  fprintf(out, "Traces recorded: %" PRIu64 ", given up: %" PRIu64
+               ", retired: %" PRIu64 "\n", stats->tracesRecorded,
+          stats->traceAborts, stats->tracesRetired);
+  fprintf(out, "Trace entries: %" PRIu64 ", iterations: %" PRIu64 "\n",
+          stats->traceEntries, stats->traceIterations);
+  fprintf(out, "IR operations: %" PRIu64 " lowered, %" PRIu64
+               " after optimisation\n", stats->irOpsLowered,
+          stats->irOpsOptimised);
+  fprintf(out, "Instructions run in lockstep: %" PRIu64 "\n",
+          stats->lockstepSteps);
+  fprintf(out, "Idle iterations skipped: %" PRIu64 "\n",
+          stats->idleIterations);
+  fprintf(out, "Instructions: %" PRIu64 ", modelled cycles: %" PRIu64 "\n",
+          state->steps, state->cycles);
+}
@@ -0,0 +1,32 @@
+/*
+ *  Caches decoded instructions per word of guest memory and feeds the
+ *  pipeline from that cache.
+ */
+
+#ifndef PREDECODE_H
+#define PREDECODE_H
+
+#include <stdbool.h>
+#include "../utils/arm.h"
+#include "../utils/instructions.h"
+#include "../emulate.h"
+
+bool is_code_page(emulate_state_t *state, word_t byteAddr);
+void mark_code_page(emulate_state_t *state, word_t byteAddr);
+void invalidate_code_page(emulate_state_t *state, word_t byteAddr);
+
+int predecode(emulate_state_t *state, word_t byteAddr, word_t word,
+              instruction_t *instr);
+
+int pipeline_fetch(emulate_state_t *state, word_t byteAddr);
+int pipeline_peek(emulate_state_t *state, instruction_t *instr);
+int pipeline_decode(emulate_state_t *state);
+int pipeline_refill(emulate_state_t *state, word_t byteAddr);
+void predecode_reload(emulate_state_t *state, const byte_t *image);
+
+fusion_t fusion_kind(const instruction_t *first, const instruction_t *second);
+bool fusion_matches(fusion_t fusion, const instruction_t *second);
+
+void print_stats(emulate_state_t *state, FILE *out);
+
+#endif
@@ -0,0 +1,380 @@
+/*
+ *  Each host thread has a run queue of tasks. A thread runs the task at the
+ *  head of its queue for a quantum, then puts it back at the tail, so the
+ *  tasks of a queue take turns. A thread with an empty queue steals the
+ *  head of another, and sleeps once every queue is empty.
+ *
+ *  A task that reads SCHED_INPUT with no input parks: it is in no queue
+ *  until sched_send gives it a word, which puts it back in one. Only tasks
+ *  with work to do hold a place in a queue, so idle tasks cost nothing but
+ *  their memory.
+ */
+
+#include <string.h>
+#include "../emulate.h"
+#include "sched.h"
+#include "execute.h"
+#include "predecode.h"
+
+typedef struct {
+  pthread_mutex_t lock;
+  sched_task_t *head;
+  sched_task_t *tail;
+} sched_queue_t;
+
+typedef struct {
+  sched_t *sched;
+  int id;
+} sched_thread_t;
+
+struct sched {
+  int numThreads;
+  uint64_t quantum;
+  sched_output_t output;
+  pthread_t ids[SCHED_MAX_THREADS];
+  sched_thread_t threads[SCHED_MAX_THREADS];
+  sched_queue_t queues[SCHED_MAX_THREADS];
+  int queued;                // tasks in the queues, accessed atomically
+  int stopping;              // accessed atomically
+
+  pthread_mutex_t lock;      // guards the fields below
+  pthread_cond_t work;       // signalled when a task is queued
+  pthread_cond_t idle;       // broadcast when no task is left to run
+  int active;                // tasks queued or running
+  unsigned next;             // queue the next task spawned or woken joins
+  sched_task_t **tasks;
+  int numTasks;
+  int maxTasks;
+};
+
+/**
+ *  Put a task at the tail of a queue and wake a sleeping thread for it
+ *
+ *  @param sched: pointer to the scheduler
+ *  @param queue: index of the queue
+ *  @param task: the task, runnable
+ */
+static void sched_enqueue(sched_t *sched, int queue, sched_task_t *task) {
+  sched_queue_t *q = &sched->queues[queue];
+  task->next = NULL;
+  pthread_mutex_lock(&q->lock);
+  if (q->tail != NULL) {
+    q->tail->next = task;
+  } else {
+    q->head = task;
+  }
+  q->tail = task;
+  pthread_mutex_unlock(&q->lock);
+
+  pthread_mutex_lock(&sched->lock);
+  __atomic_add_fetch(&sched->queued, 1, __ATOMIC_SEQ_CST);
+  pthread_cond_signal(&sched->work);
+  pthread_mutex_unlock(&sched->lock);
+}
+
+/**
+ *  Take the task at the head of a queue
+ *
+ *  @param sched: pointer to the scheduler
+ *  @param queue: index of the queue
+ *  @return: the task, or NULL if the queue is empty
+ */
+static sched_task_t *sched_pop(sched_t *sched, int queue) {
+  sched_queue_t *q = &sched->queues[queue];
+  pthread_mutex_lock(&q->lock);
+  sched_task_t *task = q->head;
+  if (task != NULL) {
+    q->head = task->next;
+    if (q->head == NULL) {
+      q->tail = NULL;
+    }
+    __atomic_sub_fetch(&sched->queued, 1, __ATOMIC_SEQ_CST);
+  }
+  pthread_mutex_unlock(&q->lock);
+  return task;
+}
+
+/**
+ *  Take a task from the queue of a thread, or steal one from the others
+ *
+ *  @param sched: pointer to the scheduler
+ *  @param id: index of the thread
+ *  @return: the task, or NULL if every queue is empty
+ */
+static sched_task_t *sched_dequeue(sched_t *sched, int id) {
+  for (int i = 0; i < sched->numThreads; i++) {
+    sched_task_t *task = sched_pop(sched, (id + i) % sched->numThreads);
+    if (task != NULL) {
+      return task;
+    }
+  }
+  return NULL;
+}
+
+/**
+ *  Count a task as no longer queued or running
+ *
+ *  @param sched: pointer to the scheduler
+ */
+static void sched_retire(sched_t *sched) {
+  pthread_mutex_lock(&sched->lock);
+  if (--sched->active == 0) {
+    pthread_cond_broadcast(&sched->idle);
+  }
+  pthread_mutex_unlock(&sched->lock);
+}
+
+/**
+ *  Run a task for a quantum, then queue it again, park it or finish it
+ *
+ *  @param sched: pointer to the scheduler
+ *  @param id: index of the thread running it
+ *  @param task: the task
+ */
+static void sched_slice(sched_t *sched, int id, sched_task_t *task) {
+  pthread_mutex_lock(&task->lock);
+  task->run = TASK_RUNNING;
+  pthread_mutex_unlock(&task->lock);
+
+  emulate_state_t *state = task->state;
+  state->budget = state->steps + sched->quantum;
+  int status = execute_program(state);
+
+  pthread_mutex_lock(&task->lock);
+  // Input may have arrived since the read found none
+  if (status == EC_BUDGET || (status == EC_BLOCKED && task->inputLen > 0)) {
+    task->run = TASK_RUNNABLE;
+    pthread_mutex_unlock(&task->lock);
+    sched_enqueue(sched, id, task);
+    return;
+  }
+  task->run = status == EC_BLOCKED ? TASK_BLOCKED : TASK_DONE;
+  task->status = status;
+  pthread_mutex_unlock(&task->lock);
+  sched_retire(sched);
+}
+
+/**
+ *  Run tasks until the scheduler is freed
+ *
+ *  @param arg: the sched_thread_t of the thread
+ *  @return: NULL
+ */
+static void *sched_main(void *arg) {
+  sched_thread_t *thread = arg;
+  sched_t *sched = thread->sched;
+  while (!__atomic_load_n(&sched->stopping, __ATOMIC_SEQ_CST)) {
+    sched_task_t *task = sched_dequeue(sched, thread->id);
+    if (task != NULL) {
+      sched_slice(sched, thread->id, task);
+      continue;
+    }
+    pthread_mutex_lock(&sched->lock);
+    while (__atomic_load_n(&sched->queued, __ATOMIC_SEQ_CST) == 0
+           && !__atomic_load_n(&sched->stopping, __ATOMIC_SEQ_CST)) {
+      pthread_cond_wait(&sched->work, &sched->lock);
+    }
+    pthread_mutex_unlock(&sched->lock);
+  }
+  return NULL;
+}
+
+/**
+ *  Stop the threads, once they finish the quanta they are running
+ *
+ *  @param sched: pointer to the scheduler
+ *  @param numStarted: number of threads started
+ */
+static void sched_stop(sched_t *sched, int numStarted) {
+  pthread_mutex_lock(&sched->lock);
+  __atomic_store_n(&sched->stopping, 1, __ATOMIC_SEQ_CST);
+  pthread_cond_broadcast(&sched->work);
+  pthread_mutex_unlock(&sched->lock);
+  for (int i = 0; i < numStarted; i++) {
+    pthread_join(sched->ids[i], NULL);
+  }
+}
+
+/**
+ *  Free a stopped scheduler and its tasks, detaching the machine states
+ *
+ *  @param sched: pointer to the scheduler
+ */
+static void sched_destroy(sched_t *sched) {
+  for (int i = 0; i < sched->numTasks; i++) {
+    sched->tasks[i]->state->task = NULL;
+    sched->tasks[i]->state->budget = 0;
+    pthread_mutex_destroy(&sched->tasks[i]->lock);
+    free(sched->tasks[i]);
+  }
+  for (int i = 0; i < SCHED_MAX_THREADS; i++) {
+    pthread_mutex_destroy(&sched->queues[i].lock);
+  }
+  pthread_mutex_destroy(&sched->lock);
+  pthread_cond_destroy(&sched->work);
+  pthread_cond_destroy(&sched->idle);
+  free(sched->tasks);
+  free(sched);
+}
+
+/**
+ *  Start a scheduler
+ *
+ *  @param numThreads: number of host threads, at most SCHED_MAX_THREADS
+ *  @param quantum: instructions a task runs before giving up its thread
+ *  @param output: called with each word a task writes to SCHED_OUTPUT, or
+ *  NULL to drop them
+ *  @return: the scheduler, or NULL if it could not be started
+ */
+sched_t *sched_new(int numThreads, uint64_t quantum, sched_output_t output) {
+  FAIL_PRED(numThreads < 1 || numThreads > SCHED_MAX_THREADS || quantum == 0,
+            NULL);
+  sched_t *sched = calloc(1, sizeof(sched_t));
+  MEM_CHECK(sched, NULL);
+  sched->quantum = quantum;
+  sched->output = output;
+  pthread_mutex_init(&sched->lock, NULL);
+  pthread_cond_init(&sched->work, NULL);
+  pthread_cond_init(&sched->idle, NULL);
+  for (int i = 0; i < SCHED_MAX_THREADS; i++) {
+    pthread_mutex_init(&sched->queues[i].lock, NULL);
+  }
+
+  sched->numThreads = numThreads;
+  for (int i = 0; i < numThreads; i++) {
+    sched->threads[i].sched = sched;
+    sched->threads[i].id = i;
+    if (pthread_create(&sched->ids[i], NULL, sched_main, &sched->threads[i])
+        != 0) {
+      sched_stop(sched, i);
+      sched_destroy(sched);
+      return NULL;
+    }
+  }
+  return sched;
+}
+
+/**
+ *  Add a guest to the scheduler, which starts running it from address 0
+ *
+ *  @param sched: pointer to the scheduler
+ *  @param state: pointer to the machine state of the guest, with its binary
+ *  loaded; it belongs to the task until the scheduler is freed
+ *  @param data: pointer kept in the task for the embedder
+ *  @param task: set to the new task, which belongs to the scheduler
+ *  @return: integer error code based on success of the function
+ */
+int sched_spawn(sched_t *sched, emulate_state_t *state, void *data,
+                sched_task_t **task) {
+  sched_task_t *created = calloc(1, sizeof(sched_task_t));
+  MEM_CHECK(created, EC_NULL_POINTER);
+  created->sched = sched;
+  created->state = state;
+  created->output = sched->output;
+  created->data = data;
+  created->run = TASK_RUNNABLE;
+  pthread_mutex_init(&created->lock, NULL);
+  state->task = created;
+  int _status = pipeline_refill(state, 0x0);
+  CHECK_STATUS(_status, state->task = NULL; free(created));
+
+  pthread_mutex_lock(&sched->lock);
+  if (sched->numTasks == sched->maxTasks) {
+    int maxTasks = sched->maxTasks ? 2 * sched->maxTasks : 16;
+    sched_task_t **tasks = realloc(sched->tasks,
+                                   maxTasks * sizeof(sched_task_t *));
+    MEM_CHECK_C(tasks, EC_NULL_POINTER, pthread_mutex_unlock(&sched->lock);
+        state->task = NULL; free(created));
+    sched->tasks = tasks;
+    sched->maxTasks = maxTasks;
+  }
+  sched->tasks[sched->numTasks++] = created;
+  sched->active++;
+  int queue = sched->next++ % sched->numThreads;
+  pthread_mutex_unlock(&sched->lock);
+
+  sched_enqueue(sched, queue, created);
+  *task = created;
+  return EC_OK;
+}
+
+/**
+ *  Send a word to a task, waking it if it is waiting for input
+ *
+ *  @param task: pointer to the task
+ *  @param word: word for the task to read from SCHED_INPUT
+ *  @return: EC_BLOCKED if SCHED_INPUT_WORDS words are waiting already,
+ *  EC_INVALID_PARAM if the task is done, EC_OK otherwise
+ */
+int sched_send(sched_task_t *task, word_t word) {
+  pthread_mutex_lock(&task->lock);
+  int _status = EC_OK;
+  if (task->run == TASK_DONE) {
+    _status = EC_INVALID_PARAM;
+  } else if (task->inputLen == SCHED_INPUT_WORDS) {
+    _status = EC_BLOCKED;
+  } else {
+    task->input[(task->inputHead + task->inputLen) % SCHED_INPUT_WORDS] =
+        word;
+    task->inputLen++;
+  }
+  bool wake = _status == EC_OK && task->run == TASK_BLOCKED;
+  if (wake) {
+    task->run = TASK_RUNNABLE;
+  }
+  pthread_mutex_unlock(&task->lock);
+  if (!wake) {
+    return _status;
+  }
+
+  sched_t *sched = task->sched;
+  pthread_mutex_lock(&sched->lock);
+  sched->active++;
+  int queue = sched->next++ % sched->numThreads;
+  pthread_mutex_unlock(&sched->lock);
+  sched_enqueue(sched, queue, task);
+  return EC_OK;
+}
+
+/**
+ *  Get the state of a task
+ *
+ *  @param task: pointer to the task
+ *  @param status: set to the error code of the task once it is done
+ *  @return: the state of the task
+ */
+task_state_t sched_task_state(sched_task_t *task, int *status) {
+  pthread_mutex_lock(&task->lock);
+  task_state_t run = task->run;
+  *status = task->status;
+  pthread_mutex_unlock(&task->lock);
+  return run;
+}
+
+/**
+ *  Wait until every task is done or waiting for input
+ *
+ *  @param sched: pointer to the scheduler
+ */
+void sched_wait(sched_t *sched) {
+  pthread_mutex_lock(&sched->lock);
+  while (sched->active > 0) {
+    pthread_cond_wait(&sched->idle, &sched->lock);
+  }
+  pthread_mutex_unlock(&sched->lock);
+}
+
+/**
+ *  Stop the threads, once they finish the quanta they are running, and free
+ *  the scheduler and its tasks. The machine states of the tasks are left
+ *  as they stopped.
+ *
+ *  @param sched: pointer to the scheduler
+ */
+void sched_free(sched_t *sched) {
+  if (sched == NULL) {
+    return;
+  }
+  sched_stop(sched, sched->numThreads);
+  sched_destroy(sched);
+}
@@ -0,0 +1,66 @@
+/*
+ *  Scheduler for many guests on a few host threads. Each guest is a task
+ *  that runs for a quantum of instructions before giving up its thread, and
+ *  parks without holding a thread while it waits for input.
+ *
+ *  Registers of a task, mapped beyond guest memory:
+ *  - SCHED_INPUT reads as the next word sent to the task by sched_send. A
+ *    read with none waiting parks the task, and the read runs again once a
+ *    word arrives.
+ *  - SCHED_OUTPUT passes each word written to it to the output function of
+ *    the scheduler.
+ */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "../utils/arm.h"
+#include "../emulate.h"
+
+#define SCHED_MAX_THREADS 64
+#define SCHED_INPUT_WORDS 16
+
+#define SCHED_BASE 0x20400000
+#define SCHED_INPUT SCHED_BASE
+#define SCHED_OUTPUT (SCHED_BASE + 0x4)
+#define SCHED_END (SCHED_BASE + 0x8)
+
+typedef struct sched sched_t;
+
+typedef enum {
+  TASK_RUNNABLE,
+  TASK_RUNNING,
+  TASK_BLOCKED,
+  TASK_DONE
+} task_state_t;
+
+// Called on the thread running the task, for each word it outputs
+typedef void (*sched_output_t)(sched_task_t *task, word_t word);
+
+struct sched_task {
+  sched_t *sched;
+  emulate_state_t *state;
+  sched_output_t output;
+  void *data;                    // for the embedder
+  sched_task_t *next;            // in the run queue holding the task
+
+  pthread_mutex_t lock;          // guards the fields below
+  task_state_t run;
+  int status;                    // error code once done
+  word_t input[SCHED_INPUT_WORDS];
+  int inputHead;
+  int inputLen;
+};
+
+sched_t *sched_new(int numThreads, uint64_t quantum, sched_output_t output);
+int sched_spawn(sched_t *sched, emulate_state_t *state, void *data,
+                sched_task_t **task);
+int sched_send(sched_task_t *task, word_t word);
+task_state_t sched_task_state(sched_task_t *task, int *status);
+void sched_wait(sched_t *sched);
+void sched_free(sched_t *sched);
+
+#endif
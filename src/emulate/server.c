@@ -0,0 +1,272 @@
+/*
+ *  The server listens on its socket and forks the workers, which all accept
+ *  connections from it, and forks a new worker whenever one dies. Each
+ *  worker runs the jobs of a connection with its standard output on the
+ *  connection, so the reply is printed exactly as the emulator would print
+ *  it, and is written to the client as it is produced.
+ *
+ *  A worker keeps one machine state for all of its jobs. Loading a binary
+ *  only copies the pages that differ from the last one, so a binary run
+ *  again keeps its decodes and traces.
+ */
+
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "server.h"
+#include "execute.h"
+#include "predecode.h"
+#include "trace.h"
+#include "../utils/io.h"
+#include "../utils/error.h"
+
+static volatile sig_atomic_t stopping = 0;
+
+/**
+ *  Stop the server once the signal interrupts its wait
+ *
+ *  @param sig: the signal, unused
+ */
+static void server_stop(int sig) {
+  (void) sig;
+  stopping = 1;
+}
+
+/**
+ *  Reset the machine state for a new job and load its binary. Traces and
+ *  the decodes of unchanged pages are kept.
+ *
+ *  @param state: pointer to the machine state of the last job
+ *  @param image: MEM_SIZE bytes of the binary, zero after its end
+ */
+static void server_reset(emulate_state_t *state, const byte_t *image) {
+  memset(&state->registers, 0, sizeof(state->registers));
+  memset(&state->stats, 0, sizeof(state->stats));
+  state->traces.pending = TRACE_NONE;
+  state->traces.recording = false;
+  state->budget = 0;
+  state->steps = 0;
+  state->cycles = 0;
+  memset(&state->perf, 0, sizeof(state->perf));
+  state->effects = 0;
+  predecode_reload(state, image);
+  state->dcache.invalidations = 0;
+}
+
+/**
+ *  Print the reply to a request that could not be run
+ *
+ *  @param status: error code of the request
+ *  @return: the error code
+ */
+static int server_reject(int status) {
+  printf("status %d\n", status);
+  fflush(stdout);
+  return status;
+}
+
+/**
+ *  Read one job from a connection, run it and print the reply
+ *
+ *  @param state: pointer to the machine state of the worker
+ *  @param in: stream of requests from the connection
+ *  @param image: buffer of MEM_SIZE bytes to read the binary into
+ *  @return: EC_OK once the reply is printed, EC_SKIP if there are no more
+ *  requests, or an error code if the request could not be read, after which
+ *  the connection is dropped
+ */
+int server_job(emulate_state_t *state, FILE *in, byte_t *image) {
+  char line[SERVER_MAX_REQUEST];
+  if (fgets(line, sizeof(line), in) == NULL) {
+    return EC_SKIP;
+  }
+  char *save = NULL;
+  char *kind = strtok_r(line, " \n", &save);
+  char *binary = strtok_r(NULL, " \n", &save);
+  if (kind == NULL || binary == NULL
+      || (strcmp(kind, "run") != 0 && strcmp(kind, "bin") != 0)) {
+    return server_reject(EC_INVALID_PARAM);
+  }
+
+  uint64_t budget = 0;
+  bool stats = false;
+  bool trace = true;
+  for (char *option = strtok_r(NULL, " \n", &save); option != NULL;
+       option = strtok_r(NULL, " \n", &save)) {
+    if (strcmp(option, "stats") == 0) {
+      stats = true;
+    } else if (strcmp(option, "no-trace") == 0) {
+      trace = false;
+    } else if (strcmp(option, "steps") == 0
+               && (option = strtok_r(NULL, " \n", &save)) != NULL) {
+      budget = strtoull(option, NULL, 10);
+    } else {
+      return server_reject(EC_INVALID_PARAM);
+    }
+  }
+
+  memset(image, 0, MEM_SIZE);
+  if (strcmp(kind, "bin") == 0) {
+    long size = strtol(binary, NULL, 10);
+    if (size < 0 || size > MEM_SIZE
+        || fread(image, 1, size, in) != (size_t) size) {
+      return server_reject(EC_INVALID_PARAM);
+    }
+  } else {
+    int _status = read_file(binary, image, MEM_SIZE);
+    if (_status != EC_OK) {
+      // The request was read whole, so the connection can carry on
+      server_reject(_status);
+      return EC_OK;
+    }
+  }
+
+  server_reset(state, image);
+  state->budget = budget;
+  state->traces.enabled = trace;
+  int _status = pipeline_refill(state, 0x0);
+  if (_status == EC_OK) {
+    _status = execute_program(state);
+  }
+  if (_status == EC_OK) {
+    _status = execute(state);
+  }
+  if (stats) {
+    print_stats(state, stdout);
+  }
+  printf("status %d\n", _status);
+  fflush(stdout);
+  return EC_OK;
+}
+
+/**
+ *  Serve connections until the worker is killed
+ *
+ *  @param state: pointer to the machine state of the worker
+ *  @param listenFd: the listening socket
+ *  @param image: buffer of MEM_SIZE bytes to read binaries into
+ */
+static void server_worker(emulate_state_t *state, int listenFd,
+                          byte_t *image) {
+  int stdoutFd = dup(STDOUT_FILENO);
+  for (;;) {
+    int conn = accept(listenFd, NULL, NULL);
+    if (conn < 0) {
+      continue;
+    }
+    FILE *in = fdopen(conn, "r");
+    if (in == NULL) {
+      close(conn);
+      continue;
+    }
+    dup2(conn, STDOUT_FILENO);
+    while (server_job(state, in, image) == EC_OK) {
+    }
+    fflush(stdout);
+    dup2(stdoutFd, STDOUT_FILENO);
+    fclose(in);
+  }
+}
+
+/**
+ *  Fork a worker
+ *
+ *  @param state: pointer to the machine state the worker starts from
+ *  @param listenFd: the listening socket
+ *  @param image: buffer of MEM_SIZE bytes to read binaries into
+ *  @return: pid of the worker, or -1 if it could not be forked
+ */
+static pid_t server_spawn(emulate_state_t *state, int listenFd,
+                          byte_t *image) {
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    server_worker(state, listenFd, image);
+  }
+  return pid;
+}
+
+/**
+ *  Listen on a Unix domain socket and serve jobs until the server receives
+ *  SIGINT or SIGTERM
+ *
+ *  @param state: pointer to a cleared machine state, copied into each worker
+ *  @param path: path to create the socket at, replacing any file there
+ *  @param numWorkers: number of workers, at most SERVER_MAX_WORKERS
+ *  @return: integer error code based on success of the function
+ */
+int server_run(emulate_state_t *state, const char *path, int numWorkers) {
+  struct sockaddr_un addr = {.sun_family = AF_UNIX};
+  FAIL_PRED(numWorkers < 1 || numWorkers > SERVER_MAX_WORKERS,
+            EC_INVALID_PARAM);
+  FAIL_PRED(strlen(path) >= sizeof(addr.sun_path), EC_INVALID_PARAM);
+  strcpy(addr.sun_path, path);
+
+  int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  FAIL_SYS(listenFd < 0);
+  unlink(path);
+  if (bind(listenFd, (struct sockaddr *) &addr, sizeof(addr)) < 0
+      || listen(listenFd, SOMAXCONN) < 0) {
+    int _status = EC_FROM_SYS_ERROR(errno);
+    close(listenFd);
+    return _status;
+  }
+  byte_t *image = malloc(MEM_SIZE);
+  MEM_CHECK_C(image, EC_NULL_POINTER, close(listenFd); unlink(path));
+
+  // Without SA_RESTART, so that the signals interrupt the wait below
+  struct sigaction stop = {.sa_handler = server_stop};
+  sigemptyset(&stop.sa_mask);
+  sigaction(SIGTERM, &stop, NULL);
+  sigaction(SIGINT, &stop, NULL);
+  // Clients that hang up make writes fail rather than kill the worker
+  signal(SIGPIPE, SIG_IGN);
+
+  int _status = EC_OK;
+  pid_t workers[SERVER_MAX_WORKERS];
+  int started = 0;
+  for (; started < numWorkers; started++) {
+    workers[started] = server_spawn(state, listenFd, image);
+    if (workers[started] < 0) {
+      _status = EC_FROM_SYS_ERROR(errno);
+      break;
+    }
+  }
+
+  while (_status == EC_OK && !stopping) {
+    pid_t pid = wait(NULL);
+    if (pid < 0) {
+      if (errno != EINTR) {
+        _status = EC_FROM_SYS_ERROR(errno);
+      }
+      continue;
+    }
+    for (int i = 0; i < started; i++) {
+      if (workers[i] == pid) {
+        workers[i] = server_spawn(state, listenFd, image);
+        if (workers[i] < 0) {
+          _status = EC_FROM_SYS_ERROR(errno);
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < started; i++) {
+    if (workers[i] > 0) {
+      kill(workers[i], SIGTERM);
+      waitpid(workers[i], NULL, 0);
+    }
+  }
+  close(listenFd);
+  unlink(path);
+  free(image);
+  return _status;
+}
@@ -0,0 +1,31 @@
+/*
+ *  Emulation server: runs jobs sent over a Unix domain socket on a pool of
+ *  worker processes, each keeping its machine state and decodes between
+ *  jobs.
+ *
+ *  A connection carries any number of jobs, one after another. A job is a
+ *  line naming the binary, followed by options:
+ *
+ *    run <path> [steps <n>] [stats] [no-trace]
+ *    bin <size> [steps <n>] [stats] [no-trace]
+ *
+ *  where bin is followed by the size bytes of the binary. steps stops the
+ *  job after that many instructions, stats adds the counters of --stats and
+ *  no-trace interprets hot loops. The reply is what the emulator prints for
+ *  the binary, ending with a line "status <code>" holding its error code.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdio.h>
+#include "../utils/arm.h"
+#include "../emulate.h"
+
+#define SERVER_MAX_WORKERS 64
+#define SERVER_MAX_REQUEST 4096
+
+int server_run(emulate_state_t *state, const char *path, int numWorkers);
+int server_job(emulate_state_t *state, FILE *in, byte_t *image);
+
+#endif
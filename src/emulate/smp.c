@@ -0,0 +1,82 @@
+/*
+ *  Runs each core on a host thread, from the start of the shared memory
+ *  until it reaches a halt. Cores do not cache decoded instructions or run
+ *  traces, since another core may write code at any time.
+ */
+
+#include <pthread.h>
+#include "../emulate.h"
+#include "smp.h"
+#include "execute.h"
+#include "predecode.h"
+
+typedef struct {
+  emulate_state_t *state;
+  int status;
+} core_thread_t;
+
+/**
+ *  Run one core up to its halt
+ *
+ *  @param arg: the core_thread_t of the core, whose status is set
+ *  @return: NULL
+ */
+static void *core_main(void *arg) {
+  core_thread_t *thread = arg;
+  thread->status = pipeline_refill(thread->state, 0x0);
+  if (thread->status == EC_OK) {
+    thread->status = execute_program(thread->state);
+  }
+  return NULL;
+}
+
+/**
+ *  Run cores, sharing the memory of the first, until each reaches a halt.
+ *  The halts are not executed.
+ *
+ *  @param cores: machine states of the cores, with the binary loaded into
+ *  the first and the registers of all cleared
+ *  @param numCores: number of cores, at most MAX_CORES
+ *  @return: integer error code of the first core to fail
+ */
+int smp_run(emulate_state_t **cores, int numCores) {
+  FAIL_PRED(numCores < 1 || numCores > MAX_CORES, EC_INVALID_PARAM);
+  smp_t *smp = calloc(1, sizeof(smp_t));
+  MEM_CHECK(smp, EC_NULL_POINTER);
+  smp->numCores = numCores;
+
+  core_thread_t threads[MAX_CORES];
+  pthread_t ids[MAX_CORES];
+  for (int i = 0; i < numCores; i++) {
+    cores[i]->memory = cores[0]->memory;
+    cores[i]->smp = smp;
+    cores[i]->core = i;
+    cores[i]->traces.enabled = false;
+    threads[i].state = cores[i];
+    threads[i].status = EC_OK;
+  }
+
+  int _status = EC_OK;
+  int started = 0;
+  while (started < numCores) {
+    int err = pthread_create(&ids[started], NULL, core_main,
+                             &threads[started]);
+    if (err != 0) {
+      _status = EC_FROM_SYS_ERROR(err);
+      break;
+    }
+    started++;
+  }
+  for (int i = 0; i < started; i++) {
+    pthread_join(ids[i], NULL);
+    if (_status == EC_OK) {
+      _status = threads[i].status;
+    }
+  }
+
+  for (int i = 0; i < numCores; i++) {
+    cores[i]->smp = NULL;
+  }
+  free(smp);
+  return _status;
+}
@@ -0,0 +1,44 @@
+/*
+ *  Several cores sharing the memory of the first, each run on its own host
+ *  thread.
+ *
+ *  Memory model: aligned word loads and stores are atomic. A load acquires
+ *  and a store releases, so a core that sees a store also sees every store
+ *  its core made before it. Unaligned accesses are not atomic. The lock and
+ *  the mailboxes below are sequentially consistent, so they also order
+ *  every access around them.
+ *
+ *  Registers of the cores, mapped beyond guest memory:
+ *  - SMP_CORE_ID reads as the number of the core reading it, from 0
+ *  - SMP_NUM_CORES reads as the number of cores
+ *  - SMP_LOCK is a spinlock: a read sets it and returns what it held, so 0
+ *    means the lock was taken, and a write of 0 releases it
+ *  - SMP_MAILBOX + 4 * n is the mailbox of core n: a write leaves a word in
+ *    it and a read takes the word out, leaving 0
+ */
+
+#ifndef SMP_H
+#define SMP_H
+
+#include <stdbool.h>
+#include "../utils/arm.h"
+#include "../emulate.h"
+
+#define MAX_CORES 16
+
+#define SMP_BASE 0x20300000
+#define SMP_CORE_ID SMP_BASE
+#define SMP_NUM_CORES (SMP_BASE + 0x4)
+#define SMP_LOCK (SMP_BASE + 0x8)
+#define SMP_MAILBOX (SMP_BASE + 0x10)
+#define SMP_END (SMP_MAILBOX + 4 * MAX_CORES)
+
+struct smp {
+  int numCores;
+  word_t lock;
+  word_t mailboxes[MAX_CORES];
+};
+
+int smp_run(emulate_state_t **cores, int numCores);
+
+#endif
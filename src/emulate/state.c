@@ -0,0 +1,42 @@
+/*
+ *  Allocation of the machine state, shared by the emulator and its tests.
+ */
+
+#include "../emulate.h"
+
+/**
+ * Allocate space on the heap for the emulator state
+ *
+ * @return: heap-allocated emulate_state_t struct
+ */
+emulate_state_t *emulate_state_new(void) {
+  emulate_state_t *state = calloc(1, sizeof(emulate_state_t));
+  MEM_CHECK(state, NULL);
+  state->memory = state->ram;
+  state->pipeline.decoded = calloc(1, sizeof(instruction_t));
+  MEM_CHECK(state->pipeline.decoded, NULL);
+  state->pipeline.fetched = calloc(1, sizeof(word_t));
+  MEM_CHECK(state->pipeline.fetched, NULL);
+  state->traces.pending = TRACE_NONE;
+  state->out = stdout;
+
+  return state;
+}
+
+/**
+ * Free space on heap of an emulate_state_t
+ *
+ * @param state: pointer to the emulate_state_t to free
+ */
+void emulate_state_free(emulate_state_t *state) {
+  if (state) {
+    diskcache_release(state);
+    trace_release(state);
+    free(state->timer);
+    gpio_free(state->gpio, state->steps);
+    uart_free(state->uart);
+    free(state->pipeline.decoded);
+    free(state->pipeline.fetched);
+  }
+  free(state);
+}
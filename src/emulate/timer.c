@@ -0,0 +1,102 @@
+/*
+ *  The timer is moved on to the guest time only when the guest accesses it,
+ *  which fires the compare matches that became due since.
+ */
+
+#include "../emulate.h"
+#include "timer.h"
+
+#define TIMER_WRAP ((uint64_t) 1 << 32)
+
+/**
+ *  Set the match bit of a compare register, and schedule its next match
+ *  for when the low word of the time comes round to the value again. The
+ *  wheel is only moved on when the guest accesses the timer, so that may
+ *  be several wraps after the match that fired.
+ *
+ *  @param wheel: pointer to the wheel of the timer
+ *  @param event: the match event of the compare register
+ */
+static void timer_match(wheel_t *wheel, wheel_event_t *event) {
+  systimer_t *timer = event->data;
+  timer->status |= 1 << (event - timer->matches);
+  uint64_t when = (wheel->now & ~(TIMER_WRAP - 1))
+                  | (event->when & (TIMER_WRAP - 1));
+  if (when <= wheel->now) {
+    when += TIMER_WRAP;
+  }
+  wheel_schedule(wheel, event, when);
+}
+
+/**
+ *  Allocate a timer at time 0, with no compare register written
+ *
+ *  @param instrs: whether it counts instructions rather than cycles
+ *  @return: the timer, to be freed with free, or NULL
+ */
+systimer_t *timer_new(bool instrs) {
+  systimer_t *timer = calloc(1, sizeof(systimer_t));
+  MEM_CHECK(timer, NULL);
+  timer->instrs = instrs;
+  wheel_init(&timer->wheel);
+  for (int i = 0; i < TIMER_COMPARES; i++) {
+    timer->matches[i].fire = timer_match;
+    timer->matches[i].data = timer;
+  }
+  return timer;
+}
+
+/**
+ *  Read a register of the timer. Reads of the time count as effects, since
+ *  they differ each time.
+ *
+ *  @param state: non-null pointer to the machine state, with a timer
+ *  @param addr: address of the register
+ *  @return: value read
+ */
+word_t timer_load(emulate_state_t *state, word_t addr) {
+  systimer_t *timer = state->timer;
+  uint64_t now = TIMER_NOW(state);
+  wheel_advance(&timer->wheel, now);
+  switch (addr) {
+    case TIMER_CS:
+      return timer->status;
+    case TIMER_CLO:
+      state->effects++;
+      return (word_t) now;
+    case TIMER_CHI:
+      state->effects++;
+      return (word_t) (now >> 32);
+  }
+  return timer->compare[(addr - TIMER_C0) >> 2];
+}
+
+/**
+ *  Write a register of the timer. The time ignores writes.
+ *
+ *  @param state: non-null pointer to the machine state, with a timer
+ *  @param addr: address of the register
+ *  @param word: value written
+ */
+void timer_store(emulate_state_t *state, word_t addr, word_t word) {
+  systimer_t *timer = state->timer;
+  uint64_t now = TIMER_NOW(state);
+  wheel_advance(&timer->wheel, now);
+  if (addr == TIMER_CS) {
+    timer->status &= ~word;
+    return;
+  }
+  if (addr < TIMER_C0) {
+    return;
+  }
+
+  int n = (addr - TIMER_C0) >> 2;
+  timer->compare[n] = word;
+  wheel_cancel(&timer->wheel, &timer->matches[n]);
+  // The first time after now with the value as its low word
+  uint64_t when = (now & ~(TIMER_WRAP - 1)) | word;
+  if (when <= now) {
+    when += TIMER_WRAP;
+  }
+  wheel_schedule(&timer->wheel, &timer->matches[n], when);
+}
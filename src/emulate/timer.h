@@ -0,0 +1,47 @@
+/*
+ *  System timer, laid out as that of the BCM2835 but counting guest time:
+ *  instructions retired, or cycles as modelled in execute.h. Compare
+ *  matches are events on a timing wheel, so they cost nothing until due.
+ *
+ *  Registers of the timer, mapped beyond guest memory:
+ *  - TIMER_CLO and TIMER_CHI read as the low and high words of the time
+ *  - TIMER_C0 + 4 * n is compare register n: once written, bit n of
+ *    TIMER_CS is set each time the low word of the time reaches its value
+ *  - TIMER_CS holds the match bits, and writing a 1 to a bit clears it
+ */
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../utils/arm.h"
+#include "../emulate.h"
+#include "wheel.h"
+
+#define TIMER_COMPARES 4
+
+#define TIMER_BASE 0x20003000
+#define TIMER_CS TIMER_BASE
+#define TIMER_CLO (TIMER_BASE + 0x4)
+#define TIMER_CHI (TIMER_BASE + 0x8)
+#define TIMER_C0 (TIMER_BASE + 0xC)
+#define TIMER_END (TIMER_C0 + 4 * TIMER_COMPARES)
+
+// Guest time the timer counts
+#define TIMER_NOW(state) \
+    ((state)->timer->instrs ? (state)->steps : (state)->cycles)
+
+struct systimer {
+  bool instrs;                               // counts instructions, not cycles
+  word_t status;                             // match bits read at TIMER_CS
+  word_t compare[TIMER_COMPARES];
+  wheel_event_t matches[TIMER_COMPARES];
+  wheel_t wheel;
+};
+
+systimer_t *timer_new(bool instrs);
+word_t timer_load(emulate_state_t *state, word_t addr);
+void timer_store(emulate_state_t *state, word_t addr, word_t word);
+
+#endif
@@ -0,0 +1,264 @@
+/*
+ *  A taken branch to a lower address counts towards its target. Once the
+ *  count reaches TRACE_HOT_THRESHOLD, the instructions executed from the
+ *  target are recorded, unfused, until a branch returns to it. The record
+ *  is lowered to IR, optimised and entered whenever a branch lands on its
+ *  head again. Recording gives up on instructions the IR does not cover
+ *  (PC writes, undefined words) and on paths longer than TRACE_MAX_INSTRS.
+ *
+ *  A trace is only valid while the pages it was recorded from have not been
+ *  written to, which is checked against their generation on every entry.
+ *  On leaving, the pipeline is refilled at the address the trace left to,
+ *  as a branch there would.
+ */
+
+#include <string.h>
+// The machine state embeds the trace cache, so it is defined first
+#include "../emulate.h"
+#include "trace.h"
+#include "execute.h"
+#include "predecode.h"
+#include "decode.h"
+#include "../utils/io.h"
+#include "../utils/register.h"
+
+/**
+ *  Count a taken backward branch, and ask for a recording from its target
+ *  when it is hot
+ *
+ *  @param state: pointer to the machine state
+ *  @param target: address the branch jumps to
+ */
+void trace_count_branch(emulate_state_t *state, word_t target) {
+  trace_cache_t *cache = &state->traces;
+  if (!cache->enabled || cache->recording || target >= MEM_SIZE
+      || (target & 0x3)) {
+    return;
+  }
+  word_t idx = target >> 2;
+  if (cache->heads[idx] != 0 || cache->aborts[idx] >= TRACE_MAX_ABORTS) {
+    return;
+  }
+  if (++cache->hot[idx] >= TRACE_HOT_THRESHOLD) {
+    cache->hot[idx] = 0;
+    cache->pending = target;
+  }
+}
+
+/**
+ *  Give up the current recording
+ *
+ *  @param state: pointer to the machine state
+ */
+static void trace_abort(emulate_state_t *state) {
+  trace_cache_t *cache = &state->traces;
+  word_t idx = cache->recordHead >> 2;
+  if (cache->aborts[idx] < TRACE_MAX_ABORTS) {
+    cache->aborts[idx]++;
+  }
+  cache->recording = false;
+  state->stats.traceAborts++;
+}
+
+/**
+ *  Check whether the decoded instruction can be part of a trace
+ *
+ *  @param state: pointer to the machine state
+ *  @return: true iff the instruction can be lowered to IR
+ */
+static bool traceable(emulate_state_t *state) {
+  instruction_t *instr = state->pipeline.decoded;
+  word_t addr = state->pipeline.decoded_addr;
+  if (addr >= MEM_SIZE || (addr & 0x3)) {
+    return false;
+  }
+  switch (instr->cond) {
+    case EQ:
+    case NE:
+    case GE:
+    case LT:
+    case GT:
+    case LE:
+    case AL:
+      break;
+    default:
+      return false;
+  }
+  switch (instr->type) {
+    case DP:
+    case MUL:
+    case SDT:
+    case BRN:
+      return !writes_pc(instr);
+    default:
+      return false;
+  }
+}
+
+/**
+ *  Execute the decoded instruction while recording, without fusion so that
+ *  every instruction is seen
+ *
+ *  @param state: pointer to the machine state
+ *  @return: integer error code returned by the execute function
+ */
+int trace_record(emulate_state_t *state) {
+  trace_cache_t *cache = &state->traces;
+  if (cache->recordLen == TRACE_MAX_INSTRS || !traceable(state)) {
+    trace_abort(state);
+    return execute(state);
+  }
+
+  trace_entry_t *entry = &cache->record[cache->recordLen++];
+  entry->addr = state->pipeline.decoded_addr;
+  entry->word = state->pipeline.decoded_word;
+  entry->instr = *state->pipeline.decoded;
+  int _status = execute_single(state, state->pipeline.decoded);
+  entry->taken = _status == EC_SKIP;
+  // Recorded when it runs again
+  if (_status == EC_BLOCKED) {
+    cache->recordLen--;
+  }
+  return _status;
+}
+
+/**
+ *  Find the code pages a trace was recorded from and their generations
+ *
+ *  @param state: pointer to the machine state
+ *  @param trace: the trace
+ *  @return: false if the pages do not all hold what was recorded
+ */
+static bool trace_pages(emulate_state_t *state, ir_trace_t *trace) {
+  trace_cache_t *cache = &state->traces;
+  if (state->dcache.invalidations != cache->recordInvalidations) {
+    return false;
+  }
+  for (int i = 0; i < cache->recordLen; i++) {
+    trace_entry_t *entry = &cache->record[i];
+    word_t word;
+    get_word(state->memory, entry->addr, &word);
+    if (word != entry->word || !is_code_page(state, entry->addr)) {
+      return false;
+    }
+
+    word_t page = entry->addr >> CODE_PAGE_SHIFT;
+    int p = 0;
+    while (p < trace->numPages && trace->pages[p] != page) {
+      p++;
+    }
+    if (p == trace->numPages) {
+      if (p == IR_MAX_PAGES) {
+        return false;
+      }
+      trace->pages[p] = page;
+      trace->generations[p] = state->dcache.generations[page];
+      trace->numPages++;
+    }
+  }
+  return true;
+}
+
+/**
+ *  Turn the current recording into a trace
+ *
+ *  @param state: pointer to the machine state
+ */
+static void trace_finish(emulate_state_t *state) {
+  trace_cache_t *cache = &state->traces;
+  int slot = 0;
+  while (slot < MAX_TRACES && cache->traces[slot] != NULL) {
+    slot++;
+  }
+  ir_trace_t *trace = NULL;
+  if (slot < MAX_TRACES) {
+    trace = ir_lower(cache->record, cache->recordLen);
+  }
+  if (trace == NULL || !trace_pages(state, trace)) {
+    free(trace);
+    trace_abort(state);
+    return;
+  }
+  cache->recording = false;
+
+  state->stats.irOpsLowered += trace->numOps;
+  ir_optimise(trace);
+  state->stats.irOpsOptimised += trace->numOps;
+  state->stats.tracesRecorded++;
+
+  cache->traces[slot] = trace;
+  cache->heads[trace->head >> 2] = slot + 1;
+}
+
+/**
+ *  Check that a trace still matches the code at its head
+ *
+ *  @param state: pointer to the machine state, at the head of the trace
+ *  @param trace: the trace
+ *  @return: true iff the trace can be entered
+ */
+static bool trace_valid(emulate_state_t *state, const ir_trace_t *trace) {
+  if (state->pipeline.decoded_word != trace->headWord) {
+    return false;
+  }
+  for (int p = 0; p < trace->numPages; p++) {
+    if (state->dcache.generations[trace->pages[p]] != trace->generations[p]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ *  Called after a taken branch, once the pipeline holds its target: close
+ *  or start a recording, or run the trace at the target
+ *
+ *  @param state: pointer to the machine state
+ */
+void trace_branch_taken(emulate_state_t *state) {
+  trace_cache_t *cache = &state->traces;
+  word_t addr = state->pipeline.decoded_addr;
+  if (cache->recording) {
+    if (addr != cache->recordHead) {
+      return;
+    }
+    trace_finish(state);
+  } else if (addr == cache->pending) {
+    cache->pending = TRACE_NONE;
+    cache->recording = true;
+    cache->recordHead = addr;
+    cache->recordInvalidations = state->dcache.invalidations;
+    cache->recordLen = 0;
+    return;
+  }
+
+  if (addr >= MEM_SIZE || (addr & 0x3) || cache->heads[addr >> 2] == 0) {
+    return;
+  }
+  int slot = cache->heads[addr >> 2] - 1;
+  ir_trace_t *trace = cache->traces[slot];
+  if (!trace_valid(state, trace)) {
+    free(trace);
+    cache->traces[slot] = NULL;
+    cache->heads[addr >> 2] = 0;
+    state->stats.tracesRetired++;
+    return;
+  }
+
+  state->stats.traceEntries++;
+  pipeline_refill(state, ir_run(state, trace));
+}
+
+/**
+ *  Free every trace
+ *
+ *  @param state: pointer to the machine state
+ */
+void trace_release(emulate_state_t *state) {
+  trace_cache_t *cache = &state->traces;
+  for (int slot = 0; slot < MAX_TRACES; slot++) {
+    free(cache->traces[slot]);
+    cache->traces[slot] = NULL;
+  }
+  memset(cache->heads, 0, sizeof(cache->heads));
+}
@@ -0,0 +1,41 @@
+/*
+ *  Trace tier: finds hot guest loops, records one iteration of each and
+ *  runs it as an optimised trace until it leaves the recorded path.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include "../utils/arm.h"
+#include "../emulate.h"
+#include "ir.h"
+
+// Taken backward branches to an address before a loop there is recorded
+#define TRACE_HOT_THRESHOLD 50
+// Recordings from an address given up before it is no longer tried
+#define TRACE_MAX_ABORTS 4
+#define MAX_TRACES 64
+#define TRACE_NONE MEM_SIZE
+
+struct trace_cache {
+  bool enabled;
+  byte_t hot[MEM_WORDS];    // taken backward branches to each word
+  byte_t aborts[MEM_WORDS]; // recordings from each word given up
+  byte_t heads[MEM_WORDS];  // 1 + slot of the trace starting at each word
+  ir_trace_t *traces[MAX_TRACES];
+
+  word_t pending;           // head to record from, or TRACE_NONE
+  bool recording;
+  word_t recordHead;
+  uint32_t recordInvalidations;
+  int recordLen;
+  trace_entry_t record[TRACE_MAX_INSTRS];
+};
+
+void trace_count_branch(emulate_state_t *state, word_t target);
+int trace_record(emulate_state_t *state);
+void trace_branch_taken(emulate_state_t *state);
+void trace_release(emulate_state_t *state);
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ *  Input is read a buffer at a time as the guest takes it, and a read of
+ *  the flags reads ahead if the buffer is empty, to tell whether any is
+ *  left.
+ */
+
+#include "../emulate.h"
+#include "uart.h"
+
+/**
+ *  Open a file for the UART
+ *
+ *  @param path: path of the file
+ *  @param mode: mode to open it in, as fopen
+ *  @param file: set to the file
+ *  @return: integer error code based on success of the function
+ */
+static int uart_open(const char *path, const char *mode, FILE **file) {
+  *file = fopen(path, mode);
+  FAIL_SYS(*file == NULL);
+  return EC_OK;
+}
+
+/**
+ *  Allocate a UART with nothing sent yet
+ *
+ *  @param outPath: path of the file to write output to, or NULL for stdout
+ *  @param inPath: path of the file to read input from, or NULL for none
+ *  @param uart: set to the UART, to be freed with uart_free
+ *  @return: integer error code based on success of the function
+ */
+int uart_new(const char *outPath, const char *inPath, uart_t **uart) {
+  *uart = calloc(1, sizeof(uart_t));
+  MEM_CHECK(*uart, EC_NULL_POINTER);
+  (*uart)->out = stdout;
+  int _status = EC_OK;
+  if (outPath != NULL) {
+    _status = uart_open(outPath, "w", &(*uart)->out);
+  }
+  if (_status == EC_OK && inPath != NULL) {
+    _status = uart_open(inPath, "r", &(*uart)->in);
+  }
+  if (_status != EC_OK) {
+    if ((*uart)->out != NULL) {
+      uart_free(*uart);
+    } else {
+      free(*uart);
+    }
+    *uart = NULL;
+  }
+  return _status;
+}
+
+/**
+ *  Check whether there is input left, reading more if the buffer is empty
+ *
+ *  @param uart: pointer to the UART
+ *  @return: true iff the guest has a character to read
+ */
+static bool uart_has_input(uart_t *uart) {
+  if (uart->inHead == uart->inLen && uart->in != NULL) {
+    uart->inHead = 0;
+    uart->inLen = fread(uart->input, 1, UART_INPUT_BUFFER, uart->in);
+  }
+  return uart->inHead < uart->inLen;
+}
+
+/**
+ *  Read a register of the UART. Reads of the data take input, so count as
+ *  effects.
+ *
+ *  @param state: non-null pointer to the machine state, with a UART
+ *  @param addr: address of the register
+ *  @return: value read
+ */
+word_t uart_load(emulate_state_t *state, word_t addr) {
+  uart_t *uart = state->uart;
+  if (addr == UART_FR) {
+    return UART_FR_TXFE | (uart_has_input(uart) ? 0 : UART_FR_RXFE);
+  }
+  state->effects++;
+  if (!uart_has_input(uart)) {
+    return 0;
+  }
+  return uart->input[uart->inHead++];
+}
+
+/**
+ *  Write a register of the UART. The flags ignore writes.
+ *
+ *  @param state: non-null pointer to the machine state, with a UART
+ *  @param addr: address of the register
+ *  @param word: value written
+ */
+void uart_store(emulate_state_t *state, word_t addr, word_t word) {
+  uart_t *uart = state->uart;
+  if (addr != UART_DR) {
+    return;
+  }
+  uart->output[uart->outUsed++] = (byte_t) word;
+  if (uart->outUsed == UART_OUTPUT_BUFFER) {
+    uart_flush(uart);
+  }
+}
+
+/**
+ *  Write out the characters sent so far
+ *
+ *  @param uart: pointer to the UART, or NULL
+ */
+void uart_flush(uart_t *uart) {
+  if (uart != NULL && uart->outUsed > 0) {
+    fwrite(uart->output, 1, uart->outUsed, uart->out);
+    uart->outUsed = 0;
+  }
+}
+
+/**
+ *  Write out the characters sent, close the files of the UART and free it
+ *
+ *  @param uart: pointer to the UART, or NULL
+ *  @return: integer error code based on success of writing the output
+ */
+int uart_free(uart_t *uart) {
+  if (uart == NULL) {
+    return EC_OK;
+  }
+  uart_flush(uart);
+  int _status = EC_OK;
+  if (ferror(uart->out)) {
+    _status = EC_FROM_SYS_ERROR(EIO);
+  }
+  if (uart->out != stdout && fclose(uart->out) != 0 && _status == EC_OK) {
+    _status = EC_FROM_SYS_ERROR(errno);
+  }
+  if (uart->in != NULL) {
+    fclose(uart->in);
+  }
+  free(uart);
+  return _status;
+}
@@ -0,0 +1,47 @@
+/*
+ *  UART with the data and flag registers of a PL011. Characters written go
+ *  to a large buffer, written out when full and before the final state is
+ *  printed, so output costs little per character. Input is read from a
+ *  file.
+ *
+ *  Registers of the UART, mapped beyond guest memory:
+ *  - UART_DR takes a character to send in its low byte, and reads as the
+ *    next character of the input, or 0 once there is none
+ *  - UART_FR reads as flags: UART_FR_RXFE while there is no input left, and
+ *    UART_FR_TXFE always, since output never has to wait
+ */
+
+#ifndef UART_H
+#define UART_H
+
+#include <stdio.h>
+#include "../utils/arm.h"
+#include "../emulate.h"
+
+#define UART_OUTPUT_BUFFER (1 << 20)
+#define UART_INPUT_BUFFER 65536
+
+#define UART_BASE 0x20201000
+#define UART_DR UART_BASE
+#define UART_FR (UART_BASE + 0x18)
+
+#define UART_FR_RXFE 0x10
+#define UART_FR_TXFE 0x80
+
+struct uart {
+  FILE *out;                          // stdout, or a file of the UART
+  FILE *in;                           // or NULL
+  size_t outUsed;
+  size_t inHead;
+  size_t inLen;
+  byte_t input[UART_INPUT_BUFFER];
+  byte_t output[UART_OUTPUT_BUFFER];
+};
+
+int uart_new(const char *outPath, const char *inPath, uart_t **uart);
+word_t uart_load(emulate_state_t *state, word_t addr);
+void uart_store(emulate_state_t *state, word_t addr, word_t word);
+void uart_flush(uart_t *uart);
+int uart_free(uart_t *uart);
+
+#endif
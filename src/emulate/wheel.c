@@ -0,0 +1,149 @@
+/*
+ *  Events are kept in doubly linked lists, one per slot, and an event at
+ *  time t is in slot t % WHEEL_SLOTS. Every pending event is after the time
+ *  the wheel was last moved on to, since moving it on fires those before.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include "wheel.h"
+
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+/**
+ *  Set up an empty wheel at time 0
+ *
+ *  @param wheel: pointer to the wheel
+ */
+void wheel_init(wheel_t *wheel) {
+  wheel->now = 0;
+  wheel->next = WHEEL_NEVER;
+  for (int i = 0; i < WHEEL_SLOTS; i++) {
+    wheel->slots[i] = NULL;
+  }
+}
+
+/**
+ *  Find the time of the earliest event. Slots are looked at in time order
+ *  from the one after now, and the first event within a turn of the wheel
+ *  from there is the earliest.
+ *
+ *  @param wheel: pointer to the wheel
+ *  @return: time of the earliest event, or WHEEL_NEVER
+ */
+static uint64_t wheel_earliest(const wheel_t *wheel) {
+  uint64_t earliest = WHEEL_NEVER;
+  for (uint64_t i = 1; i <= WHEEL_SLOTS; i++) {
+    for (const wheel_event_t *event = wheel->slots[(wheel->now + i)
+                                                   & WHEEL_MASK];
+         event != NULL; event = event->next) {
+      if (event->when < earliest) {
+        earliest = event->when;
+      }
+    }
+    if (earliest - wheel->now <= WHEEL_SLOTS) {
+      break;
+    }
+  }
+  return earliest;
+}
+
+/**
+ *  Add an event to the wheel. The event must not be pending already.
+ *
+ *  @param wheel: pointer to the wheel
+ *  @param event: the event, with its fire function set
+ *  @param when: time to fire it at, after the time of the wheel
+ */
+void wheel_schedule(wheel_t *wheel, wheel_event_t *event, uint64_t when) {
+  assert(!event->pending && when > wheel->now);
+  wheel_event_t **slot = &wheel->slots[when & WHEEL_MASK];
+  event->when = when;
+  event->pending = true;
+  event->prev = NULL;
+  event->next = *slot;
+  if (*slot != NULL) {
+    (*slot)->prev = event;
+  }
+  *slot = event;
+  if (when < wheel->next) {
+    wheel->next = when;
+  }
+}
+
+/**
+ *  Take an event out of its slot
+ *
+ *  @param wheel: pointer to the wheel
+ *  @param event: the event, pending
+ */
+static void wheel_unlink(wheel_t *wheel, wheel_event_t *event) {
+  if (event->prev != NULL) {
+    event->prev->next = event->next;
+  } else {
+    wheel->slots[event->when & WHEEL_MASK] = event->next;
+  }
+  if (event->next != NULL) {
+    event->next->prev = event->prev;
+  }
+  event->pending = false;
+}
+
+/**
+ *  Remove an event from the wheel, if it is pending
+ *
+ *  @param wheel: pointer to the wheel
+ *  @param event: the event
+ */
+void wheel_cancel(wheel_t *wheel, wheel_event_t *event) {
+  if (!event->pending) {
+    return;
+  }
+  wheel_unlink(wheel, event);
+  if (event->when == wheel->next) {
+    wheel->next = wheel_earliest(wheel);
+  }
+}
+
+/**
+ *  Move the wheel on to a time, firing every event up to it. Only the
+ *  slots from the earliest event on are looked at.
+ *
+ *  @param wheel: pointer to the wheel
+ *  @param now: the time, not before that of the wheel
+ *  @return: number of events fired
+ */
+int wheel_advance(wheel_t *wheel, uint64_t now) {
+  assert(now >= wheel->now);
+  uint64_t from = wheel->next;
+  wheel->now = now;
+  if (from > now) {
+    return 0;
+  }
+
+  // Take the events out before firing any, which may schedule them again
+  wheel_event_t *due = NULL;
+  uint64_t numSlots = now - from < WHEEL_SLOTS ? now - from + 1 : WHEEL_SLOTS;
+  for (uint64_t i = 0; i < numSlots; i++) {
+    wheel_event_t *event = wheel->slots[(from + i) & WHEEL_MASK];
+    while (event != NULL) {
+      wheel_event_t *next = event->next;
+      if (event->when <= now) {
+        wheel_unlink(wheel, event);
+        event->next = due;
+        due = event;
+      }
+      event = next;
+    }
+  }
+  wheel->next = wheel_earliest(wheel);
+
+  int fired = 0;
+  while (due != NULL) {
+    wheel_event_t *event = due;
+    due = event->next;
+    event->fire(wheel, event);
+    fired++;
+  }
+  return fired;
+}
@@ -0,0 +1,45 @@
+/*
+ *  Hashed timing wheel of events at points in guest time. An event hangs
+ *  off the slot its time hashes to, so scheduling and cancelling it take
+ *  constant time, and moving the time on only looks at the slots it passes.
+ *  The time of the earliest event is kept, so a wheel with nothing due is
+ *  moved on by a comparison.
+ */
+
+#ifndef WHEEL_H
+#define WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WHEEL_SLOTS 256
+#define WHEEL_NEVER UINT64_MAX
+
+typedef struct wheel wheel_t;
+typedef struct wheel_event wheel_event_t;
+
+// Called as the wheel passes the time of the event, which is no longer
+// pending and may be scheduled again
+typedef void (*wheel_fire_t)(wheel_t *wheel, wheel_event_t *event);
+
+struct wheel_event {
+  uint64_t when;
+  wheel_fire_t fire;
+  void *data;                 // for the owner of the event
+  wheel_event_t *next;        // in its slot
+  wheel_event_t *prev;
+  bool pending;
+};
+
+struct wheel {
+  uint64_t now;               // time the wheel has been moved on to
+  uint64_t next;              // time of the earliest event, or WHEEL_NEVER
+  wheel_event_t *slots[WHEEL_SLOTS];
+};
+
+void wheel_init(wheel_t *wheel);
+void wheel_schedule(wheel_t *wheel, wheel_event_t *event, uint64_t when);
+void wheel_cancel(wheel_t *wheel, wheel_event_t *event);
+int wheel_advance(wheel_t *wheel, uint64_t now);
+
+#endif
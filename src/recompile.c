@@ -0,0 +1,62 @@
+/*
+ * Ahead-of-time recompiler. Reads an assembled binary, recovers its control
+ * flow graph and writes a self-contained C program that behaves like running
+ * the binary on the emulator: same output, same final state.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils/arm.h"
+#include "utils/io.h"
+#include "utils/error.h"
+#include "recompile/cfg.h"
+#include "recompile/translate.h"
+#include "recompile.h"
+
+/**
+ * Find the size of the binary, up to its last non-zero byte
+ *
+ * @param state: recompiler state with the binary loaded into memory
+ * @return: size in bytes, rounded up to a whole word
+ */
+static word_t image_size(recompile_state_t *state) {
+  word_t size = MEM_SIZE;
+  while (size > 0 && state->memory[size - 1] == 0) {
+    size--;
+  }
+  return (size + 3) & ~0x3;
+}
+
+/**
+ * Main Recompiler Loop
+ *
+ * Takes as arguments the binary file to translate and the path of the C
+ * file to write out to.
+ */
+int main(int argc, char **argv) {
+  int _status = EC_OK;
+  if (argc <= 2) {
+    fprintf(stderr, "%s <path_to_binary_file> <path_to_c_file>\n", argv[0]);
+    return EC_INVALID_PARAM;
+  }
+
+  recompile_state_t *state = calloc(1, sizeof(recompile_state_t));
+  MEM_CHECK(state, EC_NULL_POINTER);
+
+  _status = read_file(argv[1], state->memory, MEM_SIZE);
+  CHECK_STATUS(_status, free(state));
+  state->imageSize = image_size(state);
+
+  _status = cfg_build(state);
+  CHECK_STATUS(_status, free(state));
+
+  FILE *out = fopen(argv[2], "w");
+  if (out == NULL) {
+    free(state);
+    return EC_FROM_SYS_ERROR(errno);
+  }
+  _status = translate_program(out, state, argv[1]);
+  fclose(out);
+  free(state);
+  return _status;
+}
@@ -0,0 +1,22 @@
+#ifndef RECOMPILE_H
+#define RECOMPILE_H
+
+#include "utils/arm.h"
+
+#define NUM_WORDS (MEM_SIZE >> 2)
+
+// Per word flags of the recovered control flow graph
+#define CFG_REACHED 0x1     // word is executed as an instruction
+#define CFG_TARGET 0x2      // word is a branch target, so gets a label
+#define CFG_LEADER 0x4      // word starts a basic block
+#define CFG_FALLTHROUGH 0x8 // control may continue to the next word
+
+typedef struct {
+  byte_t memory[MEM_SIZE];
+  word_t imageSize; // bytes up to the last non-zero byte of the binary
+  byte_t flags[NUM_WORDS];
+  word_t textEnd; // one past the last reached instruction
+  int blocks;
+} recompile_state_t;
+
+#endif
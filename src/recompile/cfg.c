@@ -0,0 +1,102 @@
+/*
+ *  Control flow recovery. Starting at address 0, every word that can be
+ *  executed is visited once, following the fallthrough and the target of
+ *  each branch. Words that are never reached (the literal pool, data after
+ *  the halt) are left out of the translation. The result is a set of flags
+ *  per word from which the basic blocks can be read off.
+ */
+
+#include <stdlib.h>
+#include "cfg.h"
+#include "../emulate/decode.h"
+#include "../utils/io.h"
+#include "../utils/error.h"
+
+/**
+ *  Check whether an address holds a word of guest memory we can translate
+ *
+ *  @param addr: byte address to check
+ *  @return: true iff the address is aligned and inside memory
+ */
+static bool in_text(word_t addr) {
+  return addr < MEM_SIZE && !(addr & 0x3);
+}
+
+/**
+ *  Compute the target of a branch, extending the offset exactly as
+ *  execute_brn does
+ *
+ *  @param addr: address of the branch
+ *  @param instr: decoded branch
+ *  @return: address the branch jumps to
+ */
+word_t cfg_branch_target(word_t addr, brn_instruction_t instr) {
+  word_t shiftedOffset = l_shift_left(instr.offset, 0x2);
+  shiftedOffset |= (shiftedOffset >> 23) ? 0xFF000000 : 0x0;
+  return addr + 8 + shiftedOffset;
+}
+
+/**
+ *  Follow every path from the entry point and flag the words visited
+ *
+ *  @param state: recompiler state with the binary loaded into memory
+ *  @return: integer error code based on success of the function
+ */
+int cfg_build(recompile_state_t *state) {
+  // Each visited word pushes at most two successors
+  word_t *worklist = malloc(sizeof(word_t) * (2 * NUM_WORDS + 1));
+  MEM_CHECK(worklist, EC_NULL_POINTER);
+  size_t top = 0;
+  worklist[top++] = 0x0;
+  state->flags[0] |= CFG_LEADER;
+
+  while (top > 0) {
+    word_t addr = worklist[--top];
+    word_t idx = addr >> 2;
+    if (state->flags[idx] & CFG_REACHED) {
+      continue;
+    }
+    state->flags[idx] |= CFG_REACHED;
+    if (addr + 4 > state->textEnd) {
+      state->textEnd = addr + 4;
+    }
+
+    word_t word;
+    instruction_t instr;
+    get_word(state->memory, addr, &word);
+    decode_word(&instr, word);
+
+    bool fallthrough = instr.cond != AL;
+    if (instr.type == HAL) {
+      fallthrough = false;
+    } else if (instr.type == BRN) {
+      word_t target = cfg_branch_target(addr, instr.i.brn);
+      if (in_text(target)) {
+        state->flags[target >> 2] |= CFG_TARGET | CFG_LEADER;
+        worklist[top++] = target;
+      }
+    } else if (instr.type != UND && !writes_pc(&instr)) {
+      fallthrough = true;
+    }
+
+    if (fallthrough) {
+      state->flags[idx] |= CFG_FALLTHROUGH;
+      if (in_text(addr + 4)) {
+        worklist[top++] = addr + 4;
+      }
+    }
+    // Anything after a change of control flow starts a new block
+    if ((!fallthrough || instr.type == BRN) && in_text(addr + 4)) {
+      state->flags[idx + 1] |= CFG_LEADER;
+    }
+  }
+  free(worklist);
+
+  for (word_t idx = 0; idx < NUM_WORDS; idx++) {
+    byte_t flags = state->flags[idx];
+    if ((flags & CFG_REACHED) && (flags & CFG_LEADER)) {
+      state->blocks++;
+    }
+  }
+  return EC_OK;
+}
@@ -0,0 +1,17 @@
+/*
+ *  Recovers the control flow graph of a binary by following every path from
+ *  the entry point.
+ */
+
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdbool.h>
+#include "../utils/arm.h"
+#include "../utils/instructions.h"
+#include "../recompile.h"
+
+int cfg_build(recompile_state_t *state);
+word_t cfg_branch_target(word_t addr, brn_instruction_t instr);
+
+#endif
@@ -0,0 +1,353 @@
+/*
+ *  Runtime prepended to every translated program: the machine state, the
+ *  helpers the translated instructions call, and an interpreter for the code
+ *  that cannot be translated ahead of time. It repeats the semantics of the
+ *  emulator, quirks included, so translated programs print the same state.
+ */
+
+#include "prelude.h"
+
+static const char *const prelude[] = {
+    "#include <stdio.h>",
+    "#include <stdint.h>",
+    "#include <string.h>",
+    "#include <limits.h>",
+    "",
+    "#define MEM_SIZE 65536",
+    "#define NUM_GENERAL_REGISTERS 13",
+    "",
+    "#define GPIO_SETUP_0_9 0x20200000u",
+    "#define GPIO_SETUP_10_19 0x20200004u",
+    "#define GPIO_SETUP_20_29 0x20200008u",
+    "#define GPIO_CLEAR 0x20200028u",
+    "#define GPIO_WRITE 0x2020001Cu",
+    "",
+    "#define RT_OK 0",
+    "#define RT_SKIP 1",
+    "#define RT_UNSUPPORTED_OP 3",
+    "",
+    "typedef uint32_t word_t;",
+    "",
+    "typedef struct {",
+    "  word_t r[NUM_GENERAL_REGISTERS];",
+    "  word_t pc;",
+    "  word_t cpsr;",
+    "} registers_t;",
+    "",
+    "registers_t regs;",
+    "uint8_t memory[MEM_SIZE + 4];",
+    "word_t rt_fetched;",
+    "",
+    "/* Registers 13 and 14 read as 1 and ignore writes, as in the emulator */",
+    "word_t rt_get_reg(unsigned reg) {",
+    "  if (reg < NUM_GENERAL_REGISTERS) {",
+    "    return regs.r[reg];",
+    "  }",
+    "  return reg == 15 ? regs.pc : 1;",
+    "}",
+    "",
+    "void rt_set_reg(unsigned reg, word_t value) {",
+    "  if (reg < NUM_GENERAL_REGISTERS) {",
+    "    regs.r[reg] = value;",
+    "  } else if (reg == 15) {",
+    "    regs.pc = value;",
+    "  }",
+    "}",
+    "",
+    "unsigned rt_get_flags(void) {",
+    "  return regs.cpsr >> 28;",
+    "}",
+    "",
+    "void rt_set_flags(unsigned flags) {",
+    "  regs.cpsr = (word_t) flags << 28;",
+    "}",
+    "",
+    "int rt_condition(unsigned cond) {",
+    "  unsigned f = rt_get_flags();",
+    "  switch (cond) {",
+    "    case 0x0: return (f & 0x4) != 0;",
+    "    case 0x1: return !(f & 0x4);",
+    "    case 0xA: return (f & 0x1) == ((f & 0x8) >> 3);",
+    "    case 0xB: return (f & 0x1) != ((f & 0x8) >> 3);",
+    "    case 0xC: return !(f & 0x4) && (f & 0x1) == ((f & 0x8) >> 3);",
+    "    case 0xD: return (f & 0x4) || (f & 0x1) != ((f & 0x8) >> 3);",
+    "    case 0xE: return 1;",
+    "    default:",
+    "      fprintf(stderr, \"Invalid cond flag %x\\n\", cond);",
+    "      return 0;",
+    "  }",
+    "}",
+    "",
+    "/* Barrel shifter, with shift counts reduced the way the emulator's are */",
+    "word_t rt_shift(unsigned type, word_t v, unsigned s, int *carry) {",
+    "  unsigned r = s % 32;",
+    "  switch (type) {",
+    "    case 0:",
+    "      *carry = s ? (v >> ((32 - s) & 31)) & 1 : 0;",
+    "      return v << (s & 31);",
+    "    case 1:",
+    "      *carry = ((v << ((32 - s) & 31)) & 0x80000000u) != 0;",
+    "      return v >> (s & 31);",
+    "    case 2:",
+    "      *carry = ((v << ((32 - s) & 31)) & 0x80000000u) != 0;",
+    "      if (!(v >> 31)) {",
+    "        return v >> (s & 31);",
+    "      }",
+    "      if (s >= 32) {",
+    "        return 0xFFFFFFFFu;",
+    "      }",
+    "      return s ? (v >> s) | (0xFFFFFFFFu << (32 - s)) : v;",
+    "    default:",
+    "      *carry = ((v << ((32 - s) & 31)) & 0x80000000u) != 0;",
+    "      return r ? (v >> r) | (v << (32 - r)) : v;",
+    "  }",
+    "}",
+    "",
+    "word_t rt_alu(unsigned opcode, int S, word_t rn, word_t op2, int carry) {",
+    "  word_t res = 0;",
+    "  switch (opcode) {",
+    "    case 0x0: case 0x8: res = rn & op2; break;",
+    "    case 0x1: case 0x9: res = rn ^ op2; break;",
+    "    case 0x2: case 0xA: res = rn + (~op2 + 1); break;",
+    "    case 0x3: res = op2 + (~rn + 1); break;",
+    "    case 0x4: res = rn + op2; break;",
+    "    case 0xC: res = rn | op2; break;",
+    "    case 0xD: res = op2; break;",
+    "  }",
+    "  if (S) {",
+    "    unsigned flags;",
+    "    switch (opcode) {",
+    "      case 0x2: case 0x3: case 0x4: case 0xA:",
+    "        flags = ((rn >> 31) == (op2 >> 31)) != (res >> 31);",
+    "        break;",
+    "      default:",
+    "        flags = carry != 0;",
+    "        break;",
+    "    }",
+    "    rt_set_flags(flags << 1 | (res >> 31) << 3 | (res == 0) << 2);",
+    "  }",
+    "  return res;",
+    "}",
+    "",
+    "word_t rt_mul(int A, int S, word_t rm, word_t rs, word_t rn) {",
+    "  word_t res = (word_t) ((uint64_t) rm * rs + (A ? rn : 0));",
+    "  if (S) {",
+    "    rt_set_flags(rt_get_flags() | (res >> 31) << 3 | (res == 0) << 2);",
+    "  }",
+    "  return res;",
+    "}",
+    "",
+    "int rt_is_gpio_addr(word_t addr) {",
+    "  return (addr >= GPIO_SETUP_0_9 && addr <= GPIO_SETUP_20_29)",
+    "      || addr == GPIO_CLEAR || addr == GPIO_WRITE;",
+    "}",
+    "",
+    "void rt_print_gpio_access(word_t addr) {",
+    "  if (addr == GPIO_SETUP_0_9) {",
+    "    printf(\"One GPIO pin from 0 to 9 has been accessed\\n\");",
+    "  } else if (addr == GPIO_SETUP_10_19) {",
+    "    printf(\"One GPIO pin from 10 to 19 has been accessed\\n\");",
+    "  } else if (addr == GPIO_SETUP_20_29) {",
+    "    printf(\"One GPIO pin from 20 to 29 has been accessed\\n\");",
+    "  } else if (addr == GPIO_CLEAR) {",
+    "    printf(\"PIN OFF\\n\");",
+    "  } else if (addr == GPIO_WRITE) {",
+    "    printf(\"PIN ON\\n\");",
+    "  }",
+    "}",
+    "",
+    "int rt_address_invalid(word_t addr) {",
+    "  if (!rt_is_gpio_addr(addr) && addr > MEM_SIZE) {",
+    "    printf(\"Error: Out of bounds memory access at address 0x%08x\\n\", addr);",
+    "    return 1;",
+    "  }",
+    "  return 0;",
+    "}",
+    "",
+    "/* Returns 0 iff *dest was loaded */",
+    "int rt_load(word_t addr, word_t *dest) {",
+    "  if (rt_address_invalid(addr)) {",
+    "    return 1;",
+    "  }",
+    "  if (rt_is_gpio_addr(addr)) {",
+    "    rt_print_gpio_access(addr);",
+    "    *dest = addr;",
+    "    return 0;",
+    "  }",
+    "  *dest = (word_t) memory[addr] | (word_t) memory[addr + 1] << 8",
+    "      | (word_t) memory[addr + 2] << 16 | (word_t) memory[addr + 3] << 24;",
+    "  return 0;",
+    "}",
+    "",
+    "/* Returns 1 iff the store may have modified translated code */",
+    "int rt_store(word_t addr, word_t word) {",
+    "  if (rt_address_invalid(addr)) {",
+    "    return 0;",
+    "  }",
+    "  if (rt_is_gpio_addr(addr)) {",
+    "    rt_print_gpio_access(addr);",
+    "    return 0;",
+    "  }",
+    "  memory[addr] = word;",
+    "  memory[addr + 1] = word >> 8;",
+    "  memory[addr + 2] = word >> 16;",
+    "  memory[addr + 3] = word >> 24;",
+    "  return addr < TEXT_END;",
+    "}",
+    "",
+    "void rt_print_reg(const char *name, word_t value) {",
+    "  printf(\"%s\", name);",
+    "  if (value == (word_t) INT_MIN) {",
+    "    printf(\" %11d (0x%08x)\\n\", (int) value, value);",
+    "  } else {",
+    "    printf(\"%11d (0x%08x)\\n\", (int) value, value);",
+    "  }",
+    "}",
+    "",
+    "void rt_print_state(void) {",
+    "  char name[16];",
+    "  unsigned i;",
+    "  printf(\"Registers:\\n\");",
+    "  for (i = 0; i < NUM_GENERAL_REGISTERS; i++) {",
+    "    sprintf(name, \"$%-3u:\", i);",
+    "    rt_print_reg(name, regs.r[i]);",
+    "  }",
+    "  rt_print_reg(\"PC  :\", regs.pc);",
+    "  rt_print_reg(\"CPSR:\", regs.cpsr);",
+    "",
+    "  printf(\"Non-zero memory:\\n\");",
+    "  for (i = 0; i < MEM_SIZE; i += 4) {",
+    "    word_t w = (word_t) memory[i] << 24 | (word_t) memory[i + 1] << 16",
+    "        | (word_t) memory[i + 2] << 8 | (word_t) memory[i + 3];",
+    "    if (w != 0) {",
+    "      printf(\"0x%08x: 0x%08x\\n\", i, w);",
+    "    }",
+    "  }",
+    "}",
+    "",
+    "/*",
+    " * Interpreter for the code that cannot be translated: PC writes, undefined",
+    " * instructions and code reached after a store into translated code. It runs",
+    " * the emulator's pipeline, executing `decoded` with `rt_fetched` as the next",
+    " * word and the PC 8 bytes ahead of the executing instruction.",
+    " */",
+    "int rt_is_dp(word_t w) {",
+    "  unsigned opcode = (w >> 21) & 0xF;",
+    "  if (!((w >> 25) & 1) && (w & 0x90) == 0x90) {",
+    "    return 0;",
+    "  }",
+    "  if (!((0x371F >> opcode) & 1)) {",
+    "    return 0;",
+    "  }",
+    "  return (w >> 20) & 1 || !((0x0700 >> opcode) & 1);",
+    "}",
+    "",
+    "word_t rt_operand(word_t w, int *carry) {",
+    "  unsigned s = (w >> 4) & 1 ? rt_get_reg((w >> 8) & 0xF) & 0xFF",
+    "                            : (w >> 7) & 0x1F;",
+    "  return rt_shift((w >> 5) & 0x3, rt_get_reg(w & 0xF), s, carry);",
+    "}",
+    "",
+    "int rt_execute(word_t w) {",
+    "  unsigned hi = (w >> 20) & 0xFF;",
+    "  int carry = 0;",
+    "  if (!rt_condition(w >> 28)) {",
+    "    return RT_OK;",
+    "  }",
+    "  if ((hi & 0xFC) == 0 && ((w >> 4) & 0xF) == 0x9) {",
+    "    rt_set_reg((w >> 16) & 0xF,",
+    "               rt_mul((w >> 21) & 1, (w >> 20) & 1, rt_get_reg(w & 0xF),",
+    "                      rt_get_reg((w >> 8) & 0xF), rt_get_reg((w >> 12) & 0xF)));",
+    "  } else if ((hi >> 6) == 0 && rt_is_dp(w)) {",
+    "    unsigned opcode = (w >> 21) & 0xF;",
+    "    word_t op2;",
+    "    word_t res;",
+    "    if ((w >> 25) & 1) {",
+    "      op2 = rt_shift(3, w & 0xFF, ((w >> 8) & 0xF) * 2, &carry);",
+    "    } else {",
+    "      op2 = rt_operand(w, &carry);",
+    "    }",
+    "    res = rt_alu(opcode, (w >> 20) & 1, rt_get_reg((w >> 16) & 0xF), op2,",
+    "                 carry);",
+    "    if (opcode < 0x8 || opcode > 0xA) {",
+    "      rt_set_reg((w >> 12) & 0xF, res);",
+    "    }",
+    "  } else if ((hi >> 6) == 1 && (hi & 0x6) == 0) {",
+    "    word_t offset = (w >> 25) & 1 ? rt_operand(w, &carry) : w & 0xFFF;",
+    "    unsigned rn = (w >> 16) & 0xF;",
+    "    unsigned rd = (w >> 12) & 0xF;",
+    "    int up = (w >> 23) & 1;",
+    "    word_t addr = rt_get_reg(rn);",
+    "    word_t data;",
+    "    if ((w >> 24) & 1) {",
+    "      addr = up ? addr + offset : addr - offset;",
+    "    }",
+    "    if ((w >> 20) & 1) {",
+    "      if (!rt_load(addr, &data)) {",
+    "        rt_set_reg(rd, data);",
+    "      }",
+    "    } else {",
+    "      rt_store(addr, rt_get_reg(rd));",
+    "    }",
+    "    if (!((w >> 24) & 1)) {",
+    "      rt_set_reg(rn, up ? addr + offset : addr - offset);",
+    "    }",
+    "  } else if ((hi >> 4) == 0xA) {",
+    "    word_t offset = (w & 0xFFFFFF) << 2;",
+    "    offset |= (offset >> 23) ? 0xFF000000u : 0;",
+    "    regs.pc += offset;",
+    "    return RT_SKIP;",
+    "  } else {",
+    "    fprintf(stderr, \"Undefined instruction at 0x%08x\\n\", regs.pc - 8);",
+    "    return RT_UNSUPPORTED_OP;",
+    "  }",
+    "  return RT_OK;",
+    "}",
+    "",
+    "int rt_interpret(word_t addr, word_t decoded) {",
+    "  int status;",
+    "  regs.pc = addr + 8;",
+    "  while (decoded != 0) {",
+    "    status = rt_execute(decoded);",
+    "    if (status == RT_SKIP) {",
+    "      rt_load(regs.pc, &rt_fetched);",
+    "      decoded = rt_fetched;",
+    "      regs.pc += 4;",
+    "      rt_load(regs.pc, &rt_fetched);",
+    "    } else if (status != RT_OK) {",
+    "      return status;",
+    "    } else {",
+    "      decoded = rt_fetched;",
+    "      rt_load(regs.pc, &rt_fetched);",
+    "    }",
+    "    regs.pc += 4;",
+    "  }",
+    "  rt_print_state();",
+    "  return RT_OK;",
+    "}",
+    "",
+    "/* Resume after the instruction before addr, with decoded already in flight */",
+    "int rt_resume(word_t addr, word_t decoded) {",
+    "  rt_load(addr + 4, &rt_fetched);",
+    "  return rt_interpret(addr, decoded);",
+    "}",
+    "",
+    "/* Start at an address with a freshly filled pipeline, as after a branch */",
+    "int rt_enter(word_t addr) {",
+    "  word_t decoded = rt_fetched;",
+    "  rt_load(addr, &decoded);",
+    "  return rt_resume(addr, decoded);",
+    "}",
+    NULL
+};
+
+/**
+ *  Write the runtime at the head of a translated program
+ *
+ *  @param out: file to write to
+ */
+void emit_prelude(FILE *out) {
+  for (int i = 0; prelude[i] != NULL; i++) {
+    fprintf(out, "%s\n", prelude[i]);
+  }
+}
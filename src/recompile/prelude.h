@@ -0,0 +1,12 @@
+/*
+ *  Source of the runtime that translated programs are linked against.
+ */
+
+#ifndef PRELUDE_H
+#define PRELUDE_H
+
+#include <stdio.h>
+
+void emit_prelude(FILE *out);
+
+#endif
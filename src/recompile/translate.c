@@ -0,0 +1,297 @@
+/*
+ *  Translation of ARM instructions to C. Every basic block becomes a
+ *  region of main() headed by its address, and branches become gotos to the
+ *  label of their target. The helpers called by the generated code, and the
+ *  interpreter it falls back on, come from the prelude.
+ *
+ *  Register reads are resolved at translation time: the PC reads as the
+ *  address of the instruction plus 8, and SP and LR read as 1 and ignore
+ *  writes, like get_register and set_register in the emulator.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "translate.h"
+#include "cfg.h"
+#include "prelude.h"
+#include "../emulate/decode.h"
+#include "../utils/io.h"
+#include "../utils/error.h"
+
+#define EXPR_SIZE 64
+#define IMAGE_BYTES_PER_LINE 12
+
+/**
+ *  Write the C expression reading a register
+ *
+ *  @param buf: buffer of at least EXPR_SIZE characters
+ *  @param reg: register to read
+ *  @param addr: address of the instruction reading it
+ */
+static void reg_expr(char *buf, reg_address_t reg, word_t addr) {
+  if (reg < NUM_GENERAL_REGISTERS) {
+    sprintf(buf, "regs.r[%u]", reg);
+  } else if (reg == REG_N_PC) {
+    sprintf(buf, "0x%08xu", addr + 8);
+  } else {
+    sprintf(buf, "%uu", EC_INVALID_PARAM);
+  }
+}
+
+/**
+ *  Emit the assignment of a value to a register
+ *
+ *  @param out: file to write to
+ *  @param reg: destination register, which must not be the PC
+ *  @param value: C expression of the value
+ */
+static void emit_write(FILE *out, reg_address_t reg, const char *value) {
+  if (reg < NUM_GENERAL_REGISTERS) {
+    fprintf(out, "    regs.r[%u] = %s;\n", reg, value);
+  } else {
+    fprintf(out, "    (void) %s;\n", value);
+  }
+}
+
+/**
+ *  Emit the declaration of a shifted register operand, and of its carry c
+ *
+ *  @param out: file to write to
+ *  @param name: name of the variable holding the operand
+ *  @param op: operand or offset to evaluate
+ *  @param addr: address of the instruction
+ */
+static void emit_shifted_reg(FILE *out, const char *name, operand_t op,
+                             word_t addr) {
+  char rm[EXPR_SIZE];
+  char amount[EXPR_SIZE];
+  reg_expr(rm, op.reg.rm, addr);
+  if (op.reg.shiftBy) {
+    reg_expr(amount, op.reg.shift.shiftreg.rs, addr);
+    sprintf(amount + strlen(amount), " & 0xFF");
+  } else {
+    sprintf(amount, "%uu", op.reg.shift.constant.integer);
+  }
+  fprintf(out, "    int c = 0;\n");
+  fprintf(out, "    word_t %s = rt_shift(%u, %s, %s, &c);\n", name,
+          op.reg.type, rm, amount);
+}
+
+/**
+ *  Emit a data processing instruction
+ *
+ *  @param out: file to write to
+ *  @param instr: instruction to translate
+ *  @param addr: address of the instruction
+ */
+static void emit_dp(FILE *out, dp_instruction_t instr, word_t addr) {
+  char rn[EXPR_SIZE];
+  char value[4 * EXPR_SIZE];
+
+  if (instr.I) {
+    // Immediates are rotated at translation time
+    shift_result_t op2 = rotate_right_c(instr.operand2.imm.rotated.value,
+                                        instr.operand2.imm.rotated.rotate * 2);
+    fprintf(out, "    int c = %d;\n", op2.carry);
+    fprintf(out, "    word_t op2 = 0x%08xu;\n", op2.value);
+  } else {
+    emit_shifted_reg(out, "op2", instr.operand2, addr);
+  }
+
+  reg_expr(rn, instr.rn, addr);
+  sprintf(value, "rt_alu(0x%x, %d, %s, op2, c)", instr.opcode, instr.S, rn);
+  if (instr.opcode == TST || instr.opcode == TEQ || instr.opcode == CMP) {
+    fprintf(out, "    (void) %s;\n", value);
+  } else {
+    emit_write(out, instr.rd, value);
+  }
+}
+
+/**
+ *  Emit a multiply instruction
+ *
+ *  @param out: file to write to
+ *  @param instr: instruction to translate
+ *  @param addr: address of the instruction
+ */
+static void emit_mul(FILE *out, mul_instruction_t instr, word_t addr) {
+  char rm[EXPR_SIZE];
+  char rs[EXPR_SIZE];
+  char rn[EXPR_SIZE];
+  char value[4 * EXPR_SIZE];
+
+  reg_expr(rm, instr.rm, addr);
+  reg_expr(rs, instr.rs, addr);
+  reg_expr(rn, instr.rn, addr);
+  sprintf(value, "rt_mul(%d, %d, %s, %s, %s)", instr.A, instr.S, rm, rs, rn);
+  emit_write(out, instr.rd, value);
+}
+
+/**
+ *  Emit a single data transfer. A store into translated code hands over to
+ *  the interpreter, with the instruction after it already in the pipeline.
+ *
+ *  @param out: file to write to
+ *  @param state: recompiler state holding the binary
+ *  @param instr: instruction to translate
+ *  @param addr: address of the instruction
+ */
+static void emit_sdt(FILE *out, recompile_state_t *state,
+                     sdt_instruction_t instr, word_t addr) {
+  char rn[EXPR_SIZE];
+  char rd[EXPR_SIZE];
+  const char *sign = instr.U ? "+" : "-";
+
+  if (instr.I) {
+    emit_shifted_reg(out, "off", instr.offset, addr);
+  } else {
+    fprintf(out, "    word_t off = 0x%03xu;\n", instr.offset.imm.fixed);
+  }
+
+  reg_expr(rn, instr.rn, addr);
+  if (instr.P) {
+    fprintf(out, "    word_t addr = %s %s off;\n", rn, sign);
+  } else {
+    fprintf(out, "    word_t addr = %s;\n", rn);
+  }
+
+  if (instr.L) {
+    fprintf(out, "    word_t data;\n");
+    if (instr.rd < NUM_GENERAL_REGISTERS) {
+      fprintf(out, "    if (!rt_load(addr, &data)) {\n");
+      fprintf(out, "      regs.r[%u] = data;\n", instr.rd);
+      fprintf(out, "    }\n");
+    } else {
+      fprintf(out, "    (void) rt_load(addr, &data);\n");
+    }
+  } else {
+    reg_expr(rd, instr.rd, addr);
+    fprintf(out, "    int smc = rt_store(addr, %s);\n", rd);
+  }
+
+  if (!instr.P) {
+    if (instr.rn < NUM_GENERAL_REGISTERS) {
+      fprintf(out, "    regs.r[%u] = addr %s off;\n", instr.rn, sign);
+    } else {
+      fprintf(out, "    (void) off;\n");
+    }
+  }
+
+  if (!instr.L) {
+    word_t next = 0;
+    if (addr + 4 < MEM_SIZE) {
+      get_word(state->memory, addr + 4, &next);
+    }
+    fprintf(out, "    if (smc) {\n");
+    fprintf(out, "      return rt_resume(0x%08xu, 0x%08xu);\n", addr + 4,
+            next);
+    fprintf(out, "    }\n");
+  }
+}
+
+/**
+ *  Emit the translation of the instruction at an address
+ *
+ *  @param out: file to write to
+ *  @param state: recompiler state holding the binary and its CFG
+ *  @param addr: address of the instruction
+ */
+static void emit_instruction(FILE *out, recompile_state_t *state,
+                             word_t addr) {
+  word_t word;
+  instruction_t instr;
+  get_word(state->memory, addr, &word);
+  decode_word(&instr, word);
+
+  fprintf(out, "  /* 0x%08x: 0x%08x */\n", addr, word);
+  if (instr.type == HAL) {
+    fprintf(out, "  regs.pc = 0x%08xu;\n", addr + 8);
+    fprintf(out, "  rt_print_state();\n");
+    fprintf(out, "  return 0;\n");
+    return;
+  }
+
+  if (instr.cond == AL) {
+    fprintf(out, "  {\n");
+  } else {
+    fprintf(out, "  if (rt_condition(0x%x)) {\n", instr.cond);
+  }
+
+  if (instr.type == UND || writes_pc(&instr)) {
+    fprintf(out, "    return rt_enter(0x%08xu);\n", addr);
+  } else {
+    switch (instr.type) {
+      case DP:
+        emit_dp(out, instr.i.dp, addr);
+        break;
+      case MUL:
+        emit_mul(out, instr.i.mul, addr);
+        break;
+      case SDT:
+        emit_sdt(out, state, instr.i.sdt, addr);
+        break;
+      case BRN: {
+        word_t target = cfg_branch_target(addr, instr.i.brn);
+        if (target < MEM_SIZE && !(target & 0x3)) {
+          fprintf(out, "    goto L_%08x;\n", target);
+        } else {
+          fprintf(out, "    return rt_enter(0x%08xu);\n", target);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  fprintf(out, "  }\n");
+
+  if ((state->flags[addr >> 2] & CFG_FALLTHROUGH) && addr + 4 >= MEM_SIZE) {
+    fprintf(out, "  return rt_enter(0x%08xu);\n", addr + 4);
+  }
+}
+
+/**
+ *  Write the C program equivalent to a binary
+ *
+ *  @param out: file to write to
+ *  @param state: recompiler state holding the binary and its CFG
+ *  @param name: name of the binary, for the header comment
+ *  @return: integer error code based on success of the function
+ */
+int translate_program(FILE *out, recompile_state_t *state, const char *name) {
+  fprintf(out, "/*\n * Translated from %s by recompile.out, %d blocks\n */\n\n",
+          name, state->blocks);
+  fprintf(out, "#define TEXT_END 0x%08xu\n\n", state->textEnd);
+  emit_prelude(out);
+
+  // The image is at least one word, since C has no empty arrays
+  word_t imageSize = state->imageSize > 4 ? state->imageSize : 4;
+  fprintf(out, "\nconst unsigned char image[%u] = {", imageSize);
+  for (word_t i = 0; i < imageSize; i++) {
+    if (i % IMAGE_BYTES_PER_LINE == 0) {
+      fprintf(out, "\n ");
+    }
+    fprintf(out, " 0x%02x,", state->memory[i]);
+  }
+  fprintf(out, "\n};\n\n");
+
+  fprintf(out, "int main(void) {\n");
+  fprintf(out, "  memcpy(memory, image, sizeof(image));\n");
+  for (word_t idx = 0; idx < NUM_WORDS; idx++) {
+    byte_t flags = state->flags[idx];
+    if (!(flags & CFG_REACHED)) {
+      continue;
+    }
+    if (flags & CFG_LEADER) {
+      fprintf(out, "\n  /* block 0x%08x */\n", idx << 2);
+    }
+    if (flags & CFG_TARGET) {
+      fprintf(out, "L_%08x:\n", idx << 2);
+    }
+    emit_instruction(out, state, idx << 2);
+  }
+  fprintf(out, "}\n");
+
+  FAIL_SYS(ferror(out));
+  return EC_OK;
+}
@@ -0,0 +1,15 @@
+/*
+ *  Emits the C translation of a binary whose control flow has been
+ *  recovered.
+ */
+
+#ifndef TRANSLATE_H
+#define TRANSLATE_H
+
+#include <stdio.h>
+#include "../utils/arm.h"
+#include "../recompile.h"
+
+int translate_program(FILE *out, recompile_state_t *state, const char *name);
+
+#endif
@@ -0,0 +1,63 @@
+#include <stdint.h>
+#include <string.h>
+#include "../../unity/src/unity.h"
+#include "../utils/arena.h"
+
+void test_arena_alloc_is_aligned_and_distinct(void) {
+  arena_t *arena = arena_new(64);
+  TEST_ASSERT_NOT_NULL(arena);
+  char *a = arena_alloc(arena, 3);
+  char *b = arena_alloc(arena, 8);
+  TEST_ASSERT_EQUAL(0, (uintptr_t) a % ARENA_ALIGN);
+  TEST_ASSERT_EQUAL(0, (uintptr_t) b % ARENA_ALIGN);
+  TEST_ASSERT_TRUE(b >= a + 3);
+  arena_delete(arena);
+}
+
+void test_arena_grows_past_a_block(void) {
+  arena_t *arena = arena_new(64);
+  for (int i = 0; i < 100; i++) {
+    TEST_ASSERT_NOT_NULL(arena_alloc(arena, 24));
+  }
+  char *big = arena_alloc(arena, 1000);
+  TEST_ASSERT_NOT_NULL(big);
+  memset(big, 1, 1000);
+  TEST_ASSERT_EQUAL_STRING("label", arena_strndup(arena, "label:", 5));
+  arena_delete(arena);
+}
+
+void test_arena_reset_reuses_blocks(void) {
+  arena_t *arena = arena_new(64);
+  void *first = arena_alloc(arena, 48);
+  arena_alloc(arena, 48);
+  arena_block_t *second = arena->current;
+  TEST_ASSERT_TRUE(second != arena->first);
+
+  arena_reset(arena);
+  TEST_ASSERT_EQUAL_PTR(first, arena_alloc(arena, 48));
+  arena_alloc(arena, 48);
+  TEST_ASSERT_EQUAL_PTR(second, arena->current);
+  TEST_ASSERT_NULL(second->next);
+  arena_delete(arena);
+}
+
+void test_arena_counts_allocations(void) {
+  arena_t *arena = arena_new(64);
+  int *zeros = arena_calloc(arena, 10, sizeof(int));
+  for (int i = 0; i < 10; i++) {
+    TEST_ASSERT_EQUAL(0, zeros[i]);
+  }
+  arena_alloc(arena, 3);
+  TEST_ASSERT_EQUAL(2, arena->numAllocs);
+  TEST_ASSERT_EQUAL(48, arena->used);
+  arena_alloc(arena, 100);
+  TEST_ASSERT_EQUAL(2, arena->numBlocks);
+  TEST_ASSERT_EQUAL(64 + 104, arena->blockBytes);
+
+  arena_reset(arena);
+  arena_alloc(arena, 8);
+  TEST_ASSERT_EQUAL(8, arena->used);
+  TEST_ASSERT_EQUAL(152, arena->peak);
+  TEST_ASSERT_EQUAL(4, arena->numAllocs);
+  arena_delete(arena);
+}
@@ -0,0 +1,56 @@
+#include <stdlib.h>
+#include "../../unity/src/unity.h"
+#include "../recompile/cfg.h"
+#include "../utils/io.h"
+
+// mov r2, #3
+#define MOV_WORD 0xE3A02003
+// subs r2, r2, #1
+#define SUBS_WORD 0xE2522001
+// bne -2 words (back to the subs)
+#define BNE_BACK_WORD 0x1AFFFFFD
+// mov pc, r2
+#define MOV_PC_WORD 0xE1A0F002
+// b +0 words (skips the next word)
+#define B_SKIP_WORD 0xEA000000
+
+void test_cfg_loop(void) {
+  recompile_state_t *state = calloc(1, sizeof(recompile_state_t));
+  set_word(state->memory, 0x0, MOV_WORD);
+  set_word(state->memory, 0x4, SUBS_WORD);
+  set_word(state->memory, 0x8, BNE_BACK_WORD);
+  // halt at 0xC, then a literal that is never executed
+  set_word(state->memory, 0x10, MOV_WORD);
+
+  TEST_ASSERT_EQUAL(EC_OK, cfg_build(state));
+  TEST_ASSERT_TRUE(state->flags[0x4 >> 2] & CFG_TARGET);
+  TEST_ASSERT_TRUE(state->flags[0xC >> 2] & CFG_LEADER);
+  TEST_ASSERT_TRUE(state->flags[0x8 >> 2] & CFG_FALLTHROUGH);
+  TEST_ASSERT_FALSE(state->flags[0xC >> 2] & CFG_FALLTHROUGH);
+  TEST_ASSERT_FALSE(state->flags[0x10 >> 2] & CFG_REACHED);
+  TEST_ASSERT_EQUAL(3, state->blocks);
+  TEST_ASSERT_EQUAL(0x10, state->textEnd);
+  free(state);
+}
+
+void test_cfg_stops_at_pc_writes(void) {
+  recompile_state_t *state = calloc(1, sizeof(recompile_state_t));
+  set_word(state->memory, 0x0, B_SKIP_WORD);
+  set_word(state->memory, 0x4, MOV_WORD);
+  set_word(state->memory, 0x8, MOV_PC_WORD);
+  set_word(state->memory, 0xC, MOV_WORD);
+
+  TEST_ASSERT_EQUAL(EC_OK, cfg_build(state));
+  TEST_ASSERT_FALSE(state->flags[0x4 >> 2] & CFG_REACHED);
+  TEST_ASSERT_TRUE(state->flags[0x8 >> 2] & CFG_REACHED);
+  TEST_ASSERT_FALSE(state->flags[0x8 >> 2] & CFG_FALLTHROUGH);
+  TEST_ASSERT_FALSE(state->flags[0xC >> 2] & CFG_REACHED);
+  free(state);
+}
+
+void test_cfg_branch_target(void) {
+  brn_instruction_t back = {.offset = 0xFFFFFD};
+  brn_instruction_t skip = {.offset = 0x0};
+  TEST_ASSERT_EQUAL_HEX32(0x4, cfg_branch_target(0x8, back));
+  TEST_ASSERT_EQUAL_HEX32(0x8, cfg_branch_target(0x0, skip));
+}
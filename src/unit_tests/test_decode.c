@@ -249,3 +249,35 @@ void test_decodeHal(void) {
   instruction_t expected = hal_i;
   compareInstructions(expected, decoded);
 }
+
+void test_decodeUnsupported(void) {
+  word_t unsupported_w[] = {
+      0xEB000001, // bl
+      0xE1E00000, // mvn
+      0xE0A00001, // adc
+      0xE10F0000, // mrs (tst without S)
+      0xE5D10000, // ldrb
+      0xE1D100B0, // ldrh
+      0xE0810392, // umull
+      0xEF000000  // swi
+  };
+  size_t n = sizeof(unsupported_w) / sizeof(word_t);
+  for (size_t i = 0; i < n; i++) {
+    instruction_t decoded;
+    TEST_ASSERT_EQUAL_MESSAGE(EC_UNSUPPORTED_OP,
+                              decode_word(&decoded, unsupported_w[i]),
+                              "Status");
+    TEST_ASSERT_EQUAL_MESSAGE(UND, decoded.type, "Instr Type");
+  }
+}
+
+void test_decodeSDT_media_space(void) {
+  instruction_t decoded;
+  // ldr r0, [r1, r2, lsl r0] is not an SDT: bit 4 set with a register
+  // offset is the media space
+  TEST_ASSERT_EQUAL(EC_UNSUPPORTED_OP, decode_word(&decoded, 0xE7910012));
+  TEST_ASSERT_EQUAL(UND, decoded.type);
+  // ldr r0, [r1, r2] is
+  TEST_ASSERT_EQUAL(EC_OK, decode_word(&decoded, 0xE7910002));
+  TEST_ASSERT_EQUAL(SDT, decoded.type);
+}
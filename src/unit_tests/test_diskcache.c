@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+// mov r1, #1
+#define MOV_WORD 0xE3A01001
+// mov r2, #2
+#define MOV2_WORD 0xE3A02002
+
+static char dir[] = "/tmp/test_diskcache_XXXXXX";
+
+void setUp(void) {
+  TEST_ASSERT_NOT_NULL(mkdtemp(strcpy(dir, "/tmp/test_diskcache_XXXXXX")));
+}
+
+void tearDown(void) {
+  DIR *d = opendir(dir);
+  struct dirent *entry;
+  char path[512];
+  while ((entry = readdir(d)) != NULL) {
+    if (entry->d_name[0] != '.') {
+      snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+      unlink(path);
+    }
+  }
+  closedir(d);
+  rmdir(dir);
+}
+
+static emulate_state_t *load_program(void) {
+  emulate_state_t *state = emulate_state_new();
+  set_word(state->memory, 0x0, MOV_WORD);
+  set_word(state->memory, 0x4, MOV2_WORD);
+  return state;
+}
+
+// Path of the only file in the cache directory
+static void cache_file(char *path) {
+  DIR *d = opendir(dir);
+  struct dirent *entry;
+  path[0] = '\0';
+  while ((entry = readdir(d)) != NULL) {
+    if (entry->d_name[0] != '.') {
+      TEST_ASSERT_EQUAL(0, path[0]);
+      sprintf(path, "%s/%s", dir, entry->d_name);
+    }
+  }
+  closedir(d);
+  TEST_ASSERT_NOT_EQUAL(0, path[0]);
+}
+
+void test_diskcache_warm_start(void) {
+  emulate_state_t *state = load_program();
+  instruction_t instr;
+  TEST_ASSERT_EQUAL(EC_OK, diskcache_load(state, dir));
+  TEST_ASSERT_EQUAL(2, state->dcache.warmWords);
+  emulate_state_free(state);
+
+  state = load_program();
+  TEST_ASSERT_EQUAL(EC_OK, diskcache_load(state, dir));
+  TEST_ASSERT_NOT_NULL(state->dcache.warm);
+  TEST_ASSERT_EQUAL(EC_OK, predecode(state, 0x4, MOV2_WORD, &instr));
+  TEST_ASSERT_EQUAL(2, instr.i.dp.rd);
+  // Served from the mapped table, not the in-memory cache
+  TEST_ASSERT_FALSE(state->dcache.valid[0] & 0x2);
+
+  // A store retires the mapped table for its page
+  set_mem_word(state, 0x4, MOV_WORD);
+  TEST_ASSERT_EQUAL(EC_OK, predecode(state, 0x4, MOV_WORD, &instr));
+  TEST_ASSERT_EQUAL(1, instr.i.dp.rd);
+  emulate_state_free(state);
+}
+
+void test_diskcache_rebuilds_corrupt_file(void) {
+  emulate_state_t *state = load_program();
+  char path[512];
+  instruction_t instr;
+  TEST_ASSERT_EQUAL(EC_OK, diskcache_load(state, dir));
+  emulate_state_free(state);
+
+  // Flip the last byte of the decoded table
+  cache_file(path);
+  FILE *fp = fopen(path, "r+b");
+  fseek(fp, -1, SEEK_END);
+  int last = fgetc(fp);
+  fseek(fp, -1, SEEK_END);
+  fputc(last ^ 0xFF, fp);
+  fclose(fp);
+
+  state = load_program();
+  TEST_ASSERT_EQUAL(EC_OK, diskcache_load(state, dir));
+  TEST_ASSERT_EQUAL(EC_OK, predecode(state, 0x4, MOV2_WORD, &instr));
+  TEST_ASSERT_EQUAL(2, instr.i.dp.rd);
+  emulate_state_free(state);
+}
+
+void test_diskcache_keys_by_binary(void) {
+  emulate_state_t *state = load_program();
+  instruction_t instr;
+  TEST_ASSERT_EQUAL(EC_OK, diskcache_load(state, dir));
+  emulate_state_free(state);
+
+  // A different binary does not pick up the first one's table
+  state = load_program();
+  set_word(state->memory, 0x4, MOV_WORD);
+  TEST_ASSERT_EQUAL(EC_OK, diskcache_load(state, dir));
+  TEST_ASSERT_EQUAL(EC_OK, predecode(state, 0x4, MOV_WORD, &instr));
+  TEST_ASSERT_EQUAL(1, instr.i.dp.rd);
+  emulate_state_free(state);
+}
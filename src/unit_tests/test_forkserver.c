@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+// mov r1, #1
+#define MOV_WORD 0xE3A01001
+// mov r2, #2
+#define MOV2_WORD 0xE3A02002
+
+static char path[] = "/tmp/test_forkserver_XXXXXX";
+
+void setUp(void) {
+  int fd = mkstemp(strcpy(path, "/tmp/test_forkserver_XXXXXX"));
+  TEST_ASSERT_TRUE(fd >= 0);
+  close(fd);
+}
+
+void tearDown(void) {
+  unlink(path);
+}
+
+/**
+ *  Write a binary of two words, one in the first page and one in the second
+ */
+static void write_binary(word_t second) {
+  byte_t image[CODE_PAGE_SIZE + 4] = {0};
+  set_word(image, 0x0, MOV_WORD);
+  set_word(image, CODE_PAGE_SIZE, second);
+  TEST_ASSERT_EQUAL(EC_OK, write_file(path, image, sizeof(image)));
+}
+
+static emulate_state_t *load_binary(void) {
+  emulate_state_t *state = emulate_state_new();
+  TEST_ASSERT_EQUAL(EC_OK, read_file(path, state->memory, MEM_SIZE));
+  instruction_t instr;
+  predecode(state, 0x0, MOV_WORD, &instr);
+  predecode(state, CODE_PAGE_SIZE, MOV_WORD, &instr);
+  return state;
+}
+
+void test_forkserver_reload_keeps_unchanged_pages(void) {
+  write_binary(MOV_WORD);
+  emulate_state_t *state = load_binary();
+  byte_t *image = malloc(MEM_SIZE);
+  TEST_ASSERT_EQUAL(EC_OK, forkserver_reload(state, path, image));
+
+  TEST_ASSERT_EQUAL(0, state->dcache.invalidations);
+  TEST_ASSERT_TRUE(is_code_page(state, 0x0));
+  TEST_ASSERT_TRUE(is_code_page(state, CODE_PAGE_SIZE));
+  free(image);
+  emulate_state_free(state);
+}
+
+void test_forkserver_reload_drops_changed_pages(void) {
+  write_binary(MOV_WORD);
+  emulate_state_t *state = load_binary();
+  write_binary(MOV2_WORD);
+  byte_t *image = malloc(MEM_SIZE);
+  TEST_ASSERT_EQUAL(EC_OK, forkserver_reload(state, path, image));
+
+  word_t word;
+  get_word(state->memory, CODE_PAGE_SIZE, &word);
+  TEST_ASSERT_EQUAL_HEX32(MOV2_WORD, word);
+  TEST_ASSERT_EQUAL(1, state->dcache.invalidations);
+  TEST_ASSERT_TRUE(is_code_page(state, 0x0));
+  TEST_ASSERT_FALSE(is_code_page(state, CODE_PAGE_SIZE));
+
+  instruction_t instr;
+  TEST_ASSERT_EQUAL(EC_OK, predecode(state, CODE_PAGE_SIZE, word, &instr));
+  TEST_ASSERT_EQUAL(2, instr.i.dp.rd);
+  free(image);
+  emulate_state_free(state);
+}
+
+void test_forkserver_reload_clears_words_past_a_shorter_binary(void) {
+  write_binary(MOV_WORD);
+  emulate_state_t *state = load_binary();
+  byte_t image[4] = {0};
+  set_word(image, 0x0, MOV_WORD);
+  TEST_ASSERT_EQUAL(EC_OK, write_file(path, image, sizeof(image)));
+
+  byte_t *buffer = malloc(MEM_SIZE);
+  TEST_ASSERT_EQUAL(EC_OK, forkserver_reload(state, path, buffer));
+  word_t word;
+  get_word(state->memory, CODE_PAGE_SIZE, &word);
+  TEST_ASSERT_EQUAL_HEX32(0x0, word);
+  free(buffer);
+  emulate_state_free(state);
+}
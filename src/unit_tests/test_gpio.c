@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+static emulate_state_t *state;
+static char path[] = "/tmp/test_gpio_XXXXXX";
+
+void setUp(void) {
+  state = emulate_state_new();
+}
+
+void tearDown(void) {
+  emulate_state_free(state);
+}
+
+void test_gpio_drives_only_output_pins(void) {
+  TEST_ASSERT_EQUAL(EC_OK, gpio_new(NULL, &state->gpio));
+  // Pin 16 as an output
+  gpio_store(state, GPIO_FSEL0 + 4, GPIO_FUNC_OUTPUT << 18);
+  gpio_store(state, GPIO_SET0, (1 << 16) | (1 << 17));
+  TEST_ASSERT_EQUAL_HEX32(1 << 16, gpio_load(state, GPIO_LEV0));
+
+  // Pin 17 takes the level it was set to once it is an output
+  gpio_store(state, GPIO_FSEL0 + 4, (GPIO_FUNC_OUTPUT << 18)
+                                    | (GPIO_FUNC_OUTPUT << 21));
+  TEST_ASSERT_EQUAL_HEX32(3 << 16, gpio_load(state, GPIO_LEV0));
+  gpio_store(state, GPIO_CLR0, 1 << 16);
+  TEST_ASSERT_EQUAL_HEX32(1 << 17, gpio_load(state, GPIO_LEV0));
+  TEST_ASSERT_EQUAL_HEX32(GPIO_FUNC_OUTPUT << 21 | GPIO_FUNC_OUTPUT << 18,
+                          gpio_load(state, GPIO_FSEL0 + 4));
+
+  // Pin 53, the last
+  gpio_store(state, GPIO_FSEL0 + 20, GPIO_FUNC_OUTPUT << 9);
+  gpio_store(state, GPIO_SET1, 0xFFFFFFFF);
+  TEST_ASSERT_EQUAL_HEX32(1 << 21, gpio_load(state, GPIO_LEV1));
+}
+
+void test_gpio_writes_level_changes_to_the_vcd_file(void) {
+  close(mkstemp(path));
+  TEST_ASSERT_EQUAL(EC_OK, gpio_new(path, &state->gpio));
+  gpio_store(state, GPIO_FSEL0, GPIO_FUNC_OUTPUT);
+  state->steps = 5;
+  gpio_store(state, GPIO_SET0, 1);
+  // No change
+  state->steps = 7;
+  gpio_store(state, GPIO_SET0, 1);
+  state->steps = 9;
+  gpio_store(state, GPIO_CLR0, 1);
+  state->steps = 12;
+  TEST_ASSERT_EQUAL(EC_OK, gpio_free(state->gpio, state->steps));
+  state->gpio = NULL;
+
+  char vcd[8192];
+  FILE *file = fopen(path, "r");
+  TEST_ASSERT_NOT_NULL(file);
+  vcd[fread(vcd, 1, sizeof(vcd) - 1, file)] = '\0';
+  fclose(file);
+  unlink(path);
+  TEST_ASSERT_NOT_NULL(strstr(vcd, "$var wire 1 ! pin0 $end\n"));
+  TEST_ASSERT_NOT_NULL(strstr(vcd, "$var wire 1 V pin53 $end\n"));
+  TEST_ASSERT_NOT_NULL(strstr(vcd, "$dumpvars\n0!\n0\"\n"));
+  TEST_ASSERT_NOT_NULL(strstr(vcd, "$end\n#5\n1!\n#9\n0!\n#12\n"));
+  TEST_ASSERT_NULL(strstr(vcd, "#7"));
+}
+
+void test_gpio_reports_a_vcd_file_it_cannot_open(void) {
+  TEST_ASSERT_TRUE(EC_IS_SYS_ERROR(gpio_new("/nonexistent/gpio.vcd",
+                                            &state->gpio)));
+  TEST_ASSERT_NULL(state->gpio);
+}
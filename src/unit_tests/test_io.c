@@ -1,21 +1,35 @@
 #include "../../unity/src/unity.h"
 #include "../utils/io.h"
 #include <stdlib.h>
+#include <string.h>
 
-void test_read_char_file(void){
-  char path[] = "../../unit_tests/test_cases/add01.s";
-  char **buff = malloc(100 * sizeof(char *));
-  for (size_t i = 0; i < 100; i++) {
-    buff[i] = malloc(512 * sizeof(char));
-  }
-  int num_of_lines = read_char_file(path, buff);
-  for (size_t i = 0; i < 100; i++) {
-    for (size_t j = 0; j < 512; j++) {
-      printf("%c", buff[i][j]);
-    }
-  }
-  printf("%s\n", path);
-  printf("%u\n", num_of_lines);
+void test_map_file(void){
+  char path[] = "../../test/test_cases/add01.s";
+  const char *data;
+  size_t size;
+  TEST_ASSERT_EQUAL(EC_OK, map_file(path, &data, &size));
+
+  char expected[256];
+  FILE *fp = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL(fp);
+  size_t expectedSize = fread(expected, 1, sizeof(expected), fp);
+  fclose(fp);
+  TEST_ASSERT_EQUAL(expectedSize, size);
+  TEST_ASSERT_EQUAL(0, memcmp(expected, data, size));
+  unmap_file(data, size);
+}
+
+void test_map_file_empty(void){
+  char path[] = "build/empty.s";
+  FILE *fp = fopen(path, "w");
+  TEST_ASSERT_NOT_NULL(fp);
+  fclose(fp);
+  const char *data;
+  size_t size;
+  TEST_ASSERT_EQUAL(EC_OK, map_file(path, &data, &size));
+  TEST_ASSERT_NULL(data);
+  TEST_ASSERT_EQUAL(0, size);
+  unmap_file(data, size);
 }
 
 void test_read_file(void){
@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+// mov r1, #1
+#define MOV_WORD 0xE3A01001
+// mov r3, #2
+#define MOV3_WORD 0xE3A03002
+// add r2, r2, r1
+#define ADD_WORD 0xE0822001
+// cmp r2, #10
+#define CMP_WORD 0xE352000A
+// cmp r2, #11
+#define CMP11_WORD 0xE352000B
+// str r1, [r0]
+#define STR_WORD 0xE5801000
+// ldr r1, [r0]
+#define LDR_WORD 0xE5901000
+// mov r3, #5
+#define MOV3_5_WORD 0xE3A03005
+
+/**
+ *  Record a loop as if each word executed in turn, ending with a bne taken
+ *  back to the first
+ */
+static int record(trace_entry_t *entries, const word_t *words, int n) {
+  for (int i = 0; i < n; i++) {
+    entries[i].addr = i << 2;
+    entries[i].word = words[i];
+    entries[i].taken = false;
+    decode_word(&entries[i].instr, words[i]);
+  }
+  word_t offset = (0 - ((n << 2) + 8)) >> 2;
+  entries[n].addr = n << 2;
+  entries[n].word = 0x1A000000 | (offset & 0xFFFFFF);
+  entries[n].taken = true;
+  decode_word(&entries[n].instr, entries[n].word);
+  return n + 1;
+}
+
+void test_ir_propagates_constants(void) {
+  trace_entry_t entries[4];
+  word_t words[] = {MOV_WORD, ADD_WORD, CMP_WORD};
+  ir_trace_t *trace = ir_lower(entries, record(entries, words, 3));
+  TEST_ASSERT_NOT_NULL(trace);
+  TEST_ASSERT_EQUAL(4, trace->numOps);
+  TEST_ASSERT_EQUAL(1, trace->ops[1].b.reg);
+
+  ir_optimise(trace);
+  TEST_ASSERT_EQUAL(4, trace->numOps);
+  TEST_ASSERT_EQUAL(IR_CONST, trace->ops[1].b.reg);
+  TEST_ASSERT_EQUAL(1, trace->ops[1].b.value);
+  TEST_ASSERT_EQUAL(IR_GUARD, trace->ops[3].kind);
+  TEST_ASSERT_EQUAL_HEX32(0x10, trace->ops[3].target);
+  free(trace);
+}
+
+void test_ir_eliminates_dead_flags_and_stores(void) {
+  trace_entry_t entries[5];
+  word_t words[] = {MOV3_WORD, MOV3_WORD, CMP_WORD, CMP11_WORD};
+  ir_trace_t *trace = ir_lower(entries, record(entries, words, 4));
+  ir_optimise(trace);
+
+  // The second move, the second compare and the guard
+  TEST_ASSERT_EQUAL(3, trace->numOps);
+  TEST_ASSERT_EQUAL(0x4, trace->ops[0].addr);
+  TEST_ASSERT_EQUAL(0xC, trace->ops[1].addr);
+  TEST_ASSERT_TRUE(trace->ops[1].setFlags);
+  free(trace);
+}
+
+void test_ir_run_leaves_precise_state(void) {
+  emulate_state_t *state = emulate_state_new();
+  trace_entry_t entries[4];
+  word_t words[] = {MOV_WORD, ADD_WORD, CMP_WORD};
+  ir_trace_t *trace = ir_lower(entries, record(entries, words, 3));
+  ir_optimise(trace);
+
+  TEST_ASSERT_EQUAL_HEX32(0x10, ir_run(state, trace));
+  TEST_ASSERT_EQUAL(1, state->registers.r[1]);
+  TEST_ASSERT_EQUAL(10, state->registers.r[2]);
+  TEST_ASSERT_EQUAL_HEX32((Z | C) << 28, state->registers.cpsr);
+  TEST_ASSERT_EQUAL(9, state->stats.traceIterations);
+  free(trace);
+  emulate_state_free(state);
+}
+
+void test_ir_store_to_code_leaves_before_storing(void) {
+  emulate_state_t *state = emulate_state_new();
+  trace_entry_t entries[3];
+  word_t words[] = {MOV_WORD, STR_WORD};
+  ir_trace_t *trace = ir_lower(entries, record(entries, words, 2));
+  ir_optimise(trace);
+  set_word(state->memory, 0x0, MOV_WORD);
+  mark_code_page(state, 0x0);
+
+  TEST_ASSERT_EQUAL_HEX32(0x4, ir_run(state, trace));
+  TEST_ASSERT_EQUAL(1, state->registers.r[1]);
+  TEST_ASSERT_EQUAL(0, state->dcache.invalidations);
+  word_t word;
+  get_word(state->memory, 0x0, &word);
+  TEST_ASSERT_EQUAL_HEX32(MOV_WORD, word);
+  free(trace);
+  emulate_state_free(state);
+}
+
+void test_ir_blocked_load_leaves_precise_state(void) {
+  emulate_state_t *state = emulate_state_new();
+  sched_task_t task = {.state = state, .inputLen = 0};
+  pthread_mutex_init(&task.lock, NULL);
+  state->task = &task;
+  state->registers.r[0] = SCHED_INPUT;
+  trace_entry_t entries[6];
+  word_t words[] = {MOV3_WORD, CMP_WORD, LDR_WORD, MOV3_5_WORD, CMP11_WORD};
+  ir_trace_t *trace = ir_lower(entries, record(entries, words, 5));
+  ir_optimise(trace);
+
+  // The move and the compare overwritten after the load are kept, as the
+  // task leaves the trace at the load with no input
+  TEST_ASSERT_EQUAL_HEX32(0x8, ir_run(state, trace));
+  TEST_ASSERT_EQUAL(2, state->registers.r[3]);
+  TEST_ASSERT_EQUAL_HEX32(N << 28, state->registers.cpsr);
+  pthread_mutex_destroy(&task.lock);
+  free(trace);
+  emulate_state_free(state);
+}
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../unity/src/unity.h"
+#include "../assemble/linecache.h"
+#include "../utils/error.h"
+
+#define NUM_LINES 10000
+
+/**
+* Make the entry of a numbered line, which assembles to a word
+*/
+line_entry_t line_entry(char *line, int i) {
+  int len = sprintf(line, "add r1,r1,#%d", i);
+  line_entry_t entry = {.hash = linecache_hash(line, len), .len = len,
+                        .word = i, .kind = LINE_WORD};
+  return entry;
+}
+
+void test_linecache_finds_lines(void) {
+  line_cache_t *cache = linecache_new();
+  TEST_ASSERT_NOT_NULL(cache);
+  const char *line = "loop: b loop";
+  line_entry_t entry = {.hash = linecache_hash(line, 12), .len = 12,
+                        .word = 0xEA000000, .labelStart = 8, .labelLen = 4,
+                        .kind = LINE_BRANCH};
+
+  TEST_ASSERT_NULL(linecache_find(cache, entry.hash, entry.len));
+  TEST_ASSERT_EQUAL(EC_OK, linecache_put(cache, &entry));
+  const line_entry_t *found = linecache_find(cache, entry.hash, entry.len);
+  TEST_ASSERT_NOT_NULL(found);
+  TEST_ASSERT_EQUAL(LINE_BRANCH, found->kind);
+  TEST_ASSERT_EQUAL_HEX32(0xEA000000, found->word);
+  TEST_ASSERT_EQUAL(8, found->labelStart);
+
+  // The same hash for a line of another length is another line
+  TEST_ASSERT_NULL(linecache_find(cache, entry.hash, 11));
+  TEST_ASSERT_EQUAL(1, cache->hits);
+  TEST_ASSERT_EQUAL(2, cache->misses);
+  linecache_delete(cache);
+}
+
+void test_linecache_grows_and_prunes(void) {
+  line_cache_t *cache = linecache_new();
+  char line[32];
+  for (int i = 0; i < NUM_LINES; i++) {
+    line_entry_t entry = line_entry(line, i);
+    TEST_ASSERT_EQUAL(EC_OK, linecache_put(cache, &entry));
+  }
+  TEST_ASSERT_EQUAL(NUM_LINES, cache->count);
+  TEST_ASSERT_TRUE(cache->count * 100 <= cache->capacity * LINECACHE_MAX_LOAD);
+
+  // Only the lines used since the last prune are kept
+  TEST_ASSERT_EQUAL(EC_OK, linecache_prune(cache));
+  TEST_ASSERT_EQUAL(NUM_LINES, cache->count);
+  line_entry_t used = line_entry(line, 7);
+  TEST_ASSERT_NOT_NULL(linecache_find(cache, used.hash, used.len));
+  TEST_ASSERT_EQUAL(EC_OK, linecache_prune(cache));
+  TEST_ASSERT_EQUAL(1, cache->count);
+  TEST_ASSERT_EQUAL(INITIAL_LINECACHE_CAPACITY, cache->capacity);
+  const line_entry_t *found = linecache_find(cache, used.hash, used.len);
+  TEST_ASSERT_NOT_NULL(found);
+  TEST_ASSERT_EQUAL(7, found->word);
+  linecache_delete(cache);
+}
+
+void test_linecache_saves_and_loads(void) {
+  char path[64];
+  sprintf(path, "/tmp/test_linecache.%d", (int) getpid());
+  line_cache_t *cache = linecache_new();
+  char line[32];
+  for (int i = 0; i < 100; i++) {
+    line_entry_t entry = line_entry(line, i);
+    TEST_ASSERT_EQUAL(EC_OK, linecache_put(cache, &entry));
+  }
+  TEST_ASSERT_EQUAL(EC_OK, linecache_save(cache, path));
+  linecache_delete(cache);
+
+  cache = linecache_new();
+  TEST_ASSERT_EQUAL(EC_OK, linecache_load(cache, path));
+  TEST_ASSERT_EQUAL(100, cache->count);
+  line_entry_t entry = line_entry(line, 42);
+  const line_entry_t *found = linecache_find(cache, entry.hash, entry.len);
+  TEST_ASSERT_NOT_NULL(found);
+  TEST_ASSERT_EQUAL(42, found->word);
+  linecache_delete(cache);
+
+  // A corrupted file adds nothing
+  FILE *fp = fopen(path, "r+b");
+  TEST_ASSERT_NOT_NULL(fp);
+  fseek(fp, sizeof(linecache_header_t) + 4, SEEK_SET);
+  fputc('x', fp);
+  fclose(fp);
+  cache = linecache_new();
+  TEST_ASSERT_EQUAL(EC_INVALID_PARAM, linecache_load(cache, path));
+  TEST_ASSERT_EQUAL(0, cache->count);
+  linecache_delete(cache);
+  unlink(path);
+
+  cache = linecache_new();
+  TEST_ASSERT_NOT_EQUAL(EC_OK, linecache_load(cache, path));
+  linecache_delete(cache);
+}
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+// ldr r0, [pc, #0x18], loading the word at 0x20
+#define LDR_WORD 0xE59F0018
+// add r1, r1, r0
+#define ADD_WORD 0xE0811000
+// subs r0, r0, #1
+#define SUBS_WORD 0xE2500001
+// bne 0x4, from 0xC
+#define BNE_WORD 0x1AFFFFFC
+// str r0, [r0]
+#define STR_WORD 0xE5800000
+#define DATA_ADDR 0x20
+
+/**
+ *  Set up a lane holding a program and a data word
+ */
+static emulate_state_t *lane_new(const word_t *words, int n, word_t data) {
+  emulate_state_t *state = emulate_state_new();
+  for (int i = 0; i < n; i++) {
+    set_word(state->memory, i << 2, words[i]);
+  }
+  set_word(state->memory, DATA_ADDR, data);
+  return state;
+}
+
+void test_lockstep_runs_lanes_to_the_halt(void) {
+  word_t words[] = {LDR_WORD, ADD_WORD, SUBS_WORD, BNE_WORD};
+  emulate_state_t *lanes[] = {lane_new(words, 4, 3), lane_new(words, 4, 3)};
+  TEST_ASSERT_EQUAL(EC_OK, lockstep_run(lanes, 2));
+
+  for (int i = 0; i < 2; i++) {
+    TEST_ASSERT_EQUAL(HAL, lanes[i]->pipeline.decoded->type);
+    TEST_ASSERT_EQUAL_HEX32(0x10, lanes[i]->pipeline.decoded_addr);
+    TEST_ASSERT_EQUAL_HEX32(0x18, get_pc(lanes[i]));
+    TEST_ASSERT_EQUAL(6, lanes[i]->registers.r[1]);
+    TEST_ASSERT_EQUAL_HEX32((Z | C) << 28, lanes[i]->registers.cpsr);
+    TEST_ASSERT_EQUAL(10, lanes[i]->stats.lockstepSteps);
+  }
+
+  // The lanes count their steps and cycles as a guest run alone does
+  emulate_state_t *alone = lane_new(words, 4, 3);
+  TEST_ASSERT_EQUAL(EC_OK, pipeline_refill(alone, 0x0));
+  TEST_ASSERT_EQUAL(EC_OK, execute_program(alone));
+  for (int i = 0; i < 2; i++) {
+    TEST_ASSERT_EQUAL(alone->steps, lanes[i]->steps);
+    TEST_ASSERT_EQUAL(alone->cycles, lanes[i]->cycles);
+    emulate_state_free(lanes[i]);
+  }
+  emulate_state_free(alone);
+}
+
+void test_lockstep_detaches_lanes_that_branch_away(void) {
+  word_t words[] = {LDR_WORD, ADD_WORD, SUBS_WORD, BNE_WORD};
+  emulate_state_t *lanes[] = {lane_new(words, 4, 5), lane_new(words, 4, 2),
+                              lane_new(words, 4, 5)};
+  TEST_ASSERT_EQUAL(EC_OK, lockstep_run(lanes, 3));
+
+  // The second lane leaves at its last bne, before the others
+  TEST_ASSERT_EQUAL(7, lanes[1]->stats.lockstepSteps);
+  TEST_ASSERT_EQUAL(3, lanes[1]->registers.r[1]);
+  TEST_ASSERT_EQUAL_HEX32(0x10, lanes[1]->pipeline.decoded_addr);
+  for (int i = 0; i < 3; i += 2) {
+    TEST_ASSERT_EQUAL(16, lanes[i]->stats.lockstepSteps);
+    TEST_ASSERT_EQUAL(15, lanes[i]->registers.r[1]);
+    TEST_ASSERT_EQUAL(HAL, lanes[i]->pipeline.decoded->type);
+  }
+  for (int i = 0; i < 3; i++) {
+    emulate_state_free(lanes[i]);
+  }
+}
+
+void test_lockstep_detaches_lanes_before_storing_to_code(void) {
+  word_t words[] = {LDR_WORD, STR_WORD};
+  emulate_state_t *lanes[] = {lane_new(words, 2, 0x0),
+                              lane_new(words, 2, 0x40)};
+  TEST_ASSERT_EQUAL(EC_OK, lockstep_run(lanes, 2));
+
+  word_t word;
+  get_word(lanes[0]->memory, 0x0, &word);
+  TEST_ASSERT_EQUAL_HEX32(LDR_WORD, word);
+  TEST_ASSERT_EQUAL_HEX32(0x4, lanes[0]->pipeline.decoded_addr);
+  TEST_ASSERT_EQUAL(SDT, lanes[0]->pipeline.decoded->type);
+
+  get_word(lanes[1]->memory, 0x40, &word);
+  TEST_ASSERT_EQUAL_HEX32(0x40, word);
+  TEST_ASSERT_EQUAL_HEX32(0x8, lanes[1]->pipeline.decoded_addr);
+  emulate_state_free(lanes[0]);
+  emulate_state_free(lanes[1]);
+}
+
+void test_lockstep_detaches_lanes_with_different_code(void) {
+  word_t words[] = {LDR_WORD, ADD_WORD};
+  word_t other[] = {LDR_WORD, SUBS_WORD};
+  emulate_state_t *lanes[] = {lane_new(words, 2, 1), lane_new(other, 2, 1)};
+  TEST_ASSERT_EQUAL(EC_OK, lockstep_run(lanes, 2));
+
+  // Both lanes hold the first word, but differ at the one fetched behind it
+  TEST_ASSERT_EQUAL(0, lanes[1]->stats.lockstepSteps);
+  TEST_ASSERT_EQUAL_HEX32(0x0, lanes[1]->pipeline.decoded_addr);
+  TEST_ASSERT_EQUAL(2, lanes[0]->stats.lockstepSteps);
+  TEST_ASSERT_EQUAL(1, lanes[0]->registers.r[1]);
+  emulate_state_free(lanes[0]);
+  emulate_state_free(lanes[1]);
+}
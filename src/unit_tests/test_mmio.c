@@ -0,0 +1,32 @@
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+#include <stdlib.h>
+
+void test_perf_counters_count_from_reset(void){
+  emulate_state_t *state = emulate_state_new();
+  state->steps = 100;
+  state->cycles = 150;
+  TEST_ASSERT_EQUAL(EC_OK, set_mem_word(state, PERF_CONTROL, PERF_RESET));
+  state->steps += 7;
+  state->cycles += 11;
+
+  word_t word;
+  TEST_ASSERT_EQUAL(EC_OK, get_mem_word(state, PERF_INSTRS, &word));
+  TEST_ASSERT_EQUAL(7, word);
+  TEST_ASSERT_EQUAL(EC_OK, get_mem_word(state, PERF_CYCLES, &word));
+  TEST_ASSERT_EQUAL(11, word);
+  emulate_state_free(state);
+}
+
+void test_perf_counters_latch_the_high_word(void){
+  emulate_state_t *state = emulate_state_new();
+  state->cycles = 0x300000002ull;
+
+  word_t low, high;
+  TEST_ASSERT_EQUAL(EC_OK, get_mem_word(state, PERF_CYCLES, &low));
+  state->cycles = 0x400000000ull;
+  TEST_ASSERT_EQUAL(EC_OK, get_mem_word(state, PERF_HIGH, &high));
+  TEST_ASSERT_EQUAL_HEX32(0x2, low);
+  TEST_ASSERT_EQUAL_HEX32(0x3, high);
+  emulate_state_free(state);
+}
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <string.h>
+#include "../../unity/src/unity.h"
+#include "../assemble/mnemonic.h"
+
+static const char *bases[] = {
+    "add", "sub", "rsb", "and", "eor", "orr", "mov", "tst", "teq", "cmp",
+    "mul", "mla", "ldr", "str", "lsl", "lsr", "asr", "ror", "b"
+};
+
+static const char *suffixes[] = {"", "eq", "ne", "ge", "lt", "gt", "le", "al"};
+
+static const condition_t conds[] = {AL, EQ, NE, GE, LT, GT, LE, AL};
+
+void test_mnemonic_finds_every_mnemonic(void) {
+  // A collision in the table would leave a mnemonic out
+  char name[8];
+  for (int i = 0; i < sizeof(bases) / sizeof(char *); i++) {
+    for (int j = 0; j < sizeof(suffixes) / sizeof(char *); j++) {
+      sprintf(name, "%s%s", bases[i], suffixes[j]);
+      const mnemonic_t *mnemonic = mnemonic_lookup(name, strlen(name));
+      TEST_ASSERT_NOT_NULL_MESSAGE(mnemonic, name);
+      TEST_ASSERT_EQUAL_STRING(name, mnemonic->name);
+      TEST_ASSERT_EQUAL(conds[j], mnemonic->cond);
+    }
+  }
+}
+
+void test_mnemonic_fields(void) {
+  const mnemonic_t *mnemonic = mnemonic_lookup("cmpgt", 5);
+  TEST_ASSERT_EQUAL(MNEMONIC_DP, mnemonic->kind);
+  TEST_ASSERT_EQUAL(CMP, mnemonic->opcode);
+  TEST_ASSERT_EQUAL(GT, mnemonic->cond);
+
+  mnemonic = mnemonic_lookup("mla", 3);
+  TEST_ASSERT_EQUAL(MNEMONIC_MUL, mnemonic->kind);
+  TEST_ASSERT_EQUAL(1, mnemonic->flag);
+
+  mnemonic = mnemonic_lookup("strne", 5);
+  TEST_ASSERT_EQUAL(MNEMONIC_SDT, mnemonic->kind);
+  TEST_ASSERT_EQUAL(0, mnemonic->flag);
+
+  mnemonic = mnemonic_lookup("ror", 3);
+  TEST_ASSERT_EQUAL(MNEMONIC_SHIFT, mnemonic->kind);
+  TEST_ASSERT_EQUAL(ROR, mnemonic->shift);
+
+  mnemonic = mnemonic_lookup("ble", 3);
+  TEST_ASSERT_EQUAL(MNEMONIC_BRN, mnemonic->kind);
+  TEST_ASSERT_EQUAL(LE, mnemonic->cond);
+}
+
+void test_mnemonic_rejects_other_words(void) {
+  const char *words[] = {"", "a", "ad", "addx", "addeqx", "beqq", "bx", "bl",
+                         "loop", "r1", "adc", "movs", "ADD", "andle\xff"};
+  for (int i = 0; i < sizeof(words) / sizeof(char *); i++) {
+    TEST_ASSERT_NULL_MESSAGE(mnemonic_lookup(words[i], strlen(words[i])),
+                             words[i]);
+  }
+  // Only the given length is looked at
+  TEST_ASSERT_NOT_NULL(mnemonic_lookup("movxyz", 3));
+}
@@ -1,11 +1,32 @@
 #include "../../unity/src/unity.h"
 #include "../assemble/symbolmap.h"
-#include "../assemble/referencemap.h"
 #include "../utils/bitops.h"
 #include "../assemble/parser.h"
+#include "../assemble/encode.h"
+#include "../utils/io.h"
+#include "../utils/error.h"
 
 assemble_state_t *prog = NULL;
 
+void setUp(void) {
+  prog = calloc(1, sizeof(assemble_state_t));
+  prog->arena = arena_new(ARENA_BLOCK_SIZE);
+  prog->smap = smap_new(prog->arena, INITIAL_S_MAP_CAPACITY);
+  prog->lineArena = arena_new(ARENA_BLOCK_SIZE);
+}
+
+void tearDown(void) {
+  arena_delete(prog->lineArena);
+  arena_delete(prog->arena);
+  free(prog);
+}
+
+// Tokenize a line of assembly into the program state
+static void tokenize_line(const char *line) {
+  TEST_ASSERT_EQUAL(EC_OK, tokenize(line, line + strlen(line), prog->lineArena,
+                                    &prog->tklst));
+}
+
 void compareInstructions(instruction_t e, instruction_t d){
   TEST_ASSERT_EQUAL_MESSAGE(e.type, d.type, "Instr Type");
   TEST_ASSERT_EQUAL_MESSAGE(e.cond, d.cond, "Condition");
@@ -102,25 +123,52 @@ void compareInstructions(instruction_t e, instruction_t d){
 
 
 void test_parse_hal(void){
+  // The halt is andeq r0,r0,r0, which encodes as the all zero word
   instruction_t hal_i = {
-          .type = HAL,
-          .cond = 0x0,
-          .i.hal.pad0 = 0x0
+          .type = DP,
+          .cond = EQ,
+          .i.dp = {
+                  .opcode = AND,
+                  .rd = 0,
+                  .rn = 0,
+                  .operand2.reg = {.rm = 0, .type = LSL}
+          }
   };
-  list_t *tklst = token_list_new();
-  token_list_add_pair(tklst, T_OPCODE, "andeq");
-  token_list_add_pair(tklst, T_REGISTER, "r0");
-  token_list_add_pair(tklst, T_REGISTER, "r0");
-  token_list_add_pair(tklst, T_REGISTER, "r0");
+  tokenize_line("andeq r0,r0,r0");
 
   instruction_t result;
   if (parse(prog, &result)){
     TEST_ASSERT_MESSAGE(false, "False Error");
   }
-  token_list_delete(tklst);
   compareInstructions(hal_i, result);
 }
 
+void test_parse_conditional_forms(void){
+  instruction_t result;
+  tokenize_line("addne r1,r2,#3");
+  TEST_ASSERT_EQUAL(EC_OK, parse(prog, &result));
+  TEST_ASSERT_EQUAL(DP, result.type);
+  TEST_ASSERT_EQUAL(NE, result.cond);
+  TEST_ASSERT_EQUAL(ADD, result.i.dp.opcode);
+
+  tokenize_line("ldrge r0,[r1]");
+  TEST_ASSERT_EQUAL(EC_OK, parse(prog, &result));
+  TEST_ASSERT_EQUAL(SDT, result.type);
+  TEST_ASSERT_EQUAL(GE, result.cond);
+  TEST_ASSERT_EQUAL(1, result.i.sdt.L);
+
+  tokenize_line("lsrlt r3,#4");
+  TEST_ASSERT_EQUAL(EC_OK, parse(prog, &result));
+  TEST_ASSERT_EQUAL(DP, result.type);
+  TEST_ASSERT_EQUAL(LT, result.cond);
+  TEST_ASSERT_EQUAL(MOV, result.i.dp.opcode);
+  TEST_ASSERT_EQUAL(LSR, result.i.dp.operand2.reg.type);
+  TEST_ASSERT_EQUAL(4, result.i.dp.operand2.reg.shift.constant.integer);
+
+  tokenize_line("addxx r1,r2,#3");
+  TEST_ASSERT_EQUAL(EC_UNSUPPORTED_OP, parse(prog, &result));
+}
+
 void test_parse_mul(void){
   instruction_t mul_i = {
           .type = MUL,
@@ -130,23 +178,18 @@ void test_parse_mul(void){
                   .A = 0,
                   .S = 0,
                   .rd = 0xC,
-                  .rn = 0xA,
+                  .rn = 0x0,
                   .rs = 0x1,
                   .pad9 = 0x9,
                   .rm = 0x2
           }
   };
-  list_t *tklst = token_list_new();
-  token_list_add_pair(tklst, T_OPCODE, "mul");
-  token_list_add_pair(tklst, T_REGISTER, "r12");
-  token_list_add_pair(tklst, T_REGISTER, "r2");
-  token_list_add_pair(tklst, T_REGISTER, "r1");
+  tokenize_line("mul r12,r2,r1");
 
   instruction_t result;
   if (parse(prog, &result)){
     TEST_ASSERT_MESSAGE(false, "False Error");
   }
-  token_list_delete(tklst);
   compareInstructions(mul_i, result);
 }
 
@@ -165,19 +208,12 @@ void test_parse_mla(void){
                   .rm = 0x2
           }
   };
-  list_t *tklst = token_list_new();
-  token_list_add_pair(tklst, T_OPCODE, "mla");
-  token_list_add_pair(tklst, T_REGISTER, "r12");
-  token_list_add_pair(tklst, T_REGISTER, "r2");
-  token_list_add_pair(tklst, T_REGISTER, "r1");
-
-  token_list_add_pair(tklst, T_REGISTER, "r10");
+  tokenize_line("mla r12,r2,r1,r10");
 
   instruction_t result;
   if (parse(prog, &result)){
     TEST_ASSERT_MESSAGE(false, "False Error");
   }
-  token_list_delete(tklst);
   compareInstructions(mla_i, result);
 }
 
@@ -187,6 +223,7 @@ void test_parse_dp(void){
           .type = DP,
           .cond = 0xE,
           .i.dp = {
+                  .I = 1,
                   .opcode = MOV,
                   .rd = 1,
                   .operand2 = {
@@ -196,17 +233,12 @@ void test_parse_dp(void){
           }
   };
 
-  list_t *tklst = token_list_new();
-  token_list_add_pair(tklst, T_OPCODE, "mov");
-  token_list_add_pair(tklst, T_REGISTER, "r1");
-  token_list_add_pair(tklst, T_REGISTER, "#56");
-
+  tokenize_line("mov r1,#56");
 
   instruction_t result;
   if (parse(prog, &result)){
   TEST_ASSERT_MESSAGE(false, "False Error");
   }
-  token_list_delete(tklst);
   compareInstructions(mov_i, result);
 }
 
@@ -224,18 +256,73 @@ void test_parse_sdt_imm(void) {
           .L = 1,
           .rn = 15,
           .rd = 0,
-          .offset.imm.fixed = 0x555
+          .offset.imm.fixed = 0xFFF // patched once the pool is placed
       }
   };
-  list_t *tklst = token_list_new();
-  token_list_add_pair(tklst, T_OPCODE, "ldr");
-  token_list_add_pair(tklst, T_REGISTER, "r0");
-  token_list_add_pair(tklst, T_EQ_EXPR, "=0x555");
+  tokenize_line("ldr r0,=0x555");
 
   instruction_t result;
   if (parse(prog, &result)){
     TEST_ASSERT_MESSAGE(false, "False Error");
   }
-  token_list_delete(tklst);
   compareInstructions(sdt_i, result);
+  TEST_ASSERT_EQUAL(1, prog->numLiterals);
+  TEST_ASSERT_EQUAL(0x555, prog->literals[0].word);
+}
+
+void test_parse_sdt_imm_top_bit(void) {
+  // A value with its top bit set is too big for a mov, so it is pooled
+  tokenize_line("ldr r2,=0xFFFFFF00");
+
+  instruction_t result;
+  TEST_ASSERT_EQUAL(EC_OK, parse(prog, &result));
+  TEST_ASSERT_EQUAL(SDT, result.type);
+  TEST_ASSERT_EQUAL(1, prog->numLiterals);
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFF00, prog->literals[0].word);
+}
+
+// Assemble a line at the current address of the program
+static int assemble_line(const char *line) {
+  instruction_t instr;
+  word_t word;
+  tokenize_line(line);
+  int _status = parse(prog, &instr);
+  if (_status != EC_OK) {
+    return _status;
+  }
+  TEST_ASSERT_EQUAL(EC_OK, encode(&instr, &word));
+  set_word(prog->out, prog->mPC, word);
+  prog->mPC += 4;
+  return EC_OK;
+}
+
+void test_parse_forward_branches(void) {
+  byte_t out[16];
+  word_t word;
+  prog->out = out;
+
+  TEST_ASSERT_EQUAL(EC_OK, assemble_line("b end"));
+  TEST_ASSERT_EQUAL(EC_OK, assemble_line("beq end"));
+  TEST_ASSERT_EQUAL(EC_OK, assemble_line("b end"));
+
+  // The waiting branches are chained from the last one back to the first
+  const symbol_t *symbol = smap_intern(prog->smap, "end", 3);
+  TEST_ASSERT_FALSE(symbol->defined);
+  TEST_ASSERT_EQUAL(FIXUP_LINK(8), symbol->address);
+  get_word(out, 8, &word);
+  TEST_ASSERT_EQUAL(FIXUP_LINK(4), word & OFFSET_MASK);
+
+  TEST_ASSERT_EQUAL(EC_SKIP, assemble_line("end:"));
+  get_word(out, 0, &word);
+  TEST_ASSERT_EQUAL_HEX32(0xEA000001, word);
+  get_word(out, 4, &word);
+  TEST_ASSERT_EQUAL_HEX32(0x0A000000, word);
+  get_word(out, 8, &word);
+  TEST_ASSERT_EQUAL_HEX32(0xEAFFFFFF, word);
+
+  // A backward branch is resolved straight away
+  TEST_ASSERT_EQUAL(EC_OK, assemble_line("bne end"));
+  get_word(out, 12, &word);
+  TEST_ASSERT_EQUAL_HEX32(0x1AFFFFFE, word);
+  TEST_ASSERT_EQUAL(EC_IS_LABEL, assemble_line("end:"));
 }
@@ -0,0 +1,87 @@
+#include <stdlib.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+// mov r1, #1
+#define MOV_WORD 0xE3A01001
+// mov r2, #2
+#define MOV2_WORD 0xE3A02002
+
+void test_predecode_marks_code_page(void) {
+  emulate_state_t *state = emulate_state_new();
+  instruction_t instr;
+  set_word(state->memory, 0x4, MOV_WORD);
+
+  TEST_ASSERT_FALSE(is_code_page(state, 0x4));
+  TEST_ASSERT_EQUAL(EC_OK, predecode(state, 0x4, MOV_WORD, &instr));
+  TEST_ASSERT_EQUAL(DP, instr.type);
+  TEST_ASSERT_TRUE(is_code_page(state, 0x4));
+  TEST_ASSERT_TRUE(is_code_page(state, CODE_PAGE_SIZE - 1));
+  TEST_ASSERT_FALSE(is_code_page(state, CODE_PAGE_SIZE));
+  emulate_state_free(state);
+}
+
+void test_store_to_code_page_invalidates(void) {
+  emulate_state_t *state = emulate_state_new();
+  instruction_t instr;
+  set_word(state->memory, 0x4, MOV_WORD);
+  predecode(state, 0x4, MOV_WORD, &instr);
+
+  // A store to another page leaves the cache alone
+  set_mem_word(state, CODE_PAGE_SIZE * 2, 0x1);
+  TEST_ASSERT_TRUE(is_code_page(state, 0x4));
+  TEST_ASSERT_EQUAL(0, state->dcache.invalidations);
+
+  // Overwrite the instruction itself
+  set_mem_word(state, 0x4, MOV2_WORD);
+  TEST_ASSERT_FALSE(is_code_page(state, 0x4));
+  TEST_ASSERT_EQUAL(1, state->dcache.invalidations);
+
+  predecode(state, 0x4, MOV2_WORD, &instr);
+  TEST_ASSERT_EQUAL(2, instr.i.dp.rd);
+  emulate_state_free(state);
+}
+
+void test_stale_fetch_is_not_cached(void) {
+  emulate_state_t *state = emulate_state_new();
+  instruction_t instr;
+  set_word(state->memory, 0x8, MOV2_WORD);
+
+  // The pipeline still holds the word from before the store
+  predecode(state, 0x8, MOV_WORD, &instr);
+  TEST_ASSERT_EQUAL(1, instr.i.dp.rd);
+  TEST_ASSERT_FALSE(is_code_page(state, 0x8));
+
+  predecode(state, 0x8, MOV2_WORD, &instr);
+  TEST_ASSERT_EQUAL(2, instr.i.dp.rd);
+  emulate_state_free(state);
+}
+
+// cmp r2, #255
+#define CMP_WORD 0xE35200FF
+// bne -4 words
+#define BNE_WORD 0x1AFFFFFC
+
+void test_predecode_tags_fused_pairs(void) {
+  emulate_state_t *state = emulate_state_new();
+  instruction_t instr;
+  set_word(state->memory, 0x4, CMP_WORD);
+  set_word(state->memory, 0x8, BNE_WORD);
+  set_word(state->memory, CODE_PAGE_SIZE - 4, CMP_WORD);
+  set_word(state->memory, CODE_PAGE_SIZE, BNE_WORD);
+
+  predecode(state, 0x4, CMP_WORD, &instr);
+  TEST_ASSERT_EQUAL(FUSE_CMP_BRN, instr.fusion);
+  predecode(state, 0x8, BNE_WORD, &instr);
+  TEST_ASSERT_EQUAL(FUSE_NONE, instr.fusion);
+
+  // Pairs are not fused across a page
+  predecode(state, CODE_PAGE_SIZE - 4, CMP_WORD, &instr);
+  TEST_ASSERT_EQUAL(FUSE_NONE, instr.fusion);
+
+  // Replacing the second half drops the tagged first half
+  set_mem_word(state, 0x8, MOV_WORD);
+  predecode(state, 0x4, CMP_WORD, &instr);
+  TEST_ASSERT_EQUAL(FUSE_NONE, instr.fusion);
+  emulate_state_free(state);
+}
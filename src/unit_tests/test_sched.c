@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+#define NUM_TASKS 64
+#define NUM_WORDS 100
+
+// Counts r0 up to 10000
+static const word_t countProgram[] = {
+    0xE3A00000, // mov r0, #0
+    0xE59F100C, // ldr r1, [pc, #0xC]: 10000
+    0xE2800001, // add r0, r0, #1
+    0xE1500001, // cmp r0, r1
+    0x1AFFFFFC, // bne 0x8
+    0x00000000,
+    10000
+};
+
+// Writes each word it reads to SCHED_OUTPUT, up to a 0
+static const word_t echoProgram[] = {
+    0xE59F2010, // ldr r2, [pc, #0x10]: SCHED_INPUT
+    0xE5920000, // ldr r0, [r2]
+    0xE5820004, // str r0, [r2, #4]
+    0xE3500000, // cmp r0, #0
+    0x1AFFFFFB, // bne 0x4
+    0x00000000,
+    SCHED_INPUT
+};
+
+static word_t output[NUM_WORDS + 1];
+static int outputLen;
+
+static void collect(sched_task_t *task, word_t word) {
+  if (outputLen <= NUM_WORDS) {
+    output[outputLen++] = word;
+  }
+}
+
+static emulate_state_t *guest_new(const word_t *words, int n) {
+  emulate_state_t *state = emulate_state_new();
+  state->traces.enabled = true;
+  for (int i = 0; i < n; i++) {
+    set_word(state->memory, i << 2, words[i]);
+  }
+  return state;
+}
+
+void setUp(void) {
+  outputLen = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_sched_runs_every_task_to_its_halt(void) {
+  sched_t *sched = sched_new(4, 100, NULL);
+  TEST_ASSERT_NOT_NULL(sched);
+  emulate_state_t *guests[NUM_TASKS];
+  sched_task_t *tasks[NUM_TASKS];
+  for (int i = 0; i < NUM_TASKS; i++) {
+    guests[i] = guest_new(countProgram,
+                          sizeof(countProgram) / sizeof(word_t));
+    TEST_ASSERT_EQUAL(EC_OK, sched_spawn(sched, guests[i], NULL, &tasks[i]));
+  }
+  sched_wait(sched);
+
+  for (int i = 0; i < NUM_TASKS; i++) {
+    int status;
+    TEST_ASSERT_EQUAL(TASK_DONE, sched_task_state(tasks[i], &status));
+    TEST_ASSERT_EQUAL(EC_OK, status);
+    TEST_ASSERT_EQUAL(10000, guests[i]->registers.r[0]);
+  }
+  sched_free(sched);
+  for (int i = 0; i < NUM_TASKS; i++) {
+    TEST_ASSERT_NULL(guests[i]->task);
+    emulate_state_free(guests[i]);
+  }
+}
+
+void test_sched_parks_a_task_until_input_arrives(void) {
+  sched_t *sched = sched_new(2, 1000, collect);
+  emulate_state_t *guest = guest_new(echoProgram,
+                                     sizeof(echoProgram) / sizeof(word_t));
+  sched_task_t *task;
+  TEST_ASSERT_EQUAL(EC_OK, sched_spawn(sched, guest, NULL, &task));
+  sched_wait(sched);
+  int status;
+  TEST_ASSERT_EQUAL(TASK_BLOCKED, sched_task_state(task, &status));
+
+  // Enough words for the loop to run as a trace, sent as they fit
+  for (word_t word = 1; word <= NUM_WORDS + 1; word++) {
+    word_t sent = word <= NUM_WORDS ? word : 0;
+    int _status;
+    while ((_status = sched_send(task, sent)) == EC_BLOCKED) {
+      sched_wait(sched);
+    }
+    TEST_ASSERT_EQUAL(EC_OK, _status);
+  }
+  sched_wait(sched);
+
+  TEST_ASSERT_EQUAL(TASK_DONE, sched_task_state(task, &status));
+  TEST_ASSERT_EQUAL(EC_OK, status);
+  TEST_ASSERT_EQUAL(NUM_WORDS + 1, outputLen);
+  for (int i = 0; i < NUM_WORDS; i++) {
+    TEST_ASSERT_EQUAL(i + 1, output[i]);
+  }
+  TEST_ASSERT_EQUAL(0, output[NUM_WORDS]);
+  TEST_ASSERT_TRUE(guest->stats.traceEntries > 0);
+  TEST_ASSERT_EQUAL(EC_INVALID_PARAM, sched_send(task, 1));
+  sched_free(sched);
+  emulate_state_free(guest);
+}
+
+void test_sched_rejects_bad_parameters(void) {
+  TEST_ASSERT_NULL(sched_new(0, 100, NULL));
+  TEST_ASSERT_NULL(sched_new(SCHED_MAX_THREADS + 1, 100, NULL));
+  TEST_ASSERT_NULL(sched_new(1, 0, NULL));
+}
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+// mov r1, #1
+#define MOV_WORD 0xE3A01001
+// b 0x0
+#define LOOP_WORD 0xEAFFFFFE
+
+static emulate_state_t *state;
+static byte_t *image;
+
+void setUp(void) {
+  state = emulate_state_new();
+  image = malloc(MEM_SIZE);
+}
+
+void tearDown(void) {
+  emulate_state_free(state);
+  free(image);
+}
+
+/**
+ *  Send requests to server_job, with a binary of some words after each,
+ *  and collect the replies
+ */
+static int serve_words(const char *request, const word_t *words, int count,
+                       int jobs, char *reply, size_t size) {
+  FILE *in = tmpfile();
+  FILE *out = tmpfile();
+  for (int i = 0; i < jobs; i++) {
+    fputs(request, in);
+    for (int j = 0; j < count; j++) {
+      byte_t binary[4];
+      set_word(binary, 0x0, words[j]);
+      fwrite(binary, 1, sizeof(binary), in);
+    }
+  }
+  rewind(in);
+
+  fflush(stdout);
+  int stdoutFd = dup(STDOUT_FILENO);
+  dup2(fileno(out), STDOUT_FILENO);
+  int _status = EC_OK;
+  for (int i = 0; i < jobs && _status == EC_OK; i++) {
+    _status = server_job(state, in, image);
+  }
+  if (_status == EC_OK) {
+    _status = server_job(state, in, image);
+  }
+  fflush(stdout);
+  dup2(stdoutFd, STDOUT_FILENO);
+  close(stdoutFd);
+
+  rewind(out);
+  size_t n = fread(reply, 1, size - 1, out);
+  reply[n] = '\0';
+  fclose(in);
+  fclose(out);
+  return _status;
+}
+
+/**
+ *  Send requests to server_job, with a binary of one word after each
+ */
+static int serve(const char *request, word_t word, int jobs, char *reply,
+                 size_t size) {
+  return serve_words(request, &word, 1, jobs, reply, size);
+}
+
+void test_server_job_prints_the_state(void) {
+  char reply[4096];
+  TEST_ASSERT_EQUAL(EC_SKIP, serve("bin 4\n", MOV_WORD, 1, reply,
+                                   sizeof(reply)));
+  TEST_ASSERT_NOT_NULL(strstr(reply, "$1  :          1 (0x00000001)\n"));
+  TEST_ASSERT_NOT_NULL(strstr(reply, "0x00000000: 0x0110a0e3\n"));
+  TEST_ASSERT_EQUAL_STRING("status 0\n", reply + strlen(reply) - 9);
+}
+
+void test_server_job_stops_at_the_budget(void) {
+  char reply[4096];
+  TEST_ASSERT_EQUAL(EC_SKIP, serve("bin 4 steps 1000\n", LOOP_WORD, 1,
+                                   reply, sizeof(reply)));
+  char expected[32];
+  sprintf(expected, "status %d\n", EC_BUDGET);
+  TEST_ASSERT_EQUAL_STRING(expected, reply);
+  TEST_ASSERT_TRUE(state->stats.traceIterations > 0);
+  TEST_ASSERT_TRUE(state->steps >= 1000);
+}
+
+void test_server_job_splits_a_fused_pair_at_the_budget(void) {
+  // mov r0, #2; sub r0, r0, #1; cmp r0, #0; bne 0x4
+  word_t words[] = {0xE3A00002, 0xE2400001, 0xE3500000, 0x1AFFFFFC};
+  char reply[4096];
+  TEST_ASSERT_EQUAL(EC_SKIP, serve_words("bin 16 steps 3\n", words, 4, 1,
+                                         reply, sizeof(reply)));
+  char expected[32];
+  sprintf(expected, "status %d\n", EC_BUDGET);
+  TEST_ASSERT_EQUAL_STRING(expected, reply);
+  TEST_ASSERT_EQUAL(3, state->steps);
+  TEST_ASSERT_EQUAL(1, state->registers.r[0]);
+  TEST_ASSERT_EQUAL_HEX32(0xC, state->pipeline.decoded_addr);
+}
+
+void test_server_job_keeps_decodes_of_the_same_binary(void) {
+  char reply[8192];
+  TEST_ASSERT_EQUAL(EC_SKIP, serve("bin 4\n", MOV_WORD, 2, reply,
+                                   sizeof(reply)));
+  TEST_ASSERT_EQUAL(0, state->dcache.invalidations);
+  TEST_ASSERT_TRUE(is_code_page(state, 0x0));
+  TEST_ASSERT_EQUAL(1, state->registers.r[1]);
+}
+
+void test_server_job_starts_the_counters_again(void) {
+  char reply[8192];
+  TEST_ASSERT_EQUAL(EC_SKIP, serve("bin 4\n", MOV_WORD, 1, reply,
+                                   sizeof(reply)));
+  uint64_t steps = state->steps;
+  uint64_t cycles = state->cycles;
+  uint64_t effects = state->effects;
+  TEST_ASSERT_TRUE(cycles > 0);
+
+  // As if the last job reset its counters part of the way through
+  state->perf.steps = steps;
+  state->perf.cycles = cycles;
+  TEST_ASSERT_EQUAL(EC_SKIP, serve("bin 4\n", MOV_WORD, 2, reply,
+                                   sizeof(reply)));
+  TEST_ASSERT_EQUAL(steps, state->steps);
+  TEST_ASSERT_EQUAL(cycles, state->cycles);
+  TEST_ASSERT_EQUAL(effects, state->effects);
+  TEST_ASSERT_EQUAL(0, state->perf.steps);
+  TEST_ASSERT_EQUAL(0, state->perf.cycles);
+}
+
+void test_server_job_rejects_unknown_requests(void) {
+  char reply[4096];
+  TEST_ASSERT_EQUAL(EC_INVALID_PARAM, serve("load 4\n", MOV_WORD, 1, reply,
+                                            sizeof(reply)));
+  char expected[32];
+  sprintf(expected, "status %d\n", EC_INVALID_PARAM);
+  TEST_ASSERT_EQUAL_STRING(expected, reply);
+}
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+#define COUNTER_ADDR 0x80
+#define ITERATIONS 1000
+
+// Each core adds one to the counter ITERATIONS times, holding the lock
+static const word_t lockProgram[] = {
+    0xE59F1038, // ldr r1, [pc, #0x38]: SMP_LOCK
+    0xE3A02FFA, // mov r2, #1000
+    0xE3A04080, // mov r4, #0x80
+    0xE5910000, // ldr r0, [r1]: take the lock
+    0xE3500000, // cmp r0, #0
+    0x1AFFFFFC, // bne 0xC
+    0xE5943000, // ldr r3, [r4]
+    0xE2833001, // add r3, r3, #1
+    0xE5843000, // str r3, [r4]
+    0xE3A00000, // mov r0, #0
+    0xE5810000, // str r0, [r1]: release it
+    0xE2522001, // subs r2, r2, #1
+    0x1AFFFFF5, // bne 0xC
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    SMP_LOCK
+};
+
+// Core 0 leaves 42 in the mailbox of core 1, which waits for it
+static const word_t mailboxProgram[] = {
+    0xE59F1038, // ldr r1, [pc, #0x38]: SMP_CORE_ID
+    0xE5910000, // ldr r0, [r1]
+    0xE59F2034, // ldr r2, [pc, #0x34]: mailbox of core 1
+    0xE3500000, // cmp r0, #0
+    0x1A000002, // bne 0x20
+    0xE3A0302A, // mov r3, #42
+    0xE5823000, // str r3, [r2]
+    0x00000000,
+    0xE5923000, // ldr r3, [r2]
+    0xE3530000, // cmp r3, #0
+    0x0AFFFFFC, // beq 0x20
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    SMP_CORE_ID,
+    SMP_MAILBOX + 4
+};
+
+static void load(emulate_state_t *state, const word_t *words, int n) {
+  for (int i = 0; i < n; i++) {
+    set_word(state->memory, i << 2, words[i]);
+  }
+}
+
+void test_smp_lock_makes_increments_atomic(void) {
+  emulate_state_t *cores[4];
+  for (int i = 0; i < 4; i++) {
+    cores[i] = emulate_state_new();
+  }
+  load(cores[0], lockProgram, sizeof(lockProgram) / sizeof(word_t));
+  TEST_ASSERT_EQUAL(EC_OK, smp_run(cores, 4));
+
+  word_t counter;
+  get_word(cores[0]->memory, COUNTER_ADDR, &counter);
+  TEST_ASSERT_EQUAL(4 * ITERATIONS, counter);
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL(HAL, cores[i]->pipeline.decoded->type);
+    TEST_ASSERT_EQUAL(0, cores[i]->registers.r[2]);
+    TEST_ASSERT_NULL(cores[i]->smp);
+    emulate_state_free(cores[i]);
+  }
+}
+
+void test_smp_mailbox_passes_a_word(void) {
+  emulate_state_t *cores[] = {emulate_state_new(), emulate_state_new()};
+  load(cores[0], mailboxProgram, sizeof(mailboxProgram) / sizeof(word_t));
+  TEST_ASSERT_EQUAL(EC_OK, smp_run(cores, 2));
+
+  TEST_ASSERT_EQUAL(0, cores[0]->registers.r[0]);
+  TEST_ASSERT_EQUAL_HEX32(0x1C, cores[0]->pipeline.decoded_addr);
+  TEST_ASSERT_EQUAL(1, cores[1]->registers.r[0]);
+  TEST_ASSERT_EQUAL(42, cores[1]->registers.r[3]);
+  TEST_ASSERT_EQUAL_HEX32(0x2C, cores[1]->pipeline.decoded_addr);
+  emulate_state_free(cores[0]);
+  emulate_state_free(cores[1]);
+}
+
+void test_smp_rejects_too_many_cores(void) {
+  emulate_state_t *cores[MAX_CORES + 1];
+  TEST_ASSERT_EQUAL(EC_INVALID_PARAM, smp_run(cores, MAX_CORES + 1));
+}
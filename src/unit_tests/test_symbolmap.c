@@ -1,34 +1,124 @@
+#include <stdio.h>
 #include "../../unity/src/unity.h"
 #include "../assemble/symbolmap.h"
+#include "../utils/error.h"
+
+#define NUM_LABELS 100000
 
 /**
-* A map function for printing a symbol
+* A map function for counting the symbols and summing their addresses
 */
-void print_symbol(const label_t label, const address_t val, const void *obj){
-  printf("(%s, %d) \n", label, val);
+void sum_symbol(const label_t label, const address_t val, const void *obj) {
+  address_t *sums = (address_t *) obj;
+  sums[0]++;
+  sums[1] += val;
 }
 
 void test_symbolmap(void) {
-  symbol_map_t *sm;
-  address_t buf;
-  int result;
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  symbol_map_t *sm = smap_new(arena, 10);
+  TEST_ASSERT_NOT_NULL(sm);
+  TEST_ASSERT_EQUAL(16, sm->capacity);
+
+  TEST_ASSERT_EQUAL(EC_OK, smap_put(sm, "application name", 16, 1));
+  TEST_ASSERT_EQUAL(EC_OK, smap_put(sm, "application version", 19, 2));
+  TEST_ASSERT_EQUAL(2, smap_get_count(sm));
+
+  address_t buf = 0;
+  TEST_ASSERT_EQUAL(EC_OK, smap_get_address(sm, "application name", 16,
+                                            &buf));
+  TEST_ASSERT_EQUAL(1, buf);
+  TEST_ASSERT_EQUAL(EC_NULL_POINTER, smap_get_address(sm, "application", 11,
+                                                      &buf));
+
+  // A label that is already there keeps its address
+  TEST_ASSERT_EQUAL(EC_IS_LABEL, smap_put(sm, "application version", 19, 7));
+  TEST_ASSERT_EQUAL(EC_OK, smap_get_address(sm, "application version", 19,
+                                            &buf));
+  TEST_ASSERT_EQUAL(2, buf);
+
+  address_t sums[2] = {0, 0};
+  TEST_ASSERT_EQUAL(EC_OK, smap_enum(sm, &sum_symbol, sums));
+  TEST_ASSERT_EQUAL(2, sums[0]);
+  TEST_ASSERT_EQUAL(3, sums[1]);
+  arena_delete(arena);
+}
+
+void test_symbolmap_takes_slices(void) {
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  symbol_map_t *sm = smap_new(arena, INITIAL_S_MAP_CAPACITY);
+  const char *line = "loop: b loopend";
+
+  TEST_ASSERT_EQUAL(EC_OK, smap_put(sm, line, 4, 8));
+  TEST_ASSERT_TRUE(smap_exists(sm, "loop", 4));
+  TEST_ASSERT_FALSE(smap_exists(sm, line + 8, 7));
+
+  // The label is copied, so does not point into the line
+  const symbol_t *symbol = smap_find(sm, line + 8, 4);
+  TEST_ASSERT_NOT_NULL(symbol);
+  TEST_ASSERT_EQUAL_STRING("loop", symbol->label);
+  TEST_ASSERT_TRUE(symbol->label != line);
+  TEST_ASSERT_EQUAL(8, symbol->address);
+  arena_delete(arena);
+}
 
-  sm = smap_new(10);
-  if (sm == NULL) {
-      /* Handle allocation failure... */
+void test_symbolmap_grows(void) {
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  symbol_map_t *sm = smap_new(arena, 1);
+  char label[16];
+
+  for (int i = 0; i < NUM_LABELS; i++) {
+    int len = sprintf(label, "label%d", i);
+    TEST_ASSERT_EQUAL(EC_OK, smap_put(sm, label, len, i << 2));
   }
-  /* Insert a couple of string associations */
-  smap_put(sm, "application name", 1);
-  smap_put(sm, "application version", 2);
-
-  smap_enum(sm, &print_symbol, NULL);
-  /* Retrieve a address */
-  result = smap_get_address(sm, "application name", &buf);
-  if (result == 0) {
-      printf("KEY: %s Not found\n", "application name");
+  TEST_ASSERT_EQUAL(NUM_LABELS, smap_get_count(sm));
+  TEST_ASSERT_TRUE(sm->count * 100 <= sm->capacity * S_MAP_MAX_LOAD);
+
+  for (int i = 0; i < NUM_LABELS; i++) {
+    int len = sprintf(label, "label%d", i);
+    address_t addr = 0;
+    TEST_ASSERT_EQUAL(EC_OK, smap_get_address(sm, label, len, &addr));
+    TEST_ASSERT_EQUAL(i << 2, addr);
   }
-  printf("KEY: %s, Value: %d\n", "application name", buf);
+  TEST_ASSERT_FALSE(smap_exists(sm, "label", 5));
+  arena_delete(arena);
+}
+
+void test_symbolmap_keeps_undefined_labels_apart(void) {
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  symbol_map_t *sm = smap_new(arena, INITIAL_S_MAP_CAPACITY);
+
+  symbol_t *symbol = smap_intern(sm, "later", 5);
+  TEST_ASSERT_NOT_NULL(symbol);
+  TEST_ASSERT_FALSE(symbol->defined);
+  symbol->address = 12;
+  TEST_ASSERT_TRUE(smap_intern(sm, "later", 5) == symbol);
+  TEST_ASSERT_FALSE(smap_exists(sm, "later", 5));
+  TEST_ASSERT_EQUAL(0, smap_get_count(sm));
 
-  /* When done, destroy the map object */
-  smap_delete(sm);
+  address_t sums[2] = {0, 0};
+  smap_enum_undefined(sm, &sum_symbol, sums);
+  TEST_ASSERT_EQUAL(1, sums[0]);
+  TEST_ASSERT_EQUAL(12, sums[1]);
+
+  TEST_ASSERT_EQUAL(EC_OK, smap_put(sm, "later", 5, 4));
+  TEST_ASSERT_TRUE(smap_exists(sm, "later", 5));
+  TEST_ASSERT_EQUAL(1, smap_get_count(sm));
+  arena_delete(arena);
+}
+
+void test_symbolmap_reserves_room(void) {
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  symbol_map_t *sm = smap_new(arena, 1);
+  char label[16];
+
+  TEST_ASSERT_EQUAL(EC_OK, smap_reserve(sm, 1000));
+  size_t capacity = sm->capacity;
+  TEST_ASSERT_TRUE(1000 * 100 <= capacity * S_MAP_MAX_LOAD);
+  for (int i = 0; i < 1000; i++) {
+    int len = sprintf(label, "label%d", i);
+    TEST_ASSERT_EQUAL(EC_OK, smap_put(sm, label, len, i));
+  }
+  TEST_ASSERT_EQUAL(capacity, sm->capacity);
+  arena_delete(arena);
 }
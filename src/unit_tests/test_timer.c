@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+#define WAIT 100000
+
+// Sets compare register 1 to WAIT after now, waits for its match, then
+// clears it and reads the match bits into r3
+static const word_t waitProgram[] = {
+    0xE59F0024, // ldr r0, [pc, #0x24]: TIMER_BASE
+    0xE5901004, // ldr r1, [r0, #4]
+    0xE59F2020, // ldr r2, [pc, #0x20]: WAIT
+    0xE0811002, // add r1, r1, r2
+    0xE5801010, // str r1, [r0, #0x10]
+    0xE5902000, // ldr r2, [r0]
+    0xE3120002, // tst r2, #2
+    0x0AFFFFFC, // beq 0x14
+    0xE5802000, // str r2, [r0]
+    0xE5903000, // ldr r3, [r0]
+    0x00000000,
+    TIMER_BASE,
+    WAIT
+};
+
+static emulate_state_t *state;
+
+void setUp(void) {
+  state = emulate_state_new();
+}
+
+void tearDown(void) {
+  emulate_state_free(state);
+}
+
+static word_t load(word_t addr) {
+  word_t word;
+  TEST_ASSERT_EQUAL(EC_OK, get_mem_word(state, addr, &word));
+  return word;
+}
+
+void test_timer_matches_once_the_time_reaches_a_compare(void) {
+  state->timer = timer_new(false);
+  state->cycles = 0x1FFFFFFF0;
+  TEST_ASSERT_EQUAL_HEX32(0xFFFFFFF0, load(TIMER_CLO));
+  TEST_ASSERT_EQUAL_HEX32(0x1, load(TIMER_CHI));
+
+  // Compare values behind the low word match after it wraps
+  set_mem_word(state, TIMER_C0 + 4, 0x10);
+  set_mem_word(state, TIMER_C0 + 12, 0xFFFFFFF8);
+  TEST_ASSERT_EQUAL_HEX32(0x10, load(TIMER_C0 + 4));
+  state->cycles = 0x1FFFFFFF7;
+  TEST_ASSERT_EQUAL_HEX32(0x0, load(TIMER_CS));
+  state->cycles = 0x1FFFFFFF8;
+  TEST_ASSERT_EQUAL_HEX32(0x8, load(TIMER_CS));
+  state->cycles = 0x200000010;
+  TEST_ASSERT_EQUAL_HEX32(0xA, load(TIMER_CS));
+
+  set_mem_word(state, TIMER_CS, 0x8);
+  TEST_ASSERT_EQUAL_HEX32(0x2, load(TIMER_CS));
+  // Until the low word comes round again
+  state->cycles = 0x300000010;
+  set_mem_word(state, TIMER_CS, 0xF);
+  TEST_ASSERT_EQUAL_HEX32(0x0, load(TIMER_CS));
+  state->cycles = 0x3FFFFFFF8;
+  TEST_ASSERT_EQUAL_HEX32(0x8, load(TIMER_CS));
+}
+
+void test_timer_matches_after_wraps_without_an_access(void) {
+  state->timer = timer_new(false);
+  set_mem_word(state, TIMER_C0, 0x10);
+
+  // Several wraps go by before the guest looks at the timer again
+  state->cycles = 0x500000020;
+  TEST_ASSERT_EQUAL_HEX32(0x1, load(TIMER_CS));
+  set_mem_word(state, TIMER_CS, 0x1);
+  state->cycles = 0x60000000F;
+  TEST_ASSERT_EQUAL_HEX32(0x0, load(TIMER_CS));
+  state->cycles = 0x600000010;
+  TEST_ASSERT_EQUAL_HEX32(0x1, load(TIMER_CS));
+}
+
+void test_timer_counts_instructions_when_asked(void) {
+  state->timer = timer_new(true);
+  state->steps = 1000;
+  state->cycles = 5000;
+  TEST_ASSERT_EQUAL(1000, load(TIMER_CLO));
+  set_mem_word(state, TIMER_C0, 1500);
+  state->cycles = 10000;
+  TEST_ASSERT_EQUAL_HEX32(0x0, load(TIMER_CS));
+  state->steps = 1500;
+  TEST_ASSERT_EQUAL_HEX32(0x1, load(TIMER_CS));
+}
+
+void test_timer_is_unmapped_without_one(void) {
+  word_t word;
+  TEST_ASSERT_EQUAL(EC_INVALID_PARAM, get_mem_word(state, TIMER_CLO, &word));
+}
+
+/**
+ *  Run the wait program to its halt
+ */
+static void run_wait(bool trace) {
+  state->timer = timer_new(false);
+  state->traces.enabled = trace;
+  for (int i = 0; i < sizeof(waitProgram) / sizeof(word_t); i++) {
+    set_word(state->memory, i << 2, waitProgram[i]);
+  }
+  TEST_ASSERT_EQUAL(EC_OK, pipeline_refill(state, 0x0));
+  TEST_ASSERT_EQUAL(EC_OK, execute_program(state));
+}
+
+void test_timer_wait_is_skipped_in_a_trace(void) {
+  run_wait(false);
+  uint64_t steps = state->steps;
+  uint64_t cycles = state->cycles;
+  TEST_ASSERT_TRUE(cycles >= WAIT);
+  TEST_ASSERT_EQUAL(0, state->registers.r[3]);
+  tearDown();
+  setUp();
+
+  run_wait(true);
+  TEST_ASSERT_EQUAL(steps, state->steps);
+  TEST_ASSERT_EQUAL(cycles, state->cycles);
+  TEST_ASSERT_EQUAL(0, state->registers.r[3]);
+  TEST_ASSERT_TRUE(state->stats.idleIterations > 0);
+  TEST_ASSERT_TRUE(state->stats.traceIterations < 100);
+}
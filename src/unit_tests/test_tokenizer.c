@@ -2,38 +2,101 @@
 #include <string.h>
 #include "../../unity/src/unity.h"
 #include "../assemble/tokenizer.h"
+#include "../utils/arm.h"
+#include "../utils/error.h"
 
-void string_separate_runner(char *str, char sep, char *tokens,
-                            int expected_size, char **expected){
-  char **token_strs = NULL;
-  int n = str_separate(str, tokens, sep, &token_strs);
-  for (int i = 0; i < n; i++) {
-    printf("%s\n", token_strs[i]);
-  }
-  TEST_ASSERT_EQUAL_MESSAGE(expected_size, n, "Size of tokens differs");
-  for (int i = 0; i < n; i++) {
-    if(strcmp(token_strs[i], expected[i])){
+void tokenize_runner(char *str, int expected_size, char **expected){
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  token_list_t *tklst = NULL;
+  int _status = tokenize(str, str + strlen(str), arena, &tklst);
+  TEST_ASSERT_EQUAL(EC_OK, _status);
+  token_list_print(tklst);
+  TEST_ASSERT_EQUAL_MESSAGE(expected_size, tklst->len, "Size of tokens differs");
+  for (int i = 0; i < tklst->len; i++) {
+    if (!token_equals(token_list_get(tklst, i), expected[i])) {
       TEST_FAIL_MESSAGE("Token != Expected");
     }
   }
-  free(token_strs);
+  arena_delete(arena);
 }
 
-void test_string_separate(void){
+void test_tokenize_separators(void){
   char *short_expected[] = {"a", "b"};
-  string_separate_runner("a  b", ' ', ",", 2, short_expected);
+  tokenize_runner("a  b", 2, short_expected);
+
+  char *str_expected[] = {"str", "r3", ",", "[", "r2", ",", "#3", "]"};
+  tokenize_runner("str r3,[r2,#3]", 8, str_expected);
+//                 01234567890123456789012
+  tokenize_runner("str  r3,[r2,#3]", 8, str_expected);
+  tokenize_runner("str r3 ,[r2,#3]", 8, str_expected);
+  tokenize_runner("str r3, [r2,#3]", 8, str_expected);
+  tokenize_runner("str r3,[ r2,#3]", 8, str_expected);
+  tokenize_runner("str r3,[r2 ,#3]", 8, str_expected);
+  tokenize_runner("str r3,[r2, #3]", 8, str_expected);
+  tokenize_runner("\tstr r3,[r2,#3] \r", 8, str_expected);
+
+  char *mov_expected[] = {"mov", "r2", ",", "#23"};
+  tokenize_runner("mov r2, #23", 4, mov_expected);
 
-  char *str_expected[] = {"str", "r3", ",", "[", "r2", ",", "#", "3", "]"};
-  string_separate_runner("str r3,[r2,#3]", ' ', "[],#", 9, str_expected);
-//                        01234567890123456789012
-  string_separate_runner("str  r3,[r2,#3]", ' ', "[],#", 9, str_expected);
-  string_separate_runner("str r3 ,[r2,#3]", ' ', "[],#", 9, str_expected);
-  string_separate_runner("str r3, [r2,#3]", ' ', "[],#", 9, str_expected);
-  string_separate_runner("str r3,[ r2,#3]", ' ', "[],#", 9, str_expected);
-  string_separate_runner("str r3,[r2 ,#3]", ' ', "[],#", 9, str_expected);
-  string_separate_runner("str r3,[r2, #3]", ' ', "[],#", 9, str_expected);
+  char *label_expected[] = {"loop", ":"};
+  tokenize_runner("loop:", 2, label_expected);
+}
+
+void test_tokenize_parses_values(void){
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  token_list_t *tklst = NULL;
+  char line[] = "ldr r10,[r1,-r2,lsr #0x1F]";
+  token_type_t types[] = {T_OPCODE, T_REGISTER, T_COMMA, T_L_BRACKET,
+                          T_REGISTER, T_COMMA, T_MINUS, T_REGISTER, T_COMMA,
+                          T_SHIFT, T_HASH_EXPR, T_R_BRACKET};
+  TEST_ASSERT_EQUAL(EC_OK, tokenize(line, line + strlen(line), arena, &tklst));
+  TEST_ASSERT_EQUAL(12, tklst->len);
+  for (int i = 0; i < tklst->len; i++) {
+    TEST_ASSERT_EQUAL(types[i], token_list_get_type(tklst, i));
+  }
+  TEST_ASSERT_EQUAL(10, token_list_get_value(tklst, 1));
+  TEST_ASSERT_EQUAL(2, token_list_get_value(tklst, 7));
+  TEST_ASSERT_EQUAL(LSR, token_list_get_value(tklst, 9));
+  TEST_ASSERT_EQUAL(0x1F, token_list_get_value(tklst, 10));
+
+  // Tokens are slices of the line
+  TEST_ASSERT_EQUAL_PTR(line + 4, token_list_get(tklst, 1)->str);
+
+  char exprs[] = "ldr r0,=-4 ror r16";
+  TEST_ASSERT_EQUAL(EC_OK, tokenize(exprs, exprs + strlen(exprs), arena,
+                                    &tklst));
+  TEST_ASSERT_EQUAL(T_EQ_EXPR, token_list_get_type(tklst, 3));
+  TEST_ASSERT_EQUAL(-4, token_list_get_value(tklst, 3));
+  TEST_ASSERT_EQUAL(T_SHIFT, token_list_get_type(tklst, 4));
+  TEST_ASSERT_EQUAL(T_STR, token_list_get_type(tklst, 5));
+  TEST_ASSERT_EQUAL_STRING("r16", token_list_dup_str(tklst, 5));
+  arena_delete(arena);
+}
+
+void test_tokenize_skips_blank_lines(void){
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  token_list_t *tklst = NULL;
+  char line[] = " \t\r";
+  TEST_ASSERT_EQUAL(EC_SKIP, tokenize(line, line + strlen(line), arena, &tklst));
+  TEST_ASSERT_EQUAL(EC_SKIP, tokenize(line, line, arena, &tklst));
+  arena_delete(arena);
+}
 
+void test_tokenize_reuses_the_arena(void){
+  arena_t *arena = arena_new(ARENA_BLOCK_SIZE);
+  token_list_t *tklst = NULL;
+  char line[] = "ldr r0,[r1,#4]";
+  TEST_ASSERT_EQUAL(EC_OK, tokenize(line, line + strlen(line), arena, &tklst));
+  TEST_ASSERT_EQUAL(8, tklst->len);
 
-  char *mov_expected[] = {"mov", "r2", ",", "#", "23"};
-  string_separate_runner("mov r2, #23", ' ', ",#[]", 5, mov_expected);
+  // A line after a reset takes its tokens from the same block
+  arena_block_t *block = arena->current;
+  arena_reset(arena);
+  char next[] = "mov r2,#1";
+  TEST_ASSERT_EQUAL(EC_OK, tokenize(next, next + strlen(next), arena, &tklst));
+  TEST_ASSERT_EQUAL(4, tklst->len);
+  TEST_ASSERT_EQUAL(2, token_list_get_value(tklst, 1));
+  TEST_ASSERT_EQUAL_PTR(block, arena->current);
+  TEST_ASSERT_NULL(arena->first->next);
+  arena_delete(arena);
 }
@@ -0,0 +1,68 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../unity/src/unity.h"
+#include "../emulate.h"
+
+static emulate_state_t *state;
+static char outPath[] = "/tmp/test_uart_out_XXXXXX";
+static char inPath[] = "/tmp/test_uart_in_XXXXXX";
+
+void setUp(void) {
+  state = emulate_state_new();
+}
+
+void tearDown(void) {
+  emulate_state_free(state);
+}
+
+/**
+ *  Read a whole file into a string
+ */
+static void read_text(const char *path, char *text, size_t size) {
+  FILE *file = fopen(path, "r");
+  TEST_ASSERT_NOT_NULL(file);
+  text[fread(text, 1, size - 1, file)] = '\0';
+  fclose(file);
+}
+
+void test_uart_buffers_output_until_flushed(void) {
+  close(mkstemp(outPath));
+  TEST_ASSERT_EQUAL(EC_OK, uart_new(outPath, NULL, &state->uart));
+  const char *message = "Hello\n";
+  for (const char *c = message; *c != '\0'; c++) {
+    uart_store(state, UART_DR, 0xFFFFFF00 | *c);
+  }
+  char text[64];
+  read_text(outPath, text, sizeof(text));
+  TEST_ASSERT_EQUAL_STRING("", text);
+
+  uart_flush(state->uart);
+  fflush(state->uart->out);
+  read_text(outPath, text, sizeof(text));
+  TEST_ASSERT_EQUAL_STRING(message, text);
+  TEST_ASSERT_EQUAL(EC_OK, uart_free(state->uart));
+  state->uart = NULL;
+  unlink(outPath);
+}
+
+void test_uart_reads_input_until_it_runs_out(void) {
+  int fd = mkstemp(inPath);
+  TEST_ASSERT_EQUAL(2, write(fd, "ok", 2));
+  close(fd);
+  TEST_ASSERT_EQUAL(EC_OK, uart_new(NULL, inPath, &state->uart));
+  TEST_ASSERT_EQUAL_HEX32(UART_FR_TXFE, uart_load(state, UART_FR));
+  TEST_ASSERT_EQUAL('o', uart_load(state, UART_DR));
+  TEST_ASSERT_EQUAL('k', uart_load(state, UART_DR));
+  TEST_ASSERT_EQUAL_HEX32(UART_FR_TXFE | UART_FR_RXFE,
+                          uart_load(state, UART_FR));
+  TEST_ASSERT_EQUAL(0, uart_load(state, UART_DR));
+  TEST_ASSERT_EQUAL(3, state->effects);
+  unlink(inPath);
+}
+
+void test_uart_reports_a_file_it_cannot_open(void) {
+  TEST_ASSERT_TRUE(EC_IS_SYS_ERROR(uart_new(NULL, "/nonexistent/input",
+                                            &state->uart)));
+  TEST_ASSERT_NULL(state->uart);
+}
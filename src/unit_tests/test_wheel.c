@@ -0,0 +1,66 @@
+#include <stdlib.h>
+#include "../../unity/src/unity.h"
+#include "../emulate/wheel.h"
+
+static wheel_t wheel;
+static wheel_event_t events[3];
+static int fired[3];
+
+static void count(wheel_t *w, wheel_event_t *event) {
+  fired[event - events]++;
+}
+
+static void repeat(wheel_t *w, wheel_event_t *event) {
+  fired[event - events]++;
+  wheel_schedule(w, event, event->when + 10);
+}
+
+void setUp(void) {
+  wheel_init(&wheel);
+  for (int i = 0; i < 3; i++) {
+    events[i].fire = count;
+    events[i].pending = false;
+    fired[i] = 0;
+  }
+}
+
+void tearDown(void) {
+}
+
+void test_wheel_fires_events_once_due(void) {
+  // The same slot in different turns of the wheel
+  wheel_schedule(&wheel, &events[0], 5);
+  wheel_schedule(&wheel, &events[1], 5 + WHEEL_SLOTS);
+  wheel_schedule(&wheel, &events[2], 70000);
+  TEST_ASSERT_EQUAL(5, wheel.next);
+
+  TEST_ASSERT_EQUAL(0, wheel_advance(&wheel, 4));
+  TEST_ASSERT_EQUAL(1, wheel_advance(&wheel, 5));
+  TEST_ASSERT_EQUAL(1, fired[0]);
+  TEST_ASSERT_EQUAL(5 + WHEEL_SLOTS, wheel.next);
+  TEST_ASSERT_EQUAL(2, wheel_advance(&wheel, 100000));
+  TEST_ASSERT_EQUAL(1, fired[1]);
+  TEST_ASSERT_EQUAL(1, fired[2]);
+  TEST_ASSERT_EQUAL(WHEEL_NEVER, wheel.next);
+}
+
+void test_wheel_cancels_events(void) {
+  wheel_schedule(&wheel, &events[0], 20);
+  wheel_schedule(&wheel, &events[1], 30);
+  wheel_cancel(&wheel, &events[0]);
+  TEST_ASSERT_EQUAL(30, wheel.next);
+  wheel_cancel(&wheel, &events[0]);
+  TEST_ASSERT_EQUAL(1, wheel_advance(&wheel, 1000));
+  TEST_ASSERT_EQUAL(0, fired[0]);
+  TEST_ASSERT_EQUAL(1, fired[1]);
+}
+
+void test_wheel_fires_an_event_scheduled_again_on_its_next_pass(void) {
+  events[0].fire = repeat;
+  wheel_schedule(&wheel, &events[0], 10);
+  TEST_ASSERT_EQUAL(1, wheel_advance(&wheel, 15));
+  TEST_ASSERT_EQUAL(20, wheel.next);
+  TEST_ASSERT_EQUAL(1, wheel_advance(&wheel, 20));
+  TEST_ASSERT_EQUAL(2, fired[0]);
+  TEST_ASSERT_TRUE(events[0].pending);
+}
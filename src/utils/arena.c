@@ -0,0 +1,156 @@
+/*
+ * Supports a region allocator, used by the assembler for everything that
+ * lives as long as a line of the program, and for its state as a whole.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+/**
+ * Allocate a block for an arena
+ *
+ * @param size: number of bytes the block can hand out
+ * @return: pointer to the empty block, or NULL if allocation failed
+ */
+static arena_block_t *arena_block_new(size_t size) {
+  arena_block_t *block = malloc(sizeof(arena_block_t) + size);
+  if (block == NULL) {
+    return NULL;
+  }
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+/**
+ * Create an arena with one empty block
+ *
+ * @param blockSize: size of the blocks, larger for allocations that need it
+ * @return: pointer to the arena, or NULL if allocation failed
+ */
+arena_t *arena_new(size_t blockSize) {
+  arena_t *arena = malloc(sizeof(arena_t));
+  if (arena == NULL) {
+    return NULL;
+  }
+  arena->first = arena_block_new(blockSize);
+  if (arena->first == NULL) {
+    free(arena);
+    return NULL;
+  }
+  arena->current = arena->first;
+  arena->blockSize = blockSize;
+  arena->numAllocs = 0;
+  arena->numBlocks = 1;
+  arena->blockBytes = blockSize;
+  arena->used = 0;
+  arena->peak = 0;
+  return arena;
+}
+
+/**
+ * Allocate memory from an arena, moving on to the next block when the
+ * current one is full, and adding a block when there is none
+ *
+ * @param arena: pointer to the arena
+ * @param size: number of bytes to allocate
+ * @return: pointer to memory aligned to ARENA_ALIGN, or NULL if allocation
+ * failed
+ */
+void *arena_alloc(arena_t *arena, size_t size) {
+  size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+  arena_block_t *block = arena->current;
+  while (block->size - block->used < size) {
+    if (block->next == NULL) {
+      block->next = arena_block_new(size > arena->blockSize
+                                    ? size : arena->blockSize);
+      if (block->next == NULL) {
+        return NULL;
+      }
+      arena->numBlocks++;
+      arena->blockBytes += block->next->size;
+    }
+    block = block->next;
+  }
+  arena->current = block;
+  void *mem = block->data + block->used;
+  block->used += size;
+  arena->numAllocs++;
+  arena->used += size;
+  if (arena->used > arena->peak) {
+    arena->peak = arena->used;
+  }
+  return mem;
+}
+
+/**
+ * Allocate zeroed memory for an array from an arena
+ *
+ * @param arena: pointer to the arena
+ * @param num: number of elements
+ * @param size: size of each element
+ * @return: pointer to the zeroed memory, or NULL if allocation failed
+ */
+void *arena_calloc(arena_t *arena, size_t num, size_t size) {
+  if (size != 0 && num > SIZE_MAX / size) {
+    return NULL;
+  }
+  void *mem = arena_alloc(arena, num * size);
+  if (mem != NULL) {
+    memset(mem, 0, num * size);
+  }
+  return mem;
+}
+
+/**
+ * Copy a string into an arena
+ *
+ * @param arena: pointer to the arena
+ * @param str: the string, of at least len characters
+ * @param len: number of characters to copy
+ * @return: pointer to the NULL terminated copy, or NULL if allocation failed
+ */
+char *arena_strndup(arena_t *arena, const char *str, size_t len) {
+  char *copy = arena_alloc(arena, len + 1);
+  if (copy == NULL) {
+    return NULL;
+  }
+  memcpy(copy, str, len);
+  copy[len] = '\0';
+  return copy;
+}
+
+/**
+ * Free everything allocated from an arena, keeping its blocks for reuse
+ *
+ * @param arena: pointer to the arena
+ */
+void arena_reset(arena_t *arena) {
+  for (arena_block_t *block = arena->first; block != NULL;
+       block = block->next) {
+    block->used = 0;
+  }
+  arena->current = arena->first;
+  arena->used = 0;
+}
+
+/**
+ * Free an arena and its blocks
+ *
+ * @param arena: pointer to the arena, or NULL
+ */
+void arena_delete(arena_t *arena) {
+  if (arena == NULL) {
+    return;
+  }
+  arena_block_t *block = arena->first;
+  while (block != NULL) {
+    arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(arena);
+}
@@ -0,0 +1,40 @@
+/*
+ *  Region allocator handing out memory from a chain of large blocks. Nothing
+ *  is freed on its own: a reset makes every block free again, ready to be
+ *  reused, and deleting the arena frees the blocks.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_ALIGN 8
+#define ARENA_BLOCK_SIZE 4096
+
+typedef struct arena_block {
+  struct arena_block *next;
+  size_t size;                // bytes in data
+  size_t used;
+  unsigned char data[];
+} arena_block_t;
+
+typedef struct {
+  arena_block_t *first;
+  arena_block_t *current;     // block allocations are made from
+  size_t blockSize;
+  size_t numAllocs;           // allocations made since the arena was created
+  size_t numBlocks;
+  size_t blockBytes;          // bytes in all blocks
+  size_t used;                // bytes handed out since the last reset
+  size_t peak;                // most bytes handed out between resets
+} arena_t;
+
+arena_t *arena_new(size_t blockSize);
+void *arena_alloc(arena_t *arena, size_t size);
+void *arena_calloc(arena_t *arena, size_t num, size_t size);
+char *arena_strndup(arena_t *arena, const char *str, size_t len);
+void arena_reset(arena_t *arena);
+void arena_delete(arena_t *arena);
+
+#endif
@@ -23,7 +23,9 @@ void ec_strerror(FILE *out, const int status, char *file, int line,
       {EC_UNSUPPORTED_OP, "This operation is not supported."},
       {EC_INVALID_PARAM, "Invalid parameter."},
       {EC_SKIP, "Function wanting to skip remainer of loop."},
-      {EC_IS_LABEL, "Special label error code."}
+      {EC_IS_LABEL, "Special label error code."},
+      {EC_BUDGET, "Instruction budget used up."},
+      {EC_BLOCKED, "Waiting for input."}
   };
 
   if (EC_IS_SYS_ERROR(status)) {
@@ -17,6 +17,8 @@ typedef enum {
   EC_UNSUPPORTED_OP,
   EC_SKIP,
   EC_IS_LABEL,
+  EC_BUDGET,
+  EC_BLOCKED,
   EC_SYS, // Must be last
 } error_code;
 
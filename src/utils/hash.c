@@ -0,0 +1,23 @@
+/*
+ *  Hashes of byte buffers, used to key and check files cached on disk.
+ */
+
+#include "hash.h"
+
+/**
+ *  Fold a buffer into a 64 bit FNV-1a hash. Start a new hash with
+ *  FNV_OFFSET_BASIS_64, or pass a previous result to continue it.
+ *
+ *  @param data: buffer to hash
+ *  @param len: number of bytes in the buffer
+ *  @param hash: hash of everything before the buffer
+ *  @return: hash including the buffer
+ */
+uint64_t fnv1a_64(const void *data, size_t len, uint64_t hash) {
+  const uint8_t *bytes = data;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME_64;
+  }
+  return hash;
+}
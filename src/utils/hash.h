@@ -0,0 +1,12 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FNV_OFFSET_BASIS_64 0xCBF29CE484222325ULL
+#define FNV_PRIME_64 0x100000001B3ULL
+
+uint64_t fnv1a_64(const void *data, size_t len, uint64_t hash);
+
+#endif
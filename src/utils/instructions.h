@@ -12,7 +12,8 @@ typedef enum {
   MUL, // Multiply instruction
   SDT, // Single data transfer
   BRN, // Branch instruction
-  HAL  // Halt instruction
+  HAL, // Halt instruction
+  UND  // Encoding we do not support
 } instruction_type_t;
 
 typedef enum {
@@ -149,9 +150,19 @@ typedef union {
   hal_instruction_t hal;
 } instructions_t;
 
+// Pairs of instructions executed by a single handler, tagged on the first
+typedef enum {
+  FUSE_NONE,
+  FUSE_CMP_BRN,  // cmp then a conditional branch
+  FUSE_LDR_ADD,  // ldr then an add reading the loaded register
+  FUSE_SUBS_BNE, // subs then bne
+  NUM_FUSIONS
+} fusion_t;
+
 typedef struct {
   instruction_type_t type;
   byte_t cond : 4;
+  byte_t fusion : 4;
   instructions_t i;
 } instruction_t;
 
@@ -2,6 +2,10 @@
 *  Contains IO related operations, operating on either the ARM machine state or local disk.
 */
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "io.h"
 
 /**
@@ -24,19 +28,20 @@ bool is_gpio_addr(word_t addr) {
 /**
  * Print out the correct string for a GPIO memory access
  *
+ * @param out: stream to print to
  * @param byteAddr: address accessed
  */
-void print_gpio_access(word_t byteAddr) {
+void print_gpio_access(FILE *out, word_t byteAddr) {
   if (byteAddr == GPIO_SETUP_0_9) {
-    printf("One GPIO pin from 0 to 9 has been accessed\n");
+    fprintf(out, "One GPIO pin from 0 to 9 has been accessed\n");
   } else if (byteAddr == GPIO_SETUP_10_19) {
-    printf("One GPIO pin from 10 to 19 has been accessed\n");
+    fprintf(out, "One GPIO pin from 10 to 19 has been accessed\n");
   } else if (byteAddr == GPIO_SETUP_20_29) {
-    printf("One GPIO pin from 20 to 29 has been accessed\n");
+    fprintf(out, "One GPIO pin from 20 to 29 has been accessed\n");
   } else if (byteAddr == GPIO_CLEAR) {
-    printf("PIN OFF\n");
+    fprintf(out, "PIN OFF\n");
   } else if (byteAddr == GPIO_WRITE) {
-    printf("PIN ON\n");
+    fprintf(out, "PIN ON\n");
   }
 }
 
@@ -89,30 +94,6 @@ int get_word(byte_t *buff, word_t byteAddr, word_t *word) {
   return EC_OK;
 }
 
-/**
- *  Read a 32 bit word from the emulator memory
- *
- *  @param state: non-null pointer to the machine state
- *  @param byteAddr: byte address to read from
- *  @param dest: non-null pointer to destination of loaded word
- *  @return: int error code indicating success or failure
- */
-int get_mem_word(emulate_state_t *state, word_t byteAddr, word_t *dest) {
-  assert(state != NULL);
-  if (check_address_invalid(byteAddr)) {
-    return EC_INVALID_PARAM;
-  }
-
-  // GPIO extension
-  if (is_gpio_addr(byteAddr)) {
-    print_gpio_access(byteAddr);
-    *dest = byteAddr;
-    return EC_OK;
-  }
-  get_word(state->memory, byteAddr, dest);
-  return EC_OK;
-}
-
 /**
  * Read the 32 bit word from emulator memory in big endian format
  *
@@ -131,7 +112,7 @@ get_mem_word_big_end(emulate_state_t *state, word_t byteAddr, word_t *dest) {
 
   // GPIO extension
   if (is_gpio_addr(byteAddr)) {
-    print_gpio_access(byteAddr);
+    print_gpio_access(state->out, byteAddr);
     *dest = byteAddr;
     return EC_OK;
   }
@@ -156,7 +137,7 @@ int set_word(byte_t *buff, word_t byteAddr, word_t word) {
 
   // GPIO extension
   if (is_gpio_addr(byteAddr)) {
-    print_gpio_access(byteAddr);
+    print_gpio_access(stdout, byteAddr);
     return EC_OK;
   }
 
@@ -166,20 +147,6 @@ int set_word(byte_t *buff, word_t byteAddr, word_t word) {
   return EC_OK;
 }
 
-/**
- * Write a word at a specified byte address in memory
- *
- *  @param state: non-null pointer to the machine state
- *  @param byteAddr: byte address to be written into
- *  @param word: word to write into memory
- *  @return: return 0 iff success
- */
-int set_mem_word(emulate_state_t *state, word_t byteAddr, word_t word) {
-  assert(state != NULL);
-  if (check_address_invalid(byteAddr)) { return EC_INVALID_PARAM; }
-  return set_word(state->memory, byteAddr, word);
-}
-
 /**
  *  Print the values stored in memory
  *  Continue until the word value is 0 or we run out of memory
@@ -229,18 +196,26 @@ void print_reg(emulate_state_t *state, reg_address_t reg) {
 }
 
 /**
- *  Print all data stored in registers and memory
+ *  Print the values stored in every register
  *
  *  @param state - pointer to the state of the emulator
  */
-void print_state(emulate_state_t *state) {
+void print_registers(emulate_state_t *state) {
   assert(state != NULL);
 
   printf("Registers:\n");
   for (int i = 0; i < REG_N; ++i) {
     print_reg(state, i);
   }
+}
 
+/**
+ *  Print all data stored in registers and memory
+ *
+ *  @param state - pointer to the state of the emulator
+ */
+void print_state(emulate_state_t *state) {
+  print_registers(state);
   printf("Non-zero memory:\n");
   print_mem(state);
 }
@@ -297,27 +272,51 @@ int read_file(const char *path, byte_t *buffer, size_t buffer_size) {
 }
 
 /**
-*  Load a file from disk as list of strings
+*  Map a file from disk into memory, read only. An empty file is not mapped,
+*  and gives a NULL pointer and a size of 0.
 *
-*  @param path: path of the ASCII file to read from
-*  @param buffer: pointer to an allocated array which the file will be read to
+*  @param path: path of the file to map
+*  @param data: set to the start of the mapping
+*  @param size: set to the size of the file in bytes
 *  @return: status code denoting the result
 */
-int read_char_file(const char *path, char **buffer) {
-  assert(buffer != NULL);
+int map_file(const char *path, const char **data, size_t *size) {
+  assert(data != NULL && size != NULL);
 
   FAIL_PRED(path == NULL, EC_INVALID_PARAM);
 
-  FILE *fp = NULL;
-  fp = fopen(path, "r");
-  FAIL_SYS(fp == NULL);
+  int fd = open(path, O_RDONLY);
+  FAIL_SYS(fd < 0);
 
-  int line = 0;
-  while (fgets(buffer[line], LINE_SIZE - 1, fp) != NULL) {
-    line++;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close(fd);
+    return EC_FROM_SYS_ERROR(err);
   }
-  FAIL_SYS(ferror(fp));
-  FAIL_SYS(fclose(fp));
+  *size = st.st_size;
+  *data = NULL;
+  if (*size == 0) {
+    close(fd);
+    return EC_OK;
+  }
+  void *map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  FAIL_SYS(map == MAP_FAILED);
+  madvise(map, *size, MADV_SEQUENTIAL);
+  *data = map;
+
+  return EC_OK;
+}
 
-  return line;
+/**
+*  Unmap a file mapped by map_file
+*
+*  @param data: start of the mapping, or NULL for an empty file
+*  @param size: size of the file in bytes
+*/
+void unmap_file(const char *data, size_t size) {
+  if (data != NULL) {
+    munmap((void *) data, size);
+  }
 }
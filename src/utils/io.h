@@ -17,20 +17,24 @@
 #define GPIO_CLEAR 0x20200028
 #define GPIO_WRITE 0x2020001C
 
+bool is_gpio_addr(word_t addr);
+void print_gpio_access(FILE *out, word_t byteAddr);
+bool check_address_invalid(word_t addr);
+
 int get_word(byte_t *buff, word_t byteAddr, word_t *word);
-int get_mem_word(emulate_state_t *state, word_t byteAddr, word_t *dest);
 int get_mem_word_big_end(emulate_state_t *state, word_t byteAddr, word_t *dest);
 
 int set_word(byte_t *buff, word_t byteAddr, word_t word);
-int set_mem_word(emulate_state_t *state, word_t byteAddr, word_t word);
 
 void print_reg(emulate_state_t *state, reg_address_t reg);
 void print_mem(emulate_state_t *state);
+void print_registers(emulate_state_t *state);
 void print_state(emulate_state_t *state);
 
 int write_file(const char *path, byte_t *buffer, int no_bytes);
 int read_file(const char *path, byte_t *buffer, size_t buffer_size);
-int read_char_file(const char *path, char **buffer);
+int map_file(const char *path, const char **data, size_t *size);
+void unmap_file(const char *data, size_t size);
 
 char *num_to_str(int n);
 
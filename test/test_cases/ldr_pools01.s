@@ -0,0 +1,1445 @@
+block0:
+ldr r0,=0x10000
+add r2,r2,r0
+ldr r0,=0x80001
+add r2,r2,r0
+ldr r0,=0xF0002
+add r2,r2,r0
+ldr r0,=0x160000
+add r2,r2,r0
+ldr r0,=0x1D0001
+add r2,r2,r0
+ldr r0,=0x240002
+add r2,r2,r0
+ldr r0,=0x30000
+add r2,r2,r0
+ldr r0,=0xA0001
+add r2,r2,r0
+ldr r0,=0x110002
+add r2,r2,r0
+ldr r0,=0x180000
+add r2,r2,r0
+ldr r0,=0x1F0001
+add r2,r2,r0
+ldr r0,=0x260002
+add r2,r2,r0
+ldr r0,=0x50000
+add r2,r2,r0
+ldr r0,=0xC0001
+add r2,r2,r0
+ldr r0,=0x130002
+add r2,r2,r0
+ldr r0,=0x1A0000
+add r2,r2,r0
+ldr r0,=0x210001
+add r2,r2,r0
+ldr r0,=0x280002
+add r2,r2,r0
+ldr r0,=0x70000
+add r2,r2,r0
+ldr r0,=0xE0001
+add r2,r2,r0
+ldr r0,=0x150002
+add r2,r2,r0
+ldr r0,=0x1C0000
+add r2,r2,r0
+ldr r0,=0x230001
+add r2,r2,r0
+ldr r0,=0x20002
+add r2,r2,r0
+ldr r0,=0x90000
+add r2,r2,r0
+ldr r0,=0x100001
+add r2,r2,r0
+ldr r0,=0x170002
+add r2,r2,r0
+ldr r0,=0x1E0000
+add r2,r2,r0
+ldr r0,=0x250001
+add r2,r2,r0
+ldr r0,=0x40002
+add r2,r2,r0
+ldr r0,=0xB0000
+add r2,r2,r0
+ldr r0,=0x120001
+add r2,r2,r0
+ldr r0,=0x190002
+add r2,r2,r0
+ldr r0,=0x200000
+add r2,r2,r0
+ldr r0,=0x270001
+add r2,r2,r0
+ldr r0,=0x60002
+add r2,r2,r0
+ldr r0,=0xD0000
+add r2,r2,r0
+ldr r0,=0x140001
+add r2,r2,r0
+ldr r0,=0x1B0002
+add r2,r2,r0
+ldr r0,=0x220000
+add r2,r2,r0
+ldr r0,=0x10001
+add r2,r2,r0
+ldr r0,=0x80002
+add r2,r2,r0
+ldr r0,=0xF0000
+add r2,r2,r0
+ldr r0,=0x160001
+add r2,r2,r0
+ldr r0,=0x1D0002
+add r2,r2,r0
+ldr r0,=0x240000
+add r2,r2,r0
+ldr r0,=0x30001
+add r2,r2,r0
+ldr r0,=0xA0002
+add r2,r2,r0
+ldr r0,=0x110000
+add r2,r2,r0
+ldr r0,=0x180001
+add r2,r2,r0
+b block50
+mov r3,#1
+block50:
+ldr r0,=0x1F0002
+add r2,r2,r0
+ldr r0,=0x260000
+add r2,r2,r0
+ldr r0,=0x50001
+add r2,r2,r0
+ldr r0,=0xC0002
+add r2,r2,r0
+ldr r0,=0x130000
+add r2,r2,r0
+ldr r0,=0x1A0001
+add r2,r2,r0
+ldr r0,=0x210002
+add r2,r2,r0
+ldr r0,=0x280000
+add r2,r2,r0
+ldr r0,=0x70001
+add r2,r2,r0
+ldr r0,=0xE0002
+add r2,r2,r0
+ldr r0,=0x150000
+add r2,r2,r0
+ldr r0,=0x1C0001
+add r2,r2,r0
+ldr r0,=0x230002
+add r2,r2,r0
+ldr r0,=0x20000
+add r2,r2,r0
+ldr r0,=0x90001
+add r2,r2,r0
+ldr r0,=0x100002
+add r2,r2,r0
+ldr r0,=0x170000
+add r2,r2,r0
+ldr r0,=0x1E0001
+add r2,r2,r0
+ldr r0,=0x250002
+add r2,r2,r0
+ldr r0,=0x40000
+add r2,r2,r0
+ldr r0,=0xB0001
+add r2,r2,r0
+ldr r0,=0x120002
+add r2,r2,r0
+ldr r0,=0x190000
+add r2,r2,r0
+ldr r0,=0x200001
+add r2,r2,r0
+ldr r0,=0x270002
+add r2,r2,r0
+ldr r0,=0x60000
+add r2,r2,r0
+ldr r0,=0xD0001
+add r2,r2,r0
+ldr r0,=0x140002
+add r2,r2,r0
+ldr r0,=0x1B0000
+add r2,r2,r0
+ldr r0,=0x220001
+add r2,r2,r0
+ldr r0,=0x10002
+add r2,r2,r0
+ldr r0,=0x80000
+add r2,r2,r0
+ldr r0,=0xF0001
+add r2,r2,r0
+ldr r0,=0x160002
+add r2,r2,r0
+ldr r0,=0x1D0000
+add r2,r2,r0
+ldr r0,=0x240001
+add r2,r2,r0
+ldr r0,=0x30002
+add r2,r2,r0
+ldr r0,=0xA0000
+add r2,r2,r0
+ldr r0,=0x110001
+add r2,r2,r0
+ldr r0,=0x180002
+add r2,r2,r0
+ldr r0,=0x1F0000
+add r2,r2,r0
+ldr r0,=0x260001
+add r2,r2,r0
+ldr r0,=0x50002
+add r2,r2,r0
+ldr r0,=0xC0000
+add r2,r2,r0
+ldr r0,=0x130001
+add r2,r2,r0
+ldr r0,=0x1A0002
+add r2,r2,r0
+ldr r0,=0x210000
+add r2,r2,r0
+ldr r0,=0x280001
+add r2,r2,r0
+ldr r0,=0x70002
+add r2,r2,r0
+ldr r0,=0xE0000
+add r2,r2,r0
+b block100
+mov r3,#1
+block100:
+ldr r0,=0x150001
+add r2,r2,r0
+ldr r0,=0x1C0002
+add r2,r2,r0
+ldr r0,=0x230000
+add r2,r2,r0
+ldr r0,=0x20001
+add r2,r2,r0
+ldr r0,=0x90002
+add r2,r2,r0
+ldr r0,=0x100000
+add r2,r2,r0
+ldr r0,=0x170001
+add r2,r2,r0
+ldr r0,=0x1E0002
+add r2,r2,r0
+ldr r0,=0x250000
+add r2,r2,r0
+ldr r0,=0x40001
+add r2,r2,r0
+ldr r0,=0xB0002
+add r2,r2,r0
+ldr r0,=0x120000
+add r2,r2,r0
+ldr r0,=0x190001
+add r2,r2,r0
+ldr r0,=0x200002
+add r2,r2,r0
+ldr r0,=0x270000
+add r2,r2,r0
+ldr r0,=0x60001
+add r2,r2,r0
+ldr r0,=0xD0002
+add r2,r2,r0
+ldr r0,=0x140000
+add r2,r2,r0
+ldr r0,=0x1B0001
+add r2,r2,r0
+ldr r0,=0x220002
+add r2,r2,r0
+ldr r0,=0x10000
+add r2,r2,r0
+ldr r0,=0x80001
+add r2,r2,r0
+ldr r0,=0xF0002
+add r2,r2,r0
+ldr r0,=0x160000
+add r2,r2,r0
+ldr r0,=0x1D0001
+add r2,r2,r0
+ldr r0,=0x240002
+add r2,r2,r0
+ldr r0,=0x30000
+add r2,r2,r0
+ldr r0,=0xA0001
+add r2,r2,r0
+ldr r0,=0x110002
+add r2,r2,r0
+ldr r0,=0x180000
+add r2,r2,r0
+ldr r0,=0x1F0001
+add r2,r2,r0
+ldr r0,=0x260002
+add r2,r2,r0
+ldr r0,=0x50000
+add r2,r2,r0
+ldr r0,=0xC0001
+add r2,r2,r0
+ldr r0,=0x130002
+add r2,r2,r0
+ldr r0,=0x1A0000
+add r2,r2,r0
+ldr r0,=0x210001
+add r2,r2,r0
+ldr r0,=0x280002
+add r2,r2,r0
+ldr r0,=0x70000
+add r2,r2,r0
+ldr r0,=0xE0001
+add r2,r2,r0
+ldr r0,=0x150002
+add r2,r2,r0
+ldr r0,=0x1C0000
+add r2,r2,r0
+ldr r0,=0x230001
+add r2,r2,r0
+ldr r0,=0x20002
+add r2,r2,r0
+ldr r0,=0x90000
+add r2,r2,r0
+ldr r0,=0x100001
+add r2,r2,r0
+ldr r0,=0x170002
+add r2,r2,r0
+ldr r0,=0x1E0000
+add r2,r2,r0
+ldr r0,=0x250001
+add r2,r2,r0
+ldr r0,=0x40002
+add r2,r2,r0
+b block150
+mov r3,#1
+block150:
+ldr r0,=0xB0000
+add r2,r2,r0
+ldr r0,=0x120001
+add r2,r2,r0
+ldr r0,=0x190002
+add r2,r2,r0
+ldr r0,=0x200000
+add r2,r2,r0
+ldr r0,=0x270001
+add r2,r2,r0
+ldr r0,=0x60002
+add r2,r2,r0
+ldr r0,=0xD0000
+add r2,r2,r0
+ldr r0,=0x140001
+add r2,r2,r0
+ldr r0,=0x1B0002
+add r2,r2,r0
+ldr r0,=0x220000
+add r2,r2,r0
+ldr r0,=0x10001
+add r2,r2,r0
+ldr r0,=0x80002
+add r2,r2,r0
+ldr r0,=0xF0000
+add r2,r2,r0
+ldr r0,=0x160001
+add r2,r2,r0
+ldr r0,=0x1D0002
+add r2,r2,r0
+ldr r0,=0x240000
+add r2,r2,r0
+ldr r0,=0x30001
+add r2,r2,r0
+ldr r0,=0xA0002
+add r2,r2,r0
+ldr r0,=0x110000
+add r2,r2,r0
+ldr r0,=0x180001
+add r2,r2,r0
+ldr r0,=0x1F0002
+add r2,r2,r0
+ldr r0,=0x260000
+add r2,r2,r0
+ldr r0,=0x50001
+add r2,r2,r0
+ldr r0,=0xC0002
+add r2,r2,r0
+ldr r0,=0x130000
+add r2,r2,r0
+ldr r0,=0x1A0001
+add r2,r2,r0
+ldr r0,=0x210002
+add r2,r2,r0
+ldr r0,=0x280000
+add r2,r2,r0
+ldr r0,=0x70001
+add r2,r2,r0
+ldr r0,=0xE0002
+add r2,r2,r0
+ldr r0,=0x150000
+add r2,r2,r0
+ldr r0,=0x1C0001
+add r2,r2,r0
+ldr r0,=0x230002
+add r2,r2,r0
+ldr r0,=0x20000
+add r2,r2,r0
+ldr r0,=0x90001
+add r2,r2,r0
+ldr r0,=0x100002
+add r2,r2,r0
+ldr r0,=0x170000
+add r2,r2,r0
+ldr r0,=0x1E0001
+add r2,r2,r0
+ldr r0,=0x250002
+add r2,r2,r0
+ldr r0,=0x40000
+add r2,r2,r0
+ldr r0,=0xB0001
+add r2,r2,r0
+ldr r0,=0x120002
+add r2,r2,r0
+ldr r0,=0x190000
+add r2,r2,r0
+ldr r0,=0x200001
+add r2,r2,r0
+ldr r0,=0x270002
+add r2,r2,r0
+ldr r0,=0x60000
+add r2,r2,r0
+ldr r0,=0xD0001
+add r2,r2,r0
+ldr r0,=0x140002
+add r2,r2,r0
+ldr r0,=0x1B0000
+add r2,r2,r0
+ldr r0,=0x220001
+add r2,r2,r0
+b block200
+mov r3,#1
+block200:
+ldr r0,=0x10002
+add r2,r2,r0
+ldr r0,=0x80000
+add r2,r2,r0
+ldr r0,=0xF0001
+add r2,r2,r0
+ldr r0,=0x160002
+add r2,r2,r0
+ldr r0,=0x1D0000
+add r2,r2,r0
+ldr r0,=0x240001
+add r2,r2,r0
+ldr r0,=0x30002
+add r2,r2,r0
+ldr r0,=0xA0000
+add r2,r2,r0
+ldr r0,=0x110001
+add r2,r2,r0
+ldr r0,=0x180002
+add r2,r2,r0
+ldr r0,=0x1F0000
+add r2,r2,r0
+ldr r0,=0x260001
+add r2,r2,r0
+ldr r0,=0x50002
+add r2,r2,r0
+ldr r0,=0xC0000
+add r2,r2,r0
+ldr r0,=0x130001
+add r2,r2,r0
+ldr r0,=0x1A0002
+add r2,r2,r0
+ldr r0,=0x210000
+add r2,r2,r0
+ldr r0,=0x280001
+add r2,r2,r0
+ldr r0,=0x70002
+add r2,r2,r0
+ldr r0,=0xE0000
+add r2,r2,r0
+ldr r0,=0x150001
+add r2,r2,r0
+ldr r0,=0x1C0002
+add r2,r2,r0
+ldr r0,=0x230000
+add r2,r2,r0
+ldr r0,=0x20001
+add r2,r2,r0
+ldr r0,=0x90002
+add r2,r2,r0
+ldr r0,=0x100000
+add r2,r2,r0
+ldr r0,=0x170001
+add r2,r2,r0
+ldr r0,=0x1E0002
+add r2,r2,r0
+ldr r0,=0x250000
+add r2,r2,r0
+ldr r0,=0x40001
+add r2,r2,r0
+ldr r0,=0xB0002
+add r2,r2,r0
+ldr r0,=0x120000
+add r2,r2,r0
+ldr r0,=0x190001
+add r2,r2,r0
+ldr r0,=0x200002
+add r2,r2,r0
+ldr r0,=0x270000
+add r2,r2,r0
+ldr r0,=0x60001
+add r2,r2,r0
+ldr r0,=0xD0002
+add r2,r2,r0
+ldr r0,=0x140000
+add r2,r2,r0
+ldr r0,=0x1B0001
+add r2,r2,r0
+ldr r0,=0x220002
+add r2,r2,r0
+ldr r0,=0x10000
+add r2,r2,r0
+ldr r0,=0x80001
+add r2,r2,r0
+ldr r0,=0xF0002
+add r2,r2,r0
+ldr r0,=0x160000
+add r2,r2,r0
+ldr r0,=0x1D0001
+add r2,r2,r0
+ldr r0,=0x240002
+add r2,r2,r0
+ldr r0,=0x30000
+add r2,r2,r0
+ldr r0,=0xA0001
+add r2,r2,r0
+ldr r0,=0x110002
+add r2,r2,r0
+ldr r0,=0x180000
+add r2,r2,r0
+b block250
+mov r3,#1
+block250:
+ldr r0,=0x1F0001
+add r2,r2,r0
+ldr r0,=0x260002
+add r2,r2,r0
+ldr r0,=0x50000
+add r2,r2,r0
+ldr r0,=0xC0001
+add r2,r2,r0
+ldr r0,=0x130002
+add r2,r2,r0
+ldr r0,=0x1A0000
+add r2,r2,r0
+ldr r0,=0x210001
+add r2,r2,r0
+ldr r0,=0x280002
+add r2,r2,r0
+ldr r0,=0x70000
+add r2,r2,r0
+ldr r0,=0xE0001
+add r2,r2,r0
+ldr r0,=0x150002
+add r2,r2,r0
+ldr r0,=0x1C0000
+add r2,r2,r0
+ldr r0,=0x230001
+add r2,r2,r0
+ldr r0,=0x20002
+add r2,r2,r0
+ldr r0,=0x90000
+add r2,r2,r0
+ldr r0,=0x100001
+add r2,r2,r0
+ldr r0,=0x170002
+add r2,r2,r0
+ldr r0,=0x1E0000
+add r2,r2,r0
+ldr r0,=0x250001
+add r2,r2,r0
+ldr r0,=0x40002
+add r2,r2,r0
+ldr r0,=0xB0000
+add r2,r2,r0
+ldr r0,=0x120001
+add r2,r2,r0
+ldr r0,=0x190002
+add r2,r2,r0
+ldr r0,=0x200000
+add r2,r2,r0
+ldr r0,=0x270001
+add r2,r2,r0
+ldr r0,=0x60002
+add r2,r2,r0
+ldr r0,=0xD0000
+add r2,r2,r0
+ldr r0,=0x140001
+add r2,r2,r0
+ldr r0,=0x1B0002
+add r2,r2,r0
+ldr r0,=0x220000
+add r2,r2,r0
+ldr r0,=0x10001
+add r2,r2,r0
+ldr r0,=0x80002
+add r2,r2,r0
+ldr r0,=0xF0000
+add r2,r2,r0
+ldr r0,=0x160001
+add r2,r2,r0
+ldr r0,=0x1D0002
+add r2,r2,r0
+ldr r0,=0x240000
+add r2,r2,r0
+ldr r0,=0x30001
+add r2,r2,r0
+ldr r0,=0xA0002
+add r2,r2,r0
+ldr r0,=0x110000
+add r2,r2,r0
+ldr r0,=0x180001
+add r2,r2,r0
+ldr r0,=0x1F0002
+add r2,r2,r0
+ldr r0,=0x260000
+add r2,r2,r0
+ldr r0,=0x50001
+add r2,r2,r0
+ldr r0,=0xC0002
+add r2,r2,r0
+ldr r0,=0x130000
+add r2,r2,r0
+ldr r0,=0x1A0001
+add r2,r2,r0
+ldr r0,=0x210002
+add r2,r2,r0
+ldr r0,=0x280000
+add r2,r2,r0
+ldr r0,=0x70001
+add r2,r2,r0
+ldr r0,=0xE0002
+add r2,r2,r0
+b block300
+mov r3,#1
+block300:
+ldr r0,=0x150000
+add r2,r2,r0
+ldr r0,=0x1C0001
+add r2,r2,r0
+ldr r0,=0x230002
+add r2,r2,r0
+ldr r0,=0x20000
+add r2,r2,r0
+ldr r0,=0x90001
+add r2,r2,r0
+ldr r0,=0x100002
+add r2,r2,r0
+ldr r0,=0x170000
+add r2,r2,r0
+ldr r0,=0x1E0001
+add r2,r2,r0
+ldr r0,=0x250002
+add r2,r2,r0
+ldr r0,=0x40000
+add r2,r2,r0
+ldr r0,=0xB0001
+add r2,r2,r0
+ldr r0,=0x120002
+add r2,r2,r0
+ldr r0,=0x190000
+add r2,r2,r0
+ldr r0,=0x200001
+add r2,r2,r0
+ldr r0,=0x270002
+add r2,r2,r0
+ldr r0,=0x60000
+add r2,r2,r0
+ldr r0,=0xD0001
+add r2,r2,r0
+ldr r0,=0x140002
+add r2,r2,r0
+ldr r0,=0x1B0000
+add r2,r2,r0
+ldr r0,=0x220001
+add r2,r2,r0
+ldr r0,=0x10002
+add r2,r2,r0
+ldr r0,=0x80000
+add r2,r2,r0
+ldr r0,=0xF0001
+add r2,r2,r0
+ldr r0,=0x160002
+add r2,r2,r0
+ldr r0,=0x1D0000
+add r2,r2,r0
+ldr r0,=0x240001
+add r2,r2,r0
+ldr r0,=0x30002
+add r2,r2,r0
+ldr r0,=0xA0000
+add r2,r2,r0
+ldr r0,=0x110001
+add r2,r2,r0
+ldr r0,=0x180002
+add r2,r2,r0
+ldr r0,=0x1F0000
+add r2,r2,r0
+ldr r0,=0x260001
+add r2,r2,r0
+ldr r0,=0x50002
+add r2,r2,r0
+ldr r0,=0xC0000
+add r2,r2,r0
+ldr r0,=0x130001
+add r2,r2,r0
+ldr r0,=0x1A0002
+add r2,r2,r0
+ldr r0,=0x210000
+add r2,r2,r0
+ldr r0,=0x280001
+add r2,r2,r0
+ldr r0,=0x70002
+add r2,r2,r0
+ldr r0,=0xE0000
+add r2,r2,r0
+ldr r0,=0x150001
+add r2,r2,r0
+ldr r0,=0x1C0002
+add r2,r2,r0
+ldr r0,=0x230000
+add r2,r2,r0
+ldr r0,=0x20001
+add r2,r2,r0
+ldr r0,=0x90002
+add r2,r2,r0
+ldr r0,=0x100000
+add r2,r2,r0
+ldr r0,=0x170001
+add r2,r2,r0
+ldr r0,=0x1E0002
+add r2,r2,r0
+ldr r0,=0x250000
+add r2,r2,r0
+ldr r0,=0x40001
+add r2,r2,r0
+b block350
+mov r3,#1
+block350:
+ldr r0,=0xB0002
+add r2,r2,r0
+ldr r0,=0x120000
+add r2,r2,r0
+ldr r0,=0x190001
+add r2,r2,r0
+ldr r0,=0x200002
+add r2,r2,r0
+ldr r0,=0x270000
+add r2,r2,r0
+ldr r0,=0x60001
+add r2,r2,r0
+ldr r0,=0xD0002
+add r2,r2,r0
+ldr r0,=0x140000
+add r2,r2,r0
+ldr r0,=0x1B0001
+add r2,r2,r0
+ldr r0,=0x220002
+add r2,r2,r0
+ldr r0,=0x10000
+add r2,r2,r0
+ldr r0,=0x80001
+add r2,r2,r0
+ldr r0,=0xF0002
+add r2,r2,r0
+ldr r0,=0x160000
+add r2,r2,r0
+ldr r0,=0x1D0001
+add r2,r2,r0
+ldr r0,=0x240002
+add r2,r2,r0
+ldr r0,=0x30000
+add r2,r2,r0
+ldr r0,=0xA0001
+add r2,r2,r0
+ldr r0,=0x110002
+add r2,r2,r0
+ldr r0,=0x180000
+add r2,r2,r0
+ldr r0,=0x1F0001
+add r2,r2,r0
+ldr r0,=0x260002
+add r2,r2,r0
+ldr r0,=0x50000
+add r2,r2,r0
+ldr r0,=0xC0001
+add r2,r2,r0
+ldr r0,=0x130002
+add r2,r2,r0
+ldr r0,=0x1A0000
+add r2,r2,r0
+ldr r0,=0x210001
+add r2,r2,r0
+ldr r0,=0x280002
+add r2,r2,r0
+ldr r0,=0x70000
+add r2,r2,r0
+ldr r0,=0xE0001
+add r2,r2,r0
+ldr r0,=0x150002
+add r2,r2,r0
+ldr r0,=0x1C0000
+add r2,r2,r0
+ldr r0,=0x230001
+add r2,r2,r0
+ldr r0,=0x20002
+add r2,r2,r0
+ldr r0,=0x90000
+add r2,r2,r0
+ldr r0,=0x100001
+add r2,r2,r0
+ldr r0,=0x170002
+add r2,r2,r0
+ldr r0,=0x1E0000
+add r2,r2,r0
+ldr r0,=0x250001
+add r2,r2,r0
+ldr r0,=0x40002
+add r2,r2,r0
+ldr r0,=0xB0000
+add r2,r2,r0
+ldr r0,=0x120001
+add r2,r2,r0
+ldr r0,=0x190002
+add r2,r2,r0
+ldr r0,=0x200000
+add r2,r2,r0
+ldr r0,=0x270001
+add r2,r2,r0
+ldr r0,=0x60002
+add r2,r2,r0
+ldr r0,=0xD0000
+add r2,r2,r0
+ldr r0,=0x140001
+add r2,r2,r0
+ldr r0,=0x1B0002
+add r2,r2,r0
+ldr r0,=0x220000
+add r2,r2,r0
+b block400
+mov r3,#1
+block400:
+ldr r0,=0x10001
+add r2,r2,r0
+ldr r0,=0x80002
+add r2,r2,r0
+ldr r0,=0xF0000
+add r2,r2,r0
+ldr r0,=0x160001
+add r2,r2,r0
+ldr r0,=0x1D0002
+add r2,r2,r0
+ldr r0,=0x240000
+add r2,r2,r0
+ldr r0,=0x30001
+add r2,r2,r0
+ldr r0,=0xA0002
+add r2,r2,r0
+ldr r0,=0x110000
+add r2,r2,r0
+ldr r0,=0x180001
+add r2,r2,r0
+ldr r0,=0x1F0002
+add r2,r2,r0
+ldr r0,=0x260000
+add r2,r2,r0
+ldr r0,=0x50001
+add r2,r2,r0
+ldr r0,=0xC0002
+add r2,r2,r0
+ldr r0,=0x130000
+add r2,r2,r0
+ldr r0,=0x1A0001
+add r2,r2,r0
+ldr r0,=0x210002
+add r2,r2,r0
+ldr r0,=0x280000
+add r2,r2,r0
+ldr r0,=0x70001
+add r2,r2,r0
+ldr r0,=0xE0002
+add r2,r2,r0
+ldr r0,=0x150000
+add r2,r2,r0
+ldr r0,=0x1C0001
+add r2,r2,r0
+ldr r0,=0x230002
+add r2,r2,r0
+ldr r0,=0x20000
+add r2,r2,r0
+ldr r0,=0x90001
+add r2,r2,r0
+ldr r0,=0x100002
+add r2,r2,r0
+ldr r0,=0x170000
+add r2,r2,r0
+ldr r0,=0x1E0001
+add r2,r2,r0
+ldr r0,=0x250002
+add r2,r2,r0
+ldr r0,=0x40000
+add r2,r2,r0
+ldr r0,=0xB0001
+add r2,r2,r0
+ldr r0,=0x120002
+add r2,r2,r0
+ldr r0,=0x190000
+add r2,r2,r0
+ldr r0,=0x200001
+add r2,r2,r0
+ldr r0,=0x270002
+add r2,r2,r0
+ldr r0,=0x60000
+add r2,r2,r0
+ldr r0,=0xD0001
+add r2,r2,r0
+ldr r0,=0x140002
+add r2,r2,r0
+ldr r0,=0x1B0000
+add r2,r2,r0
+ldr r0,=0x220001
+add r2,r2,r0
+ldr r0,=0x10002
+add r2,r2,r0
+ldr r0,=0x80000
+add r2,r2,r0
+ldr r0,=0xF0001
+add r2,r2,r0
+ldr r0,=0x160002
+add r2,r2,r0
+ldr r0,=0x1D0000
+add r2,r2,r0
+ldr r0,=0x240001
+add r2,r2,r0
+ldr r0,=0x30002
+add r2,r2,r0
+ldr r0,=0xA0000
+add r2,r2,r0
+ldr r0,=0x110001
+add r2,r2,r0
+ldr r0,=0x180002
+add r2,r2,r0
+b block450
+mov r3,#1
+block450:
+ldr r0,=0x1F0000
+add r2,r2,r0
+ldr r0,=0x260001
+add r2,r2,r0
+ldr r0,=0x50002
+add r2,r2,r0
+ldr r0,=0xC0000
+add r2,r2,r0
+ldr r0,=0x130001
+add r2,r2,r0
+ldr r0,=0x1A0002
+add r2,r2,r0
+ldr r0,=0x210000
+add r2,r2,r0
+ldr r0,=0x280001
+add r2,r2,r0
+ldr r0,=0x70002
+add r2,r2,r0
+ldr r0,=0xE0000
+add r2,r2,r0
+ldr r0,=0x150001
+add r2,r2,r0
+ldr r0,=0x1C0002
+add r2,r2,r0
+ldr r0,=0x230000
+add r2,r2,r0
+ldr r0,=0x20001
+add r2,r2,r0
+ldr r0,=0x90002
+add r2,r2,r0
+ldr r0,=0x100000
+add r2,r2,r0
+ldr r0,=0x170001
+add r2,r2,r0
+ldr r0,=0x1E0002
+add r2,r2,r0
+ldr r0,=0x250000
+add r2,r2,r0
+ldr r0,=0x40001
+add r2,r2,r0
+ldr r0,=0xB0002
+add r2,r2,r0
+ldr r0,=0x120000
+add r2,r2,r0
+ldr r0,=0x190001
+add r2,r2,r0
+ldr r0,=0x200002
+add r2,r2,r0
+ldr r0,=0x270000
+add r2,r2,r0
+ldr r0,=0x60001
+add r2,r2,r0
+ldr r0,=0xD0002
+add r2,r2,r0
+ldr r0,=0x140000
+add r2,r2,r0
+ldr r0,=0x1B0001
+add r2,r2,r0
+ldr r0,=0x220002
+add r2,r2,r0
+ldr r0,=0x10000
+add r2,r2,r0
+ldr r0,=0x80001
+add r2,r2,r0
+ldr r0,=0xF0002
+add r2,r2,r0
+ldr r0,=0x160000
+add r2,r2,r0
+ldr r0,=0x1D0001
+add r2,r2,r0
+ldr r0,=0x240002
+add r2,r2,r0
+ldr r0,=0x30000
+add r2,r2,r0
+ldr r0,=0xA0001
+add r2,r2,r0
+ldr r0,=0x110002
+add r2,r2,r0
+ldr r0,=0x180000
+add r2,r2,r0
+ldr r0,=0x1F0001
+add r2,r2,r0
+ldr r0,=0x260002
+add r2,r2,r0
+ldr r0,=0x50000
+add r2,r2,r0
+ldr r0,=0xC0001
+add r2,r2,r0
+ldr r0,=0x130002
+add r2,r2,r0
+ldr r0,=0x1A0000
+add r2,r2,r0
+ldr r0,=0x210001
+add r2,r2,r0
+ldr r0,=0x280002
+add r2,r2,r0
+ldr r0,=0x70000
+add r2,r2,r0
+ldr r0,=0xE0001
+add r2,r2,r0
+b block500
+mov r3,#1
+block500:
+ldr r0,=0x150002
+add r2,r2,r0
+ldr r0,=0x1C0000
+add r2,r2,r0
+ldr r0,=0x230001
+add r2,r2,r0
+ldr r0,=0x20002
+add r2,r2,r0
+ldr r0,=0x90000
+add r2,r2,r0
+ldr r0,=0x100001
+add r2,r2,r0
+ldr r0,=0x170002
+add r2,r2,r0
+ldr r0,=0x1E0000
+add r2,r2,r0
+ldr r0,=0x250001
+add r2,r2,r0
+ldr r0,=0x40002
+add r2,r2,r0
+ldr r0,=0xB0000
+add r2,r2,r0
+ldr r0,=0x120001
+add r2,r2,r0
+ldr r0,=0x190002
+add r2,r2,r0
+ldr r0,=0x200000
+add r2,r2,r0
+ldr r0,=0x270001
+add r2,r2,r0
+ldr r0,=0x60002
+add r2,r2,r0
+ldr r0,=0xD0000
+add r2,r2,r0
+ldr r0,=0x140001
+add r2,r2,r0
+ldr r0,=0x1B0002
+add r2,r2,r0
+ldr r0,=0x220000
+add r2,r2,r0
+ldr r0,=0x10001
+add r2,r2,r0
+ldr r0,=0x80002
+add r2,r2,r0
+ldr r0,=0xF0000
+add r2,r2,r0
+ldr r0,=0x160001
+add r2,r2,r0
+ldr r0,=0x1D0002
+add r2,r2,r0
+ldr r0,=0x240000
+add r2,r2,r0
+ldr r0,=0x30001
+add r2,r2,r0
+ldr r0,=0xA0002
+add r2,r2,r0
+ldr r0,=0x110000
+add r2,r2,r0
+ldr r0,=0x180001
+add r2,r2,r0
+ldr r0,=0x1F0002
+add r2,r2,r0
+ldr r0,=0x260000
+add r2,r2,r0
+ldr r0,=0x50001
+add r2,r2,r0
+ldr r0,=0xC0002
+add r2,r2,r0
+ldr r0,=0x130000
+add r2,r2,r0
+ldr r0,=0x1A0001
+add r2,r2,r0
+ldr r0,=0x210002
+add r2,r2,r0
+ldr r0,=0x280000
+add r2,r2,r0
+ldr r0,=0x70001
+add r2,r2,r0
+ldr r0,=0xE0002
+add r2,r2,r0
+ldr r0,=0x150000
+add r2,r2,r0
+ldr r0,=0x1C0001
+add r2,r2,r0
+ldr r0,=0x230002
+add r2,r2,r0
+ldr r0,=0x20000
+add r2,r2,r0
+ldr r0,=0x90001
+add r2,r2,r0
+ldr r0,=0x100002
+add r2,r2,r0
+ldr r0,=0x170000
+add r2,r2,r0
+ldr r0,=0x1E0001
+add r2,r2,r0
+ldr r0,=0x250002
+add r2,r2,r0
+ldr r0,=0x40000
+add r2,r2,r0
+b block550
+mov r3,#1
+block550:
+ldr r0,=0xB0001
+add r2,r2,r0
+ldr r0,=0x120002
+add r2,r2,r0
+ldr r0,=0x190000
+add r2,r2,r0
+ldr r0,=0x200001
+add r2,r2,r0
+ldr r0,=0x270002
+add r2,r2,r0
+ldr r0,=0x60000
+add r2,r2,r0
+ldr r0,=0xD0001
+add r2,r2,r0
+ldr r0,=0x140002
+add r2,r2,r0
+ldr r0,=0x1B0000
+add r2,r2,r0
+ldr r0,=0x220001
+add r2,r2,r0
+ldr r0,=0x10002
+add r2,r2,r0
+ldr r0,=0x80000
+add r2,r2,r0
+ldr r0,=0xF0001
+add r2,r2,r0
+ldr r0,=0x160002
+add r2,r2,r0
+ldr r0,=0x1D0000
+add r2,r2,r0
+ldr r0,=0x240001
+add r2,r2,r0
+ldr r0,=0x30002
+add r2,r2,r0
+ldr r0,=0xA0000
+add r2,r2,r0
+ldr r0,=0x110001
+add r2,r2,r0
+ldr r0,=0x180002
+add r2,r2,r0
+ldr r0,=0x1F0000
+add r2,r2,r0
+ldr r0,=0x260001
+add r2,r2,r0
+ldr r0,=0x50002
+add r2,r2,r0
+ldr r0,=0xC0000
+add r2,r2,r0
+ldr r0,=0x130001
+add r2,r2,r0
+ldr r0,=0x1A0002
+add r2,r2,r0
+ldr r0,=0x210000
+add r2,r2,r0
+ldr r0,=0x280001
+add r2,r2,r0
+ldr r0,=0x70002
+add r2,r2,r0
+ldr r0,=0xE0000
+add r2,r2,r0
+ldr r0,=0x150001
+add r2,r2,r0
+ldr r0,=0x1C0002
+add r2,r2,r0
+ldr r0,=0x230000
+add r2,r2,r0
+ldr r0,=0x20001
+add r2,r2,r0
+ldr r0,=0x90002
+add r2,r2,r0
+ldr r0,=0x100000
+add r2,r2,r0
+ldr r0,=0x170001
+add r2,r2,r0
+ldr r0,=0x1E0002
+add r2,r2,r0
+ldr r0,=0x250000
+add r2,r2,r0
+ldr r0,=0x40001
+add r2,r2,r0
+ldr r0,=0xB0002
+add r2,r2,r0
+ldr r0,=0x120000
+add r2,r2,r0
+ldr r0,=0x190001
+add r2,r2,r0
+ldr r0,=0x200002
+add r2,r2,r0
+ldr r0,=0x270000
+add r2,r2,r0
+ldr r0,=0x60001
+add r2,r2,r0
+ldr r0,=0xD0002
+add r2,r2,r0
+ldr r0,=0x140000
+add r2,r2,r0
+ldr r0,=0x1B0001
+add r2,r2,r0
+ldr r0,=0x220002
+add r2,r2,r0
+b block600
+mov r3,#1
+block600:
+ldr r0,=0x10000
+add r2,r2,r0
+ldr r0,=0x80001
+add r2,r2,r0
+ldr r0,=0xF0002
+add r2,r2,r0
+ldr r0,=0x160000
+add r2,r2,r0
+ldr r0,=0x1D0001
+add r2,r2,r0
+ldr r0,=0x240002
+add r2,r2,r0
+ldr r0,=0x30000
+add r2,r2,r0
+ldr r0,=0xA0001
+add r2,r2,r0
+ldr r0,=0x110002
+add r2,r2,r0
+ldr r0,=0x180000
+add r2,r2,r0
+ldr r0,=0x1F0001
+add r2,r2,r0
+ldr r0,=0x260002
+add r2,r2,r0
+ldr r0,=0x50000
+add r2,r2,r0
+ldr r0,=0xC0001
+add r2,r2,r0
+ldr r0,=0x130002
+add r2,r2,r0
+ldr r0,=0x1A0000
+add r2,r2,r0
+ldr r0,=0x210001
+add r2,r2,r0
+ldr r0,=0x280002
+add r2,r2,r0
+ldr r0,=0x70000
+add r2,r2,r0
+ldr r0,=0xE0001
+add r2,r2,r0
+ldr r0,=0x150002
+add r2,r2,r0
+ldr r0,=0x1C0000
+add r2,r2,r0
+ldr r0,=0x230001
+add r2,r2,r0
+ldr r0,=0x20002
+add r2,r2,r0
+ldr r0,=0x90000
+add r2,r2,r0
+ldr r0,=0x100001
+add r2,r2,r0
+ldr r0,=0x170002
+add r2,r2,r0
+ldr r0,=0x1E0000
+add r2,r2,r0
+ldr r0,=0x250001
+add r2,r2,r0
+ldr r0,=0x40002
+add r2,r2,r0
+ldr r0,=0xB0000
+add r2,r2,r0
+ldr r0,=0x120001
+add r2,r2,r0
+ldr r0,=0x190002
+add r2,r2,r0
+ldr r0,=0x200000
+add r2,r2,r0
+ldr r0,=0x270001
+add r2,r2,r0
+ldr r0,=0x60002
+add r2,r2,r0
+ldr r0,=0xD0000
+add r2,r2,r0
+ldr r0,=0x140001
+add r2,r2,r0
+ldr r0,=0x1B0002
+add r2,r2,r0
+ldr r0,=0x220000
+add r2,r2,r0
+ldr r0,=0x10001
+add r2,r2,r0
+ldr r0,=0x80002
+add r2,r2,r0
+ldr r0,=0xF0000
+add r2,r2,r0
+ldr r0,=0x160001
+add r2,r2,r0
+ldr r0,=0x1D0002
+add r2,r2,r0
+ldr r0,=0x240000
+add r2,r2,r0
+ldr r0,=0x30001
+add r2,r2,r0
+ldr r0,=0xA0002
+add r2,r2,r0
+ldr r0,=0x110000
+add r2,r2,r0
+ldr r0,=0x180001
+add r2,r2,r0
+b block650
+mov r3,#1
+block650:
+ldr r0,=0x1F0002
+add r2,r2,r0
+ldr r0,=0x260000
+add r2,r2,r0
+ldr r0,=0x50001
+add r2,r2,r0
+ldr r0,=0xC0002
+add r2,r2,r0
+ldr r0,=0x130000
+add r2,r2,r0
+ldr r0,=0x1A0001
+add r2,r2,r0
+ldr r0,=0x210002
+add r2,r2,r0
+ldr r0,=0x280000
+add r2,r2,r0
+ldr r0,=0x70001
+add r2,r2,r0
+ldr r0,=0xE0002
+add r2,r2,r0
+ldr r0,=0x150000
+add r2,r2,r0
+ldr r0,=0x1C0001
+add r2,r2,r0
+ldr r0,=0x230002
+add r2,r2,r0
+ldr r0,=0x20000
+add r2,r2,r0
+ldr r0,=0x90001
+add r2,r2,r0
+ldr r0,=0x100002
+add r2,r2,r0
+ldr r0,=0x170000
+add r2,r2,r0
+ldr r0,=0x1E0001
+add r2,r2,r0
+ldr r0,=0x250002
+add r2,r2,r0
+ldr r0,=0x40000
+add r2,r2,r0
+ldr r0,=0xB0001
+add r2,r2,r0
+ldr r0,=0x120002
+add r2,r2,r0
+ldr r0,=0x190000
+add r2,r2,r0
+ldr r0,=0x200001
+add r2,r2,r0
+ldr r0,=0x270002
+add r2,r2,r0
+ldr r0,=0x60000
+add r2,r2,r0
+ldr r0,=0xD0001
+add r2,r2,r0
+ldr r0,=0x140002
+add r2,r2,r0
+ldr r0,=0x1B0000
+add r2,r2,r0
+ldr r0,=0x220001
+add r2,r2,r0
+ldr r0,=0x10002
+add r2,r2,r0
+ldr r0,=0x80000
+add r2,r2,r0
+ldr r0,=0xF0001
+add r2,r2,r0
+ldr r0,=0x160002
+add r2,r2,r0
+ldr r0,=0x1D0000
+add r2,r2,r0
+ldr r0,=0x240001
+add r2,r2,r0
+ldr r0,=0x30002
+add r2,r2,r0
+ldr r0,=0xA0000
+add r2,r2,r0
+ldr r0,=0x110001
+add r2,r2,r0
+ldr r0,=0x180002
+add r2,r2,r0
+ldr r0,=0x1F0000
+add r2,r2,r0
+ldr r0,=0x260001
+add r2,r2,r0
+ldr r0,=0x50002
+add r2,r2,r0
+ldr r0,=0xC0000
+add r2,r2,r0
+ldr r0,=0x130001
+add r2,r2,r0
+ldr r0,=0x1A0002
+add r2,r2,r0
+ldr r0,=0x210000
+add r2,r2,r0
+ldr r0,=0x280001
+add r2,r2,r0
+ldr r0,=0x70002
+add r2,r2,r0
+ldr r0,=0xE0000
+add r2,r2,r0
+b end
+mov r3,#1
+end:
+mov r1,r2
+andeq r0,r0,r0